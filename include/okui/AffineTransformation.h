@@ -19,6 +19,14 @@
 
 #include <cmath>
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define OKUI_AFFINE_TRANSFORMATION_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define OKUI_AFFINE_TRANSFORMATION_NEON 1
+#endif
+
 namespace okui {
 
 class AffineTransformation {
@@ -40,6 +48,32 @@ public:
         *yOut = x * _sxSinR + y * _syCosR + _tyF;
     }
 
+    /**
+    * Transforms four points at once in single precision, using SSE or NEON where available.
+    */
+    void transform4(const float* x, const float* y, float* xOut, float* yOut) const {
+#if OKUI_AFFINE_TRANSFORMATION_SSE
+        auto vx = _mm_loadu_ps(x), vy = _mm_loadu_ps(y);
+        _mm_storeu_ps(xOut, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(vx, _mm_set1_ps(static_cast<float>(_sxCosR))), _mm_mul_ps(vy, _mm_set1_ps(static_cast<float>(_sySinR)))), _mm_set1_ps(static_cast<float>(_txF))));
+        _mm_storeu_ps(yOut, _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_set1_ps(static_cast<float>(_sxSinR))), _mm_mul_ps(vy, _mm_set1_ps(static_cast<float>(_syCosR)))), _mm_set1_ps(static_cast<float>(_tyF))));
+#elif OKUI_AFFINE_TRANSFORMATION_NEON
+        auto vx = vld1q_f32(x), vy = vld1q_f32(y);
+        vst1q_f32(xOut, vmlsq_n_f32(vmlaq_n_f32(vdupq_n_f32(static_cast<float>(_txF)), vx, static_cast<float>(_sxCosR)), vy, static_cast<float>(_sySinR)));
+        vst1q_f32(yOut, vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(static_cast<float>(_tyF)), vx, static_cast<float>(_sxSinR)), vy, static_cast<float>(_syCosR)));
+#else
+        for (int i = 0; i < 4; ++i) {
+            transform(x[i], y[i], &xOut[i], &yOut[i]);
+        }
+#endif
+    }
+
+    bool operator==(const AffineTransformation& other) const {
+        return _sxCosR == other._sxCosR && _sySinR == other._sySinR && _sxSinR == other._sxSinR
+            && _syCosR == other._syCosR && _txF == other._txF && _tyF == other._tyF;
+    }
+
+    bool operator!=(const AffineTransformation& other) const { return !(*this == other); }
+
     static AffineTransformation Translation(double x, double y) {
         return AffineTransformation(x, y);
     }
@@ -37,13 +37,16 @@
 #endif
 
 #include <cassert>
+#include <chrono>
 #include <list>
 #include <map>
+#include <memory>
 #include <typeindex>
 #include <unordered_map>
 
 namespace okui {
 
+class DisplayList;
 class Window;
 struct WindowPosition;
 
@@ -64,8 +67,10 @@ public:
 
     /**
     * iOS: applicationDidReceiveMemoryWarning(), Android: onLowMemory()
+    *
+    * By default, this purges the download cache and the caches of each window.
     */
-    virtual void lowMemory() { purgeDownloadCache(0); }
+    virtual void lowMemory();
 
     /**
     * iOS: applicationWillResignActive(), Android: onPause()
@@ -97,6 +102,20 @@ public:
     */
     virtual void quit() = 0;
 
+    /**
+    * If the main loop is waiting for events, a call to this method should cause it to continue. This is used
+    * to notify the application that work is ready for a window that renders on demand.
+    *
+    * This method should be thread-safe.
+    */
+    virtual void wakeUp() {}
+
+    /**
+    * Returns the time used by windows to pace frames and update views. Applications that need to control the
+    * passage of time, such as the headless application, can override this.
+    */
+    virtual std::chrono::steady_clock::time_point now() const { return std::chrono::steady_clock::now(); }
+
     /**
     * The following window functions should generally be avoided in favor of the more object-oriented Window class methods.
     */
@@ -366,6 +385,11 @@ public:
 protected:
     void _update(Window* window);
     void _render(Window* window);
+
+    /**
+    * Records the window's next frame without drawing it. See Window::setRendersOnRenderThread.
+    */
+    std::shared_ptr<const DisplayList> _renderFrame(Window* window);
     void _didResize(Window* window, int width, int height);
     void _assignWindowSize(Window* window);
 
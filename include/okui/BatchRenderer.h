@@ -0,0 +1,198 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <okui/Rectangle.h>
+#include <okui/opengl/ShaderProgram.h>
+#include <okui/opengl/StreamingVertexBuffer.h>
+
+#include <scraps/opengl/VertexArrayBuffer.h>
+
+#include <stdts/optional.h>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace okui {
+
+namespace shaders {
+    struct ColorVertex;
+    struct TextureVertex;
+}
+
+/**
+* Merges the draws made by okui's color and texture shaders into as few draw calls as possible.
+*
+* Vertices from consecutive draws, even those made by different views or shaders, are converted into a common
+* format and drawn by a combined shader that samples from one of several texture slots. Clipping is done by the
+* combined shader, so the scissors set by views don't interrupt batches. A batch is drawn when the render target
+* or blend function changes, when it runs out of texture slots, or when something that can't be batched needs to
+* draw.
+*
+* While disabled, state changes are applied immediately and draw calls are only counted.
+*/
+class BatchRenderer {
+public:
+    struct Statistics {
+        size_t drawCalls = 0;    // all draw calls made by okui shaders, including the batch renderer's
+        size_t batches = 0;      // draw calls made by the batch renderer
+        size_t batchedDraws = 0; // shader draws that were merged into batches
+        size_t vertices = 0;
+    };
+
+    BatchRenderer();
+    ~BatchRenderer();
+
+    bool isEnabled() const { return _isEnabled; }
+    void setEnabled(bool enabled = true);
+
+    /**
+    * Makes this the current batch renderer and begins a frame.
+    */
+    void begin(int targetWidth, int targetHeight);
+
+    /**
+    * Draws any pending batch and ends the frame.
+    */
+    void end();
+
+    /**
+    * Returns the statistics for the last frame that was ended.
+    */
+    const Statistics& statistics() const { return _lastFrameStatistics; }
+
+    /**
+    * Should be invoked when the bound framebuffer changes.
+    */
+    void setTarget(int width, int height);
+
+    /**
+    * Sets the viewport, in the same coordinates as glViewport.
+    */
+    void setViewport(const Rectangle<int>& viewport);
+
+    /**
+    * Sets or disables the scissor, in the same coordinates as glScissor.
+    */
+    void setScissor(stdts::optional<Rectangle<int>> scissor);
+
+    /**
+    * Adds vertices to the current batch. Returns false if they can't be batched, in which case the caller should
+    * flush and draw them itself.
+    */
+    bool add(const std::vector<shaders::ColorVertex>& vertices);
+    bool add(const std::vector<shaders::TextureVertex>& vertices, GLuint texture, bool inputHasPremultipliedAlpha);
+
+    /**
+    * Implemented by renderers that can't add their draws to the batch, but can merge consecutive draws of their own.
+    */
+    class Holder {
+    public:
+        virtual ~Holder() {}
+
+        /**
+        * Draws everything that's been held. This is invoked with the full target as the viewport, so clipping must
+        * be done by the holder using the scissor that was current when each draw was held.
+        */
+        virtual void drawHeld() = 0;
+    };
+
+    /**
+    * Draws the pending batch unless the holder is already holding draws, then lets the holder hold its draws until
+    * something else needs to draw. Returns false if the batch renderer is disabled, in which case the holder should
+    * draw immediately.
+    */
+    bool hold(Holder* holder);
+
+    /**
+    * Forgets about the holder's draws without drawing them. This should be invoked before a holder is destroyed.
+    */
+    void forget(Holder* holder);
+
+    int targetWidth() const { return _targetWidth; }
+    int targetHeight() const { return _targetHeight; }
+    const Rectangle<int>& viewport() const { return _viewport; }
+    const stdts::optional<Rectangle<int>>& scissor() const { return _scissor; }
+
+    /**
+    * Should be invoked for each draw call made outside of the batch renderer.
+    */
+    void didDraw(size_t vertices);
+
+    /**
+    * Draws the pending batch and applies the current scissor. This must be invoked before making OpenGL draw
+    * calls that aren't made via okui shaders.
+    */
+    void flush();
+
+    static BatchRenderer* Current() { return _sCurrent; }
+
+    /**
+    * These apply state changes via the current batch renderer if there is one, or directly otherwise. While a
+    * display list is deferring, they're recorded and applied when it's replayed.
+    */
+    static void SetTarget(int width, int height);
+    static void SetViewport(const Rectangle<int>& viewport);
+    static void SetScissor(stdts::optional<Rectangle<int>> scissor);
+    static void Flush();
+
+    static constexpr size_t kMaxTextureSlots = 8;
+
+private:
+    struct Vertex {
+        GLfloat x, y;
+        GLfloat r, g, b, a;
+        GLfloat cu, cv, cm, caa;
+        GLfloat s, t;
+        GLfloat clipX1, clipY1, clipX2, clipY2;
+        GLfloat textureSlot, inputHasPremultipliedAlpha;
+    };
+
+    template <typename SourceVertex>
+    Vertex* _append(const SourceVertex& source);
+
+    void _drawHeld();
+    int _textureSlot(GLuint texture);
+    void _applyScissor();
+    void _createProgram();
+
+    bool                                               _isEnabled = false;
+    int                                                _targetWidth = 0;
+    int                                                _targetHeight = 0;
+    Rectangle<int>                                     _viewport;
+    stdts::optional<Rectangle<int>>                    _scissor;
+    bool                                               _needsScissorUpdate = false;
+
+    std::vector<Vertex>                                _vertices;
+    Holder*                                            _holder = nullptr;
+    std::array<GLuint, kMaxTextureSlots>               _textures;
+    size_t                                             _textureCount = 0;
+
+    std::unique_ptr<opengl::ShaderProgram>             _program;
+    std::unique_ptr<scraps::opengl::VertexArrayBuffer> _vertexArrayBuffer;
+    opengl::StreamingVertexBuffer::VertexArray         _streamingVertexArray;
+    opengl::ShaderProgram::Uniform                     _blendingFlagsUniform;
+
+    Statistics                                         _statistics;
+    Statistics                                         _lastFrameStatistics;
+
+    static BatchRenderer* _sCurrent;
+};
+
+} // namespace okui
@@ -0,0 +1,71 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <okui/Rectangle.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace okui {
+
+/**
+* Accumulates the areas of a window that need to be redrawn.
+*
+* Rectangles that overlap are merged as they're added, and if the number of rectangles exceeds the
+* maximum, the pair that wastes the least area when merged is combined.
+*/
+class DamageRegion {
+public:
+    explicit DamageRegion(size_t maxRectangles = 4) : _maxRectangles{std::max<size_t>(maxRectangles, 1)} {}
+
+    void add(const Rectangle<double>& rectangle);
+    void add(const DamageRegion& other);
+
+    void clear() { _rectangles.clear(); }
+
+    bool empty() const { return _rectangles.empty(); }
+
+    const std::vector<Rectangle<double>>& rectangles() const { return _rectangles; }
+
+    /**
+    * Returns the smallest rectangle containing the entire region.
+    */
+    Rectangle<double> bounds() const;
+
+    /**
+    * Returns the total area covered by the region's rectangles.
+    */
+    double area() const;
+
+    size_t maxRectangles() const { return _maxRectangles; }
+    void setMaxRectangles(size_t maxRectangles);
+
+    /**
+    * Converts a rectangle to the smallest integer rectangle that contains it after scaling.
+    */
+    static Rectangle<int> PixelBounds(const Rectangle<double>& rectangle, double xScale, double yScale);
+
+private:
+    void _reduce();
+
+    size_t                         _maxRectangles;
+    std::vector<Rectangle<double>> _rectangles;
+};
+
+} // namespace okui
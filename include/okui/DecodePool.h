@@ -0,0 +1,129 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace okui {
+
+/**
+* A pool of threads for decoding images.
+*
+* Tasks are run in order of priority, and in the order they were submitted within a priority. Tasks that haven't
+* started yet can be reprioritized or canceled.
+*/
+class DecodePool {
+public:
+    enum class Priority {
+        kVisible,    // needed by views that are on screen
+        kPrefetch,   // needed by views that are just off screen
+        kBackground, // everything else
+    };
+
+    static constexpr size_t kPriorityCount = 3;
+
+    /**
+    * Creates the pool. By default, there's one thread for each hardware thread other than the main thread.
+    */
+    explicit DecodePool(size_t threadCount = DefaultThreadCount());
+    ~DecodePool();
+
+    DecodePool(const DecodePool&) = delete;
+    DecodePool& operator=(const DecodePool&) = delete;
+
+    static size_t DefaultThreadCount();
+
+    size_t threadCount() const { return _threads.size(); }
+
+    class Task;
+    using Ticket = std::shared_ptr<Task>;
+
+    /**
+    * Schedules a function to be invoked on one of the pool's threads.
+    */
+    Ticket async(Priority priority, std::function<void()> function);
+
+    /**
+    * Changes the priority of a task that hasn't started yet.
+    */
+    void setPriority(const Ticket& ticket, Priority priority);
+
+    /**
+    * Cancels a task that hasn't started yet. Returns true if the task was canceled, or false if it has already
+    * started or been canceled.
+    */
+    bool cancel(const Ticket& ticket);
+
+    /**
+    * Cancels every task that hasn't started yet and waits for the others to finish. The pool can't be used
+    * afterwards.
+    */
+    void cancelAndJoin();
+
+    struct Statistics {
+        size_t                    queued = 0;
+        size_t                    running = 0;
+        size_t                    completed = 0;
+        size_t                    canceled = 0;
+        std::chrono::microseconds averageLatency{0}; // from submission to completion
+        std::chrono::microseconds maximumLatency{0};
+    };
+
+    Statistics statistics() const;
+
+private:
+    void _run();
+
+    mutable std::mutex                                    _mutex;
+    std::condition_variable                               _condition;
+    std::array<std::deque<Ticket>, kPriorityCount>        _queues;
+    bool                                                  _shouldExit = false;
+    Statistics                                            _statistics;
+    std::chrono::steady_clock::duration                   _totalLatency{0};
+    std::vector<std::thread>                              _threads;
+};
+
+class DecodePool::Task {
+public:
+    Priority priority() const { return _priority; }
+
+private:
+    friend class DecodePool;
+
+    enum class State {
+        kQueued,
+        kRunning,
+        kFinished,
+        kCanceled,
+    };
+
+    std::function<void()>                 _function;
+    Priority                              _priority;
+    State                                 _state = State::kQueued;
+    std::chrono::steady_clock::time_point _submissionTime;
+};
+
+} // namespace okui
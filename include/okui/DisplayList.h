@@ -0,0 +1,103 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace okui {
+
+/**
+* A recording of draws made by okui shaders that can be replayed without regenerating any geometry.
+*
+* While a recording is active, each shader flush appends a command containing the shader's vertices along with
+* the texture, uniforms, and blend function needed to draw them again. Other OpenGL state changes, such as
+* viewports and scissors, aren't recorded.
+*
+* A recording may also defer drawing. While deferring, shader draws and the state changes made via Perform are
+* only recorded, which allows a complete frame to be built on one thread and drawn on another.
+*/
+class DisplayList {
+public:
+    using Command = std::function<void()>;
+
+    void append(Command command) { _commands.emplace_back(std::move(command)); }
+
+    /**
+    * Issues all of the recorded draws in order. While deferring, the draws are appended to the current display
+    * list instead.
+    */
+    void replay() const;
+
+    void clear() { _commands.clear(); }
+
+    bool empty() const { return _commands.empty(); }
+    size_t size() const { return _commands.size(); }
+
+    /**
+    * Records into the given display list for the lifetime of the object. Recordings may be nested, in which
+    * case the outer recording resumes once the inner one is destroyed. A null display list suspends recording.
+    */
+    class Recording {
+    public:
+        /**
+        * @param defers if true, draws are recorded without being made. Recordings nested within a deferring
+        *               recording always defer
+        */
+        explicit Recording(DisplayList* displayList, bool defers = false);
+        ~Recording();
+
+        Recording(const Recording&) = delete;
+        Recording& operator=(const Recording&) = delete;
+
+    private:
+        DisplayList* _previous;
+        bool         _previousIsDeferring;
+    };
+
+    /**
+    * Returns the display list currently being recorded into, if any.
+    */
+    static DisplayList* Current() { return _sCurrent; }
+
+    /**
+    * Returns true if draws are currently being recorded without being made.
+    */
+    static bool IsDeferring() { return _sCurrent && _sIsDeferring; }
+
+    /**
+    * Performs an OpenGL state change, or records it if deferring.
+    */
+    template <typename F>
+    static void Perform(F&& f) {
+        if (IsDeferring()) {
+            _sCurrent->append(std::forward<F>(f));
+        } else {
+            f();
+        }
+    }
+
+private:
+    std::vector<Command> _commands;
+
+    static DisplayList* _sCurrent;
+    static bool         _sIsDeferring;
+};
+
+} // namespace okui
@@ -17,7 +17,12 @@
 
 #include <okui/config.h>
 
+#include <okui/KTXContainer.h>
+#include <okui/TextureAtlas.h>
 #include <okui/TextureInterface.h>
+#include <okui/opengl/TextureUploadBuffer.h>
+
+#include <memory>
 
 namespace okui {
 
@@ -26,7 +31,8 @@ public:
     enum class Type {
         kUnknown,
         kPNG,
-        kJPEG
+        kJPEG,
+        kKTX
     };
 
     FileTexture() = default;
@@ -44,17 +50,63 @@ public:
     virtual int width() const override        { return _width; }
     virtual int height() const override       { return _height; }
 
+    /**
+    * Sets the size in pixels that the texture will be displayed at. If set before decompress is invoked, the image
+    * is decoded at a reduced resolution that still covers the target size. Zero dimensions are unconstrained.
+    *
+    * Once the texture is loaded, width and height return the decoded dimensions.
+    */
+    void setTargetSize(int width, int height) { _targetWidth = width; _targetHeight = height; }
+
     /**
     * returns success
+    *
+    * KTX and KTX2 textures in compressed formats are uploaded as-is if the driver supports them, including their mip
+    * levels. Otherwise they're decoded on the CPU if possible.
     */
     bool decompress();
 
+    /**
+    * Requires the render context to be active.
+    *
+    * If the texture was staged, it's uploaded from its pixel unpack buffer.
+    */
     virtual void load() override;
 
-    virtual GLuint id() const override           { return _id; }
+    /**
+    * Requires the render context to be active.
+    *
+    * Copies uncompressed pixels into a pixel unpack buffer and releases them from memory. load() then uploads from the
+    * buffer, and should be invoked a frame later so that the driver has had time to transfer the data instead of
+    * waiting on it. Returns false if the texture can't be staged, in which case load() uploads from memory.
+    */
+    bool stage();
+
+    bool isStaged() const { return _uploadBuffer != nullptr; }
+
+    /**
+    * Returns the number of bytes that load() will upload, or 0 if the texture hasn't been decompressed.
+    */
+    size_t uploadSize() const;
+
+    /**
+    * Requires the render context to be active.
+    *
+    * Loads the texture into the given atlas if it's eligible. Only small 8-bit RGB and RGBA images are. Returns
+    * false if the texture wasn't loaded, in which case load() can be used instead.
+    */
+    bool loadIntoAtlas(TextureAtlas* atlas);
+
+    bool isInAtlas() const { return _atlasAllocation != nullptr; }
+
+    virtual GLuint id() const override           { return _atlasAllocation ? _atlasAllocation->texture() : _id; }
+
+    virtual int allocatedWidth() const override  { return _atlasAllocation ? _width : _allocatedWidth; }
+    virtual int allocatedHeight() const override { return _atlasAllocation ? _height : _allocatedHeight; }
+
+    virtual Rectangle<double> region() const override;
 
-    virtual int allocatedWidth() const override  { return _allocatedWidth; }
-    virtual int allocatedHeight() const override { return _allocatedHeight; }
+    virtual size_t gpuBytes() const override { return _gpuBytes; }
 
 private:
     struct TextureType {
@@ -66,17 +118,31 @@ private:
     bool _loadPNG();
     bool _readJPEGMetadata();
     bool _loadJPEG();
+    bool _readKTXMetadata();
+    bool _loadKTX();
+    bool _decompressKTX();
+    void _loadCompressedKTX(GLenum format);
 
     std::string                          _name;
     std::shared_ptr<const std::string>   _data; // typically a reference into the application cache
     std::vector<uint8_t>                 _decompressedData;
+    std::unique_ptr<opengl::TextureUploadBuffer> _uploadBuffer; // set if the decompressed data was staged
     Type                                 _type = Type::kUnknown;
     int                                  _width = 0;
     int                                  _height = 0;
+    int                                  _targetWidth = 0;
+    int                                  _targetHeight = 0;
+    int                                  _decodedWidth = 0;
+    int                                  _decodedHeight = 0;
     int                                  _allocatedWidth = 0;
     int                                  _allocatedHeight = 0;
     TextureType                          _textureType;
+    KTXContainer                         _ktx;
+    size_t                               _ktxBaseLevel = 0;
+    GLenum                               _compressedFormat = 0; // set if compressed data is waiting to be uploaded
     GLuint                               _id = 0;
+    size_t                               _gpuBytes = 0;
+    std::shared_ptr<TextureAtlas::Allocation> _atlasAllocation;
 };
 
 } // namespace okui
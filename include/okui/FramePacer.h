@@ -0,0 +1,193 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace okui {
+
+/**
+* Decides when frames should begin so that they're evenly spaced at a target rate.
+*
+* The target rate is rounded to a divisor of the display's refresh rate so that every frame is presented for the
+* same number of refreshes. If adaptive pacing is enabled and frames consistently take longer than the frame
+* interval, the pacer falls back to half the target rate until the load subsides.
+*/
+template <typename Clock = std::chrono::steady_clock>
+class FramePacer {
+public:
+    using Duration = typename Clock::duration;
+    using TimePoint = typename Clock::time_point;
+
+    /**
+    * The rate at which frames should be produced. If zero, frames are produced at the refresh rate.
+    */
+    double targetFrameRate() const { return _targetFrameRate; }
+    void setTargetFrameRate(double framesPerSecond);
+
+    /**
+    * The refresh rate of the display that frames are presented on.
+    */
+    double refreshRate() const { return _refreshRate; }
+    void setRefreshRate(double hertz);
+
+    bool isAdaptive() const { return _isAdaptive; }
+    void setAdaptive(bool isAdaptive = true);
+
+    /**
+    * Returns true if the pacer has fallen back to half its target rate.
+    */
+    bool isHalfRate() const { return _isHalfRate; }
+
+    /**
+    * Returns the current interval between frames, including the half rate fallback.
+    */
+    Duration frameInterval() const { return _isHalfRate ? _baseInterval * 2 : _baseInterval; }
+
+    /**
+    * Returns the time at which the next frame should begin.
+    */
+    TimePoint nextFrameTime() const { return _nextFrameTime; }
+
+    bool isFrameDue(TimePoint now = Clock::now()) const { return now >= _nextFrameTime; }
+
+    /**
+    * Returns the time at which the frame that's in progress is expected to be presented.
+    */
+    TimePoint predictedPresentationTime() const { return _presentationTime; }
+
+    /**
+    * Returns the time spent working on the last frame, which is smoothed over several frames.
+    */
+    Duration averageFrameDuration() const { return std::chrono::duration_cast<Duration>(_averageFrameDuration); }
+
+    /**
+    * Should be invoked as work on a frame begins.
+    */
+    void beginFrame(TimePoint now = Clock::now());
+
+    /**
+    * Should be invoked once work on a frame is complete, before any blocking buffer swaps.
+    */
+    void endFrame(TimePoint now = Clock::now());
+
+    // the number of consecutive late frames that cause a fall back to half rate
+    static constexpr int kLateFrameThreshold = 5;
+
+    // the number of consecutive fast frames required to return to the full rate
+    static constexpr int kRecoveryFrameThreshold = 60;
+
+private:
+    void _updateInterval();
+
+    double     _targetFrameRate = 60.0;
+    double     _refreshRate = 60.0;
+    bool       _isAdaptive = false;
+    bool       _isHalfRate = false;
+    Duration   _baseInterval = std::chrono::duration_cast<Duration>(std::chrono::duration<double>(1.0 / 60.0));
+
+    TimePoint  _nextFrameTime{};
+    TimePoint  _frameStart{};
+    TimePoint  _presentationTime{};
+    bool       _isFrameInProgress = false;
+
+    std::chrono::duration<double> _averageFrameDuration{0.0};
+    int        _lateFrames = 0;
+    int        _fastFrames = 0;
+};
+
+template <typename Clock>
+void FramePacer<Clock>::setTargetFrameRate(double framesPerSecond) {
+    _targetFrameRate = std::max(framesPerSecond, 0.0);
+    _updateInterval();
+}
+
+template <typename Clock>
+void FramePacer<Clock>::setRefreshRate(double hertz) {
+    _refreshRate = hertz > 0.0 ? hertz : 60.0;
+    _updateInterval();
+}
+
+template <typename Clock>
+void FramePacer<Clock>::setAdaptive(bool isAdaptive) {
+    _isAdaptive = isAdaptive;
+    if (!_isAdaptive) {
+        _isHalfRate = false;
+    }
+    _lateFrames = _fastFrames = 0;
+}
+
+template <typename Clock>
+void FramePacer<Clock>::beginFrame(TimePoint now) {
+    auto interval = frameInterval();
+
+    // keep the frames in phase unless we've fallen more than a full frame behind
+    auto deadline = _nextFrameTime;
+    if (now - deadline >= interval) {
+        deadline = now;
+    }
+
+    _frameStart = now;
+    _nextFrameTime = deadline + interval;
+    _presentationTime = _nextFrameTime;
+    _isFrameInProgress = true;
+}
+
+template <typename Clock>
+void FramePacer<Clock>::endFrame(TimePoint now) {
+    if (!_isFrameInProgress) { return; }
+    _isFrameInProgress = false;
+
+    constexpr auto hysteresis = 0.8;
+    std::chrono::duration<double> duration = now - _frameStart;
+    _averageFrameDuration = _averageFrameDuration * hysteresis + duration * (1.0 - hysteresis);
+
+    if (!_isAdaptive) { return; }
+
+    if (!_isHalfRate) {
+        _lateFrames = duration > _baseInterval ? _lateFrames + 1 : 0;
+        if (_lateFrames >= kLateFrameThreshold) {
+            _isHalfRate = true;
+            _lateFrames = 0;
+            _fastFrames = 0;
+            _nextFrameTime = _frameStart + frameInterval();
+        }
+    } else {
+        // only recover if there's comfortable headroom at the full rate
+        _fastFrames = _averageFrameDuration < _baseInterval * 0.6 ? _fastFrames + 1 : 0;
+        if (_fastFrames >= kRecoveryFrameThreshold) {
+            _isHalfRate = false;
+            _fastFrames = 0;
+            _lateFrames = 0;
+        }
+    }
+}
+
+template <typename Clock>
+void FramePacer<Clock>::_updateInterval() {
+    auto refreshInterval = 1.0 / _refreshRate;
+    auto refreshesPerFrame = 1.0;
+    if (_targetFrameRate > 0.0 && _targetFrameRate < _refreshRate) {
+        refreshesPerFrame = std::max(std::round(_refreshRate / _targetFrameRate), 1.0);
+    }
+    _baseInterval = std::chrono::duration_cast<Duration>(std::chrono::duration<double>(refreshInterval * refreshesPerFrame));
+}
+
+} // namespace okui
@@ -0,0 +1,198 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace okui {
+
+class View;
+
+/**
+* Records where the time goes in each of a window's frames.
+*
+* While enabled, the profiler keeps the phases of recent frames, the time each view spent in render, and counts of
+* shader flushes, draw calls, triangles, and render cache redraws. Phases that are recorded between frames, such as
+* event handling, are attributed to the next frame. The history can be inspected directly or exported in Chrome's
+* trace event format, which can be loaded into chrome://tracing or Perfetto.
+*
+* While disabled, the instrumentation costs no more than a few branches per view.
+*/
+class FrameProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Phase {
+        kEvents,
+        kTasks,
+        kUpdate,
+        kLayout,
+        kRender,
+        kSwap,
+    };
+
+    static constexpr size_t kPhaseCount = 6;
+
+    struct Span {
+        Clock::time_point start;
+        Clock::duration   duration{};
+    };
+
+    struct PhaseSpan : Span {
+        Phase phase;
+    };
+
+    struct ViewSpan : Span {
+        const View*           view = nullptr;
+        const std::type_info* type = nullptr;
+    };
+
+    struct FrameStats {
+        size_t                                 number = 0;
+        Span                                   frame;
+        std::array<Clock::duration, kPhaseCount> phases{}; // the total time spent in each phase, indexed by Phase
+
+        size_t shaderFlushes      = 0;
+        size_t drawCalls          = 0;
+        size_t triangles          = 0;
+        size_t renderCacheRenders = 0;
+        size_t layouts            = 0;
+        size_t textureUploads     = 0;
+        size_t textureUploadBytes = 0;
+
+        std::vector<PhaseSpan> phaseSpans;
+        std::vector<ViewSpan>  viewSpans;
+
+        Clock::duration phase(Phase phase) const { return phases[static_cast<size_t>(phase)]; }
+    };
+
+    /**
+    * Measures the time from construction to destruction as a phase of the given profiler's frame. The profiler may
+    * be null.
+    */
+    class PhaseScope {
+    public:
+        PhaseScope(FrameProfiler* profiler, Phase phase);
+        ~PhaseScope();
+
+    private:
+        FrameProfiler*    _profiler;
+        Phase             _phase;
+        Clock::time_point _start;
+    };
+
+    /**
+    * Measures the time from construction to destruction as time spent rendering the given view in the current
+    * profiler's frame.
+    */
+    class ViewScope {
+    public:
+        explicit ViewScope(const View* view);
+        ~ViewScope() { end(); }
+
+        /**
+        * Ends the measurement early.
+        */
+        void end();
+
+    private:
+        FrameProfiler*    _profiler;
+        const View*       _view;
+        Clock::time_point _start;
+    };
+
+    bool isEnabled() const { return _isEnabled; }
+    void setEnabled(bool enabled = true);
+
+    /**
+    * The number of completed frames to keep.
+    */
+    size_t historyLength() const { return _historyLength; }
+    void setHistoryLength(size_t frames);
+
+    const std::deque<FrameStats>& history() const { return _history; }
+    void clearHistory() { _history.clear(); }
+
+    /**
+    * Returns the most recently completed frame, or nullptr if there isn't one.
+    */
+    const FrameStats* lastFrame() const { return _history.empty() ? nullptr : &_history.back(); }
+
+    /**
+    * Begins a frame and makes this the current profiler until the frame ends. Does nothing if disabled.
+    */
+    void beginFrame(Clock::time_point now = Clock::now());
+
+    /**
+    * Ends the frame in progress and adds it to the history.
+    */
+    void endFrame(Clock::time_point now = Clock::now());
+
+    bool isFrameInProgress() const { return _isFrameInProgress; }
+
+    /**
+    * Returns the frame in progress so that counts can be added to it, or nullptr if there isn't one.
+    */
+    FrameStats* currentFrame() { return _isFrameInProgress ? &_frame : nullptr; }
+
+    void recordPhase(Phase phase, Clock::time_point start, Clock::time_point end);
+    void recordView(const View* view, Clock::time_point start, Clock::time_point end);
+
+    /**
+    * Writes the history in Chrome's trace event JSON format.
+    */
+    void writeChromeTrace(std::ostream& os) const;
+    std::string chromeTrace() const;
+
+    static const char* PhaseName(Phase phase);
+
+    /**
+    * Returns the profiler whose frame is in progress on the calling thread, if any.
+    */
+    static FrameProfiler* Current() { return _sCurrent; }
+
+    static void DidFlushShader() {
+        if (_sCurrent) { ++_sCurrent->_frame.shaderFlushes; }
+    }
+
+    static void DidRenderCache() {
+        if (_sCurrent) { ++_sCurrent->_frame.renderCacheRenders; }
+    }
+
+private:
+    bool                   _isEnabled = false;
+    size_t                 _historyLength = 120;
+    std::deque<FrameStats> _history;
+
+    FrameStats             _frame;
+    bool                   _isFrameInProgress = false;
+    size_t                 _frameCount = 0;
+
+    // phases recorded between frames are held here until the next frame begins
+    std::vector<PhaseSpan> _pendingPhaseSpans;
+
+    static thread_local FrameProfiler* _sCurrent;
+};
+
+} // namespace okui
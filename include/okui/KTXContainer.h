@@ -0,0 +1,80 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <okui/opengl/opengl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace okui {
+
+/**
+* Parses KTX and KTX2 texture containers.
+*
+* Only 2D textures without array layers, cube faces, or supercompression are supported. The container refers to the
+* data it was parsed from, which must outlive it.
+*/
+class KTXContainer {
+public:
+    struct Level {
+        const uint8_t* data = nullptr;
+        size_t         size = 0;
+        int            width = 0;
+        int            height = 0;
+    };
+
+    /**
+    * Returns true if the data begins with a KTX or KTX2 identifier.
+    */
+    static bool IsKTX(const void* data, size_t length);
+
+    /**
+    * Returns success. Failures other than the data not being a KTX container are logged.
+    */
+    bool parse(const void* data, size_t length);
+
+    /**
+    * For compressed textures, format and type are 0 and internalFormat is the compressed format. Otherwise they're
+    * suitable for glTexImage2D.
+    */
+    GLenum internalFormat() const { return _internalFormat; }
+    GLenum format() const         { return _format; }
+    GLenum type() const           { return _type; }
+    bool isCompressed() const     { return _type == 0; }
+
+    int width() const  { return _levels.empty() ? 0 : _levels[0].width; }
+    int height() const { return _levels.empty() ? 0 : _levels[0].height; }
+
+    /**
+    * Mip levels, starting with the full resolution image.
+    */
+    const std::vector<Level>& levels() const { return _levels; }
+
+private:
+    bool _parseKTX1(const uint8_t* data, size_t length);
+    bool _parseKTX2(const uint8_t* data, size_t length);
+
+    GLenum             _internalFormat = 0;
+    GLenum             _format = 0;
+    GLenum             _type = 0;
+    std::vector<Level> _levels;
+};
+
+} // namespace okui
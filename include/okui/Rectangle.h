@@ -71,6 +71,11 @@ struct Rectangle {
     bool intersects(const Rectangle& other) const;
     Rectangle intersection(const Rectangle& other) const;
 
+    /**
+    * Returns the smallest rectangle that contains both rectangles. Empty rectangles are ignored.
+    */
+    Rectangle unionBounds(const Rectangle& other) const;
+
     std::vector<Rectangle> operator-(const Rectangle& other) const;
 
     /**
@@ -183,6 +188,17 @@ Rectangle<T> Rectangle<T>::intersection(const Rectangle& other) const {
     return {min.x, min.y, max.x - min.x, max.y - min.y};
 }
 
+template <typename T>
+Rectangle<T> Rectangle<T>::unionBounds(const Rectangle& other) const {
+    if (other.width <= 0 || other.height <= 0) { return *this; }
+    if (width <= 0 || height <= 0) { return other; }
+
+    auto min = Point<T>{std::min(minX(), other.minX()), std::min(minY(), other.minY())},
+         max = Point<T>{std::max(maxX(), other.maxX()), std::max(maxY(), other.maxY())};
+
+    return {min.x, min.y, max.x - min.x, max.y - min.y};
+}
+
 template <typename T>
 std::vector<Rectangle<T>> Rectangle<T>::operator-(const Rectangle& other) const {
     std::vector<Rectangle<T>> ret;
@@ -0,0 +1,138 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <okui/opengl/Framebuffer.h>
+
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace okui {
+
+/**
+* Recycles the framebuffers that views render their caches into.
+*
+* Sizes are rounded up to buckets so that views whose sizes change slightly, such as during scale animations,
+* can keep their framebuffers. Released framebuffers are kept for reuse until the pool exceeds its budget. When
+* it does, idle framebuffers are destroyed first, then those belonging to views that haven't been rendered
+* recently, least recently used first.
+*/
+class RenderCachePool {
+public:
+    class Surface {
+    public:
+        Surface(int width, int height);
+
+        /**
+        * The allocated size, which may be larger than the size requested.
+        */
+        int width() const { return _width; }
+        int height() const { return _height; }
+
+        /**
+        * Returns false if the surface was evicted, in which case it should be released and a new one acquired.
+        */
+        bool isValid() const { return _framebuffer != nullptr; }
+
+        opengl::Framebuffer* framebuffer() const { return _framebuffer.get(); }
+        GLuint texture() const { return _colorAttachment ? _colorAttachment->texture() : 0; }
+
+        size_t bytes() const { return isValid() ? static_cast<size_t>(_width) * _height * 4 : 0; }
+
+    private:
+        friend class RenderCachePool;
+
+        void _invalidate();
+
+        int                                  _width;
+        int                                  _height;
+        std::unique_ptr<opengl::Framebuffer> _framebuffer;
+        opengl::Framebuffer::Attachment*     _colorAttachment = nullptr;
+        size_t                               _lastUseFrame = 0;
+    };
+
+    static constexpr size_t kDefaultBudget = 128 * 1024 * 1024;
+    static constexpr size_t kDefaultMaxUnusedFrames = 600;
+
+    size_t budget() const { return _budget; }
+    void setBudget(size_t budget) { _budget = budget; }
+
+    /**
+    * Surfaces that go unused for this many frames are destroyed, even if the pool is within its budget.
+    */
+    size_t maxUnusedFrames() const { return _maxUnusedFrames; }
+    void setMaxUnusedFrames(size_t frames) { _maxUnusedFrames = frames; }
+
+    /**
+    * Requires the render context to be active.
+    *
+    * Returns a surface at least as large as the given size. Its contents are undefined.
+    */
+    std::shared_ptr<Surface> acquire(int width, int height);
+
+    /**
+    * Returns a surface to the pool so that it can be reused.
+    */
+    void release(std::shared_ptr<Surface> surface);
+
+    /**
+    * Marks the surface as used in the current frame. Surfaces used in the current frame are never evicted.
+    */
+    void use(Surface* surface) { surface->_lastUseFrame = _frame; }
+
+    /**
+    * Requires the render context to be active.
+    *
+    * Ends the current frame, evicting surfaces as needed.
+    */
+    void endFrame();
+
+    /**
+    * Requires the render context to be active.
+    *
+    * Destroys all idle surfaces.
+    */
+    void purge() { _idle.clear(); }
+
+    /**
+    * Returns the memory used by all surfaces, including those in use.
+    */
+    size_t bytes() const;
+
+    /**
+    * Returns the memory used by surfaces waiting to be reused.
+    */
+    size_t idleBytes() const;
+
+    /**
+    * Rounds a dimension up to its bucket size.
+    */
+    static int BucketSize(int size);
+
+private:
+    void _evict(size_t incomingBytes);
+
+    size_t                              _budget = kDefaultBudget;
+    size_t                              _maxUnusedFrames = kDefaultMaxUnusedFrames;
+    size_t                              _frame = 0;
+    std::list<std::shared_ptr<Surface>> _idle; // least recently released first
+    std::vector<std::weak_ptr<Surface>> _surfaces;
+};
+
+} // namespace okui
@@ -0,0 +1,69 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace okui {
+
+/**
+* A thread that draws a window's frames so that the main thread can move on to the next frame's updates.
+*
+* The main thread records each frame into a deferring DisplayList, which is immutable once it's submitted. At most
+* one frame is in flight at a time, and the main thread must wait for it to be drawn before it uses the OpenGL
+* context again. The context is shared between the threads while the render thread exists, so each thread should
+* claim it via opengl::ContextOwnership while it's current.
+*/
+class RenderThread {
+public:
+    RenderThread();
+    ~RenderThread();
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    /**
+    * Waits for the previous frame to finish, then invokes the given function on the render thread.
+    */
+    void submit(std::function<void()> frame);
+
+    /**
+    * Blocks until the submitted frame has finished.
+    */
+    void wait();
+
+    /**
+    * Returns true if the calling thread is the render thread.
+    */
+    bool isCurrent() const { return std::this_thread::get_id() == _thread.get_id(); }
+
+private:
+    void _run();
+
+    std::mutex              _mutex;
+    std::condition_variable _condition;
+    std::function<void()>   _frame;
+    bool                    _isBusy = false;
+    bool                    _shouldExit = false;
+    std::thread             _thread;
+};
+
+} // namespace okui
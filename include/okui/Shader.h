@@ -17,9 +17,13 @@
 
 #include <okui/config.h>
 
+#include <okui/BatchRenderer.h>
 #include <okui/blending.h>
+#include <okui/DisplayList.h>
+#include <okui/FrameProfiler.h>
 #include <okui/Point.h>
 #include <okui/opengl/ShaderProgram.h>
+#include <okui/opengl/StreamingVertexBuffer.h>
 #include <okui/AffineTransformation.h>
 
 #include <scraps/opengl/VertexArrayBuffer.h>
@@ -40,6 +44,14 @@ public:
         kCurveCircularConvex = 2,
     };
 
+    /**
+    * The bits of the blendingFlags uniform used by the provided fragment shaders.
+    */
+    enum BlendingFlags : GLint {
+        kBlendingFlagPremultipliedInput  = 1,
+        kBlendingFlagPremultipliedOutput = 2,
+    };
+
     /**
     * Draws a triangle. The shader may not actually render the triangle immediately. If you need
     * to render something on top of the triangle with another shader, make a call to flush() to
@@ -47,6 +59,33 @@ public:
     */
     virtual void drawTriangle(double x1, double y1, double x2, double y2, double x3, double y3, Curve curve = kCurveNone) = 0;
 
+    /**
+    * An axis-aligned rectangle for drawQuads.
+    */
+    struct Quad {
+        GLfloat x, y, width, height;
+
+        /**
+        * The area of the texture to draw, in normalized texture coordinates. Shaders without textures ignore this.
+        */
+        GLfloat s = 0.0f, t = 0.0f, textureWidth = 1.0f, textureHeight = 1.0f;
+    };
+
+    /**
+    * Draws many rectangles at once. The default implementation draws each one as two triangles, but shaders
+    * derived from ShaderBase generate the vertices for all of them in bulk.
+    */
+    virtual void drawQuads(const Quad* quads, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            auto& q = quads[i];
+            drawTriangle(q.x, q.y, q.x + q.width, q.y, q.x, q.y + q.height);
+            drawTriangle(q.x, q.y + q.height, q.x + q.width, q.y, q.x + q.width, q.y + q.height);
+        }
+    }
+
+    template <typename Quads>
+    void drawQuads(const Quads& quads) { drawQuads(quads.data(), quads.size()); }
+
     /**
     * Ensures that all triangles have been rendered.
     */
@@ -63,11 +102,6 @@ public:
 
     using Vertex = VertexType;
 
-    enum BlendingFlags : GLint {
-        kBlendingFlagPremultipliedInput  = 1,
-        kBlendingFlagPremultipliedOutput = 2,
-    };
-
     void setTransformation(const AffineTransformation& transformation) { _transformation = transformation; }
 
     virtual void drawTriangle(double x1, double y1, double x2, double y2, double x3, double y3, Curve curve) override {
@@ -92,10 +126,42 @@ public:
         _vertices.push_back(_triangle.c);
     }
 
+    using Shader::drawQuads;
+
+    virtual void drawQuads(const Quad* quads, size_t count) override {
+        // the corners of each quad, in the same order as shapes::Rectangle's triangles
+        constexpr size_t kCorners[] = {0, 1, 2, 2, 1, 3};
+
+        auto vertex = _triangle.a;
+        vertex.cm = kCurveNone;
+
+        auto first = _vertices.size();
+        _vertices.resize(first + count * 6, vertex);
+        auto out = &_vertices[first];
+
+        float x[4], y[4], xT[4], yT[4];
+        for (size_t i = 0; i < count; ++i, out += 6) {
+            auto& q = quads[i];
+            x[0] = x[2] = q.x;
+            x[1] = x[3] = q.x + q.width;
+            y[0] = y[1] = q.y;
+            y[2] = y[3] = q.y + q.height;
+            _transformation.transform4(x, y, xT, yT);
+            for (size_t j = 0; j < 6; ++j) {
+                out[j].x = xT[kCorners[j]];
+                out[j].y = yT[kCorners[j]];
+            }
+        }
+
+        _processQuads(&_vertices[first], quads, count);
+    }
+
 protected:
     opengl::ShaderProgram _program;
     std::vector<Vertex> _vertices;
     scraps::opengl::VertexArrayBuffer _vertexArrayBuffer;
+    opengl::StreamingVertexBuffer::VertexArray _streamingVertexArray;
+    GLint _firstVertex = 0;
     AffineTransformation _transformation;
     opengl::ShaderProgram::Uniform _blendingFlagsUniform;
 
@@ -138,33 +204,99 @@ protected:
         }
     };
 
+    /**
+    * Specifies a vertex attribute. Use this instead of setting attributes on the vertex array buffer directly so
+    * that the vertices can also be drawn from the window's streaming vertex buffer.
+    */
+    void _setAttribute(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, size_t offset) {
+        _vertexArrayBuffer.setAttribute(index, size, type, normalized, stride, offset);
+        _streamingVertexArray.setAttribute(index, size, type, normalized, stride, offset);
+    }
+
     /**
     * Override this to finalize the triangle before drawing.
     */
     virtual void _processTriangle(const std::array<Point<double>, 3>& p, const std::array<Point<double>, 3>& pT, Shader::Curve curve) {}
 
     /**
-    * Override this if you want to do something like draw multiple passes.
+    * Override this to finalize vertices generated by drawQuads. There are six vertices per quad, and their positions
+    * have already been transformed.
+    */
+    virtual void _processQuads(Vertex* vertices, const Quad* quads, size_t count) {}
+
+    /**
+    * Override this if you want to do something like draw multiple passes. The vertices begin at _firstVertex.
     */
     virtual void _draw() {
-        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(_vertices.size()));
+        glDrawArrays(GL_TRIANGLES, _firstVertex, static_cast<GLsizei>(_vertices.size()));
+        if (auto batch = BatchRenderer::Current()) {
+            batch->didDraw(_vertices.size());
+        }
+    }
+
+    /**
+    * Override this to hand the shader's current vertices to the batch renderer. Returns false if the shader can't
+    * be batched.
+    */
+    virtual bool _addToBatch(BatchRenderer* batch, bool inputHasPremultipliedAlpha) { return false; }
+
+    /**
+    * Returns a command that draws the shader's current vertices again. Shaders with state that isn't baked
+    * into the vertices should override this to capture it.
+    */
+    virtual DisplayList::Command _recordDraw(bool inputHasPremultipliedAlpha) {
+        return [this, vertices = _vertices, inputHasPremultipliedAlpha, blendFunction = Blending::Current()]() mutable {
+            Blending blending{blendFunction};
+            _vertices.swap(vertices);
+            _drawVertices(inputHasPremultipliedAlpha);
+            _vertices.swap(vertices);
+        };
     }
 
     void _flush(bool inputHasPremultipliedAlpha = false) {
         if (_vertices.empty()) { return; }
 
+        FrameProfiler::DidFlushShader();
+
+        if (auto displayList = DisplayList::Current()) {
+            displayList->append(_recordDraw(inputHasPremultipliedAlpha));
+        }
+
+        if (!DisplayList::IsDeferring()) {
+            _drawVertices(inputHasPremultipliedAlpha);
+        }
+
+        _vertices.clear();
+    }
+
+    void _drawVertices(bool inputHasPremultipliedAlpha) {
+        if (auto batch = BatchRenderer::Current()) {
+            if (batch->isEnabled() && _addToBatch(batch, inputHasPremultipliedAlpha)) {
+                return;
+            }
+            batch->flush();
+        }
+
         _program.use();
 
         _blendingFlagsUniform = (GLint)
             (Blending::Current().premultipliedSourceAlpha ? kBlendingFlagPremultipliedOutput : 0)
             | (inputHasPremultipliedAlpha ? kBlendingFlagPremultipliedInput : 0);
 
+        auto stream = opengl::StreamingVertexBuffer::Current();
+        if (auto first = stream ? stream->write(_vertices.data(), _vertices.size()) : stdts::nullopt) {
+            _firstVertex = *first;
+            _streamingVertexArray.bind(*stream);
+            _draw();
+            _streamingVertexArray.unbind();
+            _firstVertex = 0;
+            return;
+        }
+
         _vertexArrayBuffer.bind();
         _vertexArrayBuffer.stream(_vertices.data(), _vertices.size());
         _draw();
         _vertexArrayBuffer.unbind();
-
-        _vertices.clear();
     }
 };
 
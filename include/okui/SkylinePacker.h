@@ -0,0 +1,71 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <okui/Rectangle.h>
+
+#include <stdts/optional.h>
+
+#include <vector>
+
+namespace okui {
+
+/**
+* Packs rectangles into a fixed area using the skyline bottom-left heuristic.
+*
+* The packer tracks the top edge of the packed rectangles as a list of horizontal segments, and places each new
+* rectangle wherever its top edge would be lowest. Individual rectangles can't be freed. To reclaim space, clear
+* the packer and pack the remaining rectangles again.
+*/
+class SkylinePacker {
+public:
+    SkylinePacker(int width, int height);
+
+    int width() const { return _width; }
+    int height() const { return _height; }
+
+    /**
+    * Returns the position of the packed rectangle, or nullopt if there's no room for it.
+    */
+    stdts::optional<Rectangle<int>> pack(int width, int height);
+
+    void clear();
+
+    /**
+    * Returns the total area of the rectangles packed since the packer was last cleared.
+    */
+    size_t usedArea() const { return _usedArea; }
+
+private:
+    struct Segment {
+        int x, y, width;
+    };
+
+    /**
+    * Returns the y coordinate at which a rectangle would be placed if its left edge was aligned with the given
+    * segment, or nullopt if it doesn't fit there.
+    */
+    stdts::optional<int> _fit(size_t index, int width, int height) const;
+
+    int                  _width;
+    int                  _height;
+    std::vector<Segment> _skyline;
+    size_t               _usedArea = 0;
+};
+
+} // namespace okui
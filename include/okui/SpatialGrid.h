@@ -0,0 +1,229 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <okui/Rectangle.h>
+
+#include <stdts/optional.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace okui {
+
+/**
+* Indexes items by their bounds using a uniform grid so that the items at a point or within an area can be found
+* without visiting every item.
+*
+* Items without bounds, or with bounds spanning too many cells, are kept in a separate list and returned by every
+* query that they might match.
+*/
+template <typename T>
+class SpatialGrid {
+public:
+    static constexpr size_t kMaxCellsPerItem = 64;
+
+    explicit SpatialGrid(double cellSize = 256.0) : _cellSize{cellSize} {}
+
+    double cellSize() const { return _cellSize; }
+
+    /**
+    * Inserts the item or updates its bounds if it's already present. Items without bounds match every query.
+    */
+    void insert(const T& item, stdts::optional<Rectangle<double>> bounds);
+    void remove(const T& item);
+    void clear();
+
+    bool contains(const T& item) const { return _entries.count(item); }
+    size_t size() const { return _entries.size(); }
+
+    /**
+    * Appends the items whose bounds intersect the given area to results. Each item is appended once, in no
+    * particular order.
+    */
+    void query(const Rectangle<double>& area, std::vector<T>* results) const;
+
+    /**
+    * Appends the items whose bounds contain the given point to results, in no particular order.
+    */
+    void query(double x, double y, std::vector<T>* results) const;
+
+private:
+    struct CellRange {
+        int64_t minX, minY, maxX, maxY;
+        size_t count() const { return static_cast<size_t>(maxX - minX + 1) * (maxY - minY + 1); }
+    };
+
+    struct Entry {
+        stdts::optional<Rectangle<double>> bounds;
+        stdts::optional<CellRange>         cells; // nullopt if the item is in _unindexed
+        mutable size_t                     queryStamp = 0;
+    };
+
+    static uint64_t _CellKey(int64_t x, int64_t y) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+    }
+
+    int64_t _cell(double coordinate) const { return static_cast<int64_t>(std::floor(coordinate / _cellSize)); }
+    CellRange _cellRange(const Rectangle<double>& bounds) const;
+
+    void _unlink(const T& item, const Entry& entry);
+
+    double                                         _cellSize;
+    std::unordered_map<T, Entry>                   _entries;
+    std::unordered_map<uint64_t, std::vector<T>>   _cells;
+    std::vector<T>                                 _unindexed;
+    mutable size_t                                 _queryStamp = 0;
+};
+
+template <typename T>
+void SpatialGrid<T>::insert(const T& item, stdts::optional<Rectangle<double>> bounds) {
+    auto it = _entries.find(item);
+    if (it != _entries.end()) {
+        _unlink(item, it->second);
+    } else {
+        it = _entries.emplace(item, Entry{}).first;
+    }
+
+    auto& entry = it->second;
+    entry.bounds = bounds;
+    entry.cells = stdts::nullopt;
+
+    if (bounds) {
+        auto range = _cellRange(*bounds);
+        if (range.count() <= kMaxCellsPerItem) {
+            entry.cells = range;
+        }
+    }
+
+    if (!entry.cells) {
+        _unindexed.push_back(item);
+        return;
+    }
+
+    for (auto y = entry.cells->minY; y <= entry.cells->maxY; ++y) {
+        for (auto x = entry.cells->minX; x <= entry.cells->maxX; ++x) {
+            _cells[_CellKey(x, y)].push_back(item);
+        }
+    }
+}
+
+template <typename T>
+void SpatialGrid<T>::remove(const T& item) {
+    auto it = _entries.find(item);
+    if (it == _entries.end()) { return; }
+    _unlink(item, it->second);
+    _entries.erase(it);
+}
+
+template <typename T>
+void SpatialGrid<T>::clear() {
+    _entries.clear();
+    _cells.clear();
+    _unindexed.clear();
+}
+
+template <typename T>
+void SpatialGrid<T>::query(const Rectangle<double>& area, std::vector<T>* results) const {
+    auto stamp = ++_queryStamp;
+
+    auto visit = [&](const T& item) {
+        auto& entry = _entries.find(item)->second;
+        if (entry.queryStamp == stamp) { return; }
+        entry.queryStamp = stamp;
+        if (!entry.bounds || entry.bounds->intersects(area)) {
+            results->push_back(item);
+        }
+    };
+
+    for (auto& item : _unindexed) {
+        visit(item);
+    }
+
+    auto range = _cellRange(area);
+    if (range.count() > _cells.size()) {
+        // the area covers more cells than are occupied, so it's cheaper to visit the occupied ones
+        for (auto& cell : _cells) {
+            for (auto& item : cell.second) {
+                visit(item);
+            }
+        }
+        return;
+    }
+
+    for (auto y = range.minY; y <= range.maxY; ++y) {
+        for (auto x = range.minX; x <= range.maxX; ++x) {
+            auto cell = _cells.find(_CellKey(x, y));
+            if (cell == _cells.end()) { continue; }
+            for (auto& item : cell->second) {
+                visit(item);
+            }
+        }
+    }
+}
+
+template <typename T>
+void SpatialGrid<T>::query(double x, double y, std::vector<T>* results) const {
+    for (auto& item : _unindexed) {
+        auto& entry = _entries.find(item)->second;
+        if (!entry.bounds || entry.bounds->contains(x, y)) {
+            results->push_back(item);
+        }
+    }
+
+    auto cell = _cells.find(_CellKey(_cell(x), _cell(y)));
+    if (cell == _cells.end()) { return; }
+
+    for (auto& item : cell->second) {
+        if (_entries.find(item)->second.bounds->contains(x, y)) {
+            results->push_back(item);
+        }
+    }
+}
+
+template <typename T>
+typename SpatialGrid<T>::CellRange SpatialGrid<T>::_cellRange(const Rectangle<double>& bounds) const {
+    // the maximum edges are exclusive
+    auto maxX = std::max(bounds.minX(), std::nextafter(bounds.maxX(), bounds.minX()));
+    auto maxY = std::max(bounds.minY(), std::nextafter(bounds.maxY(), bounds.minY()));
+    return {_cell(bounds.minX()), _cell(bounds.minY()), _cell(maxX), _cell(maxY)};
+}
+
+template <typename T>
+void SpatialGrid<T>::_unlink(const T& item, const Entry& entry) {
+    if (!entry.cells) {
+        _unindexed.erase(std::find(_unindexed.begin(), _unindexed.end(), item));
+        return;
+    }
+
+    for (auto y = entry.cells->minY; y <= entry.cells->maxY; ++y) {
+        for (auto x = entry.cells->minX; x <= entry.cells->maxX; ++x) {
+            auto cell = _cells.find(_CellKey(x, y));
+            auto& items = cell->second;
+            items.erase(std::find(items.begin(), items.end(), item));
+            if (items.empty()) {
+                _cells.erase(cell);
+            }
+        }
+    }
+}
+
+} // namespace okui
@@ -0,0 +1,127 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <okui/Rectangle.h>
+#include <okui/SkylinePacker.h>
+#include <okui/opengl/opengl.h>
+
+#include <memory>
+#include <vector>
+
+namespace okui {
+
+/**
+* Packs small images into shared texture pages so that they can be drawn without changing textures.
+*
+* Pages are allocated as needed, up to a maximum. Space is reclaimed as allocations are released: pages that
+* become empty are freed by collectGarbage, and when a new image doesn't fit, the page with the most released
+* space is repacked. Repacking moves allocations within their page, which invalidates any texture coordinates
+* recorded for them. generation() is incremented whenever that happens.
+*
+* Pages don't have mipmaps, so the atlas is best suited to images that are drawn at roughly their natural size.
+*/
+class TextureAtlas {
+public:
+    class Allocation;
+
+    static constexpr int kDefaultPageSize = 1024;
+    static constexpr int kDefaultMaxEntrySize = 128;
+    static constexpr size_t kDefaultMaxPages = 4;
+
+    explicit TextureAtlas(int pageSize = kDefaultPageSize);
+    TextureAtlas(const TextureAtlas&) = delete;
+    TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+    int pageSize() const { return _pageSize; }
+
+    int maxEntrySize() const { return _maxEntrySize; }
+    void setMaxEntrySize(int maxEntrySize) { _maxEntrySize = maxEntrySize; }
+
+    size_t maxPages() const { return _maxPages; }
+    void setMaxPages(size_t maxPages) { _maxPages = maxPages; }
+
+    size_t pageCount() const { return _pages.size(); }
+
+    /**
+    * Returns true if an image of the given size is small enough to be packed.
+    */
+    bool accepts(int width, int height) const;
+
+    /**
+    * Requires the render context to be active.
+    *
+    * Packs and uploads an 8-bit RGBA image with tightly packed rows. Returns nullptr if the atlas is full.
+    *
+    * The image's space is released when the returned allocation is destroyed. Allocations may outlive the atlas.
+    */
+    std::shared_ptr<Allocation> add(int width, int height, const uint8_t* pixels);
+
+    /**
+    * Requires the render context to be active.
+    *
+    * Frees pages that no longer contain any images.
+    */
+    void collectGarbage();
+
+    /**
+    * Incremented whenever allocations are moved.
+    */
+    size_t generation() const { return _generation; }
+
+private:
+    struct Page;
+
+    std::shared_ptr<Page> _createPage();
+    bool _defragment(Page* page);
+
+    int                                _pageSize;
+    int                                _maxEntrySize = kDefaultMaxEntrySize;
+    size_t                             _maxPages = kDefaultMaxPages;
+    std::vector<std::shared_ptr<Page>> _pages;
+    size_t                             _generation = 0;
+};
+
+class TextureAtlas::Allocation {
+public:
+    Allocation(std::shared_ptr<Page> page, const Rectangle<int>& bounds, std::vector<uint8_t> pixels);
+    ~Allocation();
+
+    /**
+    * Returns the id of the page's GPU texture.
+    */
+    GLuint texture() const;
+
+    /**
+    * Returns the region of the page occupied by the image, in normalized texture coordinates.
+    */
+    const Rectangle<double>& coordinates() const { return _coordinates; }
+
+private:
+    friend class TextureAtlas;
+
+    void _place(const Rectangle<int>& bounds);
+    void _upload() const;
+
+    std::shared_ptr<Page> _page;
+    Rectangle<int>        _bounds; // includes the padding
+    Rectangle<double>     _coordinates;
+    std::vector<uint8_t>  _pixels; // padded copy, kept so that the image can be moved when its page is repacked
+};
+
+} // namespace okui
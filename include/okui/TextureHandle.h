@@ -21,6 +21,9 @@
 
 #include <scraps/Cache.h>
 
+#include <list>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace okui {
@@ -77,6 +80,10 @@ namespace scraps {
 
 /**
 * Thread-safe.
+*
+* Without a budget, unreferenced entries are removed as soon as another entry is added. With one, they're kept for
+* reuse until the GPU memory used by the cache's textures exceeds it, and then the least recently used ones are
+* evicted. Entries kept forever are only evicted if evicting every other unreferenced entry isn't enough.
 */
 template <>
 class Cache<okui::TextureHandle> {
@@ -87,11 +94,34 @@ public:
         kKeepForever,
     };
 
+    struct Statistics {
+        size_t hits      = 0;
+        size_t misses    = 0;
+        size_t evictions = 0;
+    };
+
     /**
-    * Gets the given entry from the cache if it exists.
+    * Gets the given entry from the cache if it exists and marks it as the most recently used.
     */
     template <typename T>
     okui::TextureHandle get(T&& hashable) {
+        auto hash = std::hash<std::remove_cv_t<std::remove_reference_t<T>>>()(std::forward<T>(hashable));
+        std::lock_guard<std::mutex> l(_mutex);
+        auto it = _entries.find(hash);
+        if (it == _entries.end()) {
+            ++_statistics.misses;
+            return nullptr;
+        }
+        ++_statistics.hits;
+        _useOrder.splice(_useOrder.end(), _useOrder, it->second.useOrderPosition);
+        return it->second.entry.newHandle();
+    }
+
+    /**
+    * Like get, but doesn't count as a use. The entry's recency and the cache's statistics are unaffected.
+    */
+    template <typename T>
+    okui::TextureHandle find(T&& hashable) {
         auto hash = std::hash<std::remove_cv_t<std::remove_reference_t<T>>>()(std::forward<T>(hashable));
         std::lock_guard<std::mutex> l(_mutex);
         auto it = _entries.find(hash);
@@ -127,18 +157,37 @@ public:
             return it->second.entry.newHandle();
         }
 
-        _removeUnreferenced();
+        if (_budget) {
+            _evict(_budget);
+        } else {
+            _removeUnreferenced();
+        }
 
-        _entries[hash] = {entry.newHandle(), policy};
+        auto bytes = entry->gpuBytes();
+        _bytes += bytes;
+        _entries[hash] = {entry.newHandle(), policy, _useOrder.insert(_useOrder.end(), hash), bytes};
         return std::move(entry);
     }
 
+    /**
+    * Returns true if the given entry exists and is either referenced outside of the cache or kept forever.
+    */
+    template <typename T>
+    bool isReferenced(T&& hashable) {
+        auto hash = std::hash<std::remove_cv_t<std::remove_reference_t<T>>>()(std::forward<T>(hashable));
+        std::lock_guard<std::mutex> l(_mutex);
+        auto it = _entries.find(hash);
+        return it != _entries.end() && (!it->second.entry.unique() || it->second.policy == kKeepForever);
+    }
+
     /**
     * Removes all entries from the cache.
     */
     void clear() {
         std::lock_guard<std::mutex> l(_mutex);
         _entries.clear();
+        _useOrder.clear();
+        _bytes = 0;
     }
 
     /**
@@ -148,7 +197,10 @@ public:
     void remove(T&& hashable) {
         auto hash = std::hash<std::remove_cv_t<std::remove_reference_t<T>>>()(std::forward<T>(hashable));
         std::lock_guard<std::mutex> l(_mutex);
-        _entries.erase(hash);
+        auto it = _entries.find(hash);
+        if (it != _entries.end()) {
+            _erase(it);
+        }
     }
 
     /**
@@ -159,6 +211,82 @@ public:
         _removeUnreferenced();
     }
 
+    /**
+    * Removes every unreferenced entry, including those kept forever. This is intended for low memory situations.
+    */
+    void purge() {
+        std::lock_guard<std::mutex> l(_mutex);
+        for (auto it = _entries.begin(); it != _entries.end();) {
+            if (it->second.entry.unique()) {
+                ++_statistics.evictions;
+                it = _erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    /**
+    * The number of bytes of GPU memory that the cache's textures should stay within, or 0 for no budget.
+    */
+    size_t budget() const {
+        std::lock_guard<std::mutex> l(_mutex);
+        return _budget;
+    }
+
+    void setBudget(size_t budget) {
+        std::lock_guard<std::mutex> l(_mutex);
+        _budget = budget;
+        if (_budget) {
+            _evict(_budget);
+        }
+    }
+
+    /**
+    * The cache keeps a running total of its textures' GPU memory. This should be invoked whenever an entry's texture
+    * is loaded so that the total reflects it.
+    */
+    template <typename T>
+    void updateBytes(T&& hashable) {
+        auto hash = std::hash<std::remove_cv_t<std::remove_reference_t<T>>>()(std::forward<T>(hashable));
+        std::lock_guard<std::mutex> l(_mutex);
+        auto it = _entries.find(hash);
+        if (it != _entries.end()) {
+            auto bytes = it->second.entry->gpuBytes();
+            _bytes = _bytes - it->second.bytes + bytes;
+            it->second.bytes = bytes;
+        }
+    }
+
+    /**
+    * Evicts entries if the cache exceeds its budget. Textures only use GPU memory once they're loaded, so this should
+    * be invoked after loading them.
+    */
+    void enforceBudget() {
+        std::lock_guard<std::mutex> l(_mutex);
+        if (_budget) {
+            _evict(_budget);
+        }
+    }
+
+    /**
+    * Returns the GPU memory used by the cache's textures, in bytes, as of when they were added or last updated.
+    */
+    size_t bytes() {
+        std::lock_guard<std::mutex> l(_mutex);
+        return _bytes;
+    }
+
+    Statistics statistics() const {
+        std::lock_guard<std::mutex> l(_mutex);
+        return _statistics;
+    }
+
+    void resetStatistics() {
+        std::lock_guard<std::mutex> l(_mutex);
+        _statistics = {};
+    }
+
     /**
     * Returns the number of entries currently in the cache.
     */
@@ -171,20 +299,51 @@ private:
     struct EntryInfo {
         okui::TextureHandle entry;
         Policy policy;
+        std::list<size_t>::iterator useOrderPosition;
+        size_t bytes; // the entry's gpu memory as of when it was added or last updated
     };
 
+    using Entries = std::unordered_map<size_t, EntryInfo>;
+
+    Entries::iterator _erase(Entries::iterator it) {
+        _bytes -= it->second.bytes;
+        _useOrder.erase(it->second.useOrderPosition);
+        return _entries.erase(it);
+    }
+
     void _removeUnreferenced() {
         for (auto it = _entries.begin(); it != _entries.end();) {
             if (it->second.entry.unique() && it->second.policy == kRemoveUnreferenced) {
-                it = _entries.erase(it);
+                ++_statistics.evictions;
+                it = _erase(it);
             } else {
                 ++it;
             }
         }
     }
 
+    /**
+    * Evicts unreferenced entries, least recently used first, until the cache is within the given number of bytes.
+    * Entries that aren't using any memory yet are left alone.
+    */
+    void _evict(size_t maxBytes) {
+        for (auto policy : {kRemoveUnreferenced, kKeepForever}) {
+            for (auto it = _useOrder.begin(); it != _useOrder.end() && _bytes > maxBytes;) {
+                auto entry = _entries.find(*it);
+                ++it;
+                if (entry->second.policy != policy || !entry->second.entry.unique() || !entry->second.bytes) { continue; }
+                ++_statistics.evictions;
+                _erase(entry);
+            }
+        }
+    }
+
     mutable std::mutex _mutex;
-    std::unordered_map<size_t, EntryInfo> _entries;
+    Entries            _entries;
+    std::list<size_t>  _useOrder; // least recently used first
+    size_t             _budget = 0;
+    size_t             _bytes = 0;
+    Statistics         _statistics;
 };
 
 } // namespace scraps
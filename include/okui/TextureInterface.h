@@ -17,9 +17,12 @@
 
 #include <okui/config.h>
 
+#include <okui/Rectangle.h>
 #include <okui/opengl/opengl.h>
 #include <okui/opengl/TextureCache.h>
 
+#include <cstddef>
+
 namespace okui {
 
 class TextureInterface {
@@ -57,6 +60,18 @@ public:
     virtual int allocatedWidth() const { return width(); }
     virtual int allocatedHeight() const { return height(); }
 
+    /**
+    * Returns an estimate of the GPU memory used by the texture, in bytes. Textures that share a GPU texture, such as
+    * those packed into an atlas, only count the region they occupy.
+    */
+    virtual size_t gpuBytes() const { return isLoaded() ? static_cast<size_t>(allocatedWidth()) * allocatedHeight() * 4 : 0; }
+
+    /**
+    * Returns the region of the GPU texture occupied by the texture, in normalized texture coordinates. This is
+    * only a subregion for textures that share a GPU texture, such as those packed into an atlas.
+    */
+    virtual Rectangle<double> region() const { return {0.0, 0.0, 1.0, 1.0}; }
+
     /**
     * If loaded, returns the id of the GPU texture. Otherwise, returns 0.
     */
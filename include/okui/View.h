@@ -20,15 +20,21 @@
 #include <okui/opengl/Framebuffer.h>
 #include <okui/shaders/ColorShader.h>
 #include <okui/shaders/DistanceFieldShader.h>
+#include <okui/shaders/ShapeShader.h>
 #include <okui/shaders/TextureShader.h>
 #include <okui/Application.h>
 #include <okui/Color.h>
+#include <okui/DecodePool.h>
+#include <okui/Direction.h>
+#include <okui/DisplayList.h>
 #include <okui/Point.h>
 #include <okui/Rectangle.h>
+#include <okui/RenderCachePool.h>
 #include <okui/RenderTarget.h>
 #include <okui/Relation.h>
 #include <okui/Responder.h>
 #include <okui/ShaderCache.h>
+#include <okui/SpatialGrid.h>
 #include <okui/TextureHandle.h>
 #include <okui/TouchpadFocus.h>
 #include <okui/WeakTexture.h>
@@ -44,6 +50,7 @@
 #include <list>
 #include <typeindex>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace okui {
 
@@ -235,7 +242,7 @@ public:
     /**
     * @param rendersToTexture if true, the view is rendered to a texture, making it available via renderTexture
     */
-    void setRendersToTexture(bool rendersToTexture = true) { _rendersToTexture = rendersToTexture; }
+    void setRendersToTexture(bool rendersToTexture = true);
 
     /**
     * If the view is set to render to a texture, this can be used to obtain said texture.
@@ -249,20 +256,53 @@ public:
     void setCachesRender(bool cachesRender = true) { _cachesRender = cachesRender; }
 
     /**
-    * Invalidates the view's render cache.
+    * @param retains if true, the draws made by the render() method are recorded into a display list, which is
+    *                replayed until the render cache is invalidated. Unlike setCachesRender, this doesn't require
+    *                a framebuffer. The view's render() method should only draw via okui shaders and shouldn't
+    *                render other views or change OpenGL state other than blending.
+    */
+    void setRetainsRender(bool retains = true);
+    bool retainsRender() const { return _retainsRender; }
+
+    /**
+    * Invalidates the view's render cache. The area occupied by the view is marked as damaged in its window.
     */
     void invalidateRenderCache();
 
     /**
     * @param clipsToBounds if true, the view will not render itself or any subviews outside of its bounds
     */
-    void setClipsToBounds(bool clipsToBounds = true) { _clipsToBounds = clipsToBounds; }
+    void setClipsToBounds(bool clipsToBounds = true);
 
     /**
     * @return if true, the view will not render itself or any subviews outside of its bounds
     */
     bool clipsToBounds() const { return _clipsToBounds; }
 
+    /**
+    * @param isOpaque if true, the view promises to cover its bounds with opaque pixels, allowing the views behind
+    *                 it to be skipped when they're completely covered
+    */
+    void setIsOpaque(bool isOpaque = true) { _isOpaque = isOpaque; }
+
+    /**
+    * Returns true if the view covers its bounds with opaque pixels. Views with opaque background colors are
+    * opaque unless their tint makes them translucent.
+    */
+    bool isOpaque() const { return _tintColor.alpha() == 255 && (_isOpaque || _backgroundColor.alpha() == 255); }
+
+    static constexpr double kDefaultSpatialIndexCellSize = 256.0;
+
+    /**
+    * If enabled, the view indexes its subviews by their bounds so that hit-testing and rendering don't need to
+    * visit every subview. This is worthwhile for views with many subviews. Subviews that clip to their bounds
+    * are expected to only be hit within their bounds.
+    *
+    * @param cellSize the size of the index's grid cells, in the view's coordinates
+    */
+    void setUsesSpatialIndex(bool usesSpatialIndex = true, double cellSize = kDefaultSpatialIndexCellSize);
+    bool usesSpatialIndex() const { return _spatialIndex != nullptr; }
+
     /**
     * Returns true if the mouse is hovering directly over this view.
     */
@@ -271,15 +311,29 @@ public:
     shaders::ColorShader* colorShader() { return shader<shaders::ColorShader>("color shader"); }
     shaders::TextureShader* textureShader() { return shader<shaders::TextureShader>("texture shader"); }
     shaders::DistanceFieldShader* distanceFieldShader() { return shader<shaders::DistanceFieldShader>("distance field shader"); }
+    shaders::ShapeShader* shapeShader() { return shader<shaders::ShapeShader>("shape shader"); }
 
     /**
     * Begins loading a texture associated with the view. When the texture is loaded, the view's
     * render cache will be invalidated. If the texture should not be associated with the view,
     * use Window::loadTexture* instead.
+    *
+    * See Window::loadTexture* for the meaning of the target size.
+    */
+    TextureHandle loadTextureResource(const std::string& name, Point<int> targetSize = {});
+    TextureHandle loadTextureFromMemory(std::shared_ptr<const std::string> data, Point<int> targetSize = {});
+    TextureHandle loadTextureFromURL(const std::string& url, Point<int> targetSize = {});
+
+    /**
+    * Returns the size of the view's window bounds in render target pixels, or zero if the view isn't in a window.
+    */
+    Point<int> pixelSize() const;
+
+    /**
+    * Returns the priority that the view's textures are decoded with. By default, views within the window's bounds
+    * are decoded first, followed by views that are just outside of them, such as those scrolled off screen.
     */
-    TextureHandle loadTextureResource(const std::string& name);
-    TextureHandle loadTextureFromMemory(std::shared_ptr<const std::string> data);
-    TextureHandle loadTextureFromURL(const std::string& url);
+    virtual DecodePool::Priority decodePriority() const;
 
     /**
     * Get or create a shader cached via the window's shader cache.
@@ -444,6 +498,12 @@ public:
     */
     void addUpdateHook(const std::string& handle, std::function<void()> hook);
 
+    /**
+    * The hook provided here will be called before rendering each frame with the time at which the frame is
+    * expected to be presented.
+    */
+    void addUpdateHook(const std::string& handle, std::function<void(std::chrono::steady_clock::time_point)> hook);
+
     /**
     * The hook provided here will no longer be called.
     */
@@ -467,10 +527,24 @@ public:
     virtual void postRender(std::shared_ptr<TextureInterface> texture, const AffineTransformation& transformation);
 
     /**
-    * Override this to lay out subviews whenever the view is resized.
+    * Override this to lay out subviews whenever the view is resized or setNeedsLayout is invoked.
+    *
+    * Layout is deferred. Windows lay out their views top-down once per frame, after updates and before rendering,
+    * so each view is laid out at most once per frame no matter how many times it's invalidated.
     */
     virtual void layout() {}
 
+    /**
+    * Marks the view as needing to be laid out during the next layout pass.
+    */
+    void setNeedsLayout();
+    bool needsLayout() const { return _needsLayout; }
+
+    /**
+    * Immediately lays out the view and any of its descendants that need it.
+    */
+    void layoutIfNeeded();
+
     /**
     * Override this to do any sort of setup that requires the view to be attached to a window.
     */
@@ -514,6 +588,13 @@ public:
     */
     virtual void focusChanged() {}
 
+    /**
+    * Called on the focused view and each of its ancestors before the window moves focus in the given
+    * direction. Views that create their subviews lazily can override this to create the ones that focus
+    * may move to.
+    */
+    virtual void focusWillMove(Direction direction) {}
+
     /**
     * Called before the view and all of its ancestors become visible in the window.
     */
@@ -587,6 +668,18 @@ private:
     void _setBounds(const Rectangle<double>& bounds);
 
     void _invalidateSuperviewRenderCache();
+    void _releaseRenderCache();
+
+    /**
+    * Invalidates the render cache of the view and its ancestors for the given local area. If the area is
+    * unbounded, it extends to the nearest ancestor that clips to its bounds.
+    */
+    void _invalidateRenderCache(Rectangle<double> area, bool isUnbounded);
+
+    /**
+    * Returns the area within the superview that the view renders to.
+    */
+    Rectangle<double> _superviewRenderArea(const Rectangle<double>& area) const;
 
     void _dispatchFutureVisibilityChange(bool visible);
     void _dispatchVisibilityChange(bool visible);
@@ -595,7 +688,29 @@ private:
 
     void _updateFocusableRegions(std::vector<std::tuple<View*, Rectangle<double>>>& regions);
 
-    bool _requiresTextureRendering();
+    bool _requiresTextureRendering() const;
+
+    /**
+    * Returns the pixel area the subview occupies when the view occupies the given area.
+    */
+    Rectangle<int> _subviewArea(const View* subview, const Rectangle<int>& area) const;
+
+    /**
+    * Returns the pixel area that the view and its subviews may draw to when the view occupies the given area.
+    */
+    Rectangle<int> _renderExtent(const Rectangle<int>& area) const;
+
+    /**
+    * Updates the view's entry in its superview's spatial index.
+    */
+    void _updateSpatialIndexEntry();
+
+    /**
+    * Returns the first subview, from front to back, that might contain the given point and satisfies the
+    * predicate.
+    */
+    template <typename Predicate>
+    View* _findSubview(double x, double y, Predicate&& predicate);
     void _renderAndRenderSubviews(const RenderTarget* target, const Rectangle<int>& area, bool shouldClear = false, stdts::optional<Rectangle<int>> clipBounds = stdts::nullopt);
 
     void _post(std::type_index index, const void* ptr, Relation relation);
@@ -609,6 +724,7 @@ private:
     scraps::AbstractTaskScheduler* _taskScheduler() const;
     void _updateTouchFocus(std::chrono::high_resolution_clock::duration elapsed);
 
+    void _setSubviewsNeedLayout();
     void _checkUpdateSubscription();
     bool _shouldSubscribeToUpdates();
 
@@ -617,9 +733,13 @@ private:
     bool _rendersToTexture              = false;
     bool _cachesRender                  = false;
     bool _hasCachedRender               = false;
+    bool _retainsRender                 = false;
     bool _clipsToBounds                 = true;
+    bool _isOpaque                      = false;
     bool _interceptsInteractions        = true;
     bool _childrenInterceptInteractions = true;
+    bool _needsLayout                   = false;
+    bool _subviewsNeedLayout            = false;
 
     Window* _window                     = nullptr;
     View*   _subviewWithMouse           = nullptr;
@@ -633,14 +753,24 @@ private:
     Color                _tintColor = Color::kWhite;
     AffineTransformation _renderTransformation;
 
-    std::unique_ptr<opengl::Framebuffer> _renderCache;
-    opengl::Framebuffer::Attachment*     _renderCacheColorAttachment = nullptr;
-    std::shared_ptr<WeakTexture>         _renderCacheTexture = std::make_shared<WeakTexture>();
+    std::shared_ptr<RenderCachePool::Surface> _renderCache;
+    int                                       _renderCacheWidth = 0;
+    int                                       _renderCacheHeight = 0;
+    std::shared_ptr<WeakTexture>              _renderCacheTexture = std::make_shared<WeakTexture>();
+    stdts::optional<Rectangle<double>>        _renderCacheDamage;
+    stdts::optional<DisplayList>              _displayList;
+    AffineTransformation                      _displayListTransformation;
+
+    std::unique_ptr<SpatialGrid<View*>>  _spatialIndex;
+    int64_t                              _spatialIndexOrder = 0; // larger is closer to the front
+    int64_t                              _spatialIndexFront = 0;
+    int64_t                              _spatialIndexBack = 0;
+    std::unordered_set<View*>            _subviewsRenderingToTexture; // always rendered, even if outside the index's query
 
     std::list<Listener>                               _listeners;
     std::list<Provision>                              _provisions;
     TouchpadFocus                                     _touchpadFocus;
-    std::unordered_map<size_t, std::function<void()>> _updateHooks;
+    std::unordered_map<size_t, std::function<void(std::chrono::steady_clock::time_point)>> _updateHooks;
 
     scraps::AbstractTaskScheduler::TaskScope          _taskScope; /* must be the last member */
 };
@@ -23,16 +23,25 @@ namespace okui {
 
 class WeakTexture : public TextureInterface {
 public:
-    void set(GLuint id = 0, int width = 0, int height = 0, bool hasPremultipliedAlpha = false) {
+    /**
+    * If the texture is larger than the image it contains, the image is expected to be in its bottom-left corner
+    * and allocatedWidth and allocatedHeight should give the size of the texture.
+    */
+    void set(GLuint id = 0, int width = 0, int height = 0, bool hasPremultipliedAlpha = false, int allocatedWidth = 0, int allocatedHeight = 0) {
         _id = id;
         _width = width;
         _height = height;
         _hasPremultipliedAlpha = hasPremultipliedAlpha;
+        _allocatedWidth = allocatedWidth ? allocatedWidth : width;
+        _allocatedHeight = allocatedHeight ? allocatedHeight : height;
     }
 
     virtual int width() const override { return _width; }
     virtual int height() const override { return _height; }
 
+    virtual int allocatedWidth() const override { return _allocatedWidth; }
+    virtual int allocatedHeight() const override { return _allocatedHeight; }
+
     virtual GLuint id() const override { return _id; }
 
     virtual bool hasPremultipliedAlpha() const override { return _hasPremultipliedAlpha; }
@@ -40,6 +49,8 @@ public:
 private:
     int    _width = 0;
     int    _height = 0;
+    int    _allocatedWidth = 0;
+    int    _allocatedHeight = 0;
     GLuint _id = 0;
     bool   _hasPremultipliedAlpha{false};
 };
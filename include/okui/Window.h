@@ -17,19 +17,28 @@
 
 #include <okui/config.h>
 
+#include <okui/BatchRenderer.h>
+#include <okui/DamageRegion.h>
+#include <okui/DecodePool.h>
 #include <okui/DialogButton.h>
 #include <okui/Direction.h>
+#include <okui/FramePacer.h>
+#include <okui/FrameProfiler.h>
 #include <okui/Menu.h>
 #include <okui/Point.h>
+#include <okui/RenderCachePool.h>
+#include <okui/RenderThread.h>
 #include <okui/Responder.h>
 #include <okui/ShaderCache.h>
 #include <okui/BitmapFont.h>
 #include <okui/FileTexture.h>
 #include <okui/View.h>
+#include <okui/TextureAtlas.h>
 #include <okui/TextureHandle.h>
+#include <okui/opengl/ProgramBinaryCache.h>
 
-#include <scraps/TaskThread.h>
-
+#include <deque>
+#include <functional>
 #include <future>
 #include <unordered_map>
 #include <unordered_set>
@@ -111,11 +120,254 @@ public:
 
     double framesPerSecond() const { return _framesPerSecond; }
 
+    enum class RedrawMode {
+        kFull,    // the entire window is cleared and redrawn each frame
+        kDamaged, // only damaged regions are redrawn, and cached views only re-render their damaged areas
+    };
+
+    /**
+    * In the damaged redraw mode, rendering is scissored to the regions invalidated by views since the back
+    * buffer was last drawn to. This requires the platform to preserve the back buffer's contents between
+    * frames (see setBackBufferAge).
+    */
+    RedrawMode redrawMode() const { return _redrawMode; }
+    void setRedrawMode(RedrawMode mode);
+
+    /**
+    * The number of frames old the back buffer's contents are when rendering begins. For a platform that
+    * preserves the back buffer, this is 1. For typical double buffering, this is 2.
+    */
+    int backBufferAge() const { return _backBufferAge; }
+    void setBackBufferAge(int age);
+
+    /**
+    * Marks a region of the window, in content view coordinates, as needing to be redrawn.
+    */
+    void invalidateRegion(const Rectangle<double>& region);
+
+    /**
+    * Marks the entire window as needing to be redrawn.
+    */
+    void invalidate();
+
+    /**
+    * Returns the region invalidated since the last frame was rendered.
+    */
+    const DamageRegion& damagedRegion() const { return _damagedRegion; }
+
+    /**
+    * When rendering on demand, the application only updates and renders the window when something may have
+    * changed: a region was invalidated, a view is subscribed to updates, or a texture is ready to be loaded.
+    * Window::update is only invoked for frames that are rendered.
+    */
+    bool rendersOnDemand() const { return _rendersOnDemand; }
+    void setRendersOnDemand(bool rendersOnDemand = true);
+
+    /**
+    * Returns true if the window has changes that haven't been rendered yet.
+    */
+    bool needsDisplay() const;
+
+    enum class VerticalSync {
+        kDefault,  // the platform's default swap interval is used
+        kDisabled, // buffers are swapped immediately
+        kEnabled,  // buffer swaps wait for the vertical blank
+        kAdaptive, // buffer swaps wait for the vertical blank unless the frame is late, if supported
+    };
+
+    VerticalSync verticalSync() const { return _verticalSync; }
+    void setVerticalSync(VerticalSync verticalSync) { _verticalSync = verticalSync; }
+
+    /**
+    * The frame pacer decides when the window's frames begin. It can be used to change the window's target
+    * frame rate or to enable the adaptive half rate fallback.
+    */
+    FramePacer<>& framePacer() { return _framePacer; }
+    const FramePacer<>& framePacer() const { return _framePacer; }
+
+    /**
+    * During updates, returns the time at which the frame being updated is expected to be presented.
+    * Animations should generally be evaluated at this time rather than the current time.
+    */
+    std::chrono::steady_clock::time_point predictedPresentationTime() const { return _framePacer.predictedPresentationTime(); }
+
+    /**
+    * Returns true if textures are being downloaded or decompressed for the window. Once they're ready,
+    * the window will need display.
+    */
+    bool hasPendingTextures() const;
+
+    /**
+    * Limits the textures uploaded each frame so that many textures finishing decoding at once don't cause a long
+    * frame. Once either the byte or time budget is exceeded, the remaining textures are uploaded on subsequent
+    * frames. At least one texture is uploaded per frame.
+    */
+    size_t textureUploadByteBudget() const { return _textureUploadByteBudget; }
+    std::chrono::microseconds textureUploadTimeBudget() const { return _textureUploadTimeBudget; }
+    void setTextureUploadBudget(size_t bytes, std::chrono::microseconds time) { _textureUploadByteBudget = bytes; _textureUploadTimeBudget = time; }
+
+    /**
+    * Returns the number of decoded textures waiting to be uploaded, including those that have been staged.
+    */
+    size_t pendingTextureUploads() const { return _texturesToUpload.size() + _stagedTextureUploads.size(); }
+
+    /**
+    * If enabled and supported, uncompressed texture data is copied into a pixel unpack buffer in one frame and
+    * uploaded from it in the next, so that the driver can transfer the data in between. Staged textures finish loading
+    * a frame later than they otherwise would. This is enabled by default.
+    */
+    bool stagesTextureUploads() const { return _stagesTextureUploads; }
+    void setStagesTextureUploads(bool stagesTextureUploads = true) { _stagesTextureUploads = stagesTextureUploads; }
+
+    /**
+    * If enabled, draws made by okui's color and texture shaders are merged across views into as few draw calls
+    * as possible. Views that make OpenGL draw calls of their own must invoke BatchRenderer::Flush() first.
+    */
+    bool batchesDraws() const { return _batchRenderer.isEnabled(); }
+    void setBatchesDraws(bool batchesDraws = true) { _batchRenderer.setEnabled(batchesDraws); }
+
+    /**
+    * Returns the draw call statistics for the last frame rendered.
+    */
+    const BatchRenderer::Statistics& drawStatistics() const { return _batchRenderer.statistics(); }
+
+    /**
+    * If enabled, okui's shaders write their vertices into a ring buffer shared by the whole window rather than
+    * re-specifying a buffer for every draw. This is enabled by default.
+    */
+    bool streamsVertices() const { return _streamsVertices; }
+    void setStreamsVertices(bool streamsVertices = true) { _streamsVertices = streamsVertices; }
+
+    /**
+    * If enabled, linked shader programs are saved to the application's user storage path and loaded from there
+    * instead of being compiled from source. This is enabled by default.
+    */
+    bool cachesProgramBinaries() const { return _cachesProgramBinaries; }
+    void setCachesProgramBinaries(bool cachesProgramBinaries = true);
+
+    /**
+    * Returns the window's program binary cache, or nullptr if it isn't caching program binaries.
+    */
+    opengl::ProgramBinaryCache* programBinaryCache() const { return _programBinaryCache.get(); }
+
     ShaderCache* shaderCache() { return &_shaderCache; }
 
-    TextureHandle loadTextureResource(const std::string& name);
-    TextureHandle loadTextureFromMemory(std::shared_ptr<const std::string> data);
-    TextureHandle loadTextureFromURL(const std::string& url);
+    static constexpr size_t kDefaultTextureCacheBudget = 128 * 1024 * 1024;
+
+    /**
+    * The cache that loaded textures are shared through. Unreferenced textures are kept for reuse until the GPU memory
+    * used by the cache exceeds its budget, which is kDefaultTextureCacheBudget by default.
+    */
+    scraps::Cache<TextureHandle>* textureCache() { return &_textureCache; }
+
+    /**
+    * Releases memory held for reuse: unreferenced textures, including those kept forever, and idle render caches.
+    * Application::lowMemory invokes this for each window.
+    */
+    void purgeCaches();
+
+    /**
+    * Declares a shader that should be created before it's first used so that the frame that first needs it doesn't
+    * stall. The identifier is the one views pass to View::shader.
+    *
+    * The warm-up is synchronous, but time-sliced: declared shaders are created one at a time at the end of the
+    * window's frames, starting with the first one. They only use the time left before the next frame is due, and no
+    * more than the warm-up budget's worth of it, so frames that are already busy don't warm up anything. With a
+    * budget of zero, nothing is warmed up.
+    *
+    * Each shader is compiled and linked to completion on the rendering thread when it's created, so one that takes
+    * longer than the time available still delays that frame. Some drivers also defer part of their compilation until
+    * the first draw, so that draw may still stall briefly.
+    */
+    template <typename T>
+    void warmUpShader(const char* identifier) {
+        _shaderWarmUps.push_back({identifier, [] { return ShaderCacheEntry{std::make_unique<T>()}; }});
+    }
+
+    /**
+    * Declares the shaders used by views' standard shader accessors.
+    */
+    void warmUpStandardShaders();
+
+    std::chrono::microseconds shaderWarmUpBudget() const { return _shaderWarmUpBudget; }
+    void setShaderWarmUpBudget(std::chrono::microseconds budget) { _shaderWarmUpBudget = budget; }
+
+    /**
+    * Returns the number of declared shaders that haven't been warmed up yet.
+    */
+    size_t pendingShaderWarmUps() const { return _shaderWarmUps.size(); }
+
+    /**
+    * Returns the number of views laid out during the current or most recent frame.
+    */
+    size_t layoutCount() const { return _layoutCount; }
+
+    /**
+    * The profiler records the phases of the window's frames and the time its views spend rendering. It's
+    * disabled by default and can be enabled at any time.
+    */
+    FrameProfiler* profiler() { return &_profiler; }
+    const FrameProfiler* profiler() const { return &_profiler; }
+
+    /**
+    * Returns the stats for the last frame recorded by the profiler, or nullptr if it's disabled or hasn't
+    * completed a frame yet.
+    */
+    const FrameProfiler::FrameStats* lastFrameStats() const { return _profiler.isEnabled() ? _profiler.lastFrame() : nullptr; }
+
+    /**
+    * If enabled, small textures are packed into a shared atlas as they're loaded so that they can be drawn
+    * without changing textures. Textures that are already loaded are unaffected.
+    */
+    bool packsTextures() const { return _packsTextures; }
+    void setPacksTextures(bool packsTextures = true) { _packsTextures = packsTextures; }
+
+    TextureAtlas* textureAtlas() { return &_textureAtlas; }
+
+    /**
+    * The pool that views' render caches are allocated from. Its budget limits the memory used by render caches.
+    */
+    RenderCachePool* renderCachePool() { return &_renderCachePool; }
+
+    /**
+    * Returns the GPU memory used by render caches, in bytes.
+    */
+    size_t renderCacheMemory() const { return _renderCachePool.bytes(); }
+
+    /**
+    * If enabled, frames are drawn on a dedicated render thread. Each frame, the view tree is recorded into an
+    * immutable display list on the main thread, and the render thread draws it while the main thread moves on to
+    * the next frame's updates.
+    *
+    * Views must only draw via okui's shaders and BatchRenderer, or wrap any other OpenGL calls in
+    * DisplayList::Perform. Textures, framebuffers, and shaders are still created on the main thread while frames
+    * are recorded. The application must support render threads (currently only the SDL application does), and
+    * only one window should use one.
+    */
+    bool rendersOnRenderThread() const { return _renderThread != nullptr; }
+    void setRendersOnRenderThread(bool rendersOnRenderThread = true);
+
+    RenderThread* renderThread() { return _renderThread.get(); }
+
+    /**
+    * Begins loading a texture. Textures are decoded by the window's decode pool with the given priority. If the
+    * texture is already being decoded with a lower priority, it's raised. Decoding is canceled if every handle to
+    * the texture is destroyed before it starts.
+    *
+    * If a target size in pixels is given, the texture may be decoded at a reduced resolution that still covers it.
+    * Target sizes are rounded up to powers of two, and each rounded size is cached separately.
+    */
+    TextureHandle loadTextureResource(const std::string& name, DecodePool::Priority priority = DecodePool::Priority::kBackground, Point<int> targetSize = {});
+    TextureHandle loadTextureFromMemory(std::shared_ptr<const std::string> data, DecodePool::Priority priority = DecodePool::Priority::kBackground, Point<int> targetSize = {});
+    TextureHandle loadTextureFromURL(const std::string& url, DecodePool::Priority priority = DecodePool::Priority::kBackground, Point<int> targetSize = {});
+
+    /**
+    * Returns the size that the given target size is rounded up to. Target sizes with the same bucket load the same
+    * texture.
+    */
+    static Point<int> TextureTargetSizeBucket(Point<int> targetSize);
+
+    DecodePool* decodePool() { return &_decodePool; }
     std::shared_ptr<BitmapFont> loadBitmapFontResource(const char* textureName, const char* metadataName);
 
     View* focus() const { return _focus; }
@@ -220,17 +472,25 @@ public:
 
 private:
     friend class Application;
+    friend class View;
 
     struct TextureDownload {
         std::future<std::shared_ptr<const std::string>> download;
         TextureHandle handle;
+        DecodePool::Priority priority;
     };
 
     void _update();
     void _render();
+    std::shared_ptr<const DisplayList> _renderFrame();
     void _didResize(int width, int height);
     void _updateContentLayout();
-    void _decompressTexture(const std::string& hashable);
+    void _decompressTexture(const std::string& hashable, DecodePool::Priority priority);
+    void _raiseDecodePriority(const std::string& hashable, DecodePool::Priority priority);
+    void _cancelUnreferencedDecodes();
+    void _createProgramBinaryCache();
+    void _warmUpShaders();
+    void _renderDamagedRegions(const RenderTarget& target);
 
     std::string                  _title = "Untitled";
     Application*                 _application = nullptr;
@@ -250,12 +510,22 @@ private:
 
     ShaderCache                  _shaderCache;
     scraps::Cache<TextureHandle> _textureCache;
+    TextureAtlas                 _textureAtlas;
+    bool                         _packsTextures = false;
+    RenderCachePool              _renderCachePool;
     scraps::Cache<BitmapFont>    _bitmapFontCache;
 
     std::unordered_map<std::string, TextureDownload> _textureDownloads;
 
-    std::mutex                   _texturesToLoadMutex;
+    DecodePool                   _decodePool;
+    std::unordered_map<std::string, DecodePool::Ticket> _decodes;
+    mutable std::mutex           _texturesToLoadMutex;
     std::vector<std::string>     _texturesToLoad;
+    std::deque<std::string>      _texturesToUpload;
+    size_t                       _textureUploadByteBudget = 8 * 1024 * 1024;
+    std::chrono::microseconds    _textureUploadTimeBudget{4000};
+    bool                         _stagesTextureUploads = true;
+    std::vector<std::string>     _stagedTextureUploads;
 
     Point<double>                _lastMouseDown{0.0, 0.0};
     std::unordered_set<View*>    _draggedViews;
@@ -263,11 +533,36 @@ private:
     std::unordered_set<View*>    _viewsToSubscribeToUpdates;
     std::unordered_set<View*>    _viewsToUnsubscribeFromUpdates;
 
+    bool                         _rendersOnDemand = false;
+    VerticalSync                 _verticalSync = VerticalSync::kDefault;
+    FramePacer<>                 _framePacer;
+    RedrawMode                   _redrawMode = RedrawMode::kFull;
+    int                          _backBufferAge = 2;
+    bool                         _needsFullRedraw = true;
+    DamageRegion                 _damagedRegion;
+    std::deque<DamageRegion>     _damageHistory;
+    BatchRenderer                _batchRenderer;
+    bool                         _streamsVertices = true;
+    std::unique_ptr<opengl::StreamingVertexBuffer> _vertexStream;
+    bool                         _cachesProgramBinaries = true;
+    std::shared_ptr<opengl::ProgramBinaryCache> _programBinaryCache;
+
+    struct ShaderWarmUp {
+        std::string                       identifier;
+        std::function<ShaderCacheEntry()> create;
+    };
+
+    std::deque<ShaderWarmUp>     _shaderWarmUps;
+    std::chrono::microseconds    _shaderWarmUpBudget{4000};
+
+    size_t                       _layoutCount = 0;
+    FrameProfiler                _profiler;
+
     double                       _framesPerSecond = 0.0;
-    std::chrono::high_resolution_clock::time_point _lastRenderTime = std::chrono::high_resolution_clock::now();
-    std::chrono::high_resolution_clock::time_point _lastUpdateTime = std::chrono::high_resolution_clock::now();
+    std::chrono::steady_clock::time_point _lastRenderTime;
+    std::chrono::steady_clock::time_point _lastUpdateTime;
 
-    scraps::TaskThread           _decompressionThread;
+    std::unique_ptr<RenderThread> _renderThread;
 };
 
 } // namespace okui
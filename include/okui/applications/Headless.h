@@ -0,0 +1,641 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#if __has_include(<EGL/egl.h>)
+
+#define ONAIR_OKUI_HAS_HEADLESS_APPLICATION 1
+
+#include <okui/Application.h>
+#include <okui/DisplayList.h>
+#include <okui/FrameProfiler.h>
+#include <okui/KeyCode.h>
+#include <okui/MouseButton.h>
+#include <okui/UserPreferencesInterface.h>
+#include <okui/Window.h>
+#include <okui/opengl/ContextOwnership.h>
+#include <okui/opengl/Framebuffer.h>
+
+#include <scraps/logging.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <sys/stat.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+namespace okui::applications {
+
+/**
+* An application that renders its windows offscreen, without a display server.
+*
+* Rendering is done via an EGL context, which is surfaceless if the driver supports it (as Mesa's llvmpipe does) and
+* backed by a small pbuffer otherwise. Each window renders into its own framebuffer, which can be read back via
+* readPixels.
+*
+* The application is header-only, and okui itself doesn't link EGL. Programs that use it link EGL themselves (via the
+* okui-headless target when building with b2).
+*
+* By default, time only passes when advance is invoked, so the frame pacer and update hooks see the same times on
+* every run. Input can be injected via the mouse and key methods. Frames can be driven explicitly via renderFrame,
+* or run can be used, in which case the clock advances by one frame interval per frame.
+*/
+class Headless : public Application {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Headless();
+    ~Headless();
+
+    /**
+    * Returns false if an OpenGL context couldn't be created.
+    */
+    bool isValid() const { return _context != EGL_NO_CONTEXT; }
+
+    virtual void run() override;
+    virtual void quit() override { _shouldQuit = true; }
+
+    virtual Clock::time_point now() const override { return _usesRealTime ? Clock::now() : _now; }
+
+    /**
+    * If enabled, now() returns the actual time instead of the controlled time.
+    */
+    bool usesRealTime() const { return _usesRealTime; }
+    void setUsesRealTime(bool usesRealTime = true) { _usesRealTime = usesRealTime; }
+
+    /**
+    * Moves the controlled clock forward.
+    */
+    void advance(Clock::duration duration) { _now += duration; }
+
+    /**
+    * Runs queued tasks, then updates and renders each window whose frame is due. Returns the number of windows
+    * that were rendered.
+    */
+    size_t renderFrames();
+
+    /**
+    * Updates and renders the window, regardless of whether it needs display or its frame is due.
+    */
+    void renderFrame(Window* window);
+
+    /**
+    * Returns the contents of the window's framebuffer as tightly packed RGBA rows, top row first.
+    */
+    std::vector<uint8_t> readPixels(Window* window);
+
+    /**
+    * Returns the texture that the window renders into, or 0 if the window isn't open.
+    */
+    GLuint texture(Window* window) const;
+
+    void mouseDown(Window* window, MouseButton button, double x, double y) { window->dispatchMouseDown(button, x, y); }
+    void mouseUp(Window* window, MouseButton button, double x, double y) { window->dispatchMouseUp(button, x, y); }
+    void mouseMovement(Window* window, double x, double y) { window->dispatchMouseMovement(x, y); }
+    void mouseWheel(Window* window, double x, double y, int xWheel, int yWheel) { window->dispatchMouseWheel(x, y, xWheel, yWheel); }
+
+    /**
+    * Presses and releases the given mouse button.
+    */
+    void click(Window* window, MouseButton button, double x, double y);
+
+    void keyDown(Window* window, KeyCode key, KeyModifiers modifiers = 0, bool repeat = false) { window->firstResponder()->keyDown(key, modifiers, repeat); }
+    void keyUp(Window* window, KeyCode key, KeyModifiers modifiers = 0, bool repeat = false) { window->firstResponder()->keyUp(key, modifiers, repeat); }
+    void textInput(Window* window, const std::string& text) { window->firstResponder()->textInput(text); }
+
+    virtual void openWindow(Window* window, const char* title, const WindowPosition& position, int width, int height) override;
+    virtual void closeWindow(Window* window) override;
+
+    virtual void getWindowRenderSize(Window* window, int* width, int* height) override { getWindowSize(window, width, height); }
+    virtual void getWindowSize(Window* window, int* width, int* height) override;
+    virtual void getWindowPosition(Window* window, int* x, int* y) override;
+
+    virtual void setWindowPosition(Window* window, const WindowPosition& position) override;
+    virtual void setWindowSize(Window* window, int width, int height) override;
+    virtual void setWindowTitle(Window* window, const char* title) override;
+
+    virtual bool isWindowMinimized(Window* window) const override { return _state(window, &WindowInfo::isMinimized); }
+    virtual void minimizeWindow(Window* window) override { _setState(window, &WindowInfo::isMinimized); }
+
+    virtual bool isWindowMaximized(Window* window) const override { return _state(window, &WindowInfo::isMaximized); }
+    virtual void maximizeWindow(Window* window) override { _setState(window, &WindowInfo::isMaximized); }
+
+    virtual bool isWindowFullscreen(Window* window) const override { return _state(window, &WindowInfo::isFullscreen); }
+    virtual void fullscreenWindow(Window* window) override { _setState(window, &WindowInfo::isFullscreen); }
+
+    virtual void restoreWindow(Window* window) override { _setState(window, nullptr); }
+
+    virtual void bringWindowToFront(Window* window) override;
+
+    virtual Window* activeWindow() override { return _activeWindow; }
+
+    virtual UserPreferencesInterface* getUserPreferences() override { return &_userPreferences; }
+
+    /**
+    * Defaults to a directory named after the application in the temporary directory.
+    */
+    virtual std::string userStoragePath() const override;
+    void setUserStoragePath(std::string path) { _userStoragePath = std::move(path); }
+
+    virtual void startTextInput() override {}
+    virtual void stopTextInput() override {}
+
+    /**
+    * There's nobody to respond to dialogs, so they're logged and dismissed without invoking the action.
+    */
+    virtual void openDialog(Window* window, const char* title, const char* message, const std::vector<DialogButton>& buttons, std::function<void(int)> action = {}) override;
+
+    virtual std::string operatingSystem() const override { return "Headless"; }
+
+private:
+    struct WindowInfo {
+        std::unique_ptr<opengl::Framebuffer> framebuffer;
+        opengl::Framebuffer::Attachment*     colorAttachment = nullptr;
+        int                                  width = 0;
+        int                                  height = 0;
+        WindowPosition                       position;
+        std::string                          title;
+        bool                                 isMinimized = false;
+        bool                                 isMaximized = false;
+        bool                                 isFullscreen = false;
+    };
+
+    class UserPreferences : public UserPreferencesInterface {
+    public:
+        virtual bool has(const std::string& key) const override { return _values.count(key); }
+        virtual void unset(const std::string& key) override { _values.erase(key); }
+
+        virtual bool getBool(const std::string& key) const override { return getInt64(key) != 0; }
+        virtual int32_t getInt32(const std::string& key) const override { return static_cast<int32_t>(getInt64(key)); }
+        virtual int64_t getInt64(const std::string& key) const override { return std::strtoll(getString(key).c_str(), nullptr, 10); }
+        virtual float getFloat(const std::string& key) const override { return std::strtof(getString(key).c_str(), nullptr); }
+        virtual std::string getString(const std::string& key) const override {
+            auto it = _values.find(key);
+            return it == _values.end() ? std::string{} : it->second;
+        }
+
+        virtual void setBool(const std::string& key, bool value) override { setInt64(key, value ? 1 : 0); }
+        virtual void setInt32(const std::string& key, int32_t value) override { setInt64(key, value); }
+        virtual void setInt64(const std::string& key, int64_t value) override { setString(key, std::to_string(value)); }
+        virtual void setFloat(const std::string& key, float value) override { setString(key, std::to_string(value)); }
+        virtual void setString(const std::string& key, const std::string& value) override { _values[key] = value; }
+
+    private:
+        std::unordered_map<std::string, std::string> _values;
+    };
+
+    void _makeCurrent();
+    void _releaseCurrent();
+    void _createFramebuffer(WindowInfo* info);
+    WindowInfo* _info(Window* window);
+    const WindowInfo* _info(Window* window) const;
+    bool _state(Window* window, bool WindowInfo::* state) const;
+    void _setState(Window* window, bool WindowInfo::* state);
+
+    static EGLDisplay _GetDisplay();
+    static bool _HasExtension(const char* extensions, const char* extension);
+
+    EGLDisplay                              _display = EGL_NO_DISPLAY;
+    EGLContext                              _context = EGL_NO_CONTEXT;
+    EGLSurface                              _surface = EGL_NO_SURFACE;
+
+    std::unordered_map<Window*, WindowInfo> _windows;
+    Window*                                 _activeWindow = nullptr;
+
+    bool                                    _shouldQuit = false;
+    bool                                    _usesRealTime = false;
+    Clock::time_point                       _now = Clock::now();
+
+    std::string                             _userStoragePath;
+    UserPreferences                         _userPreferences;
+};
+
+inline Headless::Headless() {
+    _display = _GetDisplay();
+    if (_display == EGL_NO_DISPLAY || !eglInitialize(_display, nullptr, nullptr)) {
+        SCRAPS_LOG_ERROR("unable to initialize egl display");
+        _display = EGL_NO_DISPLAY;
+        return;
+    }
+
+    // windows render into framebuffers, so a surface is only needed if the driver can't go without
+    auto isSurfaceless = _HasExtension(eglQueryString(_display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+
+#if OPENGL_ES
+    auto api = EGL_OPENGL_ES_API;
+    EGLint renderableType = EGL_OPENGL_ES2_BIT;
+#else
+    auto api = EGL_OPENGL_API;
+    EGLint renderableType = EGL_OPENGL_BIT;
+#endif
+
+    EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, isSurfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, renderableType,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_STENCIL_SIZE, 8,
+        EGL_NONE,
+    };
+
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(_display, configAttributes, &config, 1, &configCount) || configCount < 1) {
+        SCRAPS_LOG_ERROR("no suitable egl config");
+        return;
+    }
+
+    if (!eglBindAPI(api)) {
+        SCRAPS_LOG_ERROR("unable to bind opengl api");
+        return;
+    }
+
+#if OPENGL_ES
+    for (auto version : {3, 2}) {
+        EGLint contextAttributes[] = {EGL_CONTEXT_CLIENT_VERSION, version, EGL_NONE};
+        _context = eglCreateContext(_display, config, EGL_NO_CONTEXT, contextAttributes);
+        if (_context != EGL_NO_CONTEXT) { break; }
+    }
+#else
+    EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 1,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE,
+    };
+    _context = eglCreateContext(_display, config, EGL_NO_CONTEXT, contextAttributes);
+#endif
+
+    if (_context == EGL_NO_CONTEXT) {
+        SCRAPS_LOG_ERROR("unable to create egl context: {:#x}", eglGetError());
+        return;
+    }
+
+    if (!isSurfaceless) {
+        EGLint pbufferAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        _surface = eglCreatePbufferSurface(_display, config, pbufferAttributes);
+    }
+
+    _makeCurrent();
+    SCRAPS_LOG_INFO("opengl version: {}", glGetString(GL_VERSION));
+}
+
+inline Headless::~Headless() {
+    _windows.clear();
+
+    if (_display == EGL_NO_DISPLAY) { return; }
+
+    eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (_surface != EGL_NO_SURFACE) {
+        eglDestroySurface(_display, _surface);
+    }
+    if (_context != EGL_NO_CONTEXT) {
+        eglDestroyContext(_display, _context);
+    }
+    eglTerminate(_display);
+}
+
+inline void Headless::run() {
+    _shouldQuit = false;
+
+    while (!_shouldQuit) {
+        if (renderFrames() || _windows.empty()) {
+            if (_windows.empty()) {
+                // nothing to render, so just keep running tasks until there's a window or a reason to quit
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            continue;
+        }
+
+        // skip ahead to the next frame instead of waiting for it
+        auto next = Clock::time_point::max();
+        for (auto& kv : _windows) {
+            next = std::min(next, kv.first->framePacer().nextFrameTime());
+        }
+
+        if (_usesRealTime) {
+            std::this_thread::sleep_until(std::min(next, Clock::now() + std::chrono::milliseconds(100)));
+        } else if (next > _now) {
+            _now = next;
+        } else {
+            // every window renders on demand and none of them need display
+            _now += _windows.begin()->first->framePacer().frameInterval();
+        }
+    }
+}
+
+inline size_t Headless::renderFrames() {
+    taskScheduler()->run();
+
+    std::vector<Window*> windows;
+    auto now = this->now();
+    for (auto& kv : _windows) {
+        auto window = kv.first;
+        if (!window->framePacer().isFrameDue(now)) { continue; }
+        if (window->rendersOnDemand() && !window->needsDisplay()) { continue; }
+        windows.emplace_back(window);
+    }
+
+    // windows may be closed while rendering
+    size_t frames = 0;
+    for (auto window : windows) {
+        if (_windows.count(window)) {
+            renderFrame(window);
+            ++frames;
+        }
+    }
+    return frames;
+}
+
+inline void Headless::renderFrame(Window* window) {
+    auto info = _info(window);
+    if (!info) { return; }
+
+    _update(window);
+
+    if (!_info(window)) { return; }
+
+    auto framebuffer = info->framebuffer.get();
+
+    if (auto renderThread = window->renderThread()) {
+        renderThread->wait();
+        _makeCurrent();
+        std::shared_ptr<const DisplayList> frame;
+        {
+            opengl::ContextOwnership ownership;
+            frame = _renderFrame(window);
+        }
+        _releaseCurrent();
+        window->profiler()->endFrame();
+
+        renderThread->submit([this, framebuffer, frame = std::move(frame)]() mutable {
+            _makeCurrent();
+            {
+                opengl::ContextOwnership ownership;
+                framebuffer->bind();
+                frame->replay();
+                glFinish();
+                frame = nullptr;
+            }
+            _releaseCurrent();
+        });
+    } else {
+        _makeCurrent();
+        opengl::ContextOwnership ownership;
+        framebuffer->bind();
+        _render(window);
+        {
+            // there's nothing to swap, but finishing gives the profiler and benchmarks the actual cost of the frame
+            FrameProfiler::PhaseScope phase{window->profiler(), FrameProfiler::Phase::kSwap};
+            glFinish();
+        }
+        window->profiler()->endFrame();
+    }
+}
+
+inline std::vector<uint8_t> Headless::readPixels(Window* window) {
+    auto info = _info(window);
+    if (!info) { return {}; }
+
+    if (auto renderThread = window->renderThread()) {
+        renderThread->wait();
+    }
+    _makeCurrent();
+
+    std::vector<uint8_t> pixels(static_cast<size_t>(info->width) * info->height * 4);
+    if (pixels.empty()) { return pixels; }
+
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    info->framebuffer->bind();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, info->width, info->height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+
+    // opengl's rows start at the bottom
+    auto stride = static_cast<size_t>(info->width) * 4;
+    std::vector<uint8_t> row(stride);
+    for (int y = 0; y < info->height / 2; ++y) {
+        auto top = pixels.data() + y * stride;
+        auto bottom = pixels.data() + (info->height - 1 - y) * stride;
+        std::memcpy(row.data(), top, stride);
+        std::memcpy(top, bottom, stride);
+        std::memcpy(bottom, row.data(), stride);
+    }
+
+    return pixels;
+}
+
+inline GLuint Headless::texture(Window* window) const {
+    auto info = _info(window);
+    return info && info->colorAttachment ? info->colorAttachment->texture() : 0;
+}
+
+inline void Headless::click(Window* window, MouseButton button, double x, double y) {
+    mouseMovement(window, x, y);
+    mouseDown(window, button, x, y);
+    mouseUp(window, button, x, y);
+}
+
+inline void Headless::openWindow(Window* window, const char* title, const WindowPosition& position, int width, int height) {
+    if (_windows.count(window)) {
+        return;
+    }
+
+    auto& info = _windows[window];
+    info.title = title;
+    info.position = position;
+    info.width = width;
+    info.height = height;
+    _createFramebuffer(&info);
+
+    if (!_activeWindow) {
+        _activeWindow = window;
+    }
+}
+
+inline void Headless::closeWindow(Window* window) {
+    auto it = _windows.find(window);
+    if (it == _windows.end()) {
+        return;
+    }
+
+    if (auto renderThread = window->renderThread()) {
+        renderThread->wait();
+    }
+
+    _makeCurrent();
+    _windows.erase(it);
+
+    if (_activeWindow == window) {
+        _activeWindow = _windows.empty() ? nullptr : _windows.begin()->first;
+    }
+}
+
+inline void Headless::getWindowSize(Window* window, int* width, int* height) {
+    if (auto info = _info(window)) {
+        *width = info->width;
+        *height = info->height;
+    }
+}
+
+inline void Headless::getWindowPosition(Window* window, int* x, int* y) {
+    if (auto info = _info(window)) {
+        *x = info->position.x;
+        *y = info->position.y;
+    }
+}
+
+inline void Headless::setWindowPosition(Window* window, const WindowPosition& position) {
+    if (auto info = _info(window)) {
+        info->position = position;
+    }
+}
+
+inline void Headless::setWindowSize(Window* window, int width, int height) {
+    auto info = _info(window);
+    if (!info || (info->width == width && info->height == height)) { return; }
+
+    if (auto renderThread = window->renderThread()) {
+        renderThread->wait();
+    }
+
+    info->width = width;
+    info->height = height;
+    _makeCurrent();
+    _createFramebuffer(info);
+}
+
+inline void Headless::setWindowTitle(Window* window, const char* title) {
+    if (auto info = _info(window)) {
+        info->title = title;
+    }
+}
+
+inline void Headless::bringWindowToFront(Window* window) {
+    if (_info(window)) {
+        _activeWindow = window;
+    }
+}
+
+inline std::string Headless::userStoragePath() const {
+    if (!_userStoragePath.empty()) {
+        return _userStoragePath;
+    }
+
+    auto temporaryDirectory = std::getenv("TMPDIR");
+    auto path = std::string{temporaryDirectory && *temporaryDirectory ? temporaryDirectory : "/tmp"};
+    if (path.back() != '/') {
+        path += '/';
+    }
+    path += organization() + '-' + name() + '/';
+    mkdir(path.c_str(), 0700);
+    return path;
+}
+
+inline void Headless::openDialog(Window* window, const char* title, const char* message, const std::vector<DialogButton>& buttons, std::function<void(int)> action) {
+    SCRAPS_LOG_INFO("dismissing dialog: {}: {}", title, message);
+}
+
+inline void Headless::_makeCurrent() {
+    if (_context != EGL_NO_CONTEXT && eglGetCurrentContext() != _context) {
+        eglMakeCurrent(_display, _surface, _surface, _context);
+    }
+}
+
+inline void Headless::_releaseCurrent() {
+    eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+inline void Headless::_createFramebuffer(WindowInfo* info) {
+    info->framebuffer = std::make_unique<opengl::Framebuffer>();
+    info->colorAttachment = info->framebuffer->addColorAttachment(info->width, info->height);
+#if !OPENGL_ES
+    info->framebuffer->addDepthStencilAttachment(info->width, info->height);
+#endif
+    if (!info->framebuffer->isComplete()) {
+        SCRAPS_LOG_ERROR("incomplete framebuffer for {}x{} window", info->width, info->height);
+    }
+}
+
+inline Headless::WindowInfo* Headless::_info(Window* window) {
+    auto it = _windows.find(window);
+    return it == _windows.end() ? nullptr : &it->second;
+}
+
+inline const Headless::WindowInfo* Headless::_info(Window* window) const {
+    auto it = _windows.find(window);
+    return it == _windows.end() ? nullptr : &it->second;
+}
+
+inline bool Headless::_state(Window* window, bool WindowInfo::* state) const {
+    auto info = _info(window);
+    return info && info->*state;
+}
+
+inline void Headless::_setState(Window* window, bool WindowInfo::* state) {
+    if (auto info = _info(window)) {
+        info->isMinimized = info->isMaximized = info->isFullscreen = false;
+        if (state) {
+            info->*state = true;
+        }
+    }
+}
+
+inline EGLDisplay Headless::_GetDisplay() {
+    // prefer mesa's surfaceless platform, which doesn't need a display server or a gpu
+    if (_HasExtension(eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS), "EGL_MESA_platform_surfaceless")) {
+        if (auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"))) {
+            auto display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY) {
+                return display;
+            }
+        }
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+inline bool Headless::_HasExtension(const char* extensions, const char* extension) {
+    if (!extensions) { return false; }
+
+    auto length = std::strlen(extension);
+    for (auto p = std::strstr(extensions, extension); p; p = std::strstr(p + length, extension)) {
+        if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace okui::applications
+
+#endif // __has_include(<EGL/egl.h>)
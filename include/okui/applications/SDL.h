@@ -21,12 +21,12 @@
 #include <okui/Command.h>
 #include <okui/Controller.h>
 #include <okui/FileResourceManager.h>
+#include <okui/FrameProfiler.h>
 #include <okui/Rectangle.h>
 #include <okui/applications/SDLKeycode.h>
+#include <okui/opengl/ContextOwnership.h>
 #include <okui/Window.h>
 
-#include <scraps/Timer.h>
-
 #include <SDL.h>
 
 #if SCRAPS_MACOS
@@ -54,6 +54,7 @@ public:
 
     virtual void run() override;
     virtual void quit() override;
+    virtual void wakeUp() override;
 
     virtual void openWindow(Window* window, const char* title, const WindowPosition& windowPosition, int width, int height) override;
     virtual void closeWindow(Window* window) override;
@@ -116,6 +117,7 @@ private:
         Window* window = nullptr;
         SDL_Window* sdlWindow = nullptr;
         SDL_GLContext context;
+        stdts::optional<Window::VerticalSync> verticalSync;
     };
 
     struct SDLWindowPosition {
@@ -165,16 +167,29 @@ private:
 
     void _checkBackCommand();
 
+    void _applyVerticalSync(WindowInfo* info);
+    void _updateRefreshRate(const WindowInfo& info);
+    void _recordPhase(FrameProfiler::Phase phase, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now());
+
+    /**
+    * Returns how long the main loop may wait for events before a window's next frame is due.
+    */
+    std::chrono::steady_clock::duration _timeUntilNextFrame() const;
+
     std::unordered_map<Window*, uint32_t> _windowIds;
     std::unordered_map<uint32_t, WindowInfo> _windows;
     Window* _activeWindow = nullptr;
     std::unique_ptr<SDL_Cursor, CursorDeleter> _cursor;
     bool _backgrounded = false;
+    uint32_t _wakeUpEventType = static_cast<uint32_t>(-1);
     std::unordered_map<SDL_JoystickID, std::unique_ptr<Controller>> _controllers;
 
     std::unique_ptr<ResourceManager> _resourceManager;
 
     static MouseButton sMouseButton(uint8_t id);
+
+    // while every window is idle, tasks queued from other threads and delayed tasks are run at least this often
+    static constexpr auto kMaxIdleInterval = 100ms;
 };
 
 inline SDL::SDL() {
@@ -194,6 +209,8 @@ inline SDL::SDL() {
         SCRAPS_LOG_INFO("Controller {}: {}", i, SDL_JoystickNameForIndex(i));
     }
 
+    _wakeUpEventType = SDL_RegisterEvents(1);
+
     if (auto path = SDL_GetBasePath()) {
         _resourceManager = std::make_unique<FileResourceManager>(path);
         SDL_free(path);
@@ -214,17 +231,15 @@ inline void SDL::run() {
     SDL_Event e;
     bool shouldQuit = false;
 
-    static constexpr auto minFrameInterval = 1000ms/60;
-    scraps::SteadyTimer timer;
-    timer.start();
-
     while (!shouldQuit) {
 #if __APPLE__
         @autoreleasepool {
 #endif
 
         while(!shouldQuit) {
-            if (SDL_PollEvent(&e)) {
+            auto timeout = std::chrono::ceil<std::chrono::milliseconds>(_timeUntilNextFrame());
+            if (timeout > 0ms ? SDL_WaitEventTimeout(&e, static_cast<int>(timeout.count())) : SDL_PollEvent(&e)) {
+                auto eventStart = std::chrono::steady_clock::now();
                 switch (e.type) {
                     case SDL_QUIT:                    { shouldQuit = true; break; }
                     case SDL_MOUSEMOTION:             { _handleMouseMotionEvent(e.motion); break; }
@@ -243,7 +258,12 @@ inline void SDL::run() {
                     case SDL_APP_WILLENTERBACKGROUND: { enteringBackground(); break; }
                     case SDL_APP_DIDENTERBACKGROUND:  { enteredBackground(); _backgrounded = true; break; }
                     case SDL_APP_WILLENTERFOREGROUND: { enteringForeground(); break; }
-                    case SDL_APP_DIDENTERFOREGROUND:  { enteredForeground(); _backgrounded = false; break; }
+                    case SDL_APP_DIDENTERFOREGROUND:  {
+                        enteredForeground();
+                        _backgrounded = false;
+                        for (auto& kv : _windows) { kv.second.window->invalidate(); }
+                        break;
+                    }
                     case SDL_JOYDEVICEADDED:          { _addJoystick(e.jdevice.which); break; }
                     case SDL_JOYDEVICEREMOVED:        { _removeJoystick(e.jdevice.which); break; }
                     case SDL_JOYAXISMOTION:           { _handleJoystickAxisEvent(e.jaxis); break; }
@@ -252,8 +272,7 @@ inline void SDL::run() {
                     case SDL_DROPFILE:                { handleURL(e.drop.file); break; }
                     default:                          { break; }
                 }
-            } else if ((minFrameInterval - timer.elapsed()) > 2ms) {
-                std::this_thread::sleep_for(1ms);
+                _recordPhase(FrameProfiler::Phase::kEvents, eventStart);
             } else {
                 break;
             }
@@ -261,22 +280,58 @@ inline void SDL::run() {
 
         if (shouldQuit) { break; }
 
-        timer.restart();
-
         if (scraps::platform::kIsTVOS && _backgrounded) { continue; }
 
+        auto tasksStart = std::chrono::steady_clock::now();
         taskScheduler()->run();
 
+        auto now = std::chrono::steady_clock::now();
+        _recordPhase(FrameProfiler::Phase::kTasks, tasksStart, now);
+
         for (auto& kv : _windows) {
-            _update(kv.second.window);
+            auto window = kv.second.window;
+            if (!window->framePacer().isFrameDue(now)) { continue; }
+            if (window->rendersOnDemand() && !window->needsDisplay()) { continue; }
+
+            _update(window);
+
+            if (_backgrounded) { continue; }
 
-            if (!_backgrounded) {
+            if (auto renderThread = window->renderThread()) {
+                // take the context back from the render thread, record the frame, then hand both over
+                renderThread->wait();
                 SDL_GL_MakeCurrent(kv.second.sdlWindow, kv.second.context);
-                glDisable(GL_SCISSOR_TEST);
-                glClearColor(0.0, 0.0, 0.0, 0.0);
-                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-                _render(kv.second.window);
-                SDL_GL_SwapWindow(kv.second.sdlWindow);
+                _applyVerticalSync(&kv.second);
+                std::shared_ptr<const DisplayList> frame;
+                {
+                    opengl::ContextOwnership ownership;
+                    frame = _renderFrame(window);
+                }
+                SDL_GL_MakeCurrent(kv.second.sdlWindow, nullptr);
+
+                // the swap happens on the render thread, so it isn't included in the profile
+                window->profiler()->endFrame();
+
+                renderThread->submit([sdlWindow = kv.second.sdlWindow, context = kv.second.context, frame = std::move(frame)]() mutable {
+                    SDL_GL_MakeCurrent(sdlWindow, context);
+                    {
+                        opengl::ContextOwnership ownership;
+                        frame->replay();
+                        SDL_GL_SwapWindow(sdlWindow);
+                        frame = nullptr;
+                    }
+                    SDL_GL_MakeCurrent(sdlWindow, nullptr);
+                });
+            } else {
+                SDL_GL_MakeCurrent(kv.second.sdlWindow, kv.second.context);
+                _applyVerticalSync(&kv.second);
+                opengl::ContextOwnership ownership;
+                _render(window);
+                {
+                    FrameProfiler::PhaseScope phase{window->profiler(), FrameProfiler::Phase::kSwap};
+                    SDL_GL_SwapWindow(kv.second.sdlWindow);
+                }
+                window->profiler()->endFrame();
             }
         }
 
@@ -286,6 +341,14 @@ inline void SDL::run() {
     }
 }
 
+inline void SDL::wakeUp() {
+    if (_wakeUpEventType == static_cast<uint32_t>(-1)) { return; }
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = _wakeUpEventType;
+    SDL_PushEvent(&event);
+}
+
 inline void SDL::quit() {
     SDL_Event event;
     event.type = SDL_QUIT;
@@ -332,6 +395,7 @@ inline void SDL::openWindow(Window* window, const char* title, const WindowPosit
 
     _windowIds[window] = id;
     _windows[id] = WindowInfo(window, sdlWindow, context);
+    _updateRefreshRate(_windows[id]);
 
     if (!_activeWindow) {
         _activeWindow = window;
@@ -350,6 +414,10 @@ inline void SDL::closeWindow(Window* window) {
     auto id = it->second;
     auto& info = _windows[id];
 
+    if (auto renderThread = window->renderThread()) {
+        renderThread->wait();
+    }
+
     SDL_GL_DeleteContext(info.context);
     SDL_DestroyWindow(info.sdlWindow);
 
@@ -651,6 +719,13 @@ inline void SDL::_handleWindowEvent(const SDL_WindowEvent& event) {
         case SDL_WINDOWEVENT_RESIZED:
             _didResize(window, event.data1, event.data2);
             break;
+        case SDL_WINDOWEVENT_EXPOSED:
+            window->invalidate();
+            break;
+        case SDL_WINDOWEVENT_MOVED:
+            // the window may have moved to a display with a different refresh rate
+            _updateRefreshRate(_windows.at(event.windowID));
+            break;
         case SDL_WINDOWEVENT_FOCUS_GAINED:
             _activeWindow = window;
             break;
@@ -796,6 +871,67 @@ inline bool SDL::isCursorVisible() const {
     return ret;
 }
 
+inline void SDL::_applyVerticalSync(WindowInfo* info) {
+    auto verticalSync = info->window->verticalSync();
+    if (info->verticalSync == verticalSync) { return; }
+    info->verticalSync = verticalSync;
+
+    switch (verticalSync) {
+        case Window::VerticalSync::kDefault:
+            break;
+        case Window::VerticalSync::kDisabled:
+            SDL_GL_SetSwapInterval(0);
+            break;
+        case Window::VerticalSync::kAdaptive:
+            if (SDL_GL_SetSwapInterval(-1) == 0) {
+                break;
+            }
+            SCRAPS_LOG_INFO("adaptive vsync is not supported: {}", SDL_GetError());
+            // fall through
+        case Window::VerticalSync::kEnabled:
+            if (SDL_GL_SetSwapInterval(1) < 0) {
+                SCRAPS_LOG_ERROR("unable to enable vsync: {}", SDL_GetError());
+            }
+            break;
+    }
+}
+
+inline void SDL::_updateRefreshRate(const WindowInfo& info) {
+    SDL_DisplayMode mode;
+    if (SDL_GetWindowDisplayMode(info.sdlWindow, &mode) == 0 && mode.refresh_rate > 0) {
+        info.window->framePacer().setRefreshRate(mode.refresh_rate);
+    }
+}
+
+inline void SDL::_recordPhase(FrameProfiler::Phase phase, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    // events and tasks aren't specific to a window, so they count towards every window's next frame
+    for (auto& kv : _windows) {
+        kv.second.window->profiler()->recordPhase(phase, start, end);
+    }
+}
+
+inline std::chrono::steady_clock::duration SDL::_timeUntilNextFrame() const {
+    auto now = std::chrono::steady_clock::now();
+    auto next = now + kMaxIdleInterval;
+
+    if (scraps::platform::kIsTVOS && _backgrounded) {
+        return kMaxIdleInterval;
+    }
+
+    for (auto& kv : _windows) {
+        auto window = kv.second.window;
+        auto& pacer = window->framePacer();
+        if (!window->rendersOnDemand() || window->needsDisplay()) {
+            next = std::min(next, pacer.nextFrameTime());
+        } else if (window->hasPendingTextures()) {
+            // check on the textures once per frame without producing frames
+            next = std::min(next, std::max(pacer.nextFrameTime(), now + pacer.frameInterval()));
+        }
+    }
+
+    return next - now;
+}
+
 inline void SDL::_checkBackCommand() {
 #if SCRAPS_TVOS
     SDL_SetHint(SDL_HINT_APPLE_TV_CONTROLLER_UI_EVENTS, firstResponder()->chainCanHandleCommand(kCommandBack) ? "0" : "1");
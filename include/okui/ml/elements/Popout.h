@@ -102,7 +102,7 @@ protected:
                 }
                 return;
             }
-            setNeedsLayout();
+            this->setNeedsLayout();
         }
     };
 };
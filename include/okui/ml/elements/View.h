@@ -121,16 +121,16 @@ protected:
                 this->setBackgroundColor(SumColorComponents(components).value_or(Color::kTransparentBlack));
             } else if (name == "x") {
                 attributes().x = SumExpressionComponents(components);
-                setNeedsLayout();
+                this->setNeedsLayout();
             } else if (name == "y") {
                 attributes().y = SumExpressionComponents(components);
-                setNeedsLayout();
+                this->setNeedsLayout();
             } else if (name == "width") {
                 attributes().width = SumExpressionComponents(components);
-                setNeedsLayout();
+                this->setNeedsLayout();
             } else if (name == "height") {
                 attributes().height = SumExpressionComponents(components);
-                setNeedsLayout();
+                this->setNeedsLayout();
             } else if (name == "opacity") {
                 this->setOpacity(SumNumberComponents(components).value_or(1.0));
             } else if (name == "tint-color") {
@@ -144,26 +144,11 @@ protected:
 
         virtual void update() override {
             ElementBase::update();
-            layoutIfNeeded();
+            this->layoutIfNeeded();
         }
 
         virtual ::okui::View* view() override { return this; }
 
-        void layoutIfNeeded() {
-            if (_needsLayout) {
-                layout();
-                ViewType::removeUpdateHook("ml::Elements::View::View::setNeedsLayout");
-            }
-        }
-
-        void setNeedsLayout() {
-            if (_needsLayout) { return; }
-            _needsLayout = true;
-            ViewType::addUpdateHook("ml::Elements::View::View::setNeedsLayout", [this] {
-                layoutIfNeeded();
-            });
-        }
-
         struct Attributes {
             stdts::optional<std::string> x, y, width, height;
         };
@@ -171,8 +156,6 @@ protected:
         Attributes& attributes() { return _attributes; }
 
         virtual void layout() override {
-            _needsLayout = false;
-
             if (this->superview()) {
                 if (_attributes.x || _attributes.y || _attributes.width || _attributes.height) {
                     std::unordered_map<std::string, double> xUnits, yUnits;
@@ -188,7 +171,7 @@ protected:
                 }
 
                 for (auto& subview : this->subviews()) {
-                    subview->layout();
+                    subview->setNeedsLayout();
                 }
             }
 
@@ -233,7 +216,6 @@ protected:
 
     private:
         Attributes            _attributes;
-        bool                  _needsLayout = false;
         stdts::optional<bool> _canBecomeDirectFocus;
     };
 };
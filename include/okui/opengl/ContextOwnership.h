@@ -0,0 +1,73 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace okui::opengl {
+
+/**
+* Claims the OpenGL context for the calling thread for the lifetime of the object.
+*
+* This only matters while a context is shared between threads, such as when a window draws on a RenderThread.
+* While it's shared, the context is passed back and forth between the threads and resources can only be
+* released by the thread that currently has it. Releases requested by other threads are queued and performed
+* when ownership is next claimed or given up.
+*/
+class ContextOwnership {
+public:
+    ContextOwnership();
+    ~ContextOwnership();
+
+    ContextOwnership(const ContextOwnership&) = delete;
+    ContextOwnership& operator=(const ContextOwnership&) = delete;
+
+    /**
+    * Returns true if the calling thread may use the context. This is always true while the context isn't shared.
+    */
+    static bool IsOwnedByCurrentThread();
+
+    /**
+    * Marks the context as shared between threads. Calls may be nested.
+    */
+    static void BeginSharing();
+    static void EndSharing();
+
+    /**
+    * Performs any releases that were requested by threads that didn't own the context.
+    */
+    static void ReleasePending();
+
+private:
+    friend void ReleaseResources(std::function<void()> release);
+
+    static std::atomic<int>                   _sSharingCount;
+    static thread_local int                   _sOwnershipCount;
+    static std::mutex                         _sPendingReleasesMutex;
+    static std::vector<std::function<void()>> _sPendingReleases;
+};
+
+/**
+* Invokes the given function, which should release OpenGL resources, on a thread that owns the context.
+*/
+void ReleaseResources(std::function<void()> release);
+
+} // namespace okui::opengl
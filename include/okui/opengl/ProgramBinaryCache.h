@@ -0,0 +1,136 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <okui/opengl/opengl.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace okui::opengl {
+
+/**
+* Persists linked program binaries to disk so that shaders don't need to be compiled from source every time the
+* application starts.
+*
+* Programs are keyed by their sources and attribute bindings. The whole cache is tied to the vendor,
+* renderer, and version strings of the driver that produced it, and is discarded if they change. Binaries that the
+* driver rejects are dropped, and the program is compiled from source instead.
+*
+* The cache holds a limited number of programs. When it's full, the least recently used ones are dropped, so
+* variants that are no longer used don't accumulate.
+*/
+class ProgramBinaryCache {
+public:
+    static constexpr size_t kDefaultMaximumEntries = 256;
+
+    /**
+    * Creates a cache backed by the file at the given path. Nothing is read until a context is current and the cache
+    * is first used.
+    */
+    explicit ProgramBinaryCache(std::string path);
+    ~ProgramBinaryCache();
+
+    ProgramBinaryCache(const ProgramBinaryCache&) = delete;
+    ProgramBinaryCache& operator=(const ProgramBinaryCache&) = delete;
+
+    const std::string& path() const { return _path; }
+
+    /**
+    * The maximum number of programs kept in the cache.
+    */
+    size_t maximumEntries() const;
+    void setMaximumEntries(size_t maximumEntries);
+
+    /**
+    * Returns the number of programs currently in the cache.
+    */
+    size_t size() const;
+
+    /**
+    * Returns true if the current context can retrieve and load program binaries.
+    */
+    static bool IsSupported();
+
+    /**
+    * Should be invoked before the program is linked so that its binary can be retrieved afterwards.
+    */
+    void prepare(GLuint program);
+
+    /**
+    * Attempts to load the program identified by the given key. Returns true if the program was loaded and
+    * successfully linked.
+    */
+    bool load(GLuint program, const std::string& key);
+
+    /**
+    * Adds the binary of a linked program to the cache. It's written to disk when the cache is next saved.
+    */
+    void store(GLuint program, const std::string& key);
+
+    /**
+    * Writes the cache to disk if it has changed.
+    */
+    void save();
+
+    /**
+    * Makes this the cache returned by Current() on this thread until end() is invoked. end() also saves any changes.
+    */
+    void begin();
+    void end();
+
+    static ProgramBinaryCache* Current() { return _sCurrent; }
+
+    struct Statistics {
+        size_t hits       = 0;
+        size_t misses     = 0;
+        size_t rejections = 0;
+        size_t stores     = 0;
+    };
+
+    Statistics statistics() const;
+
+private:
+    struct Entry {
+        GLenum               format;
+        std::vector<uint8_t> binary;
+        uint64_t             lastUse = 0;
+    };
+
+    bool _open();
+    void _read();
+    void _prune();
+
+    static thread_local ProgramBinaryCache* _sCurrent;
+
+    const std::string                      _path;
+    mutable std::mutex                     _mutex;
+    bool                                   _isOpen = false;
+    bool                                   _isSupported = false;
+    bool                                   _needsSave = false;
+    std::string                            _driver;
+    std::unordered_map<std::string, Entry> _entries;
+    size_t                                 _maximumEntries = kDefaultMaximumEntries;
+    uint64_t                               _useCount = 0;
+    Statistics                             _statistics;
+};
+
+} // namespace okui::opengl
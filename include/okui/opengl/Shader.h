@@ -34,13 +34,19 @@ public:
     Shader(const std::string& source, Type type) : Shader(source.c_str(), type) {}
     ~Shader();
 
-    const std::string& error() const { return _error; }
+    /**
+    * The compile status isn't queried until the error is needed. This lets drivers that compile in the background
+    * keep working on the shader until it's linked.
+    */
+    const std::string& error() const;
 
     GLuint id() const { return _shader; }
 
 private:
-    std::string _error;
+    mutable std::string _error;
+    mutable bool _isChecked = false;
     GLuint _shader = 0;
+    std::string _source;
 };
 
 } // namespace okui::opengl
@@ -20,6 +20,10 @@
 #include <okui/Color.h>
 #include <okui/opengl/Shader.h>
 
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace okui::opengl {
 
 class ShaderProgram {
@@ -42,6 +46,12 @@ public:
 
     void link();
 
+    /**
+    * Compiles the given sources and links them. If a ProgramBinaryCache is current, the program is loaded from it
+    * when possible, and added to it otherwise. Attributes must be bound beforehand.
+    */
+    void link(const std::string& vertexSource, const std::string& fragmentSource);
+
     const std::string& error() const { return _error; }
 
     GLuint id() const { return _program; }
@@ -63,6 +73,7 @@ public:
 private:
     std::string _error;
     GLuint _program = 0;
+    std::vector<std::pair<GLuint, std::string>> _attributes;
 };
 
 } // namespace okui::opengl
@@ -0,0 +1,163 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <okui/opengl/opengl.h>
+
+#include <stdts/optional.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace okui::opengl {
+
+/**
+* A large vertex buffer that shaders stream their vertices into instead of re-specifying a buffer of their own
+* for every draw.
+*
+* Writes are appended to the buffer as a ring. Where possible, the buffer is persistently mapped and written to
+* directly. Otherwise ranges are mapped without synchronization, or as a last resort the buffer is orphaned each
+* time it wraps around. The ring is divided into segments and fences keep the CPU from overwriting a segment
+* that the GPU may still be reading from.
+*/
+class StreamingVertexBuffer {
+public:
+    enum class Mode {
+        kPersistent,
+        kUnsynchronized,
+        kOrphaning,
+    };
+
+    static constexpr size_t kDefaultCapacity = 4 * 1024 * 1024;
+    static constexpr size_t kSegmentCount    = 4;
+
+    /**
+    * Creates the buffer. A context must be current. If no mode is given, the best one the context supports is used.
+    */
+    explicit StreamingVertexBuffer(size_t capacity = kDefaultCapacity, stdts::optional<Mode> mode = stdts::nullopt);
+    ~StreamingVertexBuffer();
+
+    StreamingVertexBuffer(const StreamingVertexBuffer&) = delete;
+    StreamingVertexBuffer& operator=(const StreamingVertexBuffer&) = delete;
+
+    Mode mode() const { return _mode; }
+    size_t capacity() const { return _capacity; }
+    GLuint buffer() const { return _buffer; }
+
+    /**
+    * Uniquely identifies this buffer. Unlike the buffer's name, it's never reused once the buffer is destroyed.
+    */
+    uint64_t generation() const { return _generation; }
+
+    /**
+    * Returns true if the context supports the given mode.
+    */
+    static bool IsSupported(Mode mode);
+
+    /**
+    * Copies the vertices into the buffer and returns the index of the first one, for use with glDrawArrays. Returns
+    * nullopt if there are too many vertices to fit into a segment of the ring.
+    */
+    template <typename Vertex>
+    stdts::optional<GLint> write(const Vertex* vertices, size_t count) {
+        if (auto offset = _write(vertices, sizeof(Vertex) * count, sizeof(Vertex))) {
+            return static_cast<GLint>(*offset / sizeof(Vertex));
+        }
+        return stdts::nullopt;
+    }
+
+    /**
+    * Makes this the buffer returned by Current() until end() is invoked.
+    */
+    void begin();
+    void end();
+
+    static StreamingVertexBuffer* Current() { return _sCurrent; }
+
+    struct Statistics {
+        size_t writes = 0;
+        size_t bytes  = 0;
+        size_t wraps  = 0;
+        size_t stalls = 0;
+    };
+
+    const Statistics& statistics() const { return _statistics; }
+
+    /**
+    * A vertex array that sources its attributes from a streaming buffer. On contexts without vertex array
+    * objects, the attributes are specified each time it's bound.
+    */
+    class VertexArray {
+    public:
+        VertexArray() = default;
+        ~VertexArray();
+
+        VertexArray(const VertexArray&) = delete;
+        VertexArray& operator=(const VertexArray&) = delete;
+
+        void setAttribute(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, size_t offset);
+
+        void bind(const StreamingVertexBuffer& buffer);
+        void unbind();
+
+    private:
+        struct Attribute {
+            GLuint    index;
+            GLint     size;
+            GLenum    type;
+            GLboolean normalized;
+            GLsizei   stride;
+            size_t    offset;
+        };
+
+        void _specifyAttributes();
+
+        std::vector<Attribute> _attributes;
+        GLuint                 _vertexArray = 0;
+        uint64_t               _generation = 0;
+    };
+
+private:
+#if OPENGL_ES && !GL_ES_VERSION_3_0
+    using Fence = void*;
+#else
+    using Fence = GLsync;
+#endif
+
+    stdts::optional<size_t> _write(const void* data, size_t size, size_t alignment);
+    void _enterSegment(size_t segment);
+    void _fenceSegment(size_t segment);
+
+    static StreamingVertexBuffer* _sCurrent;
+    static uint64_t _sNextGeneration;
+
+    uint64_t                             _generation = ++_sNextGeneration;
+    Mode                                 _mode;
+    size_t                               _capacity;
+    size_t                               _segmentSize;
+    GLuint                               _buffer = 0;
+    void*                                _mapping = nullptr;
+    size_t                               _offset = 0;
+    size_t                               _segment = 0;
+    std::array<Fence, kSegmentCount>     _fences{};
+    Statistics                           _statistics;
+};
+
+} // namespace okui::opengl
@@ -17,6 +17,7 @@
 
 #include <okui/config.h>
 
+#include <okui/opengl/ContextOwnership.h>
 #include <okui/opengl/opengl.h>
 
 #include <scraps/Cache.h>
@@ -30,7 +31,9 @@ struct TextureCacheEntry {
 
     ~TextureCacheEntry() {
         if (id) {
-            glDeleteTextures(1, &id);
+            ReleaseResources([id = id] {
+                glDeleteTextures(1, &id);
+            });
         }
     }
 
@@ -0,0 +1,98 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <okui/opengl/opengl.h>
+
+#include <stdts/optional.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace okui::opengl {
+
+/**
+* Compressed texture formats. These aren't defined by every platform's headers.
+*/
+constexpr GLenum kCompressedRGB8ETC1                     = 0x8D64;
+constexpr GLenum kCompressedR11EAC                       = 0x9270;
+constexpr GLenum kCompressedSignedR11EAC                 = 0x9271;
+constexpr GLenum kCompressedRG11EAC                      = 0x9272;
+constexpr GLenum kCompressedSignedRG11EAC                = 0x9273;
+constexpr GLenum kCompressedRGB8ETC2                     = 0x9274;
+constexpr GLenum kCompressedSRGB8ETC2                    = 0x9275;
+constexpr GLenum kCompressedRGB8PunchthroughAlpha1ETC2   = 0x9276;
+constexpr GLenum kCompressedSRGB8PunchthroughAlpha1ETC2  = 0x9277;
+constexpr GLenum kCompressedRGBA8ETC2EAC                 = 0x9278;
+constexpr GLenum kCompressedSRGB8Alpha8ETC2EAC           = 0x9279;
+constexpr GLenum kCompressedRGBS3TCDXT1                  = 0x83F0;
+constexpr GLenum kCompressedRGBAS3TCDXT1                 = 0x83F1;
+constexpr GLenum kCompressedRGBAS3TCDXT3                 = 0x83F2;
+constexpr GLenum kCompressedRGBAS3TCDXT5                 = 0x83F3;
+constexpr GLenum kCompressedSRGBS3TCDXT1                 = 0x8C4C;
+constexpr GLenum kCompressedSRGBAlphaS3TCDXT1            = 0x8C4D;
+constexpr GLenum kCompressedSRGBAlphaS3TCDXT3            = 0x8C4E;
+constexpr GLenum kCompressedSRGBAlphaS3TCDXT5            = 0x8C4F;
+constexpr GLenum kCompressedRGBABPTCUnorm                = 0x8E8C;
+constexpr GLenum kCompressedSRGBAlphaBPTCUnorm           = 0x8E8D;
+constexpr GLenum kCompressedRGBAASTC4x4                  = 0x93B0; // through 0x93BD for larger blocks
+constexpr GLenum kCompressedSRGB8Alpha8ASTC4x4           = 0x93D0; // through 0x93DD for larger blocks
+
+struct CompressedBlockSize {
+    int width;
+    int height;
+    int bytes;
+};
+
+/**
+* Returns the block dimensions and size of the given compressed format, or nullopt if it isn't one of the above.
+*/
+stdts::optional<CompressedBlockSize> CompressedTextureBlockSize(GLenum format);
+
+/**
+* Returns the number of bytes occupied by an image of the given dimensions in the given compressed format.
+*/
+size_t CompressedTextureSize(GLenum format, int width, int height);
+
+/**
+* Requires the render context to be active.
+*
+* Returns true if textures in the given compressed format can be uploaded as-is. The driver is only queried once, after
+* which KnownCompressedTextureFormatSupport can answer from any thread.
+*/
+bool IsCompressedTextureFormatSupported(GLenum format);
+
+/**
+* Returns the result of IsCompressedTextureFormatSupported without requiring a render context, or nullopt if the driver
+* hasn't been queried yet.
+*/
+stdts::optional<bool> KnownCompressedTextureFormatSupport(GLenum format);
+
+/**
+* Returns true if DecompressTexture can decode the given format. ETC1, ETC2 (excluding the EAC R11 and RG11 formats),
+* and S3TC/DXT are supported. BPTC and ASTC are not.
+*/
+bool CanDecompressTexture(GLenum format);
+
+/**
+* Decodes a compressed image to tightly packed 8-bit RGBA pixels. The destination must have room for width * height
+* pixels. Returns false if the format isn't supported or there isn't enough data.
+*/
+bool DecompressTexture(GLenum format, const void* data, size_t size, int width, int height, uint8_t* destination);
+
+} // namespace okui::opengl
@@ -0,0 +1,77 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <okui/opengl/opengl.h>
+
+#include <cstddef>
+
+namespace okui::opengl {
+
+/**
+* A pixel unpack buffer that texture data is staged in before it's uploaded.
+*
+* Staging copies the data out of client memory, so it can be released right away. If the upload is made in a later
+* frame, the driver has had time to transfer the data and glTexImage2D doesn't need to wait for it. The buffer is
+* orphaned each time it's staged into so that earlier uploads never have to be waited for.
+*/
+class TextureUploadBuffer {
+public:
+    /**
+    * Creates the buffer. A context must be current.
+    */
+    TextureUploadBuffer();
+    ~TextureUploadBuffer();
+
+    TextureUploadBuffer(const TextureUploadBuffer&) = delete;
+    TextureUploadBuffer& operator=(const TextureUploadBuffer&) = delete;
+
+    /**
+    * Returns true if the context supports pixel unpack buffers.
+    */
+    static bool IsSupported();
+
+    /**
+    * Copies the data into the buffer, replacing anything staged before. Returns false if the data couldn't be staged.
+    * Nothing is left bound.
+    */
+    bool stage(const void* data, size_t size);
+
+    /**
+    * Returns the number of bytes staged in the buffer.
+    */
+    size_t size() const { return _size; }
+
+    /**
+    * Binds the buffer as the pixel unpack buffer. While it's bound, texture uploads read from it, and nullptr should
+    * be given to them in place of the data.
+    */
+    void bind();
+
+    /**
+    * Unbinds the buffer if it's bound.
+    */
+    void unbind();
+
+private:
+    GLuint     _buffer = 0;
+    size_t     _size = 0;
+    bool       _isBound = false;
+};
+
+} // namespace okui::opengl
@@ -45,6 +45,9 @@ public:
 
     virtual void flush() override;
 
+protected:
+    virtual bool _addToBatch(BatchRenderer* batch, bool inputHasPremultipliedAlpha) override { return batch->add(_vertices); }
+
 private:
     struct GradientPoint {
         double x, y;
@@ -56,6 +59,7 @@ private:
     bool _gradient = false;
 
     virtual void _processTriangle(const std::array<Point<double>, 3>& p, const std::array<Point<double>, 3>& pT, Shader::Curve curve) override;
+    virtual void _processQuads(Vertex* vertices, const Quad* quads, size_t count) override;
 
     void _calculateGradientColor(double x, double y, GLfloat* r, GLfloat* g, GLfloat* b, GLfloat* a);
     double _calculateGradientPosition(double x, double y);
@@ -52,6 +52,7 @@ public:
 
 protected:
     virtual void _draw() override;
+    virtual DisplayList::Command _recordDraw(bool inputHasPremultipliedAlpha) override;
 
 private:
     std::vector<Region> _regions;
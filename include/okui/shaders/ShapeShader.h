@@ -0,0 +1,134 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <okui/BatchRenderer.h>
+#include <okui/Color.h>
+#include <okui/Rectangle.h>
+#include <okui/Shader.h>
+
+#include <vector>
+
+namespace okui::shaders {
+
+/**
+* Draws rectangles with optionally rounded corners and borders. Each rectangle is a single instance, and its
+* corners and border are evaluated analytically in the fragment shader, so any number of rectangles drawn in a row
+* can be drawn with one draw call, even if they're drawn by different views.
+*
+* Instanced drawing is used where it's supported. Otherwise each rectangle's attributes are repeated for its six
+* vertices.
+*/
+class ShapeShader : public Shader, private BatchRenderer::Holder {
+public:
+    ShapeShader();
+    virtual ~ShapeShader();
+
+    struct Corners {
+        Corners(double radius = 0.0) : minMin{radius}, maxMin{radius}, minMax{radius}, maxMax{radius} {}
+        Corners(double minMin, double maxMin, double minMax, double maxMax) : minMin{minMin}, maxMin{maxMin}, minMax{minMax}, maxMax{maxMax} {}
+
+        double minMin, maxMin, minMax, maxMax;
+    };
+
+    struct Shape {
+        Shape() = default;
+        Shape(const Rectangle<double>& bounds, const Color& fill) : bounds{bounds}, fill{fill} {}
+
+        Rectangle<double> bounds;
+        Corners           radii;
+        Color             fill = Color::kWhite;
+        double            borderWidth = 0.0;
+        Color             borderColor = Color::kTransparentBlack;
+
+        /**
+        * The rotation about the center of the bounds, in radians.
+        */
+        double            rotation = 0.0;
+    };
+
+    void setTransformation(const AffineTransformation& transformation) { _transformation = transformation; }
+
+    void draw(const Shape& shape);
+
+    /**
+    * The shape shader can't draw arbitrary triangles. Use draw() instead.
+    */
+    virtual void drawTriangle(double x1, double y1, double x2, double y2, double x3, double y3, Curve curve = kCurveNone) override;
+
+    /**
+    * Draws the quads filled with white. Use draw() for anything else.
+    */
+    virtual void drawQuads(const Quad* quads, size_t count) override;
+    using Shader::drawQuads;
+
+    virtual void flush() override;
+
+    static bool SupportsInstancing();
+
+private:
+    struct Instance {
+        GLfloat originX, originY, width, height;
+        GLfloat xAxisX, xAxisY, yAxisX, yAxisY;
+        GLfloat radii[4];
+        GLfloat fill[4];
+        GLfloat borderColor[4];
+        GLfloat borderWidth, antialiasing;
+        GLfloat clip[4];
+    };
+
+    struct Vertex {
+        GLfloat cornerX, cornerY;
+        Instance instance;
+    };
+
+    enum : GLuint {
+        kCornerAttrib,
+        kOriginAttrib,
+        kAxesAttrib,
+        kRadiiAttrib,
+        kFillAttrib,
+        kBorderColorAttrib,
+        kBorderAttrib,
+        kClipAttrib,
+    };
+
+    virtual void drawHeld() override;
+
+    void _drawInstances(const std::vector<Instance>& instances);
+    void _appendInstances(const std::vector<Instance>& instances, const Rectangle<int>& viewport, int targetWidth, int targetHeight, const stdts::optional<Rectangle<int>>& scissor);
+    void _draw();
+    void _setUpInstancing();
+
+    opengl::ShaderProgram             _program;
+    opengl::ShaderProgram::Uniform    _blendingFlagsUniform;
+    AffineTransformation              _transformation;
+
+    std::vector<Instance>             _instances;
+    std::vector<Instance>             _pending;
+    std::vector<Vertex>               _vertices;
+
+    bool                              _isInstanced = false;
+    GLuint                            _vertexArray = 0;
+    GLuint                            _cornerBuffer = 0;
+    GLuint                            _instanceBuffer = 0;
+    size_t                            _instanceBufferCapacity = 0;
+    scraps::opengl::VertexArrayBuffer _vertexArrayBuffer;
+};
+
+} // namespace okui::shaders
@@ -42,6 +42,12 @@ public:
 
     void setColor(const Color& color);
 
+    /**
+    * Sets the texture without placing it. This is sufficient for drawQuads, which takes texture coordinates from
+    * the quads themselves.
+    */
+    void setTexture(const TextureInterface& texture);
+
     void setTexture(const TextureInterface& texture, Rectangle<double> bounds, const AffineTransformation& texCoordTransform = AffineTransformation{})
         { setTexture(texture, bounds.x, bounds.y, bounds.width, bounds.height, texCoordTransform); }
     void setTexture(const TextureInterface& texture, double x, double y, double w, double h, const AffineTransformation& texCoordTransform = AffineTransformation{});
@@ -60,14 +66,23 @@ public:
 
     virtual void flush() override;
 
+protected:
+    virtual DisplayList::Command _recordDraw(bool inputHasPremultipliedAlpha) override;
+    virtual bool _addToBatch(BatchRenderer* batch, bool inputHasPremultipliedAlpha) override;
+    virtual void _draw() override;
+
 private:
     AffineTransformation _texCoordTransform;
+    AffineTransformation _quadTexCoordTransform;
 
     GLuint _texture{0};
     double _textureX1, _textureY1, _textureWidth, _textureHeight;
+    Rectangle<double> _textureRegion{0.0, 0.0, 1.0, 1.0};
     bool _textureHasPremultipliedAlpha{false};
+    bool _isBatchable;
 
     virtual void _processTriangle(const std::array<Point<double>, 3>& p, const std::array<Point<double>, 3>& pT, Shader::Curve curve) override;
+    virtual void _processQuads(Vertex* vertices, const Quad* quads, size_t count) override;
 };
 
 } // namespace okui::shaders
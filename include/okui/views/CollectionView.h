@@ -0,0 +1,156 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <okui/config.h>
+
+#include <okui/views/ScrollView.h>
+
+#include <stdts/optional.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace okui::views {
+
+/**
+* A scroll view that only creates views for the items that are near its visible area.
+*
+* Cells are created by factories registered for reuse identifiers and are recycled as they scroll out of
+* view, so the number of live views depends on the size of the view rather than the number of items.
+*/
+class CollectionView : public ScrollView {
+public:
+    enum class Layout {
+        kVertical,
+        kHorizontal,
+        kGrid,
+    };
+
+    class DataSource {
+    public:
+        virtual ~DataSource() = default;
+
+        virtual size_t numberOfItems(CollectionView* collectionView) = 0;
+
+        /**
+        * Returns the cell for the given item. The cell must be obtained via dequeueCell and configured for
+        * the item before it's returned.
+        */
+        virtual View* cellForItem(CollectionView* collectionView, size_t index) = 0;
+    };
+
+    using CellFactory = std::function<std::unique_ptr<View>()>;
+
+    void setDataSource(DataSource* dataSource);
+    DataSource* dataSource() const { return _dataSource; }
+
+    /**
+    * Registers a factory that creates cells for the given reuse identifier.
+    */
+    void registerCell(std::string reuseIdentifier, CellFactory factory);
+
+    /**
+    * Returns a recycled cell for the given reuse identifier or creates a new one. This should only be
+    * invoked by the data source.
+    */
+    View* dequeueCell(const std::string& reuseIdentifier);
+
+    void setItemLayout(Layout layout);
+    Layout itemLayout() const { return _layout; }
+
+    /**
+    * Sets the size of each item. For vertical layouts, items always span the width of the view. For
+    * horizontal layouts, items always span the height of the view.
+    */
+    void setItemSize(double width, double height);
+    Point<double> itemSize() const { return _itemSize; }
+
+    void setSpacing(double spacing);
+    double spacing() const { return _spacing; }
+
+    /**
+    * Sets the distance beyond the visible area within which cells are created ahead of time.
+    */
+    void setOverscan(double overscan);
+    double overscan() const { return _overscan; }
+
+    /**
+    * Discards all cells and asks the data source for the items again.
+    */
+    void reloadData();
+
+    size_t numberOfItems() const { return _numberOfItems; }
+
+    /**
+    * Returns the frame of the given item within the content view.
+    */
+    Rectangle<double> itemFrame(size_t index) const;
+
+    /**
+    * Returns the cell for the given item if it currently exists.
+    */
+    View* cell(size_t index) const;
+
+    /**
+    * Returns the item that the given cell or one of its descendants currently represents.
+    */
+    stdts::optional<size_t> item(const View* view) const;
+
+    /**
+    * Returns the number of cells that currently exist for items.
+    */
+    size_t cellCount() const { return _cells.size(); }
+
+    /**
+    * Scrolls just far enough for the given item to be visible.
+    */
+    void scrollToItem(size_t index);
+
+    virtual void scrolled() override;
+    virtual void layout() override;
+    virtual void focusWillMove(Direction direction) override;
+
+private:
+    struct Cell {
+        std::unique_ptr<View> view;
+        std::string           reuseIdentifier;
+    };
+
+    size_t _columns() const;
+    Point<double> _contentSize() const;
+    stdts::optional<size_t> _neighbor(size_t index, Direction direction) const;
+    void _updateCells();
+    void _recycle(Cell cell);
+
+    DataSource*                                        _dataSource = nullptr;
+    Layout                                             _layout = Layout::kVertical;
+    Point<double>                                      _itemSize{100.0, 100.0};
+    double                                             _spacing = 0.0;
+    double                                             _overscan = 0.0;
+    size_t                                             _numberOfItems = 0;
+
+    std::unordered_map<std::string, CellFactory>       _factories;
+    std::unordered_map<std::string, std::vector<std::unique_ptr<View>>> _reusableCells;
+    std::vector<Cell>                                  _dequeuedCells;
+    std::map<size_t, Cell>                             _cells;
+};
+
+} // namespace okui::views
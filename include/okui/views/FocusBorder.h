@@ -19,7 +19,7 @@
 
 #include <okui/Animation.h>
 #include <okui/Point.h>
-#include <okui/shapes/Rectangle.h>
+#include <okui/shaders/ShapeShader.h>
 
 namespace okui::views {
 
@@ -89,15 +89,14 @@ void FocusBorder<BaseView>::layout() {
 
 template <typename BaseView>
 void FocusBorder<BaseView>::BorderView::render() {
-    auto colorShader = this->colorShader();
+    auto shapeShader = this->shapeShader();
 
-    colorShader->setColor(color.withAlphaF(color.alphaF() * anim.current()));
-    okui::shapes::Rectangle(0, 0, this->bounds().width, thickness).draw(colorShader);
-    okui::shapes::Rectangle(0, thickness, thickness, this->bounds().height).draw(colorShader);
-    okui::shapes::Rectangle(this->bounds().width-thickness, thickness, thickness, this->bounds().height).draw(colorShader);
-    okui::shapes::Rectangle(0, this->bounds().height-thickness, this->bounds().width, thickness).draw(colorShader);
+    okui::shaders::ShapeShader::Shape shape{{0, 0, this->bounds().width, this->bounds().height}, okui::Color::kTransparentBlack};
+    shape.borderWidth = thickness;
+    shape.borderColor = color.withAlphaF(color.alphaF() * anim.current());
+    shapeShader->draw(shape);
 
-    colorShader->flush();
+    shapeShader->flush();
 }
 
 } // namespace okui::views
@@ -48,6 +48,13 @@ public:
 
     void setRotation(double r) { _rotation = r; }
 
+    /**
+    * If enabled, which is the default, the texture is decoded at a resolution suited to the view's size rather than
+    * at its full resolution. It's reloaded if the view is resized. Distance field textures are never downscaled.
+    */
+    void setDownscalesTexture(bool downscalesTexture);
+    bool downscalesTexture() const { return _downscalesTexture; }
+
     TextureHandle& texture() { return _texture; }
     const Color& textureColor() const { return _color; }
 
@@ -55,12 +62,19 @@ public:
     void unload();
 
     virtual void render() override;
+    virtual void layout() override;
     virtual void windowChanged() override;
     virtual void willAppear() override;
+    virtual void disappeared() override;
 
 private:
+    Point<int> _textureTargetSize() const;
+
     TextureHandle           _texture;
+    TextureHandle           _staleTexture; // displayed while the texture is reloaded at a new size
     TextureHandle           _placeholderTexture;
+    Point<int>              _targetSize;
+    bool                    _downscalesTexture = true;
     std::string             _resource;
     std::string             _placeholderResource;
     bool                    _fromURL = false;
@@ -35,14 +35,14 @@ public:
     LabeledPopoutButton();
     ~LabeledPopoutButton() { removeSubviews(); }
 
-    void setScaling(double scaling) { _scaling = scaling; _body.setScaling(scaling); layout(); }
+    void setScaling(double scaling) { _scaling = scaling; _body.setScaling(scaling); setNeedsLayout(); }
     void setBackgroundColor(Color backgroundColor) { _body.setBackgroundColor(std::move(backgroundColor)); }
     void setIcon(std::string sdf) { _body.setIcon(std::move(sdf)); }
     void setImage(std::string resourceOrURL, std::string placeholder = {}) { _body.setImage(std::move(resourceOrURL), std::move(placeholder)); }
     void setLabelStyle(TextView::Style focused) { setLabelStyle(focused, focused); }
     void setLabelStyle(TextView::Style focused, TextView::Style unfocused);
     void setLabelText(std::string labelText) { _label.setText(std::move(labelText)); }
-    void setBodyAspectRatio(double aspectRatio) { _bodyAspectRatio = aspectRatio; layout(); }
+    void setBodyAspectRatio(double aspectRatio) { _bodyAspectRatio = aspectRatio; setNeedsLayout(); }
     void setIconColor(Color c) { _body.setIconColor(std::move(c)); }
 
     const TextView::Style& focusedLabelStyle() const { return _focusedLabelStyle; }
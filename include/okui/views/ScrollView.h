@@ -29,6 +29,7 @@ public:
     ScrollView();
 
     okui::View* contentView() { return &_contentView; }
+    const okui::View* contentView() const { return &_contentView; }
 
     /**
     * Returns the offset that the content view is currently scrolled to.
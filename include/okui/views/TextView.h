@@ -141,6 +141,7 @@ private:
     std::string                                         _text;
     std::vector<std::basic_string<BitmapFont::GlyphId>> _lines;
     double                                              _textWidth = 0;
+    std::vector<Shader::Quad>                           _glyphQuads;
 };
 
 } // namespace okui::views
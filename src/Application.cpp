@@ -46,6 +46,14 @@ Application::~Application() {
     }
 }
 
+void Application::lowMemory() {
+    purgeDownloadCache(0);
+
+    for (auto& window : _windows) {
+        window->purgeCaches();
+    }
+}
+
 void Application::bringAllWindowsToFront() {
     for (auto& window : _windows) {
         bringWindowToFront(window);
@@ -217,6 +225,10 @@ void Application::_render(Window* window) {
     window->_render();
 }
 
+std::shared_ptr<const DisplayList> Application::_renderFrame(Window* window) {
+    return window->_renderFrame();
+}
+
 void Application::_didResize(Window* window, int width, int height) {
     window->_didResize(width, height);
 }
@@ -0,0 +1,432 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/BatchRenderer.h>
+
+#include <okui/DisplayList.h>
+#include <okui/Shader.h>
+#include <okui/shaders/ColorShader.h>
+#include <okui/shaders/TextureShader.h>
+
+namespace okui {
+
+BatchRenderer* BatchRenderer::_sCurrent = nullptr;
+
+BatchRenderer::BatchRenderer() = default;
+
+BatchRenderer::~BatchRenderer() {
+    if (_sCurrent == this) {
+        _sCurrent = nullptr;
+    }
+}
+
+void BatchRenderer::setEnabled(bool enabled) {
+    flush();
+    _isEnabled = enabled;
+}
+
+void BatchRenderer::begin(int targetWidth, int targetHeight) {
+    _sCurrent = this;
+    _statistics = {};
+    _targetWidth = targetWidth;
+    _targetHeight = targetHeight;
+    _viewport = {0, 0, targetWidth, targetHeight};
+    _scissor = stdts::nullopt;
+    _needsScissorUpdate = false;
+}
+
+void BatchRenderer::end() {
+    flush();
+    _lastFrameStatistics = _statistics;
+    if (_sCurrent == this) {
+        _sCurrent = nullptr;
+    }
+}
+
+void BatchRenderer::setTarget(int width, int height) {
+    flush();
+    _targetWidth = width;
+    _targetHeight = height;
+}
+
+void BatchRenderer::setViewport(const Rectangle<int>& viewport) {
+    // batched vertices are converted to target coordinates as they're added, so this doesn't interrupt the batch
+    _viewport = viewport;
+    glViewport(viewport.x, viewport.y, viewport.width, viewport.height);
+}
+
+void BatchRenderer::setScissor(stdts::optional<Rectangle<int>> scissor) {
+    _scissor = scissor;
+    if (_isEnabled) {
+        // batched vertices carry their own clip rectangles. the scissor is only needed for unbatched draws
+        _needsScissorUpdate = true;
+    } else {
+        _applyScissor();
+    }
+}
+
+bool BatchRenderer::add(const std::vector<shaders::ColorVertex>& vertices) {
+    if (!_isEnabled) { return false; }
+
+    _drawHeld();
+
+    for (auto& source : vertices) {
+        auto vertex = _append(source);
+        vertex->s = vertex->t = 0.0;
+        vertex->textureSlot = -1.0;
+        vertex->inputHasPremultipliedAlpha = 0.0;
+    }
+
+    ++_statistics.batchedDraws;
+    return true;
+}
+
+bool BatchRenderer::add(const std::vector<shaders::TextureVertex>& vertices, GLuint texture, bool inputHasPremultipliedAlpha) {
+    if (!_isEnabled) { return false; }
+
+    _drawHeld();
+
+    auto slot = _textureSlot(texture);
+    if (slot < 0) {
+        flush();
+        slot = _textureSlot(texture);
+    }
+
+    for (auto& source : vertices) {
+        auto vertex = _append(source);
+        vertex->s = source.s;
+        vertex->t = source.t;
+        vertex->textureSlot = static_cast<GLfloat>(slot);
+        vertex->inputHasPremultipliedAlpha = inputHasPremultipliedAlpha ? 1.0 : 0.0;
+    }
+
+    ++_statistics.batchedDraws;
+    return true;
+}
+
+bool BatchRenderer::hold(Holder* holder) {
+    if (!_isEnabled) { return false; }
+
+    if (_holder != holder) {
+        flush();
+        _holder = holder;
+    }
+    return true;
+}
+
+void BatchRenderer::forget(Holder* holder) {
+    if (_holder == holder) {
+        _holder = nullptr;
+    }
+}
+
+void BatchRenderer::didDraw(size_t vertices) {
+    ++_statistics.drawCalls;
+    _statistics.vertices += vertices;
+}
+
+void BatchRenderer::flush() {
+    _drawHeld();
+
+    if (!_vertices.empty()) {
+        if (!_program) {
+            _createProgram();
+        }
+
+        _program->use();
+        _blendingFlagsUniform = (GLint)(Blending::Current().premultipliedSourceAlpha ? 2 : 0);
+
+        for (size_t i = 0; i < _textureCount; ++i) {
+            glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(i));
+            glBindTexture(GL_TEXTURE_2D, _textures[i]);
+        }
+
+        glDisable(GL_SCISSOR_TEST);
+        glViewport(0, 0, _targetWidth, _targetHeight);
+
+        auto stream = opengl::StreamingVertexBuffer::Current();
+        if (auto first = stream ? stream->write(_vertices.data(), _vertices.size()) : stdts::nullopt) {
+            _streamingVertexArray.bind(*stream);
+            glDrawArrays(GL_TRIANGLES, *first, static_cast<GLsizei>(_vertices.size()));
+            _streamingVertexArray.unbind();
+        } else {
+            _vertexArrayBuffer->bind();
+            _vertexArrayBuffer->stream(_vertices.data(), _vertices.size());
+            glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(_vertices.size()));
+            _vertexArrayBuffer->unbind();
+        }
+
+        glViewport(_viewport.x, _viewport.y, _viewport.width, _viewport.height);
+        glActiveTexture(GL_TEXTURE0);
+
+        ++_statistics.batches;
+        didDraw(_vertices.size());
+
+        _vertices.clear();
+        _textureCount = 0;
+        _needsScissorUpdate = true;
+    }
+
+    if (_needsScissorUpdate) {
+        _applyScissor();
+        _needsScissorUpdate = false;
+    }
+}
+
+void BatchRenderer::SetTarget(int width, int height) {
+    DisplayList::Perform([=] {
+        if (auto batch = Current()) {
+            batch->setTarget(width, height);
+        }
+    });
+}
+
+void BatchRenderer::SetViewport(const Rectangle<int>& viewport) {
+    DisplayList::Perform([=] {
+        if (auto batch = Current()) {
+            batch->setViewport(viewport);
+        } else {
+            glViewport(viewport.x, viewport.y, viewport.width, viewport.height);
+        }
+    });
+}
+
+void BatchRenderer::SetScissor(stdts::optional<Rectangle<int>> scissor) {
+    DisplayList::Perform([=] {
+        if (auto batch = Current()) {
+            batch->setScissor(scissor);
+        } else if (scissor) {
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(scissor->x, scissor->y, scissor->width, scissor->height);
+        } else {
+            glDisable(GL_SCISSOR_TEST);
+        }
+    });
+}
+
+void BatchRenderer::Flush() {
+    DisplayList::Perform([] {
+        if (auto batch = Current()) {
+            batch->flush();
+        }
+    });
+}
+
+template <typename SourceVertex>
+BatchRenderer::Vertex* BatchRenderer::_append(const SourceVertex& source) {
+    _vertices.emplace_back();
+    auto& vertex = _vertices.back();
+
+    // convert from the viewport's normalized device coordinates to the target's
+    vertex.x = ((source.x + 1.0f) * 0.5f * _viewport.width + _viewport.x) * 2.0f / _targetWidth - 1.0f;
+    vertex.y = ((source.y + 1.0f) * 0.5f * _viewport.height + _viewport.y) * 2.0f / _targetHeight - 1.0f;
+
+    vertex.r = source.r;
+    vertex.g = source.g;
+    vertex.b = source.b;
+    vertex.a = source.a;
+
+    vertex.cu = source.cu;
+    vertex.cv = source.cv;
+    vertex.cm = source.cm;
+    vertex.caa = source.caa;
+
+    if (_scissor) {
+        vertex.clipX1 = _scissor->minX();
+        vertex.clipY1 = _scissor->minY();
+        vertex.clipX2 = _scissor->maxX();
+        vertex.clipY2 = _scissor->maxY();
+    } else {
+        vertex.clipX1 = vertex.clipY1 = -1.0e9;
+        vertex.clipX2 = vertex.clipY2 = 1.0e9;
+    }
+
+    return &vertex;
+}
+
+void BatchRenderer::_drawHeld() {
+    if (!_holder) { return; }
+
+    // let go of the holder first in case its draw flushes
+    auto holder = _holder;
+    _holder = nullptr;
+
+    glDisable(GL_SCISSOR_TEST);
+    glViewport(0, 0, _targetWidth, _targetHeight);
+    holder->drawHeld();
+    glViewport(_viewport.x, _viewport.y, _viewport.width, _viewport.height);
+    _needsScissorUpdate = true;
+}
+
+int BatchRenderer::_textureSlot(GLuint texture) {
+    for (size_t i = 0; i < _textureCount; ++i) {
+        if (_textures[i] == texture) {
+            return static_cast<int>(i);
+        }
+    }
+
+    if (_textureCount == kMaxTextureSlots) {
+        return -1;
+    }
+
+    _textures[_textureCount] = texture;
+    return static_cast<int>(_textureCount++);
+}
+
+void BatchRenderer::_applyScissor() {
+    if (_scissor) {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(_scissor->x, _scissor->y, _scissor->width, _scissor->height);
+    } else {
+        glDisable(GL_SCISSOR_TEST);
+    }
+}
+
+void BatchRenderer::_createProgram() {
+    auto vsh = scraps::opengl::CommonVertexShaderHeader() + R"(
+        ATTRIBUTE_IN vec2 positionAttrib;
+        ATTRIBUTE_IN vec4 colorAttrib;
+        ATTRIBUTE_IN vec4 curveAttrib;
+        ATTRIBUTE_IN vec2 textureCoordAttrib;
+        ATTRIBUTE_IN vec4 clipAttrib;
+        ATTRIBUTE_IN vec2 textureInfoAttrib;
+
+        VARYING_OUT vec4 color;
+        VARYING_OUT vec4 curve;
+        VARYING_OUT vec2 textureCoord;
+        VARYING_OUT vec4 clip;
+        VARYING_OUT vec2 textureInfo;
+
+        void main() {
+            color = colorAttrib;
+            curve = curveAttrib;
+            textureCoord = textureCoordAttrib;
+            clip = clipAttrib;
+            textureInfo = textureInfoAttrib;
+            gl_Position = vec4(positionAttrib, 0.0, 1.0);
+        }
+    )";
+
+    std::string samplers, sampling;
+    for (size_t i = 0; i < kMaxTextureSlots; ++i) {
+        auto n = std::to_string(i);
+        samplers += "uniform sampler2D textureSampler" + n + ";\n";
+        sampling += "if (slot < " + n + ".5) { return SAMPLE(textureSampler" + n + ", textureCoord); }\n";
+    }
+
+    auto fsh = CommonOKUIFragmentShaderHeader() + samplers + R"(
+        VARYING_IN vec4 color;
+        VARYING_IN vec4 curve;
+        VARYING_IN vec2 textureCoord;
+        VARYING_IN vec4 clip;
+        VARYING_IN vec2 textureInfo;
+
+        vec4 sampleTexture(float slot) {
+            )" + sampling + R"(
+            return vec4(0.0);
+        }
+
+        void main() {
+            if (gl_FragCoord.x < clip.x || gl_FragCoord.y < clip.y || gl_FragCoord.x > clip.z || gl_FragCoord.y > clip.w) {
+                discard;
+            }
+
+            float alphaMultiplier = 1.0;
+            if (curve.z > 1.5) {
+                if (abs(curve.s) >= 0.5 || abs(curve.t) >= 0.5) {
+                    discard;
+                }
+                float dist = sqrt(curve.s * curve.s + curve.t * curve.t);
+                float aa = curve.w;
+                if (dist > 0.5 + 0.5 * aa) {
+                    discard;
+                } else if (dist > 0.5 - 0.5 * aa) {
+                    alphaMultiplier = 1.0 - (dist - (0.5 - 0.5 * aa)) / aa;
+                }
+            } else if (curve.z != 0.0) {
+                float dist = pow(curve.s, 2.0) - curve.t;
+                float aa = curve.w;
+                dist -= curve.z * aa;
+                if (dist < 0.0 != curve.z < 0.0) {
+                    float x = abs(dist) / (2.0 * aa);
+                    if (x < 1.0) {
+                        alphaMultiplier = (1.0 - x);
+                    } else {
+                        discard;
+                    }
+                }
+            }
+
+            vec4 c = color;
+            if (textureInfo.x > -0.5) {
+                vec4 texel = sampleTexture(textureInfo.x);
+                if (textureInfo.y > 0.5) {
+                    texel = vec4(texel.a > 0.0 ? texel.rgb / texel.a : vec3(0.0), texel.a);
+                }
+                c = vec4(texel.rgb * color.rgb, texel.a * color.a);
+            }
+
+            COLOR_OUT = multipliedOutput(vec4(c.rgb, c.a * alphaMultiplier));
+        }
+    )";
+
+    enum : GLuint {
+        kPositionAttrib,
+        kColorAttrib,
+        kCurveAttrib,
+        kTextureCoordAttrib,
+        kClipAttrib,
+        kTextureInfoAttrib,
+    };
+
+    _program = std::make_unique<opengl::ShaderProgram>();
+    _program->bindAttribute(kPositionAttrib, "positionAttrib");
+    _program->bindAttribute(kColorAttrib, "colorAttrib");
+    _program->bindAttribute(kCurveAttrib, "curveAttrib");
+    _program->bindAttribute(kTextureCoordAttrib, "textureCoordAttrib");
+    _program->bindAttribute(kClipAttrib, "clipAttrib");
+    _program->bindAttribute(kTextureInfoAttrib, "textureInfoAttrib");
+    _program->link(vsh, fsh);
+    _program->use();
+
+    for (size_t i = 0; i < kMaxTextureSlots; ++i) {
+        _program->uniform(("textureSampler" + std::to_string(i)).c_str()) = static_cast<GLint>(i);
+    }
+    _blendingFlagsUniform = _program->uniform("blendingFlags");
+
+    if (!_program->error().empty()) {
+        SCRAPS_LOGF_ERROR("error creating shader: %s", _program->error().c_str());
+    }
+
+    _vertexArrayBuffer = std::make_unique<scraps::opengl::VertexArrayBuffer>();
+    auto stride = static_cast<GLsizei>(sizeof(Vertex));
+    _vertexArrayBuffer->setAttribute(kPositionAttrib, 2, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, x));
+    _vertexArrayBuffer->setAttribute(kColorAttrib, 4, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, r));
+    _vertexArrayBuffer->setAttribute(kCurveAttrib, 4, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, cu));
+    _vertexArrayBuffer->setAttribute(kTextureCoordAttrib, 2, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, s));
+    _vertexArrayBuffer->setAttribute(kClipAttrib, 4, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, clipX1));
+    _vertexArrayBuffer->setAttribute(kTextureInfoAttrib, 2, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, textureSlot));
+
+    _streamingVertexArray.setAttribute(kPositionAttrib, 2, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, x));
+    _streamingVertexArray.setAttribute(kColorAttrib, 4, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, r));
+    _streamingVertexArray.setAttribute(kCurveAttrib, 4, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, cu));
+    _streamingVertexArray.setAttribute(kTextureCoordAttrib, 2, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, s));
+    _streamingVertexArray.setAttribute(kClipAttrib, 4, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, clipX1));
+    _streamingVertexArray.setAttribute(kTextureInfoAttrib, 2, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, textureSlot));
+
+    SCRAPS_GL_ERROR_CHECK();
+}
+
+} // namespace okui
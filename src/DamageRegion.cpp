@@ -0,0 +1,114 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/DamageRegion.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace okui {
+
+namespace {
+    double Area(const Rectangle<double>& r) { return r.width * r.height; }
+
+    bool Contains(const Rectangle<double>& a, const Rectangle<double>& b) {
+        return b.minX() >= a.minX() && b.maxX() <= a.maxX() && b.minY() >= a.minY() && b.maxY() <= a.maxY();
+    }
+}
+
+void DamageRegion::add(const Rectangle<double>& rectangle) {
+    if (rectangle.width <= 0 || rectangle.height <= 0) { return; }
+
+    auto merged = rectangle;
+
+    // keep absorbing overlapping rectangles until the new one is disjoint from the rest
+    for (auto it = _rectangles.begin(); it != _rectangles.end();) {
+        if (Contains(*it, merged)) {
+            return;
+        } else if (merged.intersects(*it)) {
+            merged = merged.unionBounds(*it);
+            _rectangles.erase(it);
+            it = _rectangles.begin();
+        } else {
+            ++it;
+        }
+    }
+
+    _rectangles.emplace_back(merged);
+    _reduce();
+}
+
+void DamageRegion::add(const DamageRegion& other) {
+    for (auto& rectangle : other._rectangles) {
+        add(rectangle);
+    }
+}
+
+Rectangle<double> DamageRegion::bounds() const {
+    Rectangle<double> ret;
+    for (auto& rectangle : _rectangles) {
+        ret = ret.unionBounds(rectangle);
+    }
+    return ret;
+}
+
+double DamageRegion::area() const {
+    double ret = 0.0;
+    for (auto& rectangle : _rectangles) {
+        ret += Area(rectangle);
+    }
+    return ret;
+}
+
+void DamageRegion::setMaxRectangles(size_t maxRectangles) {
+    _maxRectangles = std::max<size_t>(maxRectangles, 1);
+    _reduce();
+}
+
+Rectangle<int> DamageRegion::PixelBounds(const Rectangle<double>& rectangle, double xScale, double yScale) {
+    auto minX = static_cast<int>(std::floor(rectangle.minX() * xScale));
+    auto minY = static_cast<int>(std::floor(rectangle.minY() * yScale));
+    auto maxX = static_cast<int>(std::ceil(rectangle.maxX() * xScale));
+    auto maxY = static_cast<int>(std::ceil(rectangle.maxY() * yScale));
+    return {minX, minY, maxX - minX, maxY - minY};
+}
+
+void DamageRegion::_reduce() {
+    while (_rectangles.size() > _maxRectangles) {
+        size_t bestA = 0, bestB = 1;
+        auto bestWaste = std::numeric_limits<double>::max();
+
+        for (size_t a = 0; a < _rectangles.size(); ++a) {
+            for (size_t b = a + 1; b < _rectangles.size(); ++b) {
+                auto waste = Area(_rectangles[a].unionBounds(_rectangles[b])) - Area(_rectangles[a]) - Area(_rectangles[b]);
+                if (waste < bestWaste) {
+                    bestWaste = waste;
+                    bestA = a;
+                    bestB = b;
+                }
+            }
+        }
+
+        auto merged = _rectangles[bestA].unionBounds(_rectangles[bestB]);
+        _rectangles.erase(_rectangles.begin() + bestB);
+        _rectangles.erase(_rectangles.begin() + bestA);
+
+        // the merged rectangle may now overlap others
+        add(merged);
+    }
+}
+
+} // namespace okui
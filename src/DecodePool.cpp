@@ -0,0 +1,137 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/DecodePool.h>
+
+#include <algorithm>
+
+namespace okui {
+
+DecodePool::DecodePool(size_t threadCount) {
+    for (size_t i = 0; i < std::max<size_t>(threadCount, 1); ++i) {
+        _threads.emplace_back([this] { _run(); });
+    }
+}
+
+DecodePool::~DecodePool() {
+    cancelAndJoin();
+}
+
+size_t DecodePool::DefaultThreadCount() {
+    auto hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+}
+
+DecodePool::Ticket DecodePool::async(Priority priority, std::function<void()> function) {
+    auto task = std::make_shared<Task>();
+    task->_function = std::move(function);
+    task->_priority = priority;
+    task->_submissionTime = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        if (_shouldExit) {
+            task->_state = Task::State::kCanceled;
+            return task;
+        }
+        _queues[static_cast<size_t>(priority)].push_back(task);
+        ++_statistics.queued;
+    }
+
+    _condition.notify_one();
+    return task;
+}
+
+void DecodePool::setPriority(const Ticket& ticket, Priority priority) {
+    std::lock_guard<std::mutex> lock{_mutex};
+    if (ticket->_state != Task::State::kQueued || ticket->_priority == priority) { return; }
+
+    auto& from = _queues[static_cast<size_t>(ticket->_priority)];
+    from.erase(std::find(from.begin(), from.end(), ticket));
+    _queues[static_cast<size_t>(priority)].push_back(ticket);
+    ticket->_priority = priority;
+}
+
+bool DecodePool::cancel(const Ticket& ticket) {
+    std::lock_guard<std::mutex> lock{_mutex};
+    if (ticket->_state != Task::State::kQueued) { return false; }
+
+    auto& queue = _queues[static_cast<size_t>(ticket->_priority)];
+    queue.erase(std::find(queue.begin(), queue.end(), ticket));
+    ticket->_state = Task::State::kCanceled;
+    ticket->_function = nullptr;
+    --_statistics.queued;
+    ++_statistics.canceled;
+    return true;
+}
+
+void DecodePool::cancelAndJoin() {
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _shouldExit = true;
+        for (auto& queue : _queues) {
+            for (auto& task : queue) {
+                task->_state = Task::State::kCanceled;
+                task->_function = nullptr;
+                ++_statistics.canceled;
+            }
+            queue.clear();
+        }
+        _statistics.queued = 0;
+    }
+    _condition.notify_all();
+
+    for (auto& thread : _threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+DecodePool::Statistics DecodePool::statistics() const {
+    std::lock_guard<std::mutex> lock{_mutex};
+    return _statistics;
+}
+
+void DecodePool::_run() {
+    std::unique_lock<std::mutex> lock{_mutex};
+    while (true) {
+        _condition.wait(lock, [&] { return _shouldExit || _statistics.queued > 0; });
+        if (_shouldExit) { break; }
+
+        auto queue = std::find_if(_queues.begin(), _queues.end(), [](auto& queue) { return !queue.empty(); });
+        auto task = std::move(queue->front());
+        queue->pop_front();
+        task->_state = Task::State::kRunning;
+        --_statistics.queued;
+        ++_statistics.running;
+
+        auto function = std::move(task->_function);
+        lock.unlock();
+        function();
+        function = nullptr;
+        auto latency = std::chrono::steady_clock::now() - task->_submissionTime;
+        lock.lock();
+
+        task->_state = Task::State::kFinished;
+        --_statistics.running;
+        ++_statistics.completed;
+        _totalLatency += latency;
+        _statistics.averageLatency = std::chrono::duration_cast<std::chrono::microseconds>(_totalLatency / _statistics.completed);
+        _statistics.maximumLatency = std::max(_statistics.maximumLatency, std::chrono::duration_cast<std::chrono::microseconds>(latency));
+    }
+}
+
+} // namespace okui
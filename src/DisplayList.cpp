@@ -0,0 +1,46 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/DisplayList.h>
+
+namespace okui {
+
+DisplayList* DisplayList::_sCurrent = nullptr;
+bool DisplayList::_sIsDeferring = false;
+
+void DisplayList::replay() const {
+    if (IsDeferring()) {
+        if (_sCurrent != this) {
+            _sCurrent->_commands.insert(_sCurrent->_commands.end(), _commands.begin(), _commands.end());
+        }
+        return;
+    }
+
+    for (auto& command : _commands) {
+        command();
+    }
+}
+
+DisplayList::Recording::Recording(DisplayList* displayList, bool defers) : _previous{_sCurrent}, _previousIsDeferring{_sIsDeferring} {
+    _sCurrent = displayList;
+    _sIsDeferring = _sIsDeferring || defers;
+}
+
+DisplayList::Recording::~Recording() {
+    _sCurrent = _previous;
+    _sIsDeferring = _previousIsDeferring;
+}
+
+} // namespace okui
@@ -15,12 +15,18 @@
 */
 #include <okui/FileTexture.h>
 
+#include <okui/opengl/ContextOwnership.h>
+#include <okui/opengl/TextureCompression.h>
+#include <okui/opengl/TextureUploadBuffer.h>
+
 #include <gsl.h>
 
 #include <png.h>
 
 #include <turbojpeg.h>
 
+#include <algorithm>
+
 namespace okui {
 
 namespace {
@@ -68,11 +74,121 @@ namespace {
 
     void PNGWarning(png_structp png, png_const_charp message) { /* nop */ }
 
+    /**
+    * Returns whether the driver supports uploading compressed data in the given format, or nullopt if it hasn't been
+    * queried yet. ETC1 data is also valid ETC2 data, so ETC2 is substituted for ETC1 if only it is supported.
+    */
+    stdts::optional<bool> CompressedUploadFormat(GLenum* format) {
+        auto isSupported = opengl::KnownCompressedTextureFormatSupport(*format);
+        if (isSupported && !*isSupported && *format == opengl::kCompressedRGB8ETC1
+            && opengl::KnownCompressedTextureFormatSupport(opengl::kCompressedRGB8ETC2).value_or(false)) {
+            *format = opengl::kCompressedRGB8ETC2;
+            return true;
+        }
+        return isSupported;
+    }
+
+    /**
+    * Returns the scale at which an image can be decoded while still covering the target size.
+    */
+    double CoveringScale(int width, int height, int targetWidth, int targetHeight) {
+        if (width <= 0 || height <= 0 || (targetWidth <= 0 && targetHeight <= 0)) {
+            return 1.0;
+        }
+        auto scale = std::max(targetWidth > 0 ? static_cast<double>(targetWidth) / width : 0.0,
+                              targetHeight > 0 ? static_cast<double>(targetHeight) / height : 0.0);
+        return std::min(scale, 1.0);
+    }
+
+    /**
+    * Averages each factor x factor block of source pixels into a single destination pixel. Source rows are added
+    * one at a time so that the full resolution image never needs to be held in memory.
+    *
+    * If the last component is alpha, the color components are weighted by it so that the colors of transparent
+    * pixels don't bleed into their neighbors. Fully transparent blocks get the unweighted average.
+    */
+    template <typename Sample>
+    class BoxFilter {
+    public:
+        BoxFilter(int width, int components, int factor, uint8_t* destination, int destinationBytesPerRow)
+            : _width{width}
+            , _components{components}
+            , _factor{factor}
+            , _destination{destination}
+            , _destinationBytesPerRow{destinationBytesPerRow}
+            , _hasAlpha{components == 2 || components == 4}
+            , _sums(((width + factor - 1) / factor) * components)
+            , _weightedSums(_hasAlpha ? _sums.size() : 0)
+        {}
+
+        void addRow(const uint8_t* row) {
+            auto samples = reinterpret_cast<const Sample*>(row);
+            for (int x = 0; x < _width; ++x) {
+                auto block = (x / _factor) * _components;
+                auto pixel = &samples[x * _components];
+                for (int c = 0; c < _components; ++c) {
+                    _sums[block + c] += pixel[c];
+                }
+                if (_hasAlpha) {
+                    uint64_t alpha = pixel[_components - 1];
+                    for (int c = 0; c < _components - 1; ++c) {
+                        _weightedSums[block + c] += pixel[c] * alpha;
+                    }
+                }
+            }
+            if (++_rows == _factor) {
+                _flush();
+            }
+        }
+
+        /**
+        * Writes out the partial block at the bottom of the image, if any.
+        */
+        void finish() { _flush(); }
+
+    private:
+        void _flush() {
+            if (!_rows) { return; }
+
+            auto row = reinterpret_cast<Sample*>(_destination);
+            auto columns = static_cast<int>(_sums.size()) / _components;
+            for (int x = 0; x < columns; ++x) {
+                auto block = x * _components;
+                uint64_t count = std::min(_factor, _width - x * _factor) * _rows;
+                auto alphaSum = _hasAlpha ? _sums[block + _components - 1] : 0;
+                for (int c = 0; c < _components; ++c) {
+                    if (alphaSum && c < _components - 1) {
+                        row[block + c] = static_cast<Sample>((_weightedSums[block + c] + alphaSum / 2) / alphaSum);
+                    } else {
+                        row[block + c] = static_cast<Sample>((_sums[block + c] + count / 2) / count);
+                    }
+                }
+            }
+
+            std::fill(_sums.begin(), _sums.end(), 0);
+            std::fill(_weightedSums.begin(), _weightedSums.end(), 0);
+            _destination += _destinationBytesPerRow;
+            _rows = 0;
+        }
+
+        const int             _width;
+        const int             _components;
+        const int             _factor;
+        uint8_t*              _destination;
+        const int             _destinationBytesPerRow;
+        const bool            _hasAlpha;
+        std::vector<uint64_t> _sums;
+        std::vector<uint64_t> _weightedSums;
+        int                   _rows = 0;
+    };
+
 } // anonymous namespace
 
 FileTexture::~FileTexture() {
     if (_id) {
-        glDeleteTextures(1, &_id);
+        opengl::ReleaseResources([id = _id] {
+            glDeleteTextures(1, &id);
+        });
     }
 }
 
@@ -80,7 +196,9 @@ void FileTexture::setData(std::shared_ptr<const std::string> data, std::string n
     _name = std::move(name);
     _data = std::move(data);
 
-    if (_readPNGMetadata()) {
+    if (_readKTXMetadata()) {
+        _type = Type::kKTX;
+    } else if (_readPNGMetadata()) {
         _type = Type::kPNG;
     } else if (_readJPEGMetadata()) {
         _type = Type::kJPEG;
@@ -95,12 +213,32 @@ bool FileTexture::decompress() {
     switch (_type) {
         case Type::kPNG:  return _loadPNG();
         case Type::kJPEG: return _loadJPEG();
+        case Type::kKTX:  return _loadKTX();
         default:          return false;
     }
 }
 
 void FileTexture::load() {
-    if (_decompressedData.empty()) { return; }
+    if (_compressedFormat) {
+        auto format = _compressedFormat;
+        _compressedFormat = 0;
+
+        // this makes sure the driver has been queried
+        opengl::IsCompressedTextureFormatSupported(format);
+
+        if (*CompressedUploadFormat(&format)) {
+            _loadCompressedKTX(format);
+            return;
+        }
+
+        // this only happens if the texture was decompressed before the driver was first queried
+        if (!_decompressKTX()) { return; }
+    }
+
+    if (_decompressedData.empty() && !_uploadBuffer) { return; }
+
+    _width = _decodedWidth;
+    _height = _decodedHeight;
 
     glGenTextures(1, &_id);
     glBindTexture(GL_TEXTURE_2D, _id);
@@ -115,7 +253,20 @@ void FileTexture::load() {
         internalFormat = GL_RG8;
     }
 #endif
-    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, _allocatedWidth, _allocatedHeight, 0, _textureType.format, _textureType.type, _decompressedData.data());
+    auto size = uploadSize();
+    const void* pixels = _decompressedData.data();
+    if (_uploadBuffer) {
+        _uploadBuffer->bind();
+        pixels = nullptr;
+    }
+
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, _allocatedWidth, _allocatedHeight, 0, _textureType.format, _textureType.type, pixels);
+
+    if (_uploadBuffer) {
+        // the driver keeps the buffer's storage alive until the upload is complete
+        _uploadBuffer->unbind();
+        _uploadBuffer.reset();
+    }
 
 #if OPENGL_ES
     bool useMipmaps = IsPowerOfTwo(_allocatedWidth) && IsPowerOfTwo(_allocatedHeight);
@@ -146,7 +297,85 @@ void FileTexture::load() {
 
     SCRAPS_GL_ERROR_CHECK();
 
+    _gpuBytes = size;
+    if (useMipmaps) {
+        _gpuBytes += _gpuBytes / 3;
+    }
+
+    _decompressedData.clear();
+}
+
+bool FileTexture::stage() {
+    if (_compressedFormat || _decompressedData.empty() || _uploadBuffer || !opengl::TextureUploadBuffer::IsSupported()) { return false; }
+
+    auto buffer = std::make_unique<opengl::TextureUploadBuffer>();
+    if (!buffer->stage(_decompressedData.data(), _decompressedData.size())) { return false; }
+
+    _uploadBuffer = std::move(buffer);
+    _decompressedData.clear();
+    _decompressedData.shrink_to_fit();
+    return true;
+}
+
+size_t FileTexture::uploadSize() const {
+    if (_uploadBuffer) {
+        return _uploadBuffer->size();
+    }
+
+    if (!_compressedFormat) {
+        return _decompressedData.size();
+    }
+
+    size_t size = 0;
+    for (size_t i = _ktxBaseLevel; i < _ktx.levels().size(); ++i) {
+        size += _ktx.levels()[i].size;
+    }
+    return size;
+}
+
+bool FileTexture::loadIntoAtlas(TextureAtlas* atlas) {
+    if (_decompressedData.empty() || _textureType.type != GL_UNSIGNED_BYTE || !atlas->accepts(_decodedWidth, _decodedHeight)) { return false; }
+
+    int components = 0;
+    if (_textureType.format == GL_RGBA) {
+        components = 4;
+    } else if (_textureType.format == GL_RGB) {
+        components = 3;
+    } else {
+        return false;
+    }
+
+    // the atlas wants tightly packed rgba rows
+    auto bytesPerRow = components * _allocatedWidth;
+    if (bytesPerRow % 4) {
+        bytesPerRow += 4 - (bytesPerRow % 4);
+    }
+
+    std::vector<uint8_t> pixels(_decodedWidth * _decodedHeight * 4);
+    for (int y = 0; y < _decodedHeight; ++y) {
+        auto row = &_decompressedData[y * bytesPerRow];
+        for (int x = 0; x < _decodedWidth; ++x) {
+            auto pixel = &pixels[(y * _decodedWidth + x) * 4];
+            memcpy(pixel, &row[x * components], components);
+            if (components == 3) {
+                pixel[3] = 255;
+            }
+        }
+    }
+
+    _atlasAllocation = atlas->add(_decodedWidth, _decodedHeight, pixels.data());
+    if (!_atlasAllocation) { return false; }
+
+    _width = _decodedWidth;
+    _height = _decodedHeight;
+    _gpuBytes = _decodedWidth * _decodedHeight * 4;
+
     _decompressedData.clear();
+    return true;
+}
+
+Rectangle<double> FileTexture::region() const {
+    return _atlasAllocation ? _atlasAllocation->coordinates() : TextureInterface::region();
 }
 
 bool FileTexture::_readPNGMetadata() {
@@ -170,6 +399,16 @@ bool FileTexture::_readPNGMetadata() {
     return true;
 }
 
+bool FileTexture::_readKTXMetadata() {
+    if (!KTXContainer::IsKTX(_data->data(), _data->size()) || !_ktx.parse(_data->data(), _data->size())) {
+        return false;
+    }
+
+    _width = _ktx.width();
+    _height = _ktx.height();
+    return true;
+}
+
 bool FileTexture::_readJPEGMetadata() {
     auto decompressor = tjInitDecompress();
     auto _ = gsl::finally([&]{ tjDestroy(decompressor); });
@@ -261,13 +500,18 @@ bool FileTexture::_loadPNG() {
         }
     }
 
+    // decode at the largest integer reduction that still covers the target size
+    auto factor = std::max(static_cast<int>(1.0 / CoveringScale(_width, _height, _targetWidth, _targetHeight)), 1);
+    _decodedWidth = (_width + factor - 1) / factor;
+    _decodedHeight = (_height + factor - 1) / factor;
+
 #if OPENGL_ES
     // make powers of 2 so we can use mipmaps
-    _allocatedWidth = NextPowerOfTwo(_width);
-    _allocatedHeight = NextPowerOfTwo(_height);
+    _allocatedWidth = NextPowerOfTwo(_decodedWidth);
+    _allocatedHeight = NextPowerOfTwo(_decodedHeight);
 #else
-    _allocatedWidth = _width;
-    _allocatedHeight = _height;
+    _allocatedWidth = _decodedWidth;
+    _allocatedHeight = _decodedHeight;
 #endif
 
     bytesPerRow = components * (bitDepth >> 3) * _allocatedWidth;
@@ -279,12 +523,45 @@ bool FileTexture::_loadPNG() {
 
     _decompressedData.resize(bytesPerRow * _allocatedHeight);
 
-    std::vector<png_byte*> rowPointers;
-    for (int i = 0; i < _allocatedHeight; ++i) {
-        rowPointers.emplace_back(_decompressedData.data() + i * bytesPerRow);
-    }
+    if (factor == 1) {
+        std::vector<png_byte*> rowPointers;
+        for (int i = 0; i < _allocatedHeight; ++i) {
+            rowPointers.emplace_back(_decompressedData.data() + i * bytesPerRow);
+        }
 
-    png_read_image(png, rowPointers.data());
+        png_read_image(png, rowPointers.data());
+    } else {
+        auto sourceBytesPerRow = components * (bitDepth >> 3) * _width;
+        auto isInterlaced = png_get_interlace_type(png, info) != PNG_INTERLACE_NONE;
+
+        // interlaced images can't be decoded a row at a time, so those are decoded in full first
+        std::vector<png_byte> source(sourceBytesPerRow * (isInterlaced ? _height : 1));
+
+        auto downscale = [&](auto filter) {
+            if (isInterlaced) {
+                std::vector<png_byte*> rowPointers;
+                for (int i = 0; i < _height; ++i) {
+                    rowPointers.emplace_back(source.data() + i * sourceBytesPerRow);
+                }
+                png_read_image(png, rowPointers.data());
+                for (auto row : rowPointers) {
+                    filter.addRow(row);
+                }
+            } else {
+                for (int i = 0; i < _height; ++i) {
+                    png_read_row(png, source.data(), nullptr);
+                    filter.addRow(source.data());
+                }
+            }
+            filter.finish();
+        };
+
+        if (bitDepth == 8) {
+            downscale(BoxFilter<uint8_t>{_width, components, factor, _decompressedData.data(), bytesPerRow});
+        } else {
+            downscale(BoxFilter<uint16_t>{_width, components, factor, _decompressedData.data(), bytesPerRow});
+        }
+    }
 
     static_assert(sizeof(png_byte) == sizeof(uint8_t), "sizeof(png_byte) must be sizeof(char)");
 
@@ -304,13 +581,27 @@ bool FileTexture::_loadJPEG() {
         return false;
     }
 
+    // libjpeg-turbo can decode at 1/2, 1/4, or 1/8 scale using a reduced idct, which is much cheaper than a full
+    // decode. pick the smallest of those that still covers the target size
+    auto scale = CoveringScale(width, height, _targetWidth, _targetHeight);
+    tjscalingfactor scalingFactor{1, 1};
+    for (auto denominator : {8, 4, 2}) {
+        if (1.0 / denominator >= scale) {
+            scalingFactor = {1, denominator};
+            break;
+        }
+    }
+
+    _decodedWidth = TJSCALED(width, scalingFactor);
+    _decodedHeight = TJSCALED(height, scalingFactor);
+
 #if OPENGL_ES
     // make powers of 2 so we can use mipmaps
-    _allocatedWidth = NextPowerOfTwo(width);
-    _allocatedHeight = NextPowerOfTwo(height);
+    _allocatedWidth = NextPowerOfTwo(_decodedWidth);
+    _allocatedHeight = NextPowerOfTwo(_decodedHeight);
 #else
-    _allocatedWidth = _width;
-    _allocatedHeight = _height;
+    _allocatedWidth = _decodedWidth;
+    _allocatedHeight = _decodedHeight;
 #endif
 
     auto pixelFormat = jpegColorspace == TJCS_GRAY ? TJPF_GRAY : TJPF_RGB;
@@ -318,7 +609,7 @@ bool FileTexture::_loadJPEG() {
 
     _decompressedData.resize(bytesPerRow * _allocatedHeight);
 
-    if (tjDecompress2(decompressor, reinterpret_cast<const unsigned char*>(_data->data()), _data->size(), _decompressedData.data(), width, bytesPerRow, height, pixelFormat, 0)) {
+    if (tjDecompress2(decompressor, reinterpret_cast<const unsigned char*>(_data->data()), _data->size(), _decompressedData.data(), _decodedWidth, bytesPerRow, _decodedHeight, pixelFormat, 0)) {
         SCRAPS_LOG_ERROR("jpeg decompression error {}: {}", _name, tjGetErrorStr());
         // If there's an error loading the header it's unrecoverable, but an error here, decompressing
         // the body, should just show whatever data was successfully decompressed.
@@ -345,4 +636,96 @@ bool FileTexture::_loadJPEG() {
     return true;
 }
 
+bool FileTexture::_loadKTX() {
+    auto& levels = _ktx.levels();
+
+    // skip the mip levels that are larger than needed to cover the target size
+    auto scale = CoveringScale(_width, _height, _targetWidth, _targetHeight);
+    _ktxBaseLevel = 0;
+    while (_ktxBaseLevel + 1 < levels.size() && levels[_ktxBaseLevel + 1].width >= _width * scale && levels[_ktxBaseLevel + 1].height >= _height * scale) {
+        ++_ktxBaseLevel;
+    }
+
+    auto& level = levels[_ktxBaseLevel];
+    _decodedWidth = _allocatedWidth = level.width;
+    _decodedHeight = _allocatedHeight = level.height;
+
+    if (!_ktx.isCompressed()) {
+        // copy the rows so that they're aligned to 4-byte boundaries
+        auto rowSize = (_ktx.format() == GL_RGBA ? 4 : 3) * level.width;
+        auto sourceBytesPerRow = level.size / level.height;
+        auto bytesPerRow = (rowSize + 3) / 4 * 4;
+
+        _decompressedData.resize(bytesPerRow * level.height);
+        for (int y = 0; y < level.height; ++y) {
+            memcpy(&_decompressedData[y * bytesPerRow], level.data + y * sourceBytesPerRow, rowSize);
+        }
+
+        _textureType.format = _ktx.format();
+        _textureType.type = _ktx.type();
+        return true;
+    }
+
+    auto format = _ktx.internalFormat();
+    auto isSupported = CompressedUploadFormat(&format);
+    if (isSupported && !*isSupported) {
+        return _decompressKTX();
+    }
+
+    // the data is uploaded as-is by load. if the driver hasn't been queried yet, load will find out whether it can be
+    _compressedFormat = _ktx.internalFormat();
+    return true;
+}
+
+bool FileTexture::_decompressKTX() {
+    auto& level = _ktx.levels()[_ktxBaseLevel];
+
+    _decompressedData.resize(level.width * level.height * 4);
+    if (!opengl::DecompressTexture(_ktx.internalFormat(), level.data, level.size, level.width, level.height, _decompressedData.data())) {
+        SCRAPS_LOG_ERROR("unable to load {}: compressed format {} isn't supported", _name, _ktx.internalFormat());
+        _decompressedData.clear();
+        return false;
+    }
+
+    _textureType.format = GL_RGBA;
+    _textureType.type = GL_UNSIGNED_BYTE;
+    return true;
+}
+
+void FileTexture::_loadCompressedKTX(GLenum format) {
+    auto& levels = _ktx.levels();
+    auto levelCount = levels.size() - _ktxBaseLevel;
+
+#if !GL_TEXTURE_MAX_LEVEL
+    // without GL_TEXTURE_MAX_LEVEL, a partial mip chain would leave the texture incomplete
+    if (levels.back().width > 1 || levels.back().height > 1) {
+        levelCount = 1;
+    }
+#endif
+
+    glGenTextures(1, &_id);
+    glBindTexture(GL_TEXTURE_2D, _id);
+
+    _gpuBytes = 0;
+    for (size_t i = 0; i < levelCount; ++i) {
+        auto& level = levels[_ktxBaseLevel + i];
+        auto size = opengl::CompressedTextureSize(format, level.width, level.height);
+        glCompressedTexImage2D(GL_TEXTURE_2D, i, format, level.width, level.height, 0, size, level.data);
+        _gpuBytes += size;
+    }
+
+#if GL_TEXTURE_MAX_LEVEL
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+#endif
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    SCRAPS_GL_ERROR_CHECK();
+
+    _width = _decodedWidth;
+    _height = _decodedHeight;
+}
+
 } // namespace okui
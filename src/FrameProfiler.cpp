@@ -0,0 +1,248 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/FrameProfiler.h>
+
+#include <okui/View.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+#if __GNUC__
+#include <cxxabi.h>
+#endif
+
+namespace okui {
+
+thread_local FrameProfiler* FrameProfiler::_sCurrent = nullptr;
+
+namespace {
+
+std::string TypeName(const std::type_info* type) {
+    if (!type) { return "View"; }
+#if __GNUC__
+    int status = 0;
+    if (auto demangled = abi::__cxa_demangle(type->name(), nullptr, nullptr, &status)) {
+        std::string name{demangled};
+        std::free(demangled);
+        return name;
+    }
+#endif
+    return type->name();
+}
+
+void WriteEscaped(std::ostream& os, const std::string& str) {
+    os << '"';
+    for (auto c : str) {
+        switch (c) {
+            case '"':  os << "\\\""; break;
+            case '\\': os << "\\\\"; break;
+            case '\n': os << "\\n"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    os << ' ';
+                } else {
+                    os << c;
+                }
+        }
+    }
+    os << '"';
+}
+
+} // anonymous namespace
+
+FrameProfiler::PhaseScope::PhaseScope(FrameProfiler* profiler, Phase phase)
+    : _profiler{profiler && profiler->isEnabled() ? profiler : nullptr}
+    , _phase{phase}
+{
+    if (_profiler) {
+        _start = Clock::now();
+    }
+}
+
+FrameProfiler::PhaseScope::~PhaseScope() {
+    if (_profiler) {
+        _profiler->recordPhase(_phase, _start, Clock::now());
+    }
+}
+
+FrameProfiler::ViewScope::ViewScope(const View* view)
+    : _profiler{_sCurrent}
+    , _view{view}
+{
+    if (_profiler) {
+        _start = Clock::now();
+    }
+}
+
+void FrameProfiler::ViewScope::end() {
+    if (_profiler) {
+        _profiler->recordView(_view, _start, Clock::now());
+        _profiler = nullptr;
+    }
+}
+
+void FrameProfiler::setEnabled(bool enabled) {
+    _isEnabled = enabled;
+    if (!_isEnabled) {
+        if (_sCurrent == this) {
+            _sCurrent = nullptr;
+        }
+        _isFrameInProgress = false;
+        _pendingPhaseSpans.clear();
+    }
+}
+
+void FrameProfiler::setHistoryLength(size_t frames) {
+    _historyLength = frames;
+    while (_history.size() > _historyLength) {
+        _history.pop_front();
+    }
+}
+
+void FrameProfiler::beginFrame(Clock::time_point now) {
+    if (!_isEnabled) { return; }
+
+    if (_isFrameInProgress) {
+        endFrame(now);
+    }
+
+    _frame = FrameStats{};
+    _frame.number = _frameCount++;
+    _frame.frame.start = now;
+    _isFrameInProgress = true;
+    _sCurrent = this;
+
+    for (auto& span : _pendingPhaseSpans) {
+        _frame.frame.start = std::min(_frame.frame.start, span.start);
+        _frame.phases[static_cast<size_t>(span.phase)] += span.duration;
+        _frame.phaseSpans.emplace_back(span);
+    }
+    _pendingPhaseSpans.clear();
+}
+
+void FrameProfiler::endFrame(Clock::time_point now) {
+    if (!_isFrameInProgress) { return; }
+
+    _isFrameInProgress = false;
+    if (_sCurrent == this) {
+        _sCurrent = nullptr;
+    }
+
+    _frame.frame.duration = now - _frame.frame.start;
+    _history.emplace_back(std::move(_frame));
+    while (_history.size() > _historyLength) {
+        _history.pop_front();
+    }
+}
+
+void FrameProfiler::recordPhase(Phase phase, Clock::time_point start, Clock::time_point end) {
+    if (!_isEnabled) { return; }
+
+    PhaseSpan span;
+    span.start = start;
+    span.duration = end - start;
+    span.phase = phase;
+
+    if (_isFrameInProgress) {
+        _frame.phases[static_cast<size_t>(phase)] += span.duration;
+        _frame.phaseSpans.emplace_back(span);
+    } else {
+        _pendingPhaseSpans.emplace_back(span);
+    }
+}
+
+void FrameProfiler::recordView(const View* view, Clock::time_point start, Clock::time_point end) {
+    if (!_isFrameInProgress) { return; }
+
+    ViewSpan span;
+    span.start = start;
+    span.duration = end - start;
+    span.view = view;
+    span.type = view ? &typeid(*view) : nullptr;
+    _frame.viewSpans.emplace_back(span);
+}
+
+void FrameProfiler::writeChromeTrace(std::ostream& os) const {
+    if (_history.empty()) {
+        os << "{\"traceEvents\":[]}";
+        return;
+    }
+
+    auto epoch = _history.front().frame.start;
+    auto microseconds = [&](Clock::duration duration) {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    };
+
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool isFirst = true;
+    auto beginEvent = [&] {
+        if (!isFirst) { os << ','; }
+        isFirst = false;
+    };
+
+    auto writeSpan = [&](const std::string& name, const char* category, const Span& span) {
+        beginEvent();
+        os << "{\"name\":";
+        WriteEscaped(os, name);
+        os << ",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":0,\"tid\":0"
+           << ",\"ts\":" << microseconds(span.start - epoch)
+           << ",\"dur\":" << microseconds(span.duration) << '}';
+    };
+
+    for (auto& frame : _history) {
+        writeSpan("Frame " + std::to_string(frame.number), "frame", frame.frame);
+        for (auto& span : frame.phaseSpans) {
+            writeSpan(PhaseName(span.phase), "phase", span);
+        }
+        for (auto& span : frame.viewSpans) {
+            writeSpan(TypeName(span.type), "view", span);
+        }
+
+        beginEvent();
+        os << "{\"name\":\"Frame Counts\",\"ph\":\"C\",\"pid\":0,\"tid\":0,\"ts\":" << microseconds(frame.frame.start - epoch)
+           << ",\"args\":{\"shaderFlushes\":" << frame.shaderFlushes
+           << ",\"drawCalls\":" << frame.drawCalls
+           << ",\"triangles\":" << frame.triangles
+           << ",\"renderCacheRenders\":" << frame.renderCacheRenders
+           << ",\"layouts\":" << frame.layouts
+           << ",\"textureUploads\":" << frame.textureUploads
+           << ",\"textureUploadBytes\":" << frame.textureUploadBytes << "}}";
+    }
+
+    os << "]}";
+}
+
+std::string FrameProfiler::chromeTrace() const {
+    std::ostringstream ss;
+    writeChromeTrace(ss);
+    return ss.str();
+}
+
+const char* FrameProfiler::PhaseName(Phase phase) {
+    switch (phase) {
+        case Phase::kEvents: return "Events";
+        case Phase::kTasks:  return "Tasks";
+        case Phase::kUpdate: return "Update";
+        case Phase::kLayout: return "Layout";
+        case Phase::kRender: return "Render";
+        case Phase::kSwap:   return "Swap";
+    }
+    return "Unknown";
+}
+
+} // namespace okui
@@ -0,0 +1,275 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/KTXContainer.h>
+
+#include <okui/opengl/TextureCompression.h>
+
+#include <scraps/logging.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace okui {
+
+namespace {
+    constexpr uint8_t kKTX1Identifier[12] = {0xab, 0x4b, 0x54, 0x58, 0x20, 0x31, 0x31, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a};
+    constexpr uint8_t kKTX2Identifier[12] = {0xab, 0x4b, 0x54, 0x58, 0x20, 0x32, 0x30, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a};
+
+    uint32_t ReadNative32(const uint8_t* data, bool swap) {
+        uint32_t value;
+        memcpy(&value, data, sizeof(value));
+        if (swap) {
+            value = ((value & 0xff) << 24) | ((value & 0xff00) << 8) | ((value >> 8) & 0xff00) | (value >> 24);
+        }
+        return value;
+    }
+
+    uint64_t ReadLittleEndian(const uint8_t* data, size_t bytes) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            value |= static_cast<uint64_t>(data[i]) << (8 * i);
+        }
+        return value;
+    }
+
+    /**
+    * Returns the number of levels in a full mipmap chain for the given size: floor(log2(max(width, height))) + 1.
+    */
+    uint32_t MaximumLevelCount(uint32_t width, uint32_t height) {
+        uint32_t count = 1;
+        for (auto size = std::max(width, height); size > 1; size >>= 1) {
+            ++count;
+        }
+        return count;
+    }
+
+    /**
+    * Maps the Vulkan formats used by KTX2 to OpenGL formats. Returns false for unsupported formats.
+    */
+    bool GLFormatForVkFormat(uint32_t vkFormat, GLenum* internalFormat, GLenum* format, GLenum* type) {
+        *format = *type = 0;
+
+        switch (vkFormat) {
+            case 23: // VK_FORMAT_R8G8B8_UNORM
+                *internalFormat = *format = GL_RGB;
+                *type = GL_UNSIGNED_BYTE;
+                return true;
+            case 37: // VK_FORMAT_R8G8B8A8_UNORM
+                *internalFormat = *format = GL_RGBA;
+                *type = GL_UNSIGNED_BYTE;
+                return true;
+        }
+
+        // VK_FORMAT_BC1_RGB_UNORM_BLOCK through VK_FORMAT_ASTC_12x12_SRGB_BLOCK, in order
+        static constexpr GLenum kCompressedFormats[] = {
+            opengl::kCompressedRGBS3TCDXT1, opengl::kCompressedSRGBS3TCDXT1,
+            opengl::kCompressedRGBAS3TCDXT1, opengl::kCompressedSRGBAlphaS3TCDXT1,
+            opengl::kCompressedRGBAS3TCDXT3, opengl::kCompressedSRGBAlphaS3TCDXT3,
+            opengl::kCompressedRGBAS3TCDXT5, opengl::kCompressedSRGBAlphaS3TCDXT5,
+            0, 0, 0, 0, 0, 0, // bc4 through bc6h
+            opengl::kCompressedRGBABPTCUnorm, opengl::kCompressedSRGBAlphaBPTCUnorm,
+            opengl::kCompressedRGB8ETC2, opengl::kCompressedSRGB8ETC2,
+            opengl::kCompressedRGB8PunchthroughAlpha1ETC2, opengl::kCompressedSRGB8PunchthroughAlpha1ETC2,
+            opengl::kCompressedRGBA8ETC2EAC, opengl::kCompressedSRGB8Alpha8ETC2EAC,
+            opengl::kCompressedR11EAC, opengl::kCompressedSignedR11EAC,
+            opengl::kCompressedRG11EAC, opengl::kCompressedSignedRG11EAC,
+        };
+        constexpr uint32_t kFirstCompressedFormat = 131;
+        constexpr uint32_t kFirstASTCFormat = 157;
+
+        if (vkFormat >= kFirstCompressedFormat && vkFormat < kFirstCompressedFormat + sizeof(kCompressedFormats) / sizeof(*kCompressedFormats)) {
+            *internalFormat = kCompressedFormats[vkFormat - kFirstCompressedFormat];
+            return *internalFormat != 0;
+        }
+
+        if (vkFormat >= kFirstASTCFormat && vkFormat < kFirstASTCFormat + 28) {
+            auto i = vkFormat - kFirstASTCFormat;
+            *internalFormat = ((i % 2) ? opengl::kCompressedSRGB8Alpha8ASTC4x4 : opengl::kCompressedRGBAASTC4x4) + i / 2;
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+    * Returns the minimum size of a level's image data, or 0 if the format isn't supported.
+    */
+    size_t MinimumLevelSize(GLenum internalFormat, GLenum format, GLenum type, int width, int height, size_t rowAlignment) {
+        if (!type) {
+            return opengl::CompressedTextureSize(internalFormat, width, height);
+        }
+        if (type != GL_UNSIGNED_BYTE || (format != GL_RGB && format != GL_RGBA)) {
+            return 0;
+        }
+        size_t bytesPerRow = width * (format == GL_RGBA ? 4 : 3);
+        bytesPerRow = (bytesPerRow + rowAlignment - 1) / rowAlignment * rowAlignment;
+        return bytesPerRow * height;
+    }
+} // anonymous namespace
+
+bool KTXContainer::IsKTX(const void* data, size_t length) {
+    return length >= sizeof(kKTX1Identifier)
+        && (!memcmp(data, kKTX1Identifier, sizeof(kKTX1Identifier)) || !memcmp(data, kKTX2Identifier, sizeof(kKTX2Identifier)));
+}
+
+bool KTXContainer::parse(const void* data, size_t length) {
+    _levels.clear();
+
+    if (!IsKTX(data, length)) { return false; }
+
+    auto bytes = reinterpret_cast<const uint8_t*>(data);
+    auto success = bytes[5] == 0x31 ? _parseKTX1(bytes, length) : _parseKTX2(bytes, length);
+    if (!success) {
+        _levels.clear();
+    }
+    return success;
+}
+
+bool KTXContainer::_parseKTX1(const uint8_t* data, size_t length) {
+    constexpr size_t kHeaderSize = 64;
+    if (length < kHeaderSize) {
+        SCRAPS_LOG_ERROR("truncated ktx header");
+        return false;
+    }
+
+    auto endianness = ReadNative32(data + 12, false);
+    if (endianness != 0x04030201 && endianness != 0x01020304) {
+        SCRAPS_LOG_ERROR("invalid ktx endianness");
+        return false;
+    }
+    auto swap = endianness == 0x01020304;
+    auto field = [&](size_t offset) { return ReadNative32(data + offset, swap); };
+
+    _type           = field(16);
+    _format         = field(24);
+    _internalFormat = field(28);
+    auto width      = field(36);
+    auto height     = field(40);
+    auto depth      = field(44);
+    auto elements   = field(48);
+    auto faces      = field(52);
+    auto levelCount = std::max<uint32_t>(field(56), 1);
+    auto keyValueBytes = field(60);
+
+    if (!width || !height || depth || elements || faces != 1) {
+        SCRAPS_LOG_ERROR("unsupported ktx texture: only 2d textures are supported");
+        return false;
+    }
+
+    if (levelCount > MaximumLevelCount(width, height)) {
+        SCRAPS_LOG_ERROR("invalid ktx texture: {} levels is too many for {}x{}", levelCount, width, height);
+        return false;
+    }
+
+    if (!MinimumLevelSize(_internalFormat, _format, _type, 1, 1, 4)) {
+        SCRAPS_LOG_ERROR("unsupported ktx format: {}", _internalFormat);
+        return false;
+    }
+
+    size_t offset = kHeaderSize + keyValueBytes;
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        Level level;
+        level.width = std::max<int>(width >> i, 1);
+        level.height = std::max<int>(height >> i, 1);
+
+        if (offset + 4 > length) {
+            SCRAPS_LOG_ERROR("truncated ktx data");
+            return false;
+        }
+        level.size = field(offset);
+        level.data = data + offset + 4;
+
+        if (level.size > length - offset - 4 || level.size < MinimumLevelSize(_internalFormat, _format, _type, level.width, level.height, 4)) {
+            SCRAPS_LOG_ERROR("truncated ktx data");
+            return false;
+        }
+
+        // each level is padded to a multiple of 4 bytes
+        offset += 4 + (level.size + 3) / 4 * 4;
+        _levels.emplace_back(level);
+    }
+
+    return true;
+}
+
+bool KTXContainer::_parseKTX2(const uint8_t* data, size_t length) {
+    constexpr size_t kHeaderSize = 80;
+    constexpr size_t kLevelIndexEntrySize = 24;
+    if (length < kHeaderSize) {
+        SCRAPS_LOG_ERROR("truncated ktx2 header");
+        return false;
+    }
+
+    auto field = [&](size_t offset) { return static_cast<uint32_t>(ReadLittleEndian(data + offset, 4)); };
+
+    auto vkFormat         = field(12);
+    auto width            = field(20);
+    auto height           = field(24);
+    auto depth            = field(28);
+    auto layers           = field(32);
+    auto faces            = field(36);
+    auto levelCount       = std::max<uint32_t>(field(40), 1);
+    auto supercompression = field(44);
+
+    if (!width || !height || depth || layers || faces != 1) {
+        SCRAPS_LOG_ERROR("unsupported ktx2 texture: only 2d textures are supported");
+        return false;
+    }
+
+    if (levelCount > MaximumLevelCount(width, height)) {
+        SCRAPS_LOG_ERROR("invalid ktx2 texture: {} levels is too many for {}x{}", levelCount, width, height);
+        return false;
+    }
+
+    if (supercompression) {
+        SCRAPS_LOG_ERROR("unsupported ktx2 texture: supercompression scheme {} isn't supported", supercompression);
+        return false;
+    }
+
+    if (!GLFormatForVkFormat(vkFormat, &_internalFormat, &_format, &_type)) {
+        SCRAPS_LOG_ERROR("unsupported ktx2 format: {}", vkFormat);
+        return false;
+    }
+
+    if (kHeaderSize + levelCount * kLevelIndexEntrySize > length) {
+        SCRAPS_LOG_ERROR("truncated ktx2 level index");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        auto entry = data + kHeaderSize + i * kLevelIndexEntrySize;
+        auto offset = ReadLittleEndian(entry, 8);
+        auto size = ReadLittleEndian(entry + 8, 8);
+
+        Level level;
+        level.width = std::max<int>(width >> i, 1);
+        level.height = std::max<int>(height >> i, 1);
+
+        // ktx2 rows are tightly packed
+        if (offset > length || size > length - offset || size < MinimumLevelSize(_internalFormat, _format, _type, level.width, level.height, 1)) {
+            SCRAPS_LOG_ERROR("truncated ktx2 data");
+            return false;
+        }
+
+        level.data = data + offset;
+        level.size = size;
+        _levels.emplace_back(level);
+    }
+
+    return true;
+}
+
+} // namespace okui
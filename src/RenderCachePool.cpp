@@ -0,0 +1,156 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/RenderCachePool.h>
+
+#include <algorithm>
+
+namespace okui {
+
+namespace {
+    constexpr int kMinBucketGranularity = 32;
+
+    int NextPowerOfTwo(int x) {
+        int power = 1;
+        while (power < x) {
+            power <<= 1;
+        }
+        return power;
+    }
+} // anonymous namespace
+
+RenderCachePool::Surface::Surface(int width, int height)
+    : _width{width}
+    , _height{height}
+    , _framebuffer{std::make_unique<opengl::Framebuffer>()}
+{
+    _colorAttachment = _framebuffer->addColorAttachment(width, height);
+    // TODO: stencil attachment
+}
+
+void RenderCachePool::Surface::_invalidate() {
+    _framebuffer.reset();
+    _colorAttachment = nullptr;
+}
+
+std::shared_ptr<RenderCachePool::Surface> RenderCachePool::acquire(int width, int height) {
+    width = BucketSize(width);
+    height = BucketSize(height);
+
+    for (auto it = _idle.rbegin(); it != _idle.rend(); ++it) {
+        if ((*it)->isValid() && (*it)->width() == width && (*it)->height() == height) {
+            auto surface = std::move(*it);
+            _idle.erase(std::next(it).base());
+            use(surface.get());
+            return surface;
+        }
+    }
+
+    _evict(static_cast<size_t>(width) * height * 4);
+
+    auto surface = std::make_shared<Surface>(width, height);
+    use(surface.get());
+    _surfaces.emplace_back(surface);
+    return surface;
+}
+
+void RenderCachePool::release(std::shared_ptr<Surface> surface) {
+    if (!surface || !surface->isValid()) { return; }
+    use(surface.get());
+    _idle.emplace_back(std::move(surface));
+}
+
+void RenderCachePool::endFrame() {
+    for (auto it = _idle.begin(); it != _idle.end();) {
+        if (_frame - (*it)->_lastUseFrame > _maxUnusedFrames) {
+            it = _idle.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto& weak : _surfaces) {
+        if (auto surface = weak.lock()) {
+            if (_frame - surface->_lastUseFrame > _maxUnusedFrames) {
+                surface->_invalidate();
+            }
+        }
+    }
+
+    _evict(0);
+
+    _surfaces.erase(std::remove_if(_surfaces.begin(), _surfaces.end(), [](auto& weak) {
+        auto surface = weak.lock();
+        return !surface || !surface->isValid();
+    }), _surfaces.end());
+
+    ++_frame;
+}
+
+size_t RenderCachePool::bytes() const {
+    size_t total = 0;
+    for (auto& weak : _surfaces) {
+        if (auto surface = weak.lock()) {
+            total += surface->bytes();
+        }
+    }
+    return total;
+}
+
+size_t RenderCachePool::idleBytes() const {
+    size_t total = 0;
+    for (auto& surface : _idle) {
+        total += surface->bytes();
+    }
+    return total;
+}
+
+int RenderCachePool::BucketSize(int size) {
+    // buckets grow with the size so that the waste stays proportional
+    auto granularity = std::max(kMinBucketGranularity, NextPowerOfTwo(size) / 4);
+    return (size + granularity - 1) / granularity * granularity;
+}
+
+void RenderCachePool::_evict(size_t incomingBytes) {
+    auto total = bytes();
+
+    while (total + incomingBytes > _budget && !_idle.empty()) {
+        total -= _idle.front()->bytes();
+        _idle.pop_front();
+    }
+
+    if (total + incomingBytes <= _budget) { return; }
+
+    // evict the caches of views that weren't rendered this frame, least recently used first
+    std::vector<std::shared_ptr<Surface>> candidates;
+    for (auto& weak : _surfaces) {
+        auto surface = weak.lock();
+        if (surface && surface->isValid() && surface->_lastUseFrame < _frame) {
+            candidates.emplace_back(std::move(surface));
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](auto& a, auto& b) {
+        return a->_lastUseFrame < b->_lastUseFrame;
+    });
+
+    for (auto& surface : candidates) {
+        if (total + incomingBytes <= _budget) { break; }
+        total -= surface->bytes();
+        surface->_invalidate();
+    }
+}
+
+} // namespace okui
@@ -0,0 +1,76 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/RenderThread.h>
+
+#include <okui/opengl/ContextOwnership.h>
+
+#include <cassert>
+
+namespace okui {
+
+RenderThread::RenderThread() {
+    opengl::ContextOwnership::BeginSharing();
+    _thread = std::thread([this] { _run(); });
+}
+
+RenderThread::~RenderThread() {
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _shouldExit = true;
+    }
+    _condition.notify_all();
+    _thread.join();
+
+    opengl::ContextOwnership::EndSharing();
+}
+
+void RenderThread::submit(std::function<void()> frame) {
+    assert(!isCurrent());
+
+    std::unique_lock<std::mutex> lock{_mutex};
+    _condition.wait(lock, [&] { return !_isBusy; });
+    _frame = std::move(frame);
+    _isBusy = true;
+    lock.unlock();
+    _condition.notify_all();
+}
+
+void RenderThread::wait() {
+    assert(!isCurrent());
+
+    std::unique_lock<std::mutex> lock{_mutex};
+    _condition.wait(lock, [&] { return !_isBusy; });
+}
+
+void RenderThread::_run() {
+    std::unique_lock<std::mutex> lock{_mutex};
+    while (true) {
+        _condition.wait(lock, [&] { return _isBusy || _shouldExit; });
+        if (!_isBusy) { break; }
+
+        auto frame = std::move(_frame);
+        _frame = nullptr;
+        lock.unlock();
+        frame();
+        frame = nullptr;
+        lock.lock();
+
+        _isBusy = false;
+        _condition.notify_all();
+    }
+}
+
+} // namespace okui
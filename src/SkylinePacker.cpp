@@ -0,0 +1,98 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/SkylinePacker.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace okui {
+
+SkylinePacker::SkylinePacker(int width, int height) : _width{width}, _height{height} {
+    clear();
+}
+
+stdts::optional<Rectangle<int>> SkylinePacker::pack(int width, int height) {
+    if (width <= 0 || height <= 0) { return stdts::nullopt; }
+
+    auto bestIndex = _skyline.size();
+    auto bestBottom = std::numeric_limits<int>::max();
+    auto bestWidth = std::numeric_limits<int>::max();
+    int bestY = 0;
+
+    for (size_t i = 0; i < _skyline.size(); ++i) {
+        auto y = _fit(i, width, height);
+        if (!y) { continue; }
+        // prefer the lowest placement, then the narrowest segment to leave wide segments for wide rectangles
+        if (*y + height < bestBottom || (*y + height == bestBottom && _skyline[i].width < bestWidth)) {
+            bestIndex = i;
+            bestBottom = *y + height;
+            bestWidth = _skyline[i].width;
+            bestY = *y;
+        }
+    }
+
+    if (bestIndex == _skyline.size()) { return stdts::nullopt; }
+
+    Rectangle<int> placement{_skyline[bestIndex].x, bestY, width, height};
+    _skyline.insert(_skyline.begin() + bestIndex, Segment{placement.x, placement.maxY(), width});
+
+    // trim the segments now underneath the new one
+    for (auto i = bestIndex + 1; i < _skyline.size();) {
+        auto& previous = _skyline[i - 1];
+        auto& segment = _skyline[i];
+        auto overlap = previous.x + previous.width - segment.x;
+        if (overlap <= 0) { break; }
+        segment.x += overlap;
+        segment.width -= overlap;
+        if (segment.width > 0) { break; }
+        _skyline.erase(_skyline.begin() + i);
+    }
+
+    // merge neighbors at the same height
+    for (size_t i = 1; i < _skyline.size();) {
+        if (_skyline[i - 1].y == _skyline[i].y) {
+            _skyline[i - 1].width += _skyline[i].width;
+            _skyline.erase(_skyline.begin() + i);
+        } else {
+            ++i;
+        }
+    }
+
+    _usedArea += static_cast<size_t>(width) * height;
+    return placement;
+}
+
+void SkylinePacker::clear() {
+    _skyline.clear();
+    _skyline.push_back(Segment{0, 0, _width});
+    _usedArea = 0;
+}
+
+stdts::optional<int> SkylinePacker::_fit(size_t index, int width, int height) const {
+    if (_skyline[index].x + width > _width) { return stdts::nullopt; }
+
+    int y = 0;
+    auto remaining = width;
+    for (auto i = index; remaining > 0; ++i) {
+        y = std::max(y, _skyline[i].y);
+        if (y + height > _height) { return stdts::nullopt; }
+        remaining -= _skyline[i].width;
+    }
+
+    return y;
+}
+
+} // namespace okui
@@ -0,0 +1,208 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/TextureAtlas.h>
+
+#include <okui/opengl/ContextOwnership.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace okui {
+
+namespace {
+    // each image is surrounded by a copy of its edge pixels so that filtering doesn't bleed in its neighbors
+    constexpr int kPadding = 1;
+    constexpr size_t kBytesPerPixel = 4;
+
+    std::vector<uint8_t> PaddedPixels(int width, int height, const uint8_t* pixels) {
+        auto paddedWidth = width + 2 * kPadding;
+        auto paddedHeight = height + 2 * kPadding;
+        std::vector<uint8_t> padded(paddedWidth * paddedHeight * kBytesPerPixel);
+
+        for (int y = 0; y < paddedHeight; ++y) {
+            auto sourceY = std::min(std::max(y - kPadding, 0), height - 1);
+            for (int x = 0; x < paddedWidth; ++x) {
+                auto sourceX = std::min(std::max(x - kPadding, 0), width - 1);
+                memcpy(&padded[(y * paddedWidth + x) * kBytesPerPixel], &pixels[(sourceY * width + sourceX) * kBytesPerPixel], kBytesPerPixel);
+            }
+        }
+
+        return padded;
+    }
+} // anonymous namespace
+
+struct TextureAtlas::Page {
+    explicit Page(int size) : packer{size, size} {}
+    ~Page() {
+        if (texture) {
+            opengl::ReleaseResources([texture = texture] {
+                glDeleteTextures(1, &texture);
+            });
+        }
+    }
+
+    GLuint                                texture = 0;
+    SkylinePacker                         packer;
+    size_t                                liveArea = 0;
+    std::vector<std::weak_ptr<Allocation>> allocations;
+};
+
+TextureAtlas::TextureAtlas(int pageSize) : _pageSize{pageSize} {}
+
+bool TextureAtlas::accepts(int width, int height) const {
+    return width > 0 && height > 0 && width <= _maxEntrySize && height <= _maxEntrySize
+        && width + 2 * kPadding <= _pageSize && height + 2 * kPadding <= _pageSize;
+}
+
+std::shared_ptr<TextureAtlas::Allocation> TextureAtlas::add(int width, int height, const uint8_t* pixels) {
+    if (!accepts(width, height)) { return nullptr; }
+
+    auto paddedWidth = width + 2 * kPadding;
+    auto paddedHeight = height + 2 * kPadding;
+
+    std::shared_ptr<Page> page;
+    stdts::optional<Rectangle<int>> bounds;
+
+    for (auto& candidate : _pages) {
+        if ((bounds = candidate->packer.pack(paddedWidth, paddedHeight))) {
+            page = candidate;
+            break;
+        }
+    }
+
+    if (!bounds) {
+        // repack the page with the most released space, if it's worth it
+        std::shared_ptr<Page> mostReleased;
+        size_t mostReleasedArea = 0;
+        for (auto& candidate : _pages) {
+            auto released = candidate->packer.usedArea() - candidate->liveArea;
+            if (released > mostReleasedArea) {
+                mostReleased = candidate;
+                mostReleasedArea = released;
+            }
+        }
+
+        if (mostReleased && mostReleasedArea >= static_cast<size_t>(paddedWidth * paddedHeight) && _defragment(mostReleased.get())) {
+            if ((bounds = mostReleased->packer.pack(paddedWidth, paddedHeight))) {
+                page = mostReleased;
+            }
+        }
+    }
+
+    if (!bounds && _pages.size() < _maxPages) {
+        page = _createPage();
+        bounds = page->packer.pack(paddedWidth, paddedHeight);
+    }
+
+    if (!bounds) { return nullptr; }
+
+    auto allocation = std::make_shared<Allocation>(page, *bounds, PaddedPixels(width, height, pixels));
+    page->allocations.emplace_back(allocation);
+    allocation->_upload();
+    return allocation;
+}
+
+void TextureAtlas::collectGarbage() {
+    _pages.erase(std::remove_if(_pages.begin(), _pages.end(), [](auto& page) {
+        return page->liveArea == 0 && page->packer.usedArea() > 0;
+    }), _pages.end());
+}
+
+std::shared_ptr<TextureAtlas::Page> TextureAtlas::_createPage() {
+    auto page = std::make_shared<Page>(_pageSize);
+
+    glGenTextures(1, &page->texture);
+    glBindTexture(GL_TEXTURE_2D, page->texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _pageSize, _pageSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    SCRAPS_GL_ERROR_CHECK();
+
+    _pages.emplace_back(page);
+    return page;
+}
+
+bool TextureAtlas::_defragment(Page* page) {
+    std::vector<std::shared_ptr<Allocation>> allocations;
+    for (auto& weak : page->allocations) {
+        if (auto allocation = weak.lock()) {
+            allocations.emplace_back(std::move(allocation));
+        }
+    }
+
+    // tall images first packs more tightly
+    std::sort(allocations.begin(), allocations.end(), [](auto& a, auto& b) {
+        return a->_bounds.height > b->_bounds.height;
+    });
+
+    // plan the new layout before committing to it so that a failure leaves the page intact
+    SkylinePacker packer{_pageSize, _pageSize};
+    std::vector<Rectangle<int>> placements;
+    for (auto& allocation : allocations) {
+        auto placement = packer.pack(allocation->_bounds.width, allocation->_bounds.height);
+        if (!placement) { return false; }
+        placements.emplace_back(*placement);
+    }
+
+    page->packer = packer;
+    page->allocations.clear();
+    for (size_t i = 0; i < allocations.size(); ++i) {
+        allocations[i]->_place(placements[i]);
+        allocations[i]->_upload();
+        page->allocations.emplace_back(allocations[i]);
+    }
+
+    ++_generation;
+    return true;
+}
+
+TextureAtlas::Allocation::Allocation(std::shared_ptr<Page> page, const Rectangle<int>& bounds, std::vector<uint8_t> pixels)
+    : _page{std::move(page)}, _pixels{std::move(pixels)}
+{
+    _page->liveArea += static_cast<size_t>(bounds.width) * bounds.height;
+    _place(bounds);
+}
+
+TextureAtlas::Allocation::~Allocation() {
+    _page->liveArea -= static_cast<size_t>(_bounds.width) * _bounds.height;
+}
+
+GLuint TextureAtlas::Allocation::texture() const {
+    return _page->texture;
+}
+
+void TextureAtlas::Allocation::_place(const Rectangle<int>& bounds) {
+    _bounds = bounds;
+    auto size = static_cast<double>(_page->packer.width());
+    _coordinates = Rectangle<double>{
+        (bounds.x + kPadding) / size,
+        (bounds.y + kPadding) / size,
+        (bounds.width - 2 * kPadding) / size,
+        (bounds.height - 2 * kPadding) / size
+    };
+}
+
+void TextureAtlas::Allocation::_upload() const {
+    glBindTexture(GL_TEXTURE_2D, _page->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, _bounds.x, _bounds.y, _bounds.width, _bounds.height, GL_RGBA, GL_UNSIGNED_BYTE, _pixels.data());
+    SCRAPS_GL_ERROR_CHECK();
+}
+
+} // namespace okui
@@ -16,7 +16,9 @@
 #include <okui/View.h>
 
 #include <okui/Application.h>
+#include <okui/BatchRenderer.h>
 #include <okui/BitmapFont.h>
+#include <okui/FrameProfiler.h>
 #include <okui/blending.h>
 #include <okui/opengl/opengl.h>
 #include <okui/shapes/Rectangle.h>
@@ -24,7 +26,9 @@
 
 #include <scraps/Reverse.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 
 namespace okui {
 
@@ -67,6 +71,19 @@ void View::addSubview(View* view) {
 
     addChildToFront(view);
 
+    if (view->_needsLayout || view->_subviewsNeedLayout) {
+        _setSubviewsNeedLayout();
+    }
+
+    if (_spatialIndex) {
+        view->_spatialIndexOrder = ++_spatialIndexFront;
+        view->_updateSpatialIndexEntry();
+    }
+
+    if (view->_rendersToTexture) {
+        _subviewsRenderingToTexture.insert(view);
+    }
+
     assert(view->window() == nullptr);
     if (_window && _window->isOpen()) {
         view->_dispatchWindowChange(_window);
@@ -76,7 +93,7 @@ void View::addSubview(View* view) {
         view->_dispatchVisibilityChange(true);
     }
 
-    invalidateRenderCache();
+    view->_invalidateSuperviewRenderCache();
 }
 
 void View::addHiddenSubview(View* view) {
@@ -101,6 +118,14 @@ void View::removeSubview(View* view) {
         _subviewWithMouse = nullptr;
     }
 
+    view->_invalidateSuperviewRenderCache();
+
+    if (_spatialIndex) {
+        _spatialIndex->remove(view);
+    }
+
+    _subviewsRenderingToTexture.erase(view);
+
     removeChild(view);
 
     if (view->window() != nullptr) {
@@ -110,8 +135,6 @@ void View::removeSubview(View* view) {
     if (viewIsDisappearing) {
         view->_dispatchVisibilityChange(false);
     }
-
-    invalidateRenderCache();
 }
 
 void View::removeSubviews() {
@@ -134,7 +157,7 @@ void View::setIsVisible(bool isVisible) {
     }
 
     if (superview()) {
-        superview()->invalidateRenderCache();
+        superview()->_invalidateRenderCache(_superviewRenderArea({0.0, 0.0, _bounds.width, _bounds.height}), !_clipsToBounds);
     }
 }
 
@@ -165,8 +188,10 @@ ShaderCache* View::shaderCache() {
 
 void View::setScale(double scaleX, double scaleY) {
     if (_scale.x == scaleX && _scale.y == scaleY) { return; }
+    _invalidateSuperviewRenderCache();
     _scale.x = scaleX;
     _scale.y = scaleY;
+    _updateSpatialIndexEntry();
     invalidateRenderCache();
 }
 
@@ -178,15 +203,52 @@ void View::setTintColor(const Color& color) {
 
 void View::sendToBack() {
     TreeNode::sendToBack();
-    if (isVisible()) {
-        superview()->invalidateRenderCache();
+    if (superview() && superview()->_spatialIndex) {
+        _spatialIndexOrder = --superview()->_spatialIndexBack;
     }
+    _invalidateSuperviewRenderCache();
 }
 
 void View::bringToFront() {
     TreeNode::bringToFront();
-    if (isVisible()) {
-        superview()->invalidateRenderCache();
+    if (superview() && superview()->_spatialIndex) {
+        _spatialIndexOrder = ++superview()->_spatialIndexFront;
+    }
+    _invalidateSuperviewRenderCache();
+}
+
+void View::setClipsToBounds(bool clipsToBounds) {
+    if (_clipsToBounds == clipsToBounds) { return; }
+    _clipsToBounds = clipsToBounds;
+    _updateSpatialIndexEntry();
+}
+
+void View::setRendersToTexture(bool rendersToTexture) {
+    _rendersToTexture = rendersToTexture;
+    if (superview()) {
+        if (rendersToTexture) {
+            superview()->_subviewsRenderingToTexture.insert(this);
+        } else {
+            superview()->_subviewsRenderingToTexture.erase(this);
+        }
+    }
+}
+
+void View::setUsesSpatialIndex(bool usesSpatialIndex, double cellSize) {
+    if (!usesSpatialIndex) {
+        _spatialIndex.reset();
+        return;
+    }
+
+    _spatialIndex = std::make_unique<SpatialGrid<View*>>(cellSize);
+
+    // subviews are ordered from front to back
+    _spatialIndexFront = subviews().size();
+    _spatialIndexBack = 1;
+    auto order = _spatialIndexFront;
+    for (auto& subview : subviews()) {
+        subview->_spatialIndexOrder = order--;
+        subview->_updateSpatialIndexEntry();
     }
 }
 
@@ -277,32 +339,64 @@ std::shared_ptr<TextureInterface> View::renderTexture() const {
     return _renderCacheTexture;
 }
 
+void View::setRetainsRender(bool retains) {
+    _retainsRender = retains;
+    _displayList = stdts::nullopt;
+}
+
 void View::invalidateRenderCache() {
     _hasCachedRender = false;
+    _renderCacheDamage = stdts::nullopt;
+    _displayList = stdts::nullopt;
     _invalidateSuperviewRenderCache();
+
+    if (!superview() && _window && _window->contentView() == this) {
+        _window->invalidateRegion({0.0, 0.0, _bounds.width, _bounds.height});
+    }
 }
 
-TextureHandle View::loadTextureResource(const std::string& name) {
+TextureHandle View::loadTextureResource(const std::string& name, Point<int> targetSize) {
     if (!window()) { return nullptr; }
-    auto handle = window()->loadTextureResource(name);
+    auto handle = window()->loadTextureResource(name, decodePriority(), targetSize);
     handle.onLoad([this]{ invalidateRenderCache(); });
     return handle;
 }
 
-TextureHandle View::loadTextureFromMemory(std::shared_ptr<const std::string> data) {
+TextureHandle View::loadTextureFromMemory(std::shared_ptr<const std::string> data, Point<int> targetSize) {
     if (!window()) { return nullptr; }
-    auto handle = window()->loadTextureFromMemory(data);
+    auto handle = window()->loadTextureFromMemory(data, decodePriority(), targetSize);
     handle.onLoad([this]{ invalidateRenderCache(); });
     return handle;
 }
 
-TextureHandle View::loadTextureFromURL(const std::string& url) {
+TextureHandle View::loadTextureFromURL(const std::string& url, Point<int> targetSize) {
     if (!window()) { return nullptr; }
-    auto handle = window()->loadTextureFromURL(url);
+    auto handle = window()->loadTextureFromURL(url, decodePriority(), targetSize);
     handle.onLoad([this]{ invalidateRenderCache(); });
     return handle;
 }
 
+DecodePool::Priority View::decodePriority() const {
+    // views are often made visible just after they begin loading their textures, so only ancestors are considered
+    if (!window() || !window()->isOpen() || !ancestorsAreVisible()) {
+        return DecodePool::Priority::kBackground;
+    }
+
+    auto& contentBounds = window()->contentView()->bounds();
+    return windowBounds().intersects({0.0, 0.0, contentBounds.width, contentBounds.height}) ? DecodePool::Priority::kVisible : DecodePool::Priority::kPrefetch;
+}
+
+Point<int> View::pixelSize() const {
+    if (!window()) { return {}; }
+
+    auto& contentBounds = window()->contentView()->bounds();
+    if (contentBounds.width <= 0.0 || contentBounds.height <= 0.0) { return {}; }
+
+    auto bounds = windowBounds();
+    return {static_cast<int>(std::ceil(std::abs(bounds.width) * window()->_renderWidth / contentBounds.width)),
+            static_cast<int>(std::ceil(std::abs(bounds.height) * window()->_renderHeight / contentBounds.height))};
+}
+
 Application* View::application() const {
     return window() ? window()->application() : nullptr;
 }
@@ -354,16 +448,38 @@ bool View::hitTest(double x, double y) {
            y >= 0 && y < bounds().height;
 }
 
+template <typename Predicate>
+View* View::_findSubview(double x, double y, Predicate&& predicate) {
+    if (!_spatialIndex) {
+        for (auto& subview : subviews()) {
+            if (predicate(subview)) { return subview; }
+        }
+        return nullptr;
+    }
+
+    std::vector<View*> candidates;
+    _spatialIndex->query(x, y, &candidates);
+    std::sort(candidates.begin(), candidates.end(), [](View* a, View* b) {
+        return a->_spatialIndexOrder > b->_spatialIndexOrder;
+    });
+
+    for (auto subview : candidates) {
+        if (predicate(subview)) { return subview; }
+    }
+    return nullptr;
+}
+
 View* View::hitTestView(double x, double y) {
     auto hit = hitTest(x, y);
     if (hit || !_clipsToBounds) {
-        for (auto& subview : subviews()) {
-            if (subview->isVisible()) {
-                auto point = subview->superviewToLocal(x, y);
-                auto view = subview->hitTestView(point.x, point.y);
-                if (view) { return view; }
-            }
-        }
+        View* view = nullptr;
+        _findSubview(x, y, [&](View* subview) {
+            if (!subview->isVisible()) { return false; }
+            auto point = subview->superviewToLocal(x, y);
+            view = subview->hitTestView(point.x, point.y);
+            return view != nullptr;
+        });
+        if (view) { return view; }
     }
 
     return hit ? this : nullptr;
@@ -469,10 +585,11 @@ void View::dispatchUpdate(std::chrono::high_resolution_clock::duration elapsed)
         }
     }
 
+    auto presentationTime = window()->predictedPresentationTime();
     auto hooks = _updateHooks;
     for (auto& hook : hooks) {
         if (_updateHooks.count(hook.first)) {
-            hook.second();
+            hook.second(presentationTime);
         }
     }
 }
@@ -483,7 +600,7 @@ void View::renderAndRenderSubviews(const RenderTarget* target, const Rectangle<i
     if (!_requiresTextureRendering() && !_cachesRender) {
         // render directly
         _renderAndRenderSubviews(target, area, false, clipBounds);
-        _renderCacheTexture->set();
+        _releaseRenderCache();
         return;
     }
 
@@ -495,44 +612,136 @@ void View::renderAndRenderSubviews(const RenderTarget* target, const Rectangle<i
 
     // make sure the render cache is up-to-date
 
-    GLint previousFramebuffer = 0;
-    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    // the framebuffer binding is queried when the frame is drawn since the render may be deferred
+    auto previousFramebuffer = std::make_shared<GLint>(0);
+    DisplayList::Perform([previousFramebuffer] {
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, previousFramebuffer.get());
+    });
+
+    auto pool = window() ? window()->renderCachePool() : nullptr;
 
-    if (!_renderCacheColorAttachment || _renderCacheColorAttachment->width() != area.width || _renderCacheColorAttachment->height() != area.height) {
+    if (!_renderCache || !_renderCache->isValid()
+        || _renderCache->width() != RenderCachePool::BucketSize(area.width) || _renderCache->height() != RenderCachePool::BucketSize(area.height)) {
         // update the framebuffer
-        _renderCache = std::make_unique<opengl::Framebuffer>();
-        _renderCacheColorAttachment = _renderCache->addColorAttachment(area.width, area.height);
-        // TODO: stencil attachment
-        assert(_renderCache->isComplete());
+        _releaseRenderCache();
+        _renderCache = pool ? pool->acquire(area.width, area.height)
+                            : std::make_shared<RenderCachePool::Surface>(RenderCachePool::BucketSize(area.width), RenderCachePool::BucketSize(area.height));
+        assert(_renderCache->framebuffer()->isComplete());
         _hasCachedRender = false;
     }
-    _renderCacheTexture->set(_renderCacheColorAttachment->texture(), area.width, area.height, true);
+
+    if (_renderCacheWidth != area.width || _renderCacheHeight != area.height) {
+        // the framebuffer may be reused for nearby sizes, but its contents need to be redrawn
+        _renderCacheWidth = area.width;
+        _renderCacheHeight = area.height;
+        _hasCachedRender = false;
+    }
+
+    if (!_hasCachedRender) {
+        _renderCacheDamage = stdts::nullopt;
+    }
+
+    if (pool) {
+        pool->use(_renderCache.get());
+    }
+
+    _renderCacheTexture->set(_renderCache->texture(), area.width, area.height, true, _renderCache->width(), _renderCache->height());
 
     if (!_cachesRender || !_hasCachedRender) {
         // render to _renderCache
-        _renderCache->bind();
+        FrameProfiler::DidRenderCache();
+        BatchRenderer::SetTarget(area.width, area.height);
+        DisplayList::Perform([renderCache = _renderCache] {
+            renderCache->framebuffer()->bind();
+        });
         Rectangle<int> cacheArea(0, 0, area.width, area.height);
         RenderTarget cacheTarget(area.width, area.height);
-        _renderAndRenderSubviews(&cacheTarget, cacheArea, true);
+        if (_cachesRender && _renderCacheDamage && window() && window()->redrawMode() == Window::RedrawMode::kDamaged) {
+            // only the damaged part of the cache needs to be redrawn
+            auto damage = DamageRegion::PixelBounds(*_renderCacheDamage, area.width / _bounds.width, area.height / _bounds.height).intersection(cacheArea);
+            if (damage.width > 0 && damage.height > 0) {
+                BatchRenderer::SetScissor(Rectangle<int>{damage.x, area.height - damage.maxY(), damage.width, damage.height});
+                BatchRenderer::Flush();
+                DisplayList::Perform([] {
+                    glClearColor(0.0, 0.0, 0.0, 0.0);
+                    glClear(GL_COLOR_BUFFER_BIT);
+                });
+                _renderAndRenderSubviews(&cacheTarget, cacheArea, false, damage);
+                BatchRenderer::SetScissor(stdts::nullopt);
+            }
+        } else {
+            _renderAndRenderSubviews(&cacheTarget, cacheArea, true);
+        }
         _hasCachedRender = true;
+        _renderCacheDamage = stdts::nullopt;
+        BatchRenderer::SetTarget(target->width(), target->height());
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    DisplayList::Perform([previousFramebuffer] {
+        glBindFramebuffer(GL_FRAMEBUFFER, *previousFramebuffer);
+    });
 
     // do the actual rendering
 
-    glViewport(area.x, target->height() - area.maxY(), area.width, area.height);
+    BatchRenderer::SetViewport({area.x, target->height() - area.maxY(), area.width, area.height});
     Blending blending{BlendFunction::kDefault};
-    glEnable(GL_SCISSOR_TEST);
-    glScissor(clipBounds->x, target->height() - clipBounds->maxY(), clipBounds->width, clipBounds->height);
+    BatchRenderer::SetScissor(Rectangle<int>{clipBounds->x, target->height() - clipBounds->maxY(), clipBounds->width, clipBounds->height});
 
     AffineTransformation transformation{-1, -1, 0, 0, 2.0/_bounds.width, 2.0/_bounds.height};
     postRender(_renderCacheTexture, transformation);
 
-    glDisable(GL_SCISSOR_TEST);
+    BatchRenderer::SetScissor(stdts::nullopt);
+}
+
+void View::setNeedsLayout() {
+    if (_needsLayout) { return; }
+    _needsLayout = true;
+    if (auto superview = this->superview()) {
+        superview->_setSubviewsNeedLayout();
+    }
+}
+
+void View::layoutIfNeeded() {
+    if (_needsLayout) {
+        _needsLayout = false;
+        if (_window) {
+            ++_window->_layoutCount;
+        }
+        layout();
+    }
+
+    // the flag stays set during the pass so that subviews flagged by the pass don't re-flag every ancestor. if any
+    // subview was flagged after it was laid out, another pass is made
+    while (_subviewsNeedLayout) {
+        for (auto& subview : subviews()) {
+            subview->layoutIfNeeded();
+        }
+        _subviewsNeedLayout = std::any_of(subviews().begin(), subviews().end(), [](auto& subview) {
+            return subview->_needsLayout || subview->_subviewsNeedLayout;
+        });
+    }
+}
+
+void View::_setSubviewsNeedLayout() {
+    for (auto view = this; view && !view->_subviewsNeedLayout; view = view->superview()) {
+        view->_subviewsNeedLayout = true;
+    }
+}
+
+void View::_releaseRenderCache() {
+    if (_renderCache && _window) {
+        _window->renderCachePool()->release(std::move(_renderCache));
+    }
+    _renderCache = nullptr;
+    _renderCacheTexture->set();
+    _hasCachedRender = false;
 }
 
 void View::addUpdateHook(const std::string& handle, std::function<void()> hook) {
+    addUpdateHook(handle, [hook = std::move(hook)](std::chrono::steady_clock::time_point) { hook(); });
+}
+
+void View::addUpdateHook(const std::string& handle, std::function<void(std::chrono::steady_clock::time_point)> hook) {
     _updateHooks[std::hash<std::string>()(handle)] = std::move(hook);
     _checkUpdateSubscription();
 }
@@ -554,11 +763,12 @@ bool View::dispatchMouseDown(MouseButton button, double x, double y) {
     if (!isVisible()) { return false; }
 
     if (_childrenInterceptInteractions) {
-        for (auto& subview : subviews()) {
+        auto subview = _findSubview(x, y, [&](View* subview) {
             auto point = subview->superviewToLocal(x, y);
-            if ((!subview->clipsToBounds() || subview->hitTest(point.x, point.y)) && subview->dispatchMouseDown(button, point.x, point.y)) {
-                return true;
-            }
+            return (!subview->clipsToBounds() || subview->hitTest(point.x, point.y)) && subview->dispatchMouseDown(button, point.x, point.y);
+        });
+        if (subview) {
+            return true;
         }
     }
     if (_interceptsInteractions && hitTest(x, y)) {
@@ -574,12 +784,13 @@ bool View::dispatchMouseUp(MouseButton button, double startX, double startY, dou
     if (!isVisible()) { return false; }
 
     if (_childrenInterceptInteractions) {
-        for (auto& subview : subviews()) {
+        auto subview = _findSubview(x, y, [&](View* subview) {
             auto startPoint = subview->superviewToLocal(startX, startY);
             auto point = subview->superviewToLocal(x, y);
-            if ((!subview->clipsToBounds() || subview->hitTest(point.x, point.y)) && subview->dispatchMouseUp(button, startPoint.x, startPoint.y, point.x, point.y)) {
-                return true;
-            }
+            return (!subview->clipsToBounds() || subview->hitTest(point.x, point.y)) && subview->dispatchMouseUp(button, startPoint.x, startPoint.y, point.x, point.y);
+        });
+        if (subview) {
+            return true;
         }
     }
     if (_interceptsInteractions && hitTest(x, y)) {
@@ -596,13 +807,10 @@ bool View::dispatchMouseMovement(double x, double y) {
     View* subviewWithMouse = nullptr;
 
     if (_childrenInterceptInteractions) {
-        for (auto& subview : subviews()) {
+        subviewWithMouse = _findSubview(x, y, [&](View* subview) {
             auto point = subview->superviewToLocal(x, y);
-            if ((!subview->clipsToBounds() || subview->hitTest(point.x, point.y)) && subview->dispatchMouseMovement(point.x, point.y)) {
-                subviewWithMouse = subview;
-                break;
-            }
-        }
+            return (!subview->clipsToBounds() || subview->hitTest(point.x, point.y)) && subview->dispatchMouseMovement(point.x, point.y);
+        });
     }
 
     if (subviewWithMouse != _subviewWithMouse) {
@@ -631,12 +839,13 @@ bool View::dispatchMouseWheel(double xPos, double yPos, int xWheel, int yWheel)
     if (!isVisible()) { return false; }
 
     if (_childrenInterceptInteractions) {
-        for (auto& subview : subviews()) {
+        auto subview = _findSubview(xPos, yPos, [&](View* subview) {
             auto point = subview->superviewToLocal(xPos, yPos);
-            if ((!subview->clipsToBounds() || subview->hitTest(point.x, point.y)) &&
-                subview->dispatchMouseWheel(point.x, point.y, xWheel, yWheel)) {
-                return true;
-            }
+            return (!subview->clipsToBounds() || subview->hitTest(point.x, point.y)) &&
+                subview->dispatchMouseWheel(point.x, point.y, xWheel, yWheel);
+        });
+        if (subview) {
+            return true;
         }
     }
 
@@ -668,10 +877,44 @@ void View::touchMovement(size_t finger, Point<double> position, Point<double> di
 
 void View::_invalidateSuperviewRenderCache() {
     if (isVisible() && superview()) {
-        superview()->invalidateRenderCache();
+        superview()->_invalidateRenderCache(_superviewRenderArea({0.0, 0.0, _bounds.width, _bounds.height}), !_clipsToBounds);
+    }
+}
+
+void View::_invalidateRenderCache(Rectangle<double> area, bool isUnbounded) {
+    Rectangle<double> localBounds{0.0, 0.0, _bounds.width, _bounds.height};
+
+    if (_clipsToBounds || _cachesRender || _requiresTextureRendering()) {
+        // nothing rendered by this view or its subviews can escape its bounds
+        area = isUnbounded ? localBounds : area.intersection(localBounds);
+        isUnbounded = false;
+    }
+
+    if (_hasCachedRender) {
+        _hasCachedRender = false;
+        _renderCacheDamage = isUnbounded ? localBounds : area;
+    } else if (_renderCacheDamage) {
+        _renderCacheDamage = _renderCacheDamage->unionBounds(isUnbounded ? localBounds : area);
+    }
+
+    if (!isVisible()) { return; }
+
+    if (superview()) {
+        superview()->_invalidateRenderCache(_superviewRenderArea(area), isUnbounded);
+    } else if (_window && _window->contentView() == this) {
+        _window->invalidateRegion(isUnbounded ? localBounds : area);
     }
 }
 
+Rectangle<double> View::_superviewRenderArea(const Rectangle<double>& area) const {
+    return {
+        _bounds.x + area.x * _scale.x,
+        _bounds.y + area.y * _scale.y,
+        area.width * _scale.x,
+        area.height * _scale.y
+    };
+}
+
 void View::_setBounds(const Rectangle<double>& bounds) {
     auto willMove = (_bounds.x != bounds.x || _bounds.y != bounds.y);
     auto willResize = (_bounds.width != bounds.width || _bounds.height != bounds.height);
@@ -680,15 +923,17 @@ void View::_setBounds(const Rectangle<double>& bounds) {
         return;
     }
 
+    // the previously occupied area needs to be redrawn as well as the new one
+    _invalidateSuperviewRenderCache();
+
     _bounds = std::move(bounds);
+    _updateSpatialIndexEntry();
 
     if (willResize) {
-        layout();
+        setNeedsLayout();
         invalidateRenderCache();
-    }
-
-    if (isVisible() && superview()) {
-        superview()->invalidateRenderCache();
+    } else {
+        _invalidateSuperviewRenderCache();
     }
 }
 
@@ -737,8 +982,15 @@ void View::_dispatchWindowChange(Window* window) {
     }
 
     assert(_window != window);
+
+    // hand the render cache back to the previous window's pool
+    _releaseRenderCache();
+
     _window = window;
 
+    // recorded draws refer to the previous window's shaders
+    _displayList = stdts::nullopt;
+
     if (application()) {
         for (auto& listener : _listeners) {
             application()->addListener(this, listener.index, &listener.action, listener.relation);
@@ -795,10 +1047,45 @@ void View::_updateFocusableRegions(std::vector<std::tuple<View*, Rectangle<doubl
     }
 }
 
-bool View::_requiresTextureRendering() {
+bool View::_requiresTextureRendering() const {
     return _rendersToTexture || _tintColor != Color::kWhite;
 }
 
+void View::_updateSpatialIndexEntry() {
+    if (!superview() || !superview()->_spatialIndex) { return; }
+
+    // subviews that don't clip may draw or be hit anywhere. the scale only affects rendering, so the entry needs to
+    // cover both the scaled and unscaled bounds
+    stdts::optional<Rectangle<double>> bounds;
+    if (_clipsToBounds) {
+        bounds = Rectangle<double>{_bounds.x, _bounds.y, _bounds.width * std::max(_scale.x, 1.0), _bounds.height * std::max(_scale.y, 1.0)};
+    }
+    superview()->_spatialIndex->insert(this, bounds);
+}
+
+Rectangle<int> View::_subviewArea(const View* subview, const Rectangle<int>& area) const {
+    auto xScale = (_bounds.width != 0.0 ? area.width / _bounds.width : 1.0);
+    auto yScale = (_bounds.height != 0.0 ? area.height / _bounds.height : 1.0);
+    return Rectangle<int>(std::round(area.x + xScale * subview->_bounds.x),
+                          std::round(area.y + yScale * subview->_bounds.y),
+                          std::round(xScale * subview->_scale.x * subview->_bounds.width),
+                          std::round(yScale * subview->_scale.y * subview->_bounds.height));
+}
+
+Rectangle<int> View::_renderExtent(const Rectangle<int>& area) const {
+    if (!isVisible() || !area.width || !area.height) { return {}; }
+
+    if (_clipsToBounds || _cachesRender || _requiresTextureRendering()) {
+        return area;
+    }
+
+    auto extent = area;
+    for (auto& subview : subviews()) {
+        extent = extent.unionBounds(subview->_renderExtent(_subviewArea(subview, area)));
+    }
+    return extent;
+}
+
 void View::_renderAndRenderSubviews(const RenderTarget* target, const Rectangle<int>& area, bool shouldClear, stdts::optional<Rectangle<int>> clipBounds) {
     auto xScale = (_bounds.width != 0.0 ? area.width / _bounds.width : 1.0);
     auto yScale = (_bounds.height != 0.0 ? area.height / _bounds.height : 1.0);
@@ -817,20 +1104,22 @@ void View::_renderAndRenderSubviews(const RenderTarget* target, const Rectangle<
         }
     }
 
-    glViewport(visibleArea.x, target->height() - visibleArea.maxY(), visibleArea.width, visibleArea.height);
+    BatchRenderer::SetViewport({visibleArea.x, target->height() - visibleArea.maxY(), visibleArea.width, visibleArea.height});
     Blending blending{BlendFunction::kDefault};
 
     if (shouldClear) {
-        glDisable(GL_SCISSOR_TEST);
-        glClearColor(0.0, 0.0, 0.0, 0.0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        BatchRenderer::SetScissor(stdts::nullopt);
+        BatchRenderer::Flush();
+        DisplayList::Perform([] {
+            glClearColor(0.0, 0.0, 0.0, 0.0);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        });
     }
 
     if (clipBounds) {
-        glEnable(GL_SCISSOR_TEST);
-        glScissor(clipBounds->x, target->height() - clipBounds->maxY(), clipBounds->width, clipBounds->height);
+        BatchRenderer::SetScissor(Rectangle<int>{clipBounds->x, target->height() - clipBounds->maxY(), clipBounds->width, clipBounds->height});
     } else {
-        glDisable(GL_SCISSOR_TEST);
+        BatchRenderer::SetScissor(stdts::nullopt);
     }
 
     if (_backgroundColor.alpha() > 0) {
@@ -840,18 +1129,81 @@ void View::_renderAndRenderSubviews(const RenderTarget* target, const Rectangle<
         backgroundShader->flush();
     }
 
-    render(target, area);
+    FrameProfiler::ViewScope profilerScope{this};
+
+    if (!_retainsRender) {
+        render(target, area);
+    } else if (_displayList && _displayListTransformation == _renderTransformation) {
+        _displayList->replay();
+    } else {
+        _displayList.emplace();
+        _displayListTransformation = _renderTransformation;
+        {
+            DisplayList::Recording recording{&*_displayList};
+            render(target, area);
+        }
+        if (DisplayList::IsDeferring()) {
+            // nothing was drawn while recording, so the draws need to be added to the frame
+            _displayList->replay();
+        }
+    }
+
+    profilerScope.end();
+
+    Rectangle<int> targetArea{0, 0, target->width(), target->height()};
+    auto drawableArea = clipBounds ? clipBounds->intersection(targetArea) : targetArea;
 
-    for (auto& subview : Reverse(subviews())) {
-        Rectangle<int> subarea(std::round(area.x + xScale * subview->_bounds.x),
-                               std::round(area.y + yScale * subview->_bounds.y),
-                               std::round(xScale * subview->_scale.x * subview->_bounds.width),
-                               std::round(yScale * subview->_scale.y * subview->_bounds.height));
-        subview->renderAndRenderSubviews(target, subarea, clipBounds);
+    auto renderSubviews = [&](auto& subviews) {
+        // find the opaque subviews so that the subviews behind them can be skipped if they're completely covered
+        std::vector<std::pair<size_t, Rectangle<int>>> opaqueAreas;
+        size_t index = 0;
+        for (auto& subview : subviews) {
+            if (subview->isVisible() && subview->isOpaque()) {
+                auto covered = _subviewArea(subview, area).intersection(drawableArea);
+                if (covered.width > 0 && covered.height > 0) {
+                    opaqueAreas.emplace_back(index, covered);
+                }
+            }
+            ++index;
+        }
+
+        for (auto& subview : Reverse(subviews)) {
+            --index;
+            auto subarea = _subviewArea(subview, area);
+            if (!opaqueAreas.empty() && !subview->_rendersToTexture) {
+                auto extent = subview->_renderExtent(subarea).intersection(drawableArea);
+                auto isOccluded = std::any_of(opaqueAreas.begin(), opaqueAreas.end(), [&](auto& opaqueArea) {
+                    return opaqueArea.first < index && opaqueArea.second.intersection(extent) == extent;
+                });
+                if (isOccluded) { continue; }
+            }
+            subview->renderAndRenderSubviews(target, subarea, clipBounds);
+        }
+    };
+
+    if (_spatialIndex) {
+        // only the subviews that intersect the drawable area need to be rendered. pad it a bit for rounding
+        Rectangle<double> localArea{
+            (drawableArea.x - area.x - 1) / xScale,
+            (drawableArea.y - area.y - 1) / yScale,
+            (drawableArea.width + 2) / xScale,
+            (drawableArea.height + 2) / yScale
+        };
+        std::vector<View*> candidates;
+        _spatialIndex->query(localArea, &candidates);
+        // subviews that render to textures are always rendered since their textures may be used elsewhere
+        candidates.insert(candidates.end(), _subviewsRenderingToTexture.begin(), _subviewsRenderingToTexture.end());
+        std::sort(candidates.begin(), candidates.end(), [](View* a, View* b) {
+            return a->_spatialIndexOrder > b->_spatialIndexOrder;
+        });
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        renderSubviews(candidates);
+    } else {
+        renderSubviews(subviews());
     }
 
     if (clipBounds) {
-        glDisable(GL_SCISSOR_TEST);
+        BatchRenderer::SetScissor(stdts::nullopt);
     }
 }
 
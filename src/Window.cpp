@@ -16,19 +16,53 @@
 #include <okui/Window.h>
 #include <okui/Application.h>
 
+#include <algorithm>
 #include <cassert>
 
 namespace okui {
 
+namespace {
+    void InvalidateRenderCaches(View* view) {
+        view->invalidateRenderCache();
+        for (auto subview : view->subviews()) {
+            InvalidateRenderCaches(subview);
+        }
+    }
+
+    int NextPowerOfTwo(int x) {
+        int result = 1;
+        while (result < x) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    std::string TextureCacheKey(std::string source, Point<int> bucket) {
+        if (bucket.x || bucket.y) {
+            source += "@" + std::to_string(bucket.x) + "x" + std::to_string(bucket.y);
+        }
+        return source;
+    }
+
+    std::shared_ptr<FileTexture> MakeFileTexture(std::shared_ptr<FileTexture> texture, Point<int> bucket) {
+        texture->setTargetSize(bucket.x, bucket.y);
+        return texture;
+    }
+} // anonymous namespace
+
 Window::Window(Application* application)
     : _application{application}
     , _deviceRenderScale{application->renderScale()}
+    , _lastRenderTime{application->now()}
+    , _lastUpdateTime{application->now()}
 {
     _application->addWindow(this);
+    _textureCache.setBudget(kDefaultTextureCacheBudget);
 }
 
 Window::~Window() {
-    _decompressionThread.cancelAndJoin();
+    _renderThread.reset();
+    _decodePool.cancelAndJoin();
 
     // the content view should be destroyed before the window's other members
     _contentView.reset();
@@ -40,6 +74,9 @@ Window::~Window() {
 void Window::open() {
     if (_isOpen) { return; }
     willOpen();
+    if (_cachesProgramBinaries && !_programBinaryCache) {
+        _createProgramBinaryCache();
+    }
     _contentView->_dispatchFutureVisibilityChange(true);
     application()->openWindow(this, _title.c_str(), _position, _width, _height);
     _isOpen = true;
@@ -60,6 +97,22 @@ void Window::close() {
     didClose();
 }
 
+void Window::setCachesProgramBinaries(bool cachesProgramBinaries) {
+    _cachesProgramBinaries = cachesProgramBinaries;
+    if (!cachesProgramBinaries) {
+        _programBinaryCache.reset();
+    } else if (_isOpen && !_programBinaryCache) {
+        _createProgramBinaryCache();
+    }
+}
+
+void Window::warmUpStandardShaders() {
+    warmUpShader<shaders::ColorShader>("color shader");
+    warmUpShader<shaders::TextureShader>("texture shader");
+    warmUpShader<shaders::DistanceFieldShader>("distance field shader");
+    warmUpShader<shaders::ShapeShader>("shape shader");
+}
+
 void Window::setPosition(const WindowPosition& pos) {
     _position = pos;
     application()->setWindowPosition(this, pos);
@@ -76,6 +129,62 @@ void Window::setSize(int width, int height) {
     _updateContentLayout();
 }
 
+void Window::setRedrawMode(RedrawMode mode) {
+    _redrawMode = mode;
+    invalidate();
+}
+
+void Window::setBackBufferAge(int age) {
+    assert(age > 0);
+    _backBufferAge = age;
+    invalidate();
+}
+
+void Window::invalidateRegion(const Rectangle<double>& region) {
+    _damagedRegion.add(region);
+}
+
+void Window::invalidate() {
+    _needsFullRedraw = true;
+    _damageHistory.clear();
+}
+
+void Window::setRendersOnDemand(bool rendersOnDemand) {
+    _rendersOnDemand = rendersOnDemand;
+    invalidate();
+}
+
+void Window::setRendersOnRenderThread(bool rendersOnRenderThread) {
+    if (rendersOnRenderThread == this->rendersOnRenderThread()) { return; }
+    _renderThread = rendersOnRenderThread ? std::make_unique<RenderThread>() : nullptr;
+    invalidate();
+}
+
+bool Window::needsDisplay() const {
+    if (_needsFullRedraw || !_damagedRegion.empty() || !_updatingViews.empty() || !_viewsToSubscribeToUpdates.empty()
+        || _contentView->needsLayout() || _contentView->_subviewsNeedLayout || (!_shaderWarmUps.empty() && _shaderWarmUpBudget.count() > 0) || !_texturesToUpload.empty() || !_stagedTextureUploads.empty()) {
+        return true;
+    }
+
+    for (auto& kv : _textureDownloads) {
+        if (kv.second.download.wait_for(0ms) == std::future_status::ready) {
+            return true;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock{_texturesToLoadMutex};
+    return !_texturesToLoad.empty();
+}
+
+void Window::purgeCaches() {
+    _textureCache.purge();
+    _renderCachePool.purge();
+}
+
+bool Window::hasPendingTextures() const {
+    return !_textureDownloads.empty() || !_decodes.empty() || !_texturesToUpload.empty() || !_stagedTextureUploads.empty();
+}
+
 void Window::setTitle(std::string title) {
     _title = std::move(title);
     application()->setWindowTitle(this, _title.c_str());
@@ -86,10 +195,17 @@ void Window::setMenu(const Menu& menu) {
     application()->setWindowMenu(this, menu);
 }
 
-TextureHandle Window::loadTextureResource(const std::string& name) {
-    auto hashable = std::string("resource: ") + name;
+Point<int> Window::TextureTargetSizeBucket(Point<int> targetSize) {
+    // rounding up to powers of two lets similarly sized views share the same decoded texture
+    return {targetSize.x > 0 ? NextPowerOfTwo(targetSize.x) : 0, targetSize.y > 0 ? NextPowerOfTwo(targetSize.y) : 0};
+}
+
+TextureHandle Window::loadTextureResource(const std::string& name, DecodePool::Priority priority, Point<int> targetSize) {
+    auto bucket = TextureTargetSizeBucket(targetSize);
+    auto hashable = TextureCacheKey(std::string("resource: ") + name, bucket);
 
     if (auto hit = _textureCache.get(hashable)) {
+        _raiseDecodePriority(hashable, priority);
         return hit;
     }
 
@@ -99,36 +215,43 @@ TextureHandle Window::loadTextureResource(const std::string& name) {
         return nullptr;
     }
 
-    auto handle = _textureCache.add(TextureHandle{std::make_shared<FileTexture>(resource, hashable)}, hashable);
-    _decompressTexture(hashable);
+    auto handle = _textureCache.add(TextureHandle{MakeFileTexture(std::make_shared<FileTexture>(resource, hashable), bucket)}, hashable);
+    _decompressTexture(hashable, priority);
     return handle;
 }
 
-TextureHandle Window::loadTextureFromMemory(std::shared_ptr<const std::string> data) {
-    auto hashable = std::string("memory: ") + std::to_string(reinterpret_cast<uintptr_t>(data->data())) + ":" + std::to_string(data->size());
+TextureHandle Window::loadTextureFromMemory(std::shared_ptr<const std::string> data, DecodePool::Priority priority, Point<int> targetSize) {
+    auto bucket = TextureTargetSizeBucket(targetSize);
+    auto hashable = TextureCacheKey(std::string("memory: ") + std::to_string(reinterpret_cast<uintptr_t>(data->data())) + ":" + std::to_string(data->size()), bucket);
 
     if (auto hit = _textureCache.get(hashable)) {
+        _raiseDecodePriority(hashable, priority);
         return hit;
     }
 
-    auto handle = _textureCache.add(TextureHandle{std::make_shared<FileTexture>(data, hashable)}, hashable);
-    _decompressTexture(hashable);
+    auto handle = _textureCache.add(TextureHandle{MakeFileTexture(std::make_shared<FileTexture>(data, hashable), bucket)}, hashable);
+    _decompressTexture(hashable, priority);
     return handle;
 }
 
-TextureHandle Window::loadTextureFromURL(const std::string& url) {
-    if (auto hit = _textureCache.get(url)) {
-        return hit;
+TextureHandle Window::loadTextureFromURL(const std::string& url, DecodePool::Priority priority, Point<int> targetSize) {
+    auto bucket = TextureTargetSizeBucket(targetSize);
+    auto hashable = TextureCacheKey(url, bucket);
+
+    auto it = _textureDownloads.find(hashable);
+    if (it != _textureDownloads.end()) {
+        it->second.priority = std::min(it->second.priority, priority);
+        return it->second.handle.newHandle();
     }
 
-    auto it = _textureDownloads.find(url);
-    if (it == _textureDownloads.end()) {
-        auto handle = _textureCache.add(TextureHandle{std::make_shared<FileTexture>(url)}, url);
-        _textureDownloads[url] = { application()->download(url), handle.newHandle() };
-        return handle;
+    if (auto hit = _textureCache.get(hashable)) {
+        _raiseDecodePriority(hashable, priority);
+        return hit;
     }
 
-    return it->second.handle.newHandle();
+    auto handle = _textureCache.add(TextureHandle{MakeFileTexture(std::make_shared<FileTexture>(url), bucket)}, hashable);
+    _textureDownloads[hashable] = { application()->download(url), handle.newHandle(), priority };
+    return handle;
 }
 
 std::shared_ptr<BitmapFont> Window::loadBitmapFontResource(const char* textureName, const char* metadataName) {
@@ -181,6 +304,14 @@ bool Window::moveFocus(Direction direction) {
         return false;
     }
 
+    for (auto view = focus(); view; view = view->superview()) {
+        view->focusWillMove(direction);
+    }
+
+    if (!focus()) {
+        return false;
+    }
+
     std::vector<std::tuple<View*, Rectangle<double>>> focusableRegions;
     contentView()->_updateFocusableRegions(focusableRegions);
     auto previousFocus = focus();
@@ -356,7 +487,10 @@ void Window::ensureTextures() {
         if (status == std::future_status::ready) {
             if (auto data = download.download.get()) {
                 std::static_pointer_cast<FileTexture>(download.handle.texture())->setData(data);
-                _decompressTexture(it->first);
+                _decompressTexture(it->first, download.priority);
+            } else {
+                // like failed decodes, failed downloads would otherwise stay in the cache forever
+                _textureCache.remove(it->first);
             }
 
             it = _textureDownloads.erase(it);
@@ -365,45 +499,119 @@ void Window::ensureTextures() {
         }
     }
 
-    std::vector<std::string> texturesToLoad;
+    _cancelUnreferencedDecodes();
 
     {
         std::lock_guard<std::mutex> lock{_texturesToLoadMutex};
-        _texturesToLoad.swap(texturesToLoad);
+        for (auto& textureToLoad : _texturesToLoad) {
+            _decodes.erase(textureToLoad);
+            _texturesToUpload.emplace_back(std::move(textureToLoad));
+        }
+        _texturesToLoad.clear();
     }
 
-    for (auto& textureToLoad : texturesToLoad) {
-        if (auto handle = _textureCache.get(textureToLoad)) {
-            handle->load();
+    // textures staged last frame have had a frame for their data to be transferred, so they're uploaded first. their
+    // bytes were counted against the budget when they were staged
+    auto loadsStagedTextures = !_stagedTextureUploads.empty();
+    for (auto& hashable : _stagedTextureUploads) {
+        if (auto handle = _textureCache.find(hashable)) {
+            std::static_pointer_cast<FileTexture>(handle.texture())->load();
+            _textureCache.updateBytes(hashable);
             if (handle.isLoaded()) {
                 handle.invokeLoadCallbacks();
             }
         }
     }
-}
+    _stagedTextureUploads.clear();
+
+    auto atlasGeneration = _textureAtlas.generation();
+    auto stats = _profiler.currentFrame();
+
+    // at least one texture is uploaded per frame, even if it alone exceeds the budget
+    auto deadline = std::chrono::steady_clock::now() + _textureUploadTimeBudget;
+    size_t bytes = 0;
+    while (!_texturesToUpload.empty()) {
+        auto hashable = std::move(_texturesToUpload.front());
+        _texturesToUpload.pop_front();
+        auto handle = _textureCache.find(hashable);
+        if (!handle) { continue; }
+
+        auto texture = std::static_pointer_cast<FileTexture>(handle.texture());
+        auto size = texture->uploadSize();
+        if (!_packsTextures || !texture->loadIntoAtlas(&_textureAtlas)) {
+            if (_stagesTextureUploads && texture->stage()) {
+                _stagedTextureUploads.emplace_back(std::move(hashable));
+            } else {
+                texture->load();
+            }
+        }
+        if (!texture->isStaged()) {
+            _textureCache.updateBytes(hashable);
+        }
+        if (handle.isLoaded()) {
+            handle.invokeLoadCallbacks();
+        }
 
-void Window::_update() {
-    auto now = std::chrono::high_resolution_clock::now();
-    update();
-    auto elapsed = now - _lastUpdateTime;
-    for (auto view : _viewsToSubscribeToUpdates) {
-        _updatingViews.insert(view);
+        bytes += size;
+        if (stats) {
+            ++stats->textureUploads;
+            stats->textureUploadBytes += size;
+        }
+
+        if (bytes >= _textureUploadByteBudget || std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
     }
-    _viewsToSubscribeToUpdates.clear();
-    for (auto view : _viewsToUnsubscribeFromUpdates) {
-        _updatingViews.erase(view);
+
+    if (bytes || loadsStagedTextures) {
+        // the uploads may have pushed the cache over its budget
+        _textureCache.enforceBudget();
     }
-    _viewsToUnsubscribeFromUpdates.clear();
-    for (auto view : _updatingViews) {
-        if (!_viewsToUnsubscribeFromUpdates.count(view)) {
-            view->dispatchUpdate(elapsed);
+
+    _textureAtlas.collectGarbage();
+
+    if (_textureAtlas.generation() != atlasGeneration && _contentView) {
+        // atlas textures were moved, so retained renders may have stale texture coordinates
+        InvalidateRenderCaches(_contentView.get());
+    }
+}
+
+void Window::_update() {
+    auto now = _application->now();
+    _framePacer.beginFrame(now);
+    _profiler.beginFrame();
+    _layoutCount = 0;
+
+    {
+        FrameProfiler::PhaseScope phase{&_profiler, FrameProfiler::Phase::kUpdate};
+        update();
+        // when rendering on demand, time spent idle shouldn't be reported to newly subscribed views
+        auto elapsed = _rendersOnDemand && _updatingViews.empty() ? std::chrono::high_resolution_clock::duration::zero()
+                                                                  : std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(now - _lastUpdateTime);
+        for (auto view : _viewsToSubscribeToUpdates) {
+            _updatingViews.insert(view);
+        }
+        _viewsToSubscribeToUpdates.clear();
+        for (auto view : _viewsToUnsubscribeFromUpdates) {
+            _updatingViews.erase(view);
+        }
+        _viewsToUnsubscribeFromUpdates.clear();
+        for (auto view : _updatingViews) {
+            if (!_viewsToUnsubscribeFromUpdates.count(view)) {
+                view->dispatchUpdate(elapsed);
+            }
         }
+        _lastUpdateTime = now;
     }
-    _lastUpdateTime = now;
+
+    FrameProfiler::PhaseScope phase{&_profiler, FrameProfiler::Phase::kLayout};
+    _contentView->layoutIfNeeded();
 }
 
 void Window::_render() {
-    auto now = std::chrono::high_resolution_clock::now();
+    FrameProfiler::PhaseScope phase{&_profiler, FrameProfiler::Phase::kRender};
+
+    auto now = _application->now();
     auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(now - _lastRenderTime).count();
     constexpr auto hysteresis = 0.5;
     _framesPerSecond = _framesPerSecond * hysteresis + 1.0 / elapsed * (1.0 - hysteresis);
@@ -411,16 +619,123 @@ void Window::_render() {
 
     ensureTextures();
 
-    glDisable(GL_SCISSOR_TEST);
-    glClearColor(0.0, 0.0, 0.0, 0.0);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-
-    render();
+    // shaders may be created both while views render and while the display list is performed
+    if (_programBinaryCache) {
+        _programBinaryCache->begin();
+    }
 
     RenderTarget target(_renderWidth, _renderHeight);
-    _contentView->renderAndRenderSubviews(&target, {0, 0, _renderWidth, _renderHeight});
+    DisplayList::Perform([this, width = _renderWidth, height = _renderHeight, streamsVertices = _streamsVertices, programBinaryCache = _programBinaryCache] {
+        if (programBinaryCache) {
+            programBinaryCache->begin();
+        }
+        _batchRenderer.begin(width, height);
+        if (!streamsVertices) {
+            _vertexStream.reset();
+        } else if (!_vertexStream) {
+            _vertexStream = std::make_unique<opengl::StreamingVertexBuffer>();
+        }
+        if (_vertexStream) {
+            _vertexStream->begin();
+        }
+    });
+
+    if (_redrawMode == RedrawMode::kDamaged && !_needsFullRedraw) {
+        _renderDamagedRegions(target);
+    } else {
+        DisplayList::Perform([] {
+            glDisable(GL_SCISSOR_TEST);
+            glClearColor(0.0, 0.0, 0.0, 0.0);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        });
+
+        render();
+
+        _contentView->renderAndRenderSubviews(&target, {0, 0, _renderWidth, _renderHeight});
+
+        _damageHistory.clear();
+        _damagedRegion.clear();
+        _needsFullRedraw = false;
+    }
+
+    _warmUpShaders();
+
+    DisplayList::Perform([this, programBinaryCache = _programBinaryCache] {
+        _batchRenderer.end();
+        if (_vertexStream) {
+            _vertexStream->end();
+        }
+        if (programBinaryCache) {
+            programBinaryCache->end();
+        }
+    });
+    if (_programBinaryCache) {
+        _programBinaryCache->end();
+    }
+    _renderCachePool.endFrame();
+
+    if (auto stats = _profiler.currentFrame()) {
+        stats->layouts = _layoutCount;
+        if (!DisplayList::IsDeferring()) {
+            // deferred frames are drawn later, on the render thread
+            stats->drawCalls = _batchRenderer.statistics().drawCalls;
+            stats->triangles = _batchRenderer.statistics().vertices / 3;
+        }
+    }
 
     SCRAPS_GL_ERROR_CHECK();
+
+    _framePacer.endFrame(_application->now());
+}
+
+std::shared_ptr<const DisplayList> Window::_renderFrame() {
+    auto frame = std::make_shared<DisplayList>();
+    DisplayList::Recording recording{frame.get(), true};
+    _render();
+    return frame;
+}
+
+void Window::_renderDamagedRegions(const RenderTarget& target) {
+    // the back buffer is missing the damage from every frame since it was last drawn to
+    _damageHistory.push_front(std::move(_damagedRegion));
+    _damagedRegion = DamageRegion{};
+
+    DamageRegion redrawRegion;
+    for (auto& damage : _damageHistory) {
+        redrawRegion.add(damage);
+    }
+
+    if (_damageHistory.size() < static_cast<size_t>(_backBufferAge)) {
+        // the back buffer's contents predate the history. draw everything
+        redrawRegion.add(Rectangle<double>{0.0, 0.0, _contentView->bounds().width, _contentView->bounds().height});
+    }
+
+    while (_damageHistory.size() > static_cast<size_t>(std::max(_backBufferAge - 1, 0))) {
+        _damageHistory.pop_back();
+    }
+
+    if (redrawRegion.empty()) { return; }
+
+    Rectangle<int> targetArea{0, 0, _renderWidth, _renderHeight};
+    auto xScale = _contentView->bounds().width > 0.0 ? _renderWidth / _contentView->bounds().width : 1.0;
+    auto yScale = _contentView->bounds().height > 0.0 ? _renderHeight / _contentView->bounds().height : 1.0;
+
+    // each region is drawn just like a full frame would be: cleared, then the window, then its views
+    for (auto& region : redrawRegion.rectangles()) {
+        auto clipBounds = DamageRegion::PixelBounds(region, xScale, yScale).intersection(targetArea);
+        if (clipBounds.width <= 0 || clipBounds.height <= 0) { continue; }
+
+        BatchRenderer::SetScissor(Rectangle<int>{clipBounds.x, _renderHeight - clipBounds.maxY(), clipBounds.width, clipBounds.height});
+        BatchRenderer::Flush();
+        DisplayList::Perform([] {
+            glClearColor(0.0, 0.0, 0.0, 0.0);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        });
+        render();
+        BatchRenderer::SetScissor(stdts::nullopt);
+
+        _contentView->renderAndRenderSubviews(&target, targetArea, clipBounds);
+    }
 }
 
 void Window::_didResize(int width, int height) {
@@ -431,20 +746,75 @@ void Window::_didResize(int width, int height) {
 
 void Window::_updateContentLayout() {
     application()->getWindowRenderSize(this, &_renderWidth, &_renderHeight);
+    invalidate();
     auto scale = (1/_renderScale) * (1/_deviceRenderScale);
     _contentView->setBounds(0, 0, _width*scale, _height*scale);
     layout();
 }
 
-void Window::_decompressTexture(const std::string& hashable) {
-    _decompressionThread.async([=] {
-        if (auto hit = _textureCache.get(hashable)) {
-            std::static_pointer_cast<FileTexture>(hit.texture())->decompress();
+void Window::_decompressTexture(const std::string& hashable, DecodePool::Priority priority) {
+    _decodes[hashable] = _decodePool.async(priority, [=] {
+        if (auto hit = _textureCache.find(hashable)) {
+            if (!std::static_pointer_cast<FileTexture>(hit.texture())->decompress()) {
+                // textures that fail never use any gpu memory, so the budget would never evict them
+                _textureCache.remove(hashable);
+            }
+        }
 
+        {
             std::lock_guard<std::mutex> lock{_texturesToLoadMutex};
             _texturesToLoad.push_back(hashable);
         }
+
+        // the texture can be loaded on the next frame
+        application()->wakeUp();
     });
 }
 
+void Window::_raiseDecodePriority(const std::string& hashable, DecodePool::Priority priority) {
+    auto it = _decodes.find(hashable);
+    if (it != _decodes.end() && priority < it->second->priority()) {
+        _decodePool.setPriority(it->second, priority);
+    }
+}
+
+void Window::_cancelUnreferencedDecodes() {
+    for (auto it = _decodes.begin(); it != _decodes.end();) {
+        // if nothing but the cache refers to the texture, nobody is waiting for it
+        if (!_textureCache.isReferenced(it->first) && _decodePool.cancel(it->second)) {
+            _textureCache.remove(it->first);
+            it = _decodes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void Window::_createProgramBinaryCache() {
+    auto path = _application->userStoragePath();
+    if (path.empty()) { return; }
+    if (path.back() != '/') {
+        path += '/';
+    }
+    _programBinaryCache = std::make_shared<opengl::ProgramBinaryCache>(path + "program-binaries.cache");
+}
+
+void Window::_warmUpShaders() {
+    if (_shaderWarmUps.empty()) { return; }
+
+    // warm-ups only use the time left before the next frame is due, and no more of it than the budget allows. busy
+    // frames don't warm up anything
+    auto now = _application->now();
+    auto deadline = std::min(now + _shaderWarmUpBudget, _framePacer.nextFrameTime());
+    if (now >= deadline) { return; }
+
+    do {
+        auto warmUp = std::move(_shaderWarmUps.front());
+        _shaderWarmUps.pop_front();
+        if (!_shaderCache.get(warmUp.identifier)) {
+            _shaderCache.add(warmUp.create(), warmUp.identifier, ShaderCache::Policy::kKeepForever);
+        }
+    } while (!_shaderWarmUps.empty() && _application->now() < deadline);
+}
+
 } // namespace okui
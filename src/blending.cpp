@@ -15,6 +15,8 @@
 */
 #include <okui/blending.h>
 
+#include <okui/BatchRenderer.h>
+
 namespace okui {
 
 BlendFunction BlendFunction::kDefault{BlendFactor::kOne, BlendFactor::kOneMinusSourceAlpha, BlendFactor::kOne, BlendFactor::kOneMinusSourceAlpha, true};
@@ -25,13 +27,17 @@ BlendFunction Blending::_sBlendFunction;
 int Blending::_sBlendingDepth = 0;
 
 Blending::Blending(const BlendFunction& function) {
-    ++_sBlendingDepth;
+    if (_sBlendingDepth++ == 0) {
+        BatchRenderer::Flush();
+    }
     opengl::EnableBlending();
     SetBlendFunction(function, &_previous);
 }
 
 Blending::Blending(BlendFactor sourceRGB, BlendFactor destinationRGB, BlendFactor sourceAlpha, BlendFactor destinationAlpha, bool premultipliedSourceAlpha) {
-    ++_sBlendingDepth;
+    if (_sBlendingDepth++ == 0) {
+        BatchRenderer::Flush();
+    }
     opengl::EnableBlending();
     SetBlendFunction(BlendFunction{sourceRGB, destinationRGB, sourceAlpha, destinationAlpha, premultipliedSourceAlpha}, &_previous);
 }
@@ -39,6 +45,7 @@ Blending::Blending(BlendFactor sourceRGB, BlendFactor destinationRGB, BlendFacto
 Blending::~Blending() {
     SetBlendFunction(_previous);
     if (--_sBlendingDepth == 0) {
+        BatchRenderer::Flush();
         opengl::DisableBlending();
     }
 }
@@ -47,6 +54,10 @@ void Blending::SetBlendFunction(const BlendFunction& function, BlendFunction* pr
     if (previous) {
         *previous = _sBlendFunction;
     }
+    if (!(function == _sBlendFunction)) {
+        // batched draws must be made with the blend function they were added with
+        BatchRenderer::Flush();
+    }
     _sBlendFunction = function;
     opengl::SetBlendFunction(function.sourceRGB, function.destinationRGB, function.sourceAlpha, function.destinationAlpha);
 }
@@ -0,0 +1,74 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/opengl/ContextOwnership.h>
+
+#include <cassert>
+
+namespace okui::opengl {
+
+std::atomic<int> ContextOwnership::_sSharingCount{0};
+thread_local int ContextOwnership::_sOwnershipCount = 0;
+std::mutex ContextOwnership::_sPendingReleasesMutex;
+std::vector<std::function<void()>> ContextOwnership::_sPendingReleases;
+
+ContextOwnership::ContextOwnership() {
+    ++_sOwnershipCount;
+    ReleasePending();
+}
+
+ContextOwnership::~ContextOwnership() {
+    ReleasePending();
+    --_sOwnershipCount;
+}
+
+bool ContextOwnership::IsOwnedByCurrentThread() {
+    return _sOwnershipCount > 0 || !_sSharingCount;
+}
+
+void ContextOwnership::BeginSharing() {
+    ++_sSharingCount;
+}
+
+void ContextOwnership::EndSharing() {
+    assert(_sSharingCount > 0);
+    --_sSharingCount;
+}
+
+void ContextOwnership::ReleasePending() {
+    if (!IsOwnedByCurrentThread()) { return; }
+
+    std::vector<std::function<void()>> releases;
+    {
+        std::lock_guard<std::mutex> lock{_sPendingReleasesMutex};
+        releases.swap(_sPendingReleases);
+    }
+
+    for (auto& release : releases) {
+        release();
+    }
+}
+
+void ReleaseResources(std::function<void()> release) {
+    if (ContextOwnership::IsOwnedByCurrentThread()) {
+        release();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock{ContextOwnership::_sPendingReleasesMutex};
+    ContextOwnership::_sPendingReleases.emplace_back(std::move(release));
+}
+
+} // namespace okui::opengl
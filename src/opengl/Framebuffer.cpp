@@ -15,6 +15,8 @@
 */
 #include <okui/opengl/Framebuffer.h>
 
+#include <okui/opengl/ContextOwnership.h>
+
 #include <cassert>
 
 namespace okui::opengl {
@@ -25,7 +27,9 @@ Framebuffer::Framebuffer() {
 }
 
 Framebuffer::~Framebuffer() {
-    glDeleteFramebuffers(1, &_framebuffer);
+    ReleaseResources([framebuffer = _framebuffer] {
+        glDeleteFramebuffers(1, &framebuffer);
+    });
 }
 
 bool Framebuffer::isComplete() {
@@ -104,7 +108,9 @@ Framebuffer::Attachment::Attachment(int width, int height, bool isDepthStencil)
 
 Framebuffer::Attachment::~Attachment() {
     if (_texture) {
-        glDeleteTextures(1, &_texture);
+        ReleaseResources([texture = _texture] {
+            glDeleteTextures(1, &texture);
+        });
     }
 }
 
@@ -0,0 +1,293 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/opengl/ProgramBinaryCache.h>
+
+#include <scraps/logging.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#if OPENGL_ES && !GL_ES_VERSION_3_0
+#define OKUI_PROGRAM_BINARIES 0
+#else
+#define OKUI_PROGRAM_BINARIES 1
+#endif
+
+namespace okui::opengl {
+
+namespace {
+
+constexpr char     kMagic[4] = {'O', 'K', 'P', 'B'};
+constexpr uint32_t kVersion  = 2;
+
+std::string GLString(GLenum name) {
+    auto string = reinterpret_cast<const char*>(glGetString(name));
+    return string ? string : "";
+}
+
+template <typename T>
+bool Read(std::istream& stream, T* value) {
+    return static_cast<bool>(stream.read(reinterpret_cast<char*>(value), sizeof(T)));
+}
+
+template <typename T>
+void Write(std::ostream& stream, const T& value) {
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+} // anonymous namespace
+
+thread_local ProgramBinaryCache* ProgramBinaryCache::_sCurrent = nullptr;
+
+ProgramBinaryCache::ProgramBinaryCache(std::string path) : _path{std::move(path)} {}
+
+ProgramBinaryCache::~ProgramBinaryCache() {
+    save();
+    if (_sCurrent == this) {
+        _sCurrent = nullptr;
+    }
+}
+
+size_t ProgramBinaryCache::maximumEntries() const {
+    std::lock_guard<std::mutex> lock{_mutex};
+    return _maximumEntries;
+}
+
+void ProgramBinaryCache::setMaximumEntries(size_t maximumEntries) {
+    std::lock_guard<std::mutex> lock{_mutex};
+    _maximumEntries = maximumEntries;
+    _prune();
+}
+
+size_t ProgramBinaryCache::size() const {
+    std::lock_guard<std::mutex> lock{_mutex};
+    return _entries.size();
+}
+
+bool ProgramBinaryCache::IsSupported() {
+#if OKUI_PROGRAM_BINARIES
+    auto major = scraps::opengl::MajorVersion();
+    auto minor = scraps::opengl::MinorVersion();
+    if (scraps::opengl::kIsOpenGLES) {
+        if (major < 3) { return false; }
+    } else if ((major < 4 || (major == 4 && minor < 1)) && !scraps::opengl::HasExtension("GL_ARB_get_program_binary")) {
+        return false;
+    }
+    // some drivers expose the functions but don't support any formats
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+#else
+    return false;
+#endif
+}
+
+void ProgramBinaryCache::prepare(GLuint program) {
+    std::lock_guard<std::mutex> lock{_mutex};
+    if (!_open()) { return; }
+#if OKUI_PROGRAM_BINARIES
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+}
+
+bool ProgramBinaryCache::load(GLuint program, const std::string& key) {
+    std::lock_guard<std::mutex> lock{_mutex};
+    if (!_open()) { return false; }
+
+    auto it = _entries.find(key);
+    if (it == _entries.end()) {
+        ++_statistics.misses;
+        return false;
+    }
+
+#if OKUI_PROGRAM_BINARIES
+    glProgramBinary(program, it->second.format, it->second.binary.data(), static_cast<GLsizei>(it->second.binary.size()));
+
+    GLint linkStatus = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+    if (linkStatus) {
+        it->second.lastUse = ++_useCount;
+        ++_statistics.hits;
+        return true;
+    }
+#endif
+
+    SCRAPS_LOG_WARNING("program binary was rejected by the driver. compiling from source");
+    _entries.erase(it);
+    _needsSave = true;
+    ++_statistics.rejections;
+    return false;
+}
+
+void ProgramBinaryCache::store(GLuint program, const std::string& key) {
+    std::lock_guard<std::mutex> lock{_mutex};
+    if (!_open()) { return; }
+
+#if OKUI_PROGRAM_BINARIES
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) { return; }
+
+    Entry entry;
+    entry.binary.resize(length);
+    glGetProgramBinary(program, length, &length, &entry.format, entry.binary.data());
+    if (length <= 0) { return; }
+    entry.binary.resize(length);
+    entry.lastUse = ++_useCount;
+
+    _entries[key] = std::move(entry);
+    _prune();
+    _needsSave = true;
+    ++_statistics.stores;
+#endif
+}
+
+void ProgramBinaryCache::save() {
+    std::lock_guard<std::mutex> lock{_mutex};
+    if (!_needsSave) { return; }
+    _needsSave = false;
+
+    // write to a temporary file first so that a crash can't leave a truncated cache behind
+    auto temporaryPath = _path + ".tmp";
+    {
+        std::ofstream f(temporaryPath, std::ios::binary | std::ios::trunc);
+        f.write(kMagic, sizeof(kMagic));
+        Write(f, kVersion);
+        Write(f, static_cast<uint32_t>(_driver.size()));
+        f.write(_driver.data(), _driver.size());
+        Write(f, static_cast<uint32_t>(_entries.size()));
+
+        // entries are written from least to most recently used so that the order can be restored when they're read
+        std::vector<const std::pair<const std::string, Entry>*> entries;
+        for (auto& kv : _entries) {
+            entries.emplace_back(&kv);
+        }
+        std::sort(entries.begin(), entries.end(), [](auto a, auto b) { return a->second.lastUse < b->second.lastUse; });
+
+        for (auto kv : entries) {
+            // the whole key is written rather than a hash of it so that a collision can never load the wrong binary
+            Write(f, static_cast<uint32_t>(kv->first.size()));
+            f.write(kv->first.data(), kv->first.size());
+            Write(f, static_cast<uint32_t>(kv->second.format));
+            Write(f, static_cast<uint32_t>(kv->second.binary.size()));
+            f.write(reinterpret_cast<const char*>(kv->second.binary.data()), kv->second.binary.size());
+        }
+        if (!f) {
+            SCRAPS_LOG_WARNING("unable to write program binary cache to {}", temporaryPath);
+            std::remove(temporaryPath.c_str());
+            return;
+        }
+    }
+
+    if (std::rename(temporaryPath.c_str(), _path.c_str())) {
+        SCRAPS_LOG_WARNING("unable to write program binary cache to {}", _path);
+        std::remove(temporaryPath.c_str());
+    }
+}
+
+void ProgramBinaryCache::begin() {
+    _sCurrent = this;
+}
+
+void ProgramBinaryCache::end() {
+    save();
+    if (_sCurrent == this) {
+        _sCurrent = nullptr;
+    }
+}
+
+ProgramBinaryCache::Statistics ProgramBinaryCache::statistics() const {
+    std::lock_guard<std::mutex> lock{_mutex};
+    return _statistics;
+}
+
+bool ProgramBinaryCache::_open() {
+    if (_isOpen) { return _isSupported; }
+    _isOpen = true;
+
+    _isSupported = IsSupported();
+    if (!_isSupported) { return false; }
+
+    _driver = GLString(GL_VENDOR) + '\n' + GLString(GL_RENDERER) + '\n' + GLString(GL_VERSION) + '\n' + GLString(GL_SHADING_LANGUAGE_VERSION);
+    _read();
+    return true;
+}
+
+void ProgramBinaryCache::_read() {
+    std::ifstream f(_path, std::ios::binary | std::ios::ate);
+    if (!f) { return; }
+
+    // lengths read from the file are checked against what's left of it before anything is allocated for them, so a
+    // corrupt file can't cause a huge allocation
+    auto size = static_cast<uint64_t>(f.tellg());
+    f.seekg(0);
+    auto fits = [&](uint64_t length) { return length <= size - static_cast<uint64_t>(f.tellg()); };
+
+    char magic[sizeof(kMagic)];
+    uint32_t version = 0, driverLength = 0, count = 0;
+    if (!f.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), kMagic) || !Read(f, &version) || version != kVersion || !Read(f, &driverLength) || !fits(driverLength)) {
+        SCRAPS_LOG_WARNING("discarding unrecognized program binary cache at {}", _path);
+        _needsSave = true;
+        return;
+    }
+
+    std::string driver(driverLength, '\0');
+    if (!f.read(&driver[0], driverLength) || driver != _driver) {
+        SCRAPS_LOG_INFO("the graphics driver has changed. discarding program binary cache");
+        _needsSave = true;
+        return;
+    }
+
+    if (!Read(f, &count)) {
+        _needsSave = true;
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t keyLength = 0, format = 0, length = 0;
+        std::string key;
+        Entry entry;
+        if (Read(f, &keyLength) && fits(keyLength)) {
+            key.resize(keyLength);
+            if (f.read(&key[0], keyLength) && Read(f, &format) && Read(f, &length) && fits(length)) {
+                entry.format = format;
+                entry.binary.resize(length);
+                if (f.read(reinterpret_cast<char*>(entry.binary.data()), length)) {
+                    entry.lastUse = ++_useCount;
+                    _entries[std::move(key)] = std::move(entry);
+                    continue;
+                }
+            }
+        }
+        SCRAPS_LOG_WARNING("discarding corrupt program binary cache at {}", _path);
+        _entries.clear();
+        _needsSave = true;
+        return;
+    }
+
+    _prune();
+}
+
+void ProgramBinaryCache::_prune() {
+    while (_entries.size() > _maximumEntries) {
+        auto leastRecentlyUsed = std::min_element(_entries.begin(), _entries.end(), [](auto& a, auto& b) { return a.second.lastUse < b.second.lastUse; });
+        _entries.erase(leastRecentlyUsed);
+        _needsSave = true;
+    }
+}
+
+} // namespace okui::opengl
@@ -17,24 +17,28 @@
 
 namespace okui::opengl {
 
-Shader::Shader(const char* source, Shader::Type type) {
-    auto shader = glCreateShader(type == kVertexShader ? GL_VERTEX_SHADER : GL_FRAGMENT_SHADER);
+Shader::Shader(const char* source, Shader::Type type) : _source{source} {
+    _shader = glCreateShader(type == kVertexShader ? GL_VERTEX_SHADER : GL_FRAGMENT_SHADER);
     const GLchar* sourcePointer = source;
-    glShaderSource(shader, 1, &sourcePointer, nullptr);
-    glCompileShader(shader);
+    glShaderSource(_shader, 1, &sourcePointer, nullptr);
+    glCompileShader(_shader);
+}
+
+const std::string& Shader::error() const {
+    if (_isChecked) { return _error; }
+    _isChecked = true;
 
     GLint compileStatus = GL_FALSE;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
+    glGetShaderiv(_shader, GL_COMPILE_STATUS, &compileStatus);
 
     if (!compileStatus) {
         char buf[200];
-        glGetShaderInfoLog(shader, sizeof(buf), nullptr, buf);
+        glGetShaderInfoLog(_shader, sizeof(buf), nullptr, buf);
         _error = buf;
-        SCRAPS_LOG_DEBUG("shader compilation failure: {}, source: {}", _error, source);
-        glDeleteShader(shader);
-    } else {
-        _shader = shader;
+        SCRAPS_LOG_DEBUG("shader compilation failure: {}, source: {}", _error, _source);
     }
+
+    return _error;
 }
 
 Shader::~Shader() {
@@ -15,6 +15,8 @@
 */
 #include <okui/opengl/ShaderProgram.h>
 
+#include <okui/opengl/ProgramBinaryCache.h>
+
 namespace okui::opengl {
 
 ShaderProgram::ShaderProgram() {
@@ -34,6 +36,7 @@ void ShaderProgram::attachShader(const Shader& shader) {
 
 void ShaderProgram::bindAttribute(GLuint id, const char* name) {
     glBindAttribLocation(_program, id, name);
+    _attributes.emplace_back(id, name);
 }
 
 void ShaderProgram::link() {
@@ -53,4 +56,38 @@ void ShaderProgram::link() {
     }
 }
 
+void ShaderProgram::link(const std::string& vertexSource, const std::string& fragmentSource) {
+    if (!_error.empty()) { return; }
+
+    auto cache = ProgramBinaryCache::Current();
+    std::string key;
+    if (cache) {
+        key = vertexSource + '\0' + fragmentSource;
+        for (auto& attribute : _attributes) {
+            key += '\0' + std::to_string(attribute.first) + ':' + attribute.second;
+        }
+        if (cache->load(_program, key)) { return; }
+        cache->prepare(_program);
+    }
+
+    // compile errors aren't checked until after linking so that the driver can work on both shaders at once
+    Shader vsh(vertexSource, Shader::kVertexShader);
+    Shader fsh(fragmentSource, Shader::kFragmentShader);
+    glAttachShader(_program, vsh.id());
+    glAttachShader(_program, fsh.id());
+    link();
+
+    if (!_error.empty()) {
+        if (!vsh.error().empty()) {
+            _error = vsh.error();
+        } else if (!fsh.error().empty()) {
+            _error = fsh.error();
+        }
+    }
+
+    if (cache && _error.empty()) {
+        cache->store(_program, key);
+    }
+}
+
 } // namespace okui::opengl
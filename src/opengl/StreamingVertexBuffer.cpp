@@ -0,0 +1,286 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/opengl/StreamingVertexBuffer.h>
+
+#include <okui/opengl/ContextOwnership.h>
+
+#include <scraps/logging.h>
+
+#include <cstring>
+
+#if OPENGL_ES && !GL_ES_VERSION_3_0
+#define OKUI_STREAMING_VERTEX_BUFFER_ES2 1
+#endif
+
+namespace okui::opengl {
+
+namespace {
+
+bool IsVersionAtLeast(int major, int minor) {
+    auto actual = scraps::opengl::MajorVersion();
+    return actual > major || (actual == major && scraps::opengl::MinorVersion() >= minor);
+}
+
+bool SupportsVertexArrays() {
+#if OKUI_STREAMING_VERTEX_BUFFER_ES2
+    return false;
+#else
+    return scraps::opengl::MajorVersion() >= 3;
+#endif
+}
+
+} // anonymous namespace
+
+StreamingVertexBuffer* StreamingVertexBuffer::_sCurrent = nullptr;
+uint64_t StreamingVertexBuffer::_sNextGeneration = 0;
+
+StreamingVertexBuffer::StreamingVertexBuffer(size_t capacity, stdts::optional<Mode> mode)
+    : _segmentSize{capacity / kSegmentCount}
+{
+    _capacity = _segmentSize * kSegmentCount;
+
+    if (mode && IsSupported(*mode)) {
+        _mode = *mode;
+    } else if (IsSupported(Mode::kPersistent)) {
+        _mode = Mode::kPersistent;
+    } else if (IsSupported(Mode::kUnsynchronized)) {
+        _mode = Mode::kUnsynchronized;
+    } else {
+        _mode = Mode::kOrphaning;
+    }
+
+    glGenBuffers(1, &_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+
+#if defined(GL_MAP_PERSISTENT_BIT) && !OPENGL_ES
+    if (_mode == Mode::kPersistent) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, _capacity, nullptr, flags);
+        _mapping = glMapBufferRange(GL_ARRAY_BUFFER, 0, _capacity, flags);
+        if (!_mapping) {
+            SCRAPS_LOG_WARNING("unable to persistently map streaming vertex buffer. falling back to unsynchronized mapping");
+            // buffer storage is immutable, so a new buffer is needed
+            glDeleteBuffers(1, &_buffer);
+            glGenBuffers(1, &_buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+            _mode = Mode::kUnsynchronized;
+        }
+    }
+#endif
+
+    if (_mode != Mode::kPersistent) {
+        glBufferData(GL_ARRAY_BUFFER, _capacity, nullptr, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+StreamingVertexBuffer::~StreamingVertexBuffer() {
+    end();
+
+    ReleaseResources([buffer = _buffer, fences = _fences] {
+#if !OKUI_STREAMING_VERTEX_BUFFER_ES2
+        for (auto fence : fences) {
+            if (fence) {
+                glDeleteSync(fence);
+            }
+        }
+#endif
+        // deleting the buffer also unmaps it
+        glDeleteBuffers(1, &buffer);
+    });
+}
+
+bool StreamingVertexBuffer::IsSupported(Mode mode) {
+    switch (mode) {
+        case Mode::kPersistent:
+#if defined(GL_MAP_PERSISTENT_BIT) && !OPENGL_ES
+            return IsVersionAtLeast(4, 4) || (IsVersionAtLeast(3, 2) && scraps::opengl::HasExtension("GL_ARB_buffer_storage"));
+#else
+            return false;
+#endif
+        case Mode::kUnsynchronized:
+#if OKUI_STREAMING_VERTEX_BUFFER_ES2
+            return false;
+#else
+            // fences are needed too, which desktop contexts don't have until 3.2
+            return scraps::opengl::kIsOpenGLES ? scraps::opengl::MajorVersion() >= 3 : IsVersionAtLeast(3, 2);
+#endif
+        case Mode::kOrphaning:
+            return true;
+    }
+    return false;
+}
+
+void StreamingVertexBuffer::begin() {
+    _sCurrent = this;
+    _statistics = {};
+}
+
+void StreamingVertexBuffer::end() {
+    if (_sCurrent == this) {
+        _sCurrent = nullptr;
+    }
+}
+
+stdts::optional<size_t> StreamingVertexBuffer::_write(const void* data, size_t size, size_t alignment) {
+    if (!size || size > _segmentSize) {
+        return stdts::nullopt;
+    }
+
+    auto offset = (_offset + alignment - 1) / alignment * alignment;
+
+    if (offset + size > _capacity) {
+        _fenceSegment(_segment);
+        if (_mode == Mode::kOrphaning) {
+            glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+            glBufferData(GL_ARRAY_BUFFER, _capacity, nullptr, GL_STREAM_DRAW);
+        }
+        _enterSegment(0);
+        offset = 0;
+        ++_statistics.wraps;
+    }
+
+    auto lastSegment = (offset + size - 1) / _segmentSize;
+    while (_segment < lastSegment) {
+        _fenceSegment(_segment);
+        _enterSegment(_segment + 1);
+    }
+
+    switch (_mode) {
+        case Mode::kPersistent:
+            std::memcpy(static_cast<char*>(_mapping) + offset, data, size);
+            break;
+        case Mode::kUnsynchronized: {
+#if !OKUI_STREAMING_VERTEX_BUFFER_ES2
+            glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+            auto mapping = glMapBufferRange(GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            if (!mapping) {
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                return stdts::nullopt;
+            }
+            std::memcpy(mapping, data, size);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+#endif
+            break;
+        }
+        case Mode::kOrphaning:
+            glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+            glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+            break;
+    }
+
+    if (_mode != Mode::kPersistent) {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    _offset = offset + size;
+    ++_statistics.writes;
+    _statistics.bytes += size;
+    return offset;
+}
+
+void StreamingVertexBuffer::_enterSegment(size_t segment) {
+    _segment = segment;
+
+#if !OKUI_STREAMING_VERTEX_BUFFER_ES2
+    auto& fence = _fences[segment];
+    if (!fence) { return; }
+
+    // the fence is usually signaled long before the ring comes back around, so check before flushing and waiting
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        ++_statistics.stalls;
+        constexpr GLuint64 kTimeout = 1000000000;
+        if (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, kTimeout) == GL_TIMEOUT_EXPIRED) {
+            SCRAPS_LOG_WARNING("timed out waiting for the gpu to release a streaming vertex buffer segment");
+        }
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+#endif
+}
+
+void StreamingVertexBuffer::_fenceSegment(size_t segment) {
+#if !OKUI_STREAMING_VERTEX_BUFFER_ES2
+    // orphaning relies on the driver to keep the old storage alive instead
+    if (_mode == Mode::kOrphaning) { return; }
+
+    auto& fence = _fences[segment];
+    if (fence) {
+        glDeleteSync(fence);
+    }
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+}
+
+StreamingVertexBuffer::VertexArray::~VertexArray() {
+#if !OKUI_STREAMING_VERTEX_BUFFER_ES2
+    if (_vertexArray) {
+        ReleaseResources([vertexArray = _vertexArray] {
+            glDeleteVertexArrays(1, &vertexArray);
+        });
+    }
+#endif
+}
+
+void StreamingVertexBuffer::VertexArray::setAttribute(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, size_t offset) {
+    _attributes.push_back({index, size, type, normalized, stride, offset});
+    _generation = 0;
+}
+
+void StreamingVertexBuffer::VertexArray::bind(const StreamingVertexBuffer& buffer) {
+#if !OKUI_STREAMING_VERTEX_BUFFER_ES2
+    if (SupportsVertexArrays()) {
+        if (!_vertexArray) {
+            glGenVertexArrays(1, &_vertexArray);
+        }
+        glBindVertexArray(_vertexArray);
+        // buffer names may be reused after a buffer is deleted, so the generation determines whether the attributes
+        // need to be re-specified
+        if (_generation != buffer.generation()) {
+            _generation = buffer.generation();
+            glBindBuffer(GL_ARRAY_BUFFER, buffer.buffer());
+            _specifyAttributes();
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        return;
+    }
+#endif
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.buffer());
+    _specifyAttributes();
+}
+
+void StreamingVertexBuffer::VertexArray::unbind() {
+#if !OKUI_STREAMING_VERTEX_BUFFER_ES2
+    if (_vertexArray) {
+        glBindVertexArray(0);
+        return;
+    }
+#endif
+    for (auto& attribute : _attributes) {
+        glDisableVertexAttribArray(attribute.index);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StreamingVertexBuffer::VertexArray::_specifyAttributes() {
+    for (auto& attribute : _attributes) {
+        glEnableVertexAttribArray(attribute.index);
+        glVertexAttribPointer(attribute.index, attribute.size, attribute.type, attribute.normalized, attribute.stride, reinterpret_cast<const void*>(attribute.offset));
+    }
+}
+
+} // namespace okui::opengl
@@ -0,0 +1,502 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/opengl/TextureCompression.h>
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace okui::opengl {
+
+namespace {
+
+struct SupportedFormats {
+    std::mutex                 mutex;
+    bool                       isKnown = false;
+    std::unordered_set<GLenum> formats;
+};
+
+SupportedFormats& Supported() {
+    static SupportedFormats supported;
+    return supported;
+}
+
+bool IsVersionAtLeast(int major, int minor) {
+    auto actual = scraps::opengl::MajorVersion();
+    return actual > major || (actual == major && scraps::opengl::MinorVersion() >= minor);
+}
+
+void QuerySupportedFormats(std::unordered_set<GLenum>* formats) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+    if (count > 0) {
+        std::vector<GLint> list(count);
+        glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, list.data());
+        formats->insert(list.begin(), list.end());
+    }
+
+    // drivers aren't required to list every format they support, so the versions and extensions that guarantee them
+    // are checked too
+    auto hasETC2 = scraps::opengl::kIsOpenGLES ? scraps::opengl::MajorVersion() >= 3
+                                               : IsVersionAtLeast(4, 3) || scraps::opengl::HasExtension("GL_ARB_ES3_compatibility");
+    if (hasETC2) {
+        for (GLenum format = kCompressedR11EAC; format <= kCompressedSRGB8Alpha8ETC2EAC; ++format) {
+            formats->insert(format);
+        }
+    }
+
+    if (scraps::opengl::HasExtension("GL_OES_compressed_ETC1_RGB8_texture")) {
+        formats->insert(kCompressedRGB8ETC1);
+    }
+
+    if (scraps::opengl::HasExtension("GL_EXT_texture_compression_s3tc")) {
+        formats->insert({kCompressedRGBS3TCDXT1, kCompressedRGBAS3TCDXT1, kCompressedRGBAS3TCDXT3, kCompressedRGBAS3TCDXT5});
+        if (!scraps::opengl::kIsOpenGLES || scraps::opengl::HasExtension("GL_EXT_texture_compression_s3tc_srgb")) {
+            formats->insert({kCompressedSRGBS3TCDXT1, kCompressedSRGBAlphaS3TCDXT1, kCompressedSRGBAlphaS3TCDXT3, kCompressedSRGBAlphaS3TCDXT5});
+        }
+    }
+
+    if ((!scraps::opengl::kIsOpenGLES && IsVersionAtLeast(4, 2)) || scraps::opengl::HasExtension("GL_ARB_texture_compression_bptc") || scraps::opengl::HasExtension("GL_EXT_texture_compression_bptc")) {
+        formats->insert({kCompressedRGBABPTCUnorm, kCompressedSRGBAlphaBPTCUnorm});
+    }
+
+    if (scraps::opengl::HasExtension("GL_KHR_texture_compression_astc_ldr") || scraps::opengl::HasExtension("GL_OES_texture_compression_astc")) {
+        for (GLenum i = 0; i < 14; ++i) {
+            formats->insert({kCompressedRGBAASTC4x4 + i, kCompressedSRGB8Alpha8ASTC4x4 + i});
+        }
+    }
+}
+
+uint8_t Clamp(int value) {
+    return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+
+int Extend4(int x) { return (x << 4) | x; }
+int Extend5(int x) { return (x << 3) | (x >> 2); }
+int Extend6(int x) { return (x << 2) | (x >> 4); }
+int Extend7(int x) { return (x << 1) | (x >> 6); }
+
+int SignExtend3(int x) {
+    x &= 7;
+    return x >= 4 ? x - 8 : x;
+}
+
+void SetPixel(uint8_t* pixels, int x, int y, int r, int g, int b, int a = 255) {
+    auto pixel = &pixels[(y * 4 + x) * 4];
+    pixel[0] = Clamp(r);
+    pixel[1] = Clamp(g);
+    pixel[2] = Clamp(b);
+    pixel[3] = Clamp(a);
+}
+
+constexpr int kETCModifiers[8][2] = {{2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}};
+constexpr int kETCDistances[8] = {3, 6, 11, 16, 23, 32, 41, 64};
+
+constexpr int kEACModifiers[16][8] = {
+    {-3, -6,  -9, -15, 2, 5, 8, 14},
+    {-3, -7, -10, -13, 2, 6, 9, 12},
+    {-2, -5,  -8, -13, 1, 4, 7, 12},
+    {-2, -4,  -6, -13, 1, 3, 5, 12},
+    {-3, -6,  -8, -12, 2, 5, 7, 11},
+    {-3, -7,  -9, -11, 2, 6, 8, 10},
+    {-4, -7,  -8, -11, 3, 6, 7, 10},
+    {-3, -5,  -8, -11, 2, 4, 7, 10},
+    {-2, -6,  -8, -10, 1, 5, 7,  9},
+    {-2, -5,  -8, -10, 1, 4, 7,  9},
+    {-2, -4,  -8, -10, 1, 3, 7,  9},
+    {-2, -5,  -7, -10, 1, 4, 6,  9},
+    {-3, -4,  -7, -10, 2, 3, 6,  9},
+    {-1, -2,  -3, -10, 0, 1, 2,  9},
+    {-4, -6,  -8,  -9, 3, 5, 7,  8},
+    {-3, -5,  -7,  -9, 2, 4, 6,  8},
+};
+
+/**
+* Decodes an ETC1 or ETC2 color block into 16 row-major RGBA pixels. Punchthrough blocks are those of the RGB8A1
+* formats, which use the differential bit to indicate whether the block is opaque.
+*/
+void DecodeETC2Block(const uint8_t* block, bool punchthrough, uint8_t* pixels) {
+    uint32_t indices = (uint32_t(block[4]) << 24) | (uint32_t(block[5]) << 16) | (uint32_t(block[6]) << 8) | block[7];
+    auto index = [&](int x, int y) {
+        auto i = x * 4 + y;
+        return static_cast<int>((((indices >> (i + 16)) & 1) << 1) | ((indices >> i) & 1));
+    };
+
+    auto isDifferential = (block[3] & 2) != 0;
+    auto isOpaque = !punchthrough || isDifferential;
+
+    auto setPaintPixels = [&](const int (&paint)[4][3]) {
+        for (int y = 0; y < 4; ++y) {
+            for (int x = 0; x < 4; ++x) {
+                auto i = index(x, y);
+                if (!isOpaque && i == 2) {
+                    SetPixel(pixels, x, y, 0, 0, 0, 0);
+                } else {
+                    SetPixel(pixels, x, y, paint[i][0], paint[i][1], paint[i][2]);
+                }
+            }
+        }
+    };
+
+    int base[2][3];
+
+    if (isDifferential || punchthrough) {
+        int r = block[0] >> 3, g = block[1] >> 3, b = block[2] >> 3;
+        int dr = SignExtend3(block[0]), dg = SignExtend3(block[1]), db = SignExtend3(block[2]);
+
+        if (r + dr < 0 || r + dr > 31) {
+            // t mode
+            int c1[3] = {Extend4((((block[0] >> 3) & 3) << 2) | (block[0] & 3)), Extend4(block[1] >> 4), Extend4(block[1] & 0xf)};
+            int c2[3] = {Extend4(block[2] >> 4), Extend4(block[2] & 0xf), Extend4(block[3] >> 4)};
+            auto d = kETCDistances[(((block[3] >> 2) & 3) << 1) | (block[3] & 1)];
+            int paint[4][3] = {
+                {c1[0], c1[1], c1[2]},
+                {c2[0] + d, c2[1] + d, c2[2] + d},
+                {c2[0], c2[1], c2[2]},
+                {c2[0] - d, c2[1] - d, c2[2] - d},
+            };
+            setPaintPixels(paint);
+            return;
+        }
+
+        if (g + dg < 0 || g + dg > 31) {
+            // h mode
+            int r1 = (block[0] >> 3) & 0xf;
+            int g1 = ((block[0] & 7) << 1) | ((block[1] >> 4) & 1);
+            int b1 = (((block[1] >> 3) & 1) << 3) | ((block[1] & 3) << 1) | (block[2] >> 7);
+            int r2 = (block[2] >> 3) & 0xf;
+            int g2 = ((block[2] & 7) << 1) | (block[3] >> 7);
+            int b2 = (block[3] >> 3) & 0xf;
+            auto ordering = ((r1 << 8) | (g1 << 4) | b1) >= ((r2 << 8) | (g2 << 4) | b2) ? 1 : 0;
+            auto d = kETCDistances[(((block[3] >> 2) & 1) << 2) | ((block[3] & 1) << 1) | ordering];
+            int c1[3] = {Extend4(r1), Extend4(g1), Extend4(b1)};
+            int c2[3] = {Extend4(r2), Extend4(g2), Extend4(b2)};
+            int paint[4][3] = {
+                {c1[0] + d, c1[1] + d, c1[2] + d},
+                {c1[0] - d, c1[1] - d, c1[2] - d},
+                {c2[0] + d, c2[1] + d, c2[2] + d},
+                {c2[0] - d, c2[1] - d, c2[2] - d},
+            };
+            setPaintPixels(paint);
+            return;
+        }
+
+        if (b + db < 0 || b + db > 31) {
+            // planar mode, which is always opaque
+            int ro = Extend6((block[0] >> 1) & 0x3f);
+            int go = Extend7(((block[0] & 1) << 6) | ((block[1] >> 1) & 0x3f));
+            int bo = Extend6(((block[1] & 1) << 5) | (((block[2] >> 3) & 3) << 3) | ((block[2] & 3) << 1) | (block[3] >> 7));
+            int rh = Extend6((((block[3] >> 2) & 0x1f) << 1) | (block[3] & 1));
+            int gh = Extend7(block[4] >> 1);
+            int bh = Extend6(((block[4] & 1) << 5) | (block[5] >> 3));
+            int rv = Extend6(((block[5] & 7) << 3) | (block[6] >> 5));
+            int gv = Extend7(((block[6] & 0x1f) << 2) | (block[7] >> 6));
+            int bv = Extend6(block[7] & 0x3f);
+            for (int y = 0; y < 4; ++y) {
+                for (int x = 0; x < 4; ++x) {
+                    SetPixel(pixels, x, y,
+                        (x * (rh - ro) + y * (rv - ro) + 4 * ro + 2) >> 2,
+                        (x * (gh - go) + y * (gv - go) + 4 * go + 2) >> 2,
+                        (x * (bh - bo) + y * (bv - bo) + 4 * bo + 2) >> 2);
+                }
+            }
+            return;
+        }
+
+        base[0][0] = Extend5(r);
+        base[0][1] = Extend5(g);
+        base[0][2] = Extend5(b);
+        base[1][0] = Extend5(r + dr);
+        base[1][1] = Extend5(g + dg);
+        base[1][2] = Extend5(b + db);
+    } else {
+        base[0][0] = Extend4(block[0] >> 4);
+        base[0][1] = Extend4(block[1] >> 4);
+        base[0][2] = Extend4(block[2] >> 4);
+        base[1][0] = Extend4(block[0] & 0xf);
+        base[1][1] = Extend4(block[1] & 0xf);
+        base[1][2] = Extend4(block[2] & 0xf);
+    }
+
+    int tables[2] = {(block[3] >> 5) & 7, (block[3] >> 2) & 7};
+    auto isFlipped = (block[3] & 1) != 0;
+
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            auto subblock = isFlipped ? (y >= 2) : (x >= 2);
+            auto i = index(x, y);
+            if (!isOpaque && i == 2) {
+                SetPixel(pixels, x, y, 0, 0, 0, 0);
+                continue;
+            }
+            auto modifier = (!isOpaque && i == 0) ? 0 : kETCModifiers[tables[subblock]][i & 1] * ((i & 2) ? -1 : 1);
+            auto& color = base[subblock];
+            SetPixel(pixels, x, y, color[0] + modifier, color[1] + modifier, color[2] + modifier);
+        }
+    }
+}
+
+/**
+* Decodes an EAC block into the alpha channel of 16 row-major RGBA pixels.
+*/
+void DecodeEACAlphaBlock(const uint8_t* block, uint8_t* pixels) {
+    int base = block[0];
+    int multiplier = block[1] >> 4;
+    auto& modifiers = kEACModifiers[block[1] & 0xf];
+
+    uint64_t indices = 0;
+    for (int i = 2; i < 8; ++i) {
+        indices = (indices << 8) | block[i];
+    }
+
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            auto i = x * 4 + y;
+            pixels[(y * 4 + x) * 4 + 3] = Clamp(base + modifiers[(indices >> (45 - 3 * i)) & 7] * multiplier);
+        }
+    }
+}
+
+/**
+* Decodes a BC1 (DXT1) color block into 16 row-major RGBA pixels. BC2 and BC3 color blocks are always in four color
+* mode.
+*/
+void DecodeBC1Block(const uint8_t* block, bool hasAlpha, bool isFourColor, uint8_t* pixels) {
+    int endpoints[2] = {block[0] | (block[1] << 8), block[2] | (block[3] << 8)};
+
+    int colors[4][4];
+    for (int i = 0; i < 2; ++i) {
+        colors[i][0] = Extend5(endpoints[i] >> 11);
+        colors[i][1] = Extend6((endpoints[i] >> 5) & 0x3f);
+        colors[i][2] = Extend5(endpoints[i] & 0x1f);
+        colors[i][3] = 255;
+    }
+
+    if (isFourColor || endpoints[0] > endpoints[1]) {
+        for (int c = 0; c < 3; ++c) {
+            colors[2][c] = (2 * colors[0][c] + colors[1][c]) / 3;
+            colors[3][c] = (colors[0][c] + 2 * colors[1][c]) / 3;
+        }
+        colors[2][3] = colors[3][3] = 255;
+    } else {
+        for (int c = 0; c < 3; ++c) {
+            colors[2][c] = (colors[0][c] + colors[1][c]) / 2;
+            colors[3][c] = 0;
+        }
+        colors[2][3] = 255;
+        colors[3][3] = hasAlpha ? 0 : 255;
+    }
+
+    uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (uint32_t(block[7]) << 24);
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            auto& color = colors[(indices >> (2 * (y * 4 + x))) & 3];
+            SetPixel(pixels, x, y, color[0], color[1], color[2], color[3]);
+        }
+    }
+}
+
+/**
+* Decodes a BC2 (DXT3) explicit alpha block into the alpha channel of 16 row-major RGBA pixels.
+*/
+void DecodeBC2AlphaBlock(const uint8_t* block, uint8_t* pixels) {
+    for (int i = 0; i < 16; ++i) {
+        pixels[i * 4 + 3] = Extend4((block[i / 2] >> (4 * (i % 2))) & 0xf);
+    }
+}
+
+/**
+* Decodes a BC3 (DXT5) interpolated alpha block into the alpha channel of 16 row-major RGBA pixels.
+*/
+void DecodeBC3AlphaBlock(const uint8_t* block, uint8_t* pixels) {
+    int alphas[8] = {block[0], block[1]};
+    if (alphas[0] > alphas[1]) {
+        for (int i = 2; i < 8; ++i) {
+            alphas[i] = ((8 - i) * alphas[0] + (i - 1) * alphas[1]) / 7;
+        }
+    } else {
+        for (int i = 2; i < 6; ++i) {
+            alphas[i] = ((6 - i) * alphas[0] + (i - 1) * alphas[1]) / 5;
+        }
+        alphas[6] = 0;
+        alphas[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (int i = 7; i >= 2; --i) {
+        indices = (indices << 8) | block[i];
+    }
+
+    for (int i = 0; i < 16; ++i) {
+        pixels[i * 4 + 3] = static_cast<uint8_t>(alphas[(indices >> (3 * i)) & 7]);
+    }
+}
+
+void DecodeBlock(GLenum format, const uint8_t* block, uint8_t* pixels) {
+    switch (format) {
+        case kCompressedRGB8ETC1:
+        case kCompressedRGB8ETC2:
+        case kCompressedSRGB8ETC2:
+            DecodeETC2Block(block, false, pixels);
+            break;
+        case kCompressedRGB8PunchthroughAlpha1ETC2:
+        case kCompressedSRGB8PunchthroughAlpha1ETC2:
+            DecodeETC2Block(block, true, pixels);
+            break;
+        case kCompressedRGBA8ETC2EAC:
+        case kCompressedSRGB8Alpha8ETC2EAC:
+            DecodeETC2Block(block + 8, false, pixels);
+            DecodeEACAlphaBlock(block, pixels);
+            break;
+        case kCompressedRGBS3TCDXT1:
+        case kCompressedSRGBS3TCDXT1:
+            DecodeBC1Block(block, false, false, pixels);
+            break;
+        case kCompressedRGBAS3TCDXT1:
+        case kCompressedSRGBAlphaS3TCDXT1:
+            DecodeBC1Block(block, true, false, pixels);
+            break;
+        case kCompressedRGBAS3TCDXT3:
+        case kCompressedSRGBAlphaS3TCDXT3:
+            DecodeBC1Block(block + 8, false, true, pixels);
+            DecodeBC2AlphaBlock(block, pixels);
+            break;
+        case kCompressedRGBAS3TCDXT5:
+        case kCompressedSRGBAlphaS3TCDXT5:
+            DecodeBC1Block(block + 8, false, true, pixels);
+            DecodeBC3AlphaBlock(block, pixels);
+            break;
+    }
+}
+
+} // anonymous namespace
+
+stdts::optional<CompressedBlockSize> CompressedTextureBlockSize(GLenum format) {
+    switch (format) {
+        case kCompressedRGB8ETC1:
+        case kCompressedR11EAC:
+        case kCompressedSignedR11EAC:
+        case kCompressedRGB8ETC2:
+        case kCompressedSRGB8ETC2:
+        case kCompressedRGB8PunchthroughAlpha1ETC2:
+        case kCompressedSRGB8PunchthroughAlpha1ETC2:
+        case kCompressedRGBS3TCDXT1:
+        case kCompressedRGBAS3TCDXT1:
+        case kCompressedSRGBS3TCDXT1:
+        case kCompressedSRGBAlphaS3TCDXT1:
+            return CompressedBlockSize{4, 4, 8};
+        case kCompressedRG11EAC:
+        case kCompressedSignedRG11EAC:
+        case kCompressedRGBA8ETC2EAC:
+        case kCompressedSRGB8Alpha8ETC2EAC:
+        case kCompressedRGBAS3TCDXT3:
+        case kCompressedRGBAS3TCDXT5:
+        case kCompressedSRGBAlphaS3TCDXT3:
+        case kCompressedSRGBAlphaS3TCDXT5:
+        case kCompressedRGBABPTCUnorm:
+        case kCompressedSRGBAlphaBPTCUnorm:
+            return CompressedBlockSize{4, 4, 16};
+    }
+
+    static constexpr int kASTCBlockSizes[14][2] = {
+        {4, 4}, {5, 4}, {5, 5}, {6, 5}, {6, 6}, {8, 5}, {8, 6}, {8, 8}, {10, 5}, {10, 6}, {10, 8}, {10, 10}, {12, 10}, {12, 12},
+    };
+
+    for (auto first : {kCompressedRGBAASTC4x4, kCompressedSRGB8Alpha8ASTC4x4}) {
+        if (format >= first && format < first + 14) {
+            auto& size = kASTCBlockSizes[format - first];
+            return CompressedBlockSize{size[0], size[1], 16};
+        }
+    }
+
+    return stdts::nullopt;
+}
+
+size_t CompressedTextureSize(GLenum format, int width, int height) {
+    auto blockSize = CompressedTextureBlockSize(format);
+    if (!blockSize || width <= 0 || height <= 0) { return 0; }
+    return static_cast<size_t>((width + blockSize->width - 1) / blockSize->width) * ((height + blockSize->height - 1) / blockSize->height) * blockSize->bytes;
+}
+
+bool IsCompressedTextureFormatSupported(GLenum format) {
+    auto& supported = Supported();
+    std::lock_guard<std::mutex> lock{supported.mutex};
+    if (!supported.isKnown) {
+        QuerySupportedFormats(&supported.formats);
+        supported.isKnown = true;
+    }
+    return supported.formats.count(format) > 0;
+}
+
+stdts::optional<bool> KnownCompressedTextureFormatSupport(GLenum format) {
+    auto& supported = Supported();
+    std::lock_guard<std::mutex> lock{supported.mutex};
+    if (!supported.isKnown) {
+        return stdts::nullopt;
+    }
+    return supported.formats.count(format) > 0;
+}
+
+bool CanDecompressTexture(GLenum format) {
+    switch (format) {
+        case kCompressedRGB8ETC1:
+        case kCompressedRGB8ETC2:
+        case kCompressedSRGB8ETC2:
+        case kCompressedRGB8PunchthroughAlpha1ETC2:
+        case kCompressedSRGB8PunchthroughAlpha1ETC2:
+        case kCompressedRGBA8ETC2EAC:
+        case kCompressedSRGB8Alpha8ETC2EAC:
+        case kCompressedRGBS3TCDXT1:
+        case kCompressedRGBAS3TCDXT1:
+        case kCompressedRGBAS3TCDXT3:
+        case kCompressedRGBAS3TCDXT5:
+        case kCompressedSRGBS3TCDXT1:
+        case kCompressedSRGBAlphaS3TCDXT1:
+        case kCompressedSRGBAlphaS3TCDXT3:
+        case kCompressedSRGBAlphaS3TCDXT5:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool DecompressTexture(GLenum format, const void* data, size_t size, int width, int height, uint8_t* destination) {
+    if (!CanDecompressTexture(format) || width <= 0 || height <= 0 || size < CompressedTextureSize(format, width, height)) {
+        return false;
+    }
+
+    auto blockBytes = CompressedTextureBlockSize(format)->bytes;
+    auto blocksWide = (width + 3) / 4;
+    auto blocksHigh = (height + 3) / 4;
+
+    uint8_t pixels[16 * 4];
+    for (int by = 0; by < blocksHigh; ++by) {
+        for (int bx = 0; bx < blocksWide; ++bx) {
+            DecodeBlock(format, reinterpret_cast<const uint8_t*>(data) + (by * blocksWide + bx) * blockBytes, pixels);
+
+            // blocks on the right and bottom edges may extend past the image
+            auto columns = std::min(4, width - bx * 4);
+            for (int y = 0; y < 4 && by * 4 + y < height; ++y) {
+                std::copy(&pixels[y * 16], &pixels[y * 16 + columns * 4], &destination[((by * 4 + y) * width + bx * 4) * 4]);
+            }
+        }
+    }
+
+    return true;
+}
+
+} // namespace okui::opengl
@@ -0,0 +1,99 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/opengl/TextureUploadBuffer.h>
+
+#include <okui/opengl/ContextOwnership.h>
+
+#include <scraps/logging.h>
+
+#include <cstring>
+
+#if OPENGL_ES && !GL_ES_VERSION_3_0
+#define OKUI_TEXTURE_UPLOAD_BUFFER_ES2 1
+#endif
+
+namespace okui::opengl {
+
+TextureUploadBuffer::TextureUploadBuffer() {
+#if !OKUI_TEXTURE_UPLOAD_BUFFER_ES2
+    glGenBuffers(1, &_buffer);
+#endif
+}
+
+TextureUploadBuffer::~TextureUploadBuffer() {
+#if !OKUI_TEXTURE_UPLOAD_BUFFER_ES2
+    // deleting the buffer also unbinds it
+    ReleaseResources([buffer = _buffer] {
+        glDeleteBuffers(1, &buffer);
+    });
+#endif
+}
+
+bool TextureUploadBuffer::IsSupported() {
+#if OKUI_TEXTURE_UPLOAD_BUFFER_ES2
+    return false;
+#else
+    // desktop contexts have had pixel buffer objects since 2.1, and glMapBufferRange since 3.0
+    return scraps::opengl::MajorVersion() >= 3;
+#endif
+}
+
+bool TextureUploadBuffer::stage(const void* data, size_t size) {
+#if OKUI_TEXTURE_UPLOAD_BUFFER_ES2
+    return false;
+#else
+    _size = 0;
+    if (!size) { return false; }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    auto mapping = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!mapping) {
+        SCRAPS_LOG_WARNING("unable to map texture upload buffer");
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+
+    std::memcpy(mapping, data, size);
+
+    // if the contents were lost, which can happen if the display mode changes, unmapping fails
+    auto isValid = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    _isBound = false;
+    if (!isValid) { return false; }
+
+    _size = size;
+    return true;
+#endif
+}
+
+void TextureUploadBuffer::bind() {
+#if !OKUI_TEXTURE_UPLOAD_BUFFER_ES2
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+    _isBound = true;
+#endif
+}
+
+void TextureUploadBuffer::unbind() {
+#if !OKUI_TEXTURE_UPLOAD_BUFFER_ES2
+    if (_isBound) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        _isBound = false;
+    }
+#endif
+}
+
+} // namespace okui::opengl
@@ -18,7 +18,7 @@
 namespace okui::shaders {
 
 ColorShader::ColorShader() {
-    opengl::Shader vsh(scraps::opengl::CommonVertexShaderHeader() + R"(
+    auto vsh = scraps::opengl::CommonVertexShaderHeader() + R"(
         ATTRIBUTE_IN vec2 positionAttrib;
         ATTRIBUTE_IN vec4 colorAttrib;
         ATTRIBUTE_IN vec4 curveAttrib;
@@ -31,9 +31,9 @@ ColorShader::ColorShader() {
             curve = curveAttrib;
             gl_Position = vec4(positionAttrib, 0.0, 1.0);
         }
-    )", opengl::Shader::kVertexShader);
+    )";
 
-    opengl::Shader fsh(CommonOKUIFragmentShaderHeader() + R"(
+    auto fsh = CommonOKUIFragmentShaderHeader() + R"(
         VARYING_IN vec4 color;
         VARYING_IN vec4 curve;
 
@@ -67,7 +67,7 @@ ColorShader::ColorShader() {
 
             COLOR_OUT = multipliedOutput(vec4(c.rgb, color.a * alphaMultiplier));
         }
-    )", opengl::Shader::kFragmentShader);
+    )";
 
     enum : GLuint {
         kPositionAttrib,
@@ -75,11 +75,10 @@ ColorShader::ColorShader() {
         kCurveAttrib,
     };
 
-    _program.attachShaders(vsh, fsh);
     _program.bindAttribute(kPositionAttrib, "positionAttrib");
     _program.bindAttribute(kColorAttrib, "colorAttrib");
     _program.bindAttribute(kCurveAttrib, "curveAttrib");
-    _program.link();
+    _program.link(vsh, fsh);
     _program.use();
 
     _blendingFlagsUniform = _program.uniform("blendingFlags");
@@ -90,9 +89,9 @@ ColorShader::ColorShader() {
     }
 
     auto stride = reinterpret_cast<char*>(&_vertices[1]) - reinterpret_cast<char*>(&_vertices[0]);
-    _vertexArrayBuffer.setAttribute(kPositionAttrib, 2, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, x));
-    _vertexArrayBuffer.setAttribute(kColorAttrib, 4, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, r));
-    _vertexArrayBuffer.setAttribute(kCurveAttrib, 4, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, cu));
+    _setAttribute(kPositionAttrib, 2, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, x));
+    _setAttribute(kColorAttrib, 4, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, r));
+    _setAttribute(kCurveAttrib, 4, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, cu));
 
     SCRAPS_GL_ERROR_CHECK();
 }
@@ -133,6 +132,15 @@ void ColorShader::_processTriangle(const std::array<Point<double>, 3>& p, const
     }
 }
 
+void ColorShader::_processQuads(Vertex* vertices, const Quad* quads, size_t count) {
+    if (!_gradient) { return; }
+
+    for (size_t i = 0; i < count * 6; ++i) {
+        auto& v = vertices[i];
+        _calculateGradientColor(v.x, v.y, &v.r, &v.g, &v.b, &v.a);
+    }
+}
+
 void ColorShader::_calculateGradientColor(double x, double y, GLfloat* r, GLfloat* g, GLfloat* b, GLfloat* a) {
     auto bWeight = std::min(std::max(_calculateGradientPosition(x, y), 0.0), 1.0);
     auto aWeight = 1.0 - bWeight;
@@ -75,6 +75,16 @@ void DistanceFieldShader::flush() {
     TextureShader::flush();
 }
 
+DisplayList::Command DistanceFieldShader::_recordDraw(bool inputHasPremultipliedAlpha) {
+    return [this, regions = _regions, supersample = _supersample, draw = TextureShader::_recordDraw(inputHasPremultipliedAlpha)]() mutable {
+        _program.use();
+        _supersampleUniform = (GLboolean)supersample;
+        _regions.swap(regions);
+        draw();
+        _regions.swap(regions);
+    };
+}
+
 void DistanceFieldShader::_draw() {
     for (auto& region : _regions) {
         // if this region includes the fully opaque areas of the distance field, set the inner edge
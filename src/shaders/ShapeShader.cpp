@@ -0,0 +1,388 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/shaders/ShapeShader.h>
+
+#include <okui/blending.h>
+#include <okui/FrameProfiler.h>
+#include <okui/opengl/ContextOwnership.h>
+
+#include <scraps/logging.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if OPENGL_ES && !GL_ES_VERSION_3_0
+#define OKUI_SHAPE_SHADER_INSTANCING 0
+#else
+#define OKUI_SHAPE_SHADER_INSTANCING 1
+#endif
+
+namespace okui::shaders {
+
+namespace {
+
+// the corners of the two triangles that make up each rectangle
+constexpr GLfloat kCorners[] = {0, 0, 1, 0, 0, 1, 0, 1, 1, 0, 1, 1};
+constexpr size_t kVerticesPerShape = 6;
+
+} // anonymous namespace
+
+ShapeShader::ShapeShader() {
+    auto vsh = scraps::opengl::CommonVertexShaderHeader() + R"(
+        ATTRIBUTE_IN vec2 cornerAttrib;
+        ATTRIBUTE_IN vec4 originAttrib;
+        ATTRIBUTE_IN vec4 axesAttrib;
+        ATTRIBUTE_IN vec4 radiiAttrib;
+        ATTRIBUTE_IN vec4 fillAttrib;
+        ATTRIBUTE_IN vec4 borderColorAttrib;
+        ATTRIBUTE_IN vec2 borderAttrib;
+        ATTRIBUTE_IN vec4 clipAttrib;
+
+        VARYING_OUT vec4 box;
+        VARYING_OUT vec4 radii;
+        VARYING_OUT vec4 fill;
+        VARYING_OUT vec4 borderColor;
+        VARYING_OUT vec2 border;
+        VARYING_OUT vec4 clip;
+
+        void main() {
+            vec2 size = originAttrib.zw;
+            float aa = borderAttrib.y;
+            // extend the rectangle by the anti-aliasing width so that its edges aren't cut off
+            vec2 local = cornerAttrib * (size + 2.0 * aa) - aa;
+            box = vec4(local - 0.5 * size, 0.5 * size);
+            radii = radiiAttrib;
+            fill = fillAttrib;
+            borderColor = borderColorAttrib;
+            border = borderAttrib;
+            clip = clipAttrib;
+            gl_Position = vec4(originAttrib.xy + local.x * axesAttrib.xy + local.y * axesAttrib.zw, 0.0, 1.0);
+        }
+    )";
+
+    auto fsh = CommonOKUIFragmentShaderHeader() + R"(
+        VARYING_IN vec4 box;
+        VARYING_IN vec4 radii;
+        VARYING_IN vec4 fill;
+        VARYING_IN vec4 borderColor;
+        VARYING_IN vec2 border;
+        VARYING_IN vec4 clip;
+
+        // the signed distance from p to the edge of a box centered on the origin with the given half size. the radii
+        // are for the +x+y, +x-y, -x+y, and -x-y corners
+        float roundedBoxDistance(vec2 p, vec2 b, vec4 r) {
+            r.xy = p.x > 0.0 ? r.xy : r.zw;
+            r.x = p.y > 0.0 ? r.x : r.y;
+            vec2 q = abs(p) - b + r.x;
+            return min(max(q.x, q.y), 0.0) + length(max(q, 0.0)) - r.x;
+        }
+
+        void main() {
+            if (gl_FragCoord.x < clip.x || gl_FragCoord.y < clip.y || gl_FragCoord.x > clip.z || gl_FragCoord.y > clip.w) {
+                discard;
+            }
+
+            float aa = border.y;
+            float d = roundedBoxDistance(box.xy, box.zw, radii);
+            float coverage = clamp(0.5 - d / aa, 0.0, 1.0);
+            if (coverage <= 0.0) {
+                discard;
+            }
+
+            // blend the border and fill premultiplied so that transparent fills don't darken the border
+            vec4 c = vec4(fill.rgb * fill.a, fill.a);
+            if (border.x > 0.0) {
+                float inner = clamp(0.5 - (d + border.x) / aa, 0.0, 1.0);
+                c = mix(vec4(borderColor.rgb * borderColor.a, borderColor.a), c, inner);
+            }
+            c *= coverage;
+
+            COLOR_OUT = multipliedOutput(vec4(c.a > 0.0 ? c.rgb / c.a : vec3(0.0), c.a));
+        }
+    )";
+
+    _program.bindAttribute(kCornerAttrib, "cornerAttrib");
+    _program.bindAttribute(kOriginAttrib, "originAttrib");
+    _program.bindAttribute(kAxesAttrib, "axesAttrib");
+    _program.bindAttribute(kRadiiAttrib, "radiiAttrib");
+    _program.bindAttribute(kFillAttrib, "fillAttrib");
+    _program.bindAttribute(kBorderColorAttrib, "borderColorAttrib");
+    _program.bindAttribute(kBorderAttrib, "borderAttrib");
+    _program.bindAttribute(kClipAttrib, "clipAttrib");
+    _program.link(vsh, fsh);
+    _program.use();
+
+    _blendingFlagsUniform = _program.uniform("blendingFlags");
+
+    if (!_program.error().empty()) {
+        SCRAPS_LOGF_ERROR("error creating shader: %s", _program.error().c_str());
+        return;
+    }
+
+    auto stride = static_cast<GLsizei>(sizeof(Vertex));
+    auto instance = offsetof(Vertex, instance);
+    _vertexArrayBuffer.setAttribute(kCornerAttrib, 2, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, cornerX));
+    _vertexArrayBuffer.setAttribute(kOriginAttrib, 4, GL_FLOAT, GL_FALSE, stride, instance + offsetof(Instance, originX));
+    _vertexArrayBuffer.setAttribute(kAxesAttrib, 4, GL_FLOAT, GL_FALSE, stride, instance + offsetof(Instance, xAxisX));
+    _vertexArrayBuffer.setAttribute(kRadiiAttrib, 4, GL_FLOAT, GL_FALSE, stride, instance + offsetof(Instance, radii));
+    _vertexArrayBuffer.setAttribute(kFillAttrib, 4, GL_FLOAT, GL_FALSE, stride, instance + offsetof(Instance, fill));
+    _vertexArrayBuffer.setAttribute(kBorderColorAttrib, 4, GL_FLOAT, GL_FALSE, stride, instance + offsetof(Instance, borderColor));
+    _vertexArrayBuffer.setAttribute(kBorderAttrib, 2, GL_FLOAT, GL_FALSE, stride, instance + offsetof(Instance, borderWidth));
+    _vertexArrayBuffer.setAttribute(kClipAttrib, 4, GL_FLOAT, GL_FALSE, stride, instance + offsetof(Instance, clip));
+
+    if (SupportsInstancing()) {
+        _setUpInstancing();
+    }
+
+    SCRAPS_GL_ERROR_CHECK();
+}
+
+ShapeShader::~ShapeShader() {
+    if (auto batch = BatchRenderer::Current()) {
+        batch->forget(this);
+    }
+
+#if OKUI_SHAPE_SHADER_INSTANCING
+    if (_isInstanced) {
+        opengl::ReleaseResources([vertexArray = _vertexArray, buffers = std::array<GLuint, 2>{{_cornerBuffer, _instanceBuffer}}] {
+            glDeleteVertexArrays(1, &vertexArray);
+            glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+        });
+    }
+#endif
+}
+
+void ShapeShader::draw(const Shape& shape) {
+    auto& bounds = shape.bounds;
+    auto centerX = bounds.x + bounds.width / 2;
+    auto centerY = bounds.y + bounds.height / 2;
+    AffineTransformation rotation{centerX, centerY, -centerX, -centerY, 1.0, 1.0, shape.rotation};
+
+    auto transform = [&](double x, double y, double* xOut, double* yOut) {
+        rotation.transform(x, y, &x, &y);
+        _transformation.transform(x, y, xOut, yOut);
+    };
+
+    double originX, originY, xAxisX, xAxisY, yAxisX, yAxisY;
+    transform(bounds.x, bounds.y, &originX, &originY);
+    transform(bounds.x + 1.0, bounds.y, &xAxisX, &xAxisY);
+    transform(bounds.x, bounds.y + 1.0, &yAxisX, &yAxisY);
+
+    Instance instance;
+    instance.originX = originX;
+    instance.originY = originY;
+    instance.width = bounds.width;
+    instance.height = bounds.height;
+    instance.xAxisX = xAxisX - originX;
+    instance.xAxisY = xAxisY - originY;
+    instance.yAxisX = yAxisX - originX;
+    instance.yAxisY = yAxisY - originY;
+
+    auto maxRadius = std::max(std::min(bounds.width, bounds.height) / 2, 0.0);
+    auto radius = [&](double r) { return static_cast<GLfloat>(std::min(std::max(r, 0.0), maxRadius)); };
+    instance.radii[0] = radius(shape.radii.maxMax);
+    instance.radii[1] = radius(shape.radii.maxMin);
+    instance.radii[2] = radius(shape.radii.minMax);
+    instance.radii[3] = radius(shape.radii.minMin);
+
+    instance.fill[0] = shape.fill.redF();
+    instance.fill[1] = shape.fill.greenF();
+    instance.fill[2] = shape.fill.blueF();
+    instance.fill[3] = shape.fill.alphaF();
+    instance.borderColor[0] = shape.borderColor.redF();
+    instance.borderColor[1] = shape.borderColor.greenF();
+    instance.borderColor[2] = shape.borderColor.blueF();
+    instance.borderColor[3] = shape.borderColor.alphaF();
+    instance.borderWidth = std::max(shape.borderWidth, 0.0);
+
+    // these depend on the target, so they're filled in when the shape is drawn
+    instance.antialiasing = 1.0f;
+    std::fill(std::begin(instance.clip), std::end(instance.clip), 0.0f);
+
+    _instances.emplace_back(instance);
+}
+
+void ShapeShader::drawTriangle(double x1, double y1, double x2, double y2, double x3, double y3, Curve curve) {
+    SCRAPS_LOG_ERROR("the shape shader can't draw triangles");
+}
+
+void ShapeShader::drawQuads(const Quad* quads, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        draw(Shape{{quads[i].x, quads[i].y, quads[i].width, quads[i].height}, Color::kWhite});
+    }
+}
+
+void ShapeShader::flush() {
+    if (_instances.empty()) { return; }
+
+    FrameProfiler::DidFlushShader();
+
+    if (auto displayList = DisplayList::Current()) {
+        displayList->append([this, instances = _instances, blendFunction = Blending::Current()] {
+            Blending blending{blendFunction};
+            _drawInstances(instances);
+        });
+    }
+
+    if (!DisplayList::IsDeferring()) {
+        _drawInstances(_instances);
+    }
+
+    _instances.clear();
+}
+
+bool ShapeShader::SupportsInstancing() {
+#if OKUI_SHAPE_SHADER_INSTANCING
+    auto major = scraps::opengl::MajorVersion();
+    return major > 3 || (major == 3 && (scraps::opengl::kIsOpenGLES || scraps::opengl::MinorVersion() >= 3));
+#else
+    return false;
+#endif
+}
+
+void ShapeShader::drawHeld() {
+    _draw();
+}
+
+void ShapeShader::_drawInstances(const std::vector<Instance>& instances) {
+    auto batch = BatchRenderer::Current();
+    if (batch && batch->hold(this)) {
+        // consecutive shapes are drawn together, even if they're from different views
+        _appendInstances(instances, batch->viewport(), batch->targetWidth(), batch->targetHeight(), batch->scissor());
+        return;
+    }
+
+    if (batch) {
+        batch->flush();
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    _appendInstances(instances, {0, 0, viewport[2], viewport[3]}, viewport[2], viewport[3], stdts::nullopt);
+    _draw();
+}
+
+void ShapeShader::_appendInstances(const std::vector<Instance>& instances, const Rectangle<int>& viewport, int targetWidth, int targetHeight, const stdts::optional<Rectangle<int>>& scissor) {
+    auto scaleX = static_cast<GLfloat>(viewport.width) / targetWidth;
+    auto scaleY = static_cast<GLfloat>(viewport.height) / targetHeight;
+
+    for (auto instance : instances) {
+        // convert from the viewport's normalized device coordinates to the target's
+        instance.originX = ((instance.originX + 1.0f) * 0.5f * viewport.width + viewport.x) * 2.0f / targetWidth - 1.0f;
+        instance.originY = ((instance.originY + 1.0f) * 0.5f * viewport.height + viewport.y) * 2.0f / targetHeight - 1.0f;
+        instance.xAxisX *= scaleX;
+        instance.xAxisY *= scaleY;
+        instance.yAxisX *= scaleX;
+        instance.yAxisY *= scaleY;
+
+        // anti-alias over about a pixel
+        auto pixelsPerUnitX = std::hypot(instance.xAxisX * targetWidth * 0.5f, instance.xAxisY * targetHeight * 0.5f);
+        auto pixelsPerUnitY = std::hypot(instance.yAxisX * targetWidth * 0.5f, instance.yAxisY * targetHeight * 0.5f);
+        auto pixelsPerUnit = (pixelsPerUnitX + pixelsPerUnitY) * 0.5f;
+        instance.antialiasing = pixelsPerUnit > 0.0f ? 1.0f / pixelsPerUnit : 1.0f;
+
+        if (scissor) {
+            instance.clip[0] = scissor->minX();
+            instance.clip[1] = scissor->minY();
+            instance.clip[2] = scissor->maxX();
+            instance.clip[3] = scissor->maxY();
+        } else {
+            instance.clip[0] = instance.clip[1] = -1.0e9f;
+            instance.clip[2] = instance.clip[3] = 1.0e9f;
+        }
+
+        _pending.emplace_back(instance);
+    }
+}
+
+void ShapeShader::_draw() {
+    if (_pending.empty()) { return; }
+
+    _program.use();
+    _blendingFlagsUniform = (GLint)(Blending::Current().premultipliedSourceAlpha ? kBlendingFlagPremultipliedOutput : 0);
+
+#if OKUI_SHAPE_SHADER_INSTANCING
+    if (_isInstanced) {
+        glBindVertexArray(_vertexArray);
+        glBindBuffer(GL_ARRAY_BUFFER, _instanceBuffer);
+        auto size = _pending.size() * sizeof(Instance);
+        if (size > _instanceBufferCapacity) {
+            _instanceBufferCapacity = std::max(size, _instanceBufferCapacity * 2);
+        }
+        // orphan the previous contents rather than waiting for the gpu to finish with them
+        glBufferData(GL_ARRAY_BUFFER, _instanceBufferCapacity, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size, _pending.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, kVerticesPerShape, static_cast<GLsizei>(_pending.size()));
+        glBindVertexArray(0);
+    } else
+#endif
+    {
+        _vertices.clear();
+        for (auto& instance : _pending) {
+            for (size_t i = 0; i < kVerticesPerShape; ++i) {
+                _vertices.push_back({kCorners[i * 2], kCorners[i * 2 + 1], instance});
+            }
+        }
+        _vertexArrayBuffer.bind();
+        _vertexArrayBuffer.stream(_vertices.data(), _vertices.size());
+        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(_vertices.size()));
+        _vertexArrayBuffer.unbind();
+    }
+
+    if (auto batch = BatchRenderer::Current()) {
+        batch->didDraw(_pending.size() * kVerticesPerShape);
+    }
+
+    _pending.clear();
+}
+
+void ShapeShader::_setUpInstancing() {
+#if OKUI_SHAPE_SHADER_INSTANCING
+    glGenVertexArrays(1, &_vertexArray);
+    glBindVertexArray(_vertexArray);
+
+    glGenBuffers(1, &_cornerBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, _cornerBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(kCorners), kCorners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(kCornerAttrib);
+    glVertexAttribPointer(kCornerAttrib, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    glGenBuffers(1, &_instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceBuffer);
+
+    auto setAttribute = [](GLuint index, GLint size, size_t offset) {
+        glEnableVertexAttribArray(index);
+        glVertexAttribPointer(index, size, GL_FLOAT, GL_FALSE, sizeof(Instance), reinterpret_cast<const void*>(offset));
+        glVertexAttribDivisor(index, 1);
+    };
+    setAttribute(kOriginAttrib, 4, offsetof(Instance, originX));
+    setAttribute(kAxesAttrib, 4, offsetof(Instance, xAxisX));
+    setAttribute(kRadiiAttrib, 4, offsetof(Instance, radii));
+    setAttribute(kFillAttrib, 4, offsetof(Instance, fill));
+    setAttribute(kBorderColorAttrib, 4, offsetof(Instance, borderColor));
+    setAttribute(kBorderAttrib, 2, offsetof(Instance, borderWidth));
+    setAttribute(kClipAttrib, 4, offsetof(Instance, clip));
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    _isInstanced = true;
+#endif
+}
+
+} // namespace okui::shaders
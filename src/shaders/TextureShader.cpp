@@ -20,8 +20,8 @@
 
 namespace okui::shaders {
 
-TextureShader::TextureShader(const char* fragmentShader) {
-    opengl::Shader vsh(scraps::opengl::CommonVertexShaderHeader() + R"(
+TextureShader::TextureShader(const char* fragmentShader) : _isBatchable{fragmentShader == nullptr} {
+    auto vsh = scraps::opengl::CommonVertexShaderHeader() + R"(
         ATTRIBUTE_IN vec2 positionAttrib;
         ATTRIBUTE_IN vec4 colorAttrib;
         ATTRIBUTE_IN vec4 curveAttrib;
@@ -37,9 +37,9 @@ TextureShader::TextureShader(const char* fragmentShader) {
             textureCoord = textureCoordAttrib;
             gl_Position = vec4(positionAttrib, 0.0, 1.0);
         }
-    )", opengl::Shader::kVertexShader);
+    )";
 
-    opengl::Shader fsh(fragmentShader ? std::string(fragmentShader) : CommonOKUIFragmentShaderHeader() + R"(
+    auto fsh = fragmentShader ? std::string(fragmentShader) : CommonOKUIFragmentShaderHeader() + R"(
         VARYING_IN vec4 color;
         VARYING_IN vec4 curve;
         VARYING_IN vec2 textureCoord;
@@ -76,7 +76,7 @@ TextureShader::TextureShader(const char* fragmentShader) {
             vec4 sample = unmultipliedInput(SAMPLE(textureSampler, textureCoord));
             COLOR_OUT = multipliedOutput(vec4(sample.rgb * color.rgb, sample.a * color.a * alphaMultiplier));
         }
-    )", opengl::Shader::kFragmentShader);
+    )";
 
     enum : GLuint {
         kPositionAttrib,
@@ -85,13 +85,12 @@ TextureShader::TextureShader(const char* fragmentShader) {
         kTextureCoordAttrib,
     };
 
-    _program.attachShaders(vsh, fsh);
     _program.bindAttribute(kPositionAttrib, "positionAttrib");
     _program.bindAttribute(kColorAttrib, "colorAttrib");
     _program.bindAttribute(kCurveAttrib, "curveAttrib");
     _program.bindAttribute(kTextureCoordAttrib, "textureCoordAttrib");
 
-    _program.link();
+    _program.link(vsh, fsh);
     _program.use();
 
     _program.uniform("texture") = 0;
@@ -103,10 +102,10 @@ TextureShader::TextureShader(const char* fragmentShader) {
     }
 
     auto stride = reinterpret_cast<char*>(&_vertices[1]) - reinterpret_cast<char*>(&_vertices[0]);
-    _vertexArrayBuffer.setAttribute(kPositionAttrib, 2, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, x));
-    _vertexArrayBuffer.setAttribute(kColorAttrib, 4, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, r));
-    _vertexArrayBuffer.setAttribute(kCurveAttrib, 4, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, cu));
-    _vertexArrayBuffer.setAttribute(kTextureCoordAttrib, 2, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, s));
+    _setAttribute(kPositionAttrib, 2, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, x));
+    _setAttribute(kColorAttrib, 4, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, r));
+    _setAttribute(kCurveAttrib, 4, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, cu));
+    _setAttribute(kTextureCoordAttrib, 2, GL_FLOAT, GL_FALSE, stride, offsetof(Vertex, s));
 
     SCRAPS_GL_ERROR_CHECK();
 }
@@ -118,13 +117,23 @@ void TextureShader::setColor(const Color& color) {
     _triangle.a.a = _triangle.b.a = _triangle.c.a = color.alphaF();
 }
 
-void TextureShader::setTexture(const TextureInterface& texture, double x, double y, double w, double h, const AffineTransformation& texCoordTransform) {
+void TextureShader::setTexture(const TextureInterface& texture) {
     if (_texture != texture.id()) {
         flush();
     }
 
     _texture = texture.id();
     _textureHasPremultipliedAlpha = texture.hasPremultipliedAlpha();
+    // textures packed into atlases only occupy part of the gpu texture
+    _textureRegion = texture.region();
+
+    auto scaleX = static_cast<double>(texture.width()) / texture.allocatedWidth();
+    auto scaleY = static_cast<double>(texture.height()) / texture.allocatedHeight();
+    _quadTexCoordTransform = AffineTransformation{_textureRegion.x, _textureRegion.y, 0.0, 0.0, scaleX * _textureRegion.width, scaleY * _textureRegion.height};
+}
+
+void TextureShader::setTexture(const TextureInterface& texture, double x, double y, double w, double h, const AffineTransformation& texCoordTransform) {
+    setTexture(texture);
 
     _transformation.transform(x, y, &_textureX1, &_textureY1);
 
@@ -153,21 +162,56 @@ void TextureShader::_processTriangle(const std::array<Point<double>, 3>& p, cons
 
     double s, t;
     _texCoordTransform.transform((pT[0].x - _textureX1) / _textureWidth, (pT[0].y - _textureY1) / _textureHeight, &s, &t);
-    _triangle.a.s  = s;
-    _triangle.a.t  = t;
+    _triangle.a.s  = _textureRegion.x + s * _textureRegion.width;
+    _triangle.a.t  = _textureRegion.y + t * _textureRegion.height;
     _texCoordTransform.transform((pT[1].x - _textureX1) / _textureWidth, (pT[1].y - _textureY1) / _textureHeight, &s, &t);
-    _triangle.b.s  = s;
-    _triangle.b.t  = t;
+    _triangle.b.s  = _textureRegion.x + s * _textureRegion.width;
+    _triangle.b.t  = _textureRegion.y + t * _textureRegion.height;
     _texCoordTransform.transform((pT[2].x - _textureX1) / _textureWidth, (pT[2].y - _textureY1) / _textureHeight, &s, &t);
-    _triangle.c.s  = s;
-    _triangle.c.t  = t;
+    _triangle.c.s  = _textureRegion.x + s * _textureRegion.width;
+    _triangle.c.t  = _textureRegion.y + t * _textureRegion.height;
+}
+
+void TextureShader::_processQuads(Vertex* vertices, const Quad* quads, size_t count) {
+    constexpr size_t kCorners[] = {0, 1, 2, 2, 1, 3};
+
+    float s[4], t[4], sT[4], tT[4];
+    for (size_t i = 0; i < count; ++i, vertices += 6) {
+        auto& q = quads[i];
+        s[0] = s[2] = q.s;
+        s[1] = s[3] = q.s + q.textureWidth;
+        t[0] = t[1] = q.t;
+        t[2] = t[3] = q.t + q.textureHeight;
+        _quadTexCoordTransform.transform4(s, t, sT, tT);
+        for (size_t j = 0; j < 6; ++j) {
+            vertices[j].s = sT[kCorners[j]];
+            vertices[j].t = tT[kCorners[j]];
+        }
+    }
+}
+
+DisplayList::Command TextureShader::_recordDraw(bool inputHasPremultipliedAlpha) {
+    return [this, texture = _texture, draw = ShaderBase<Vertex>::_recordDraw(inputHasPremultipliedAlpha)]() mutable {
+        std::swap(_texture, texture);
+        draw();
+        std::swap(_texture, texture);
+    };
+}
+
+bool TextureShader::_addToBatch(BatchRenderer* batch, bool inputHasPremultipliedAlpha) {
+    // shaders with custom fragment shaders can't be merged into the batch renderer's shader
+    return _isBatchable && batch->add(_vertices, _texture, inputHasPremultipliedAlpha);
 }
 
 void TextureShader::flush() {
-    _program.use();
+    ShaderBase<Vertex>::_flush(_textureHasPremultipliedAlpha);
+}
+
+void TextureShader::_draw() {
+    // the texture is bound here rather than in flush so that it isn't disturbed by the batch renderer
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, _texture);
-    ShaderBase<Vertex>::_flush(_textureHasPremultipliedAlpha);
+    ShaderBase<Vertex>::_draw();
 }
 
 } // namespace okui::shaders
@@ -0,0 +1,301 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/views/CollectionView.h>
+
+#include <okui/Window.h>
+
+#include <scraps/logging.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace okui::views {
+
+void CollectionView::setDataSource(DataSource* dataSource) {
+    _dataSource = dataSource;
+    reloadData();
+}
+
+void CollectionView::registerCell(std::string reuseIdentifier, CellFactory factory) {
+    _factories[std::move(reuseIdentifier)] = std::move(factory);
+}
+
+View* CollectionView::dequeueCell(const std::string& reuseIdentifier) {
+    Cell cell;
+    cell.reuseIdentifier = reuseIdentifier;
+
+    auto& reusable = _reusableCells[reuseIdentifier];
+    if (!reusable.empty()) {
+        cell.view = std::move(reusable.back());
+        reusable.pop_back();
+    } else {
+        auto it = _factories.find(reuseIdentifier);
+        if (it == _factories.end()) {
+            SCRAPS_LOG_ERROR("no cell is registered for reuse identifier {}", reuseIdentifier);
+            return nullptr;
+        }
+        cell.view = it->second();
+    }
+
+    auto view = cell.view.get();
+    _dequeuedCells.emplace_back(std::move(cell));
+    return view;
+}
+
+void CollectionView::setItemLayout(Layout layout) {
+    _layout = layout;
+    _updateCells();
+}
+
+void CollectionView::setItemSize(double width, double height) {
+    _itemSize = {width, height};
+    _updateCells();
+}
+
+void CollectionView::setSpacing(double spacing) {
+    _spacing = spacing;
+    _updateCells();
+}
+
+void CollectionView::setOverscan(double overscan) {
+    _overscan = overscan;
+    _updateCells();
+}
+
+void CollectionView::reloadData() {
+    while (!_cells.empty()) {
+        _recycle(std::move(_cells.begin()->second));
+        _cells.erase(_cells.begin());
+    }
+    _numberOfItems = _dataSource ? _dataSource->numberOfItems(this) : 0;
+    _updateCells();
+}
+
+Rectangle<double> CollectionView::itemFrame(size_t index) const {
+    switch (_layout) {
+        case Layout::kVertical:
+            return {0.0, index * (_itemSize.y + _spacing), bounds().width, _itemSize.y};
+        case Layout::kHorizontal:
+            return {index * (_itemSize.x + _spacing), 0.0, _itemSize.x, bounds().height};
+        case Layout::kGrid: {
+            auto columns = _columns();
+            return {(index % columns) * (_itemSize.x + _spacing), (index / columns) * (_itemSize.y + _spacing), _itemSize.x, _itemSize.y};
+        }
+    }
+    return {};
+}
+
+View* CollectionView::cell(size_t index) const {
+    auto it = _cells.find(index);
+    return it == _cells.end() ? nullptr : it->second.view.get();
+}
+
+stdts::optional<size_t> CollectionView::item(const View* view) const {
+    while (view && view->superview() != contentView()) {
+        view = view->superview();
+    }
+    if (!view) { return stdts::nullopt; }
+
+    for (auto& kv : _cells) {
+        if (kv.second.view.get() == view) {
+            return kv.first;
+        }
+    }
+    return stdts::nullopt;
+}
+
+void CollectionView::scrollToItem(size_t index) {
+    if (index >= _numberOfItems) { return; }
+
+    // the content offset is the position of the content view, so the visible area starts at its negation
+    auto frame = itemFrame(index);
+    auto x = -contentOffset().x;
+    auto y = -contentOffset().y;
+
+    if (frame.x < x) {
+        x = frame.x;
+    } else if (frame.maxX() > x + bounds().width) {
+        x = frame.maxX() - bounds().width;
+    }
+
+    if (frame.y < y) {
+        y = frame.y;
+    } else if (frame.maxY() > y + bounds().height) {
+        y = frame.maxY() - bounds().height;
+    }
+
+    setContentOffset(-x, -y);
+    scrolled();
+}
+
+void CollectionView::scrolled() {
+    _updateCells();
+}
+
+void CollectionView::layout() {
+    _updateCells();
+}
+
+void CollectionView::focusWillMove(Direction direction) {
+    auto focus = window() ? window()->focus() : nullptr;
+    auto index = focus ? item(focus) : stdts::nullopt;
+    if (!index) { return; }
+
+    // make sure the cell that focus is most likely to move to exists
+    if (auto neighbor = _neighbor(*index, direction)) {
+        scrollToItem(*neighbor);
+    }
+}
+
+size_t CollectionView::_columns() const {
+    if (_layout != Layout::kGrid || _itemSize.x + _spacing <= 0.0) {
+        return 1;
+    }
+    return std::max<size_t>(std::floor((bounds().width + _spacing) / (_itemSize.x + _spacing)), 1);
+}
+
+Point<double> CollectionView::_contentSize() const {
+    auto extent = [&](size_t count, double size) {
+        return count ? count * (size + _spacing) - _spacing : 0.0;
+    };
+
+    switch (_layout) {
+        case Layout::kVertical:
+            return {bounds().width, extent(_numberOfItems, _itemSize.y)};
+        case Layout::kHorizontal:
+            return {extent(_numberOfItems, _itemSize.x), bounds().height};
+        case Layout::kGrid: {
+            auto columns = _columns();
+            return {extent(std::min(columns, _numberOfItems), _itemSize.x), extent((_numberOfItems + columns - 1) / columns, _itemSize.y)};
+        }
+    }
+    return {};
+}
+
+stdts::optional<size_t> CollectionView::_neighbor(size_t index, Direction direction) const {
+    auto columns = _columns();
+    stdts::optional<size_t> neighbor;
+
+    switch (_layout) {
+        case Layout::kVertical:
+            if (direction == Direction::kUp && index > 0) {
+                neighbor = index - 1;
+            } else if (direction == Direction::kDown) {
+                neighbor = index + 1;
+            }
+            break;
+        case Layout::kHorizontal:
+            if (direction == Direction::kLeft && index > 0) {
+                neighbor = index - 1;
+            } else if (direction == Direction::kRight) {
+                neighbor = index + 1;
+            }
+            break;
+        case Layout::kGrid:
+            if (direction == Direction::kLeft && index % columns > 0) {
+                neighbor = index - 1;
+            } else if (direction == Direction::kRight && index % columns + 1 < columns) {
+                neighbor = index + 1;
+            } else if (direction == Direction::kUp && index >= columns) {
+                neighbor = index - columns;
+            } else if (direction == Direction::kDown) {
+                neighbor = std::min(index + columns, _numberOfItems - 1);
+            }
+            break;
+    }
+
+    if (neighbor && *neighbor < _numberOfItems && *neighbor != index) {
+        return neighbor;
+    }
+    return stdts::nullopt;
+}
+
+void CollectionView::_updateCells() {
+    auto contentSize = _contentSize();
+    setContentSize(contentSize.x, contentSize.y);
+
+    // keep the content offset within the content in case it shrank
+    auto x = std::max(std::min(-contentOffset().x, contentSize.x - bounds().width), 0.0);
+    auto y = std::max(std::min(-contentOffset().y, contentSize.y - bounds().height), 0.0);
+    if (x != -contentOffset().x || y != -contentOffset().y) {
+        setContentOffset(-x, -y);
+    }
+
+    // find the range of items that intersect the visible area, extended by the overscan
+    size_t first = 0, last = 0;
+    if (_dataSource && _numberOfItems && bounds().width > 0 && bounds().height > 0) {
+        auto isHorizontal = _layout == Layout::kHorizontal;
+        auto minimum = (isHorizontal ? -contentOffset().x : -contentOffset().y) - _overscan;
+        auto maximum = minimum + (isHorizontal ? bounds().width : bounds().height) + 2 * _overscan;
+        auto stride = std::max((isHorizontal ? _itemSize.x : _itemSize.y) + _spacing, 1.0);
+        auto itemsPerStride = _columns();
+        if (maximum > 0.0) {
+            first = std::min<size_t>(std::floor(std::max(minimum, 0.0) / stride) * itemsPerStride, _numberOfItems);
+            last = std::min<size_t>(std::ceil(maximum / stride) * itemsPerStride, _numberOfItems);
+        }
+    }
+
+    // recycle the cells that are no longer needed. the cell containing focus is kept around so that focus isn't lost
+    auto focus = window() ? window()->focus() : nullptr;
+    auto focusedItem = focus ? item(focus) : stdts::nullopt;
+    for (auto it = _cells.begin(); it != _cells.end();) {
+        auto isNeeded = (it->first >= first && it->first < last) || (it->first < _numberOfItems && focusedItem == it->first);
+        if (isNeeded) {
+            ++it;
+            continue;
+        }
+        _recycle(std::move(it->second));
+        it = _cells.erase(it);
+    }
+
+    for (auto i = first; i < last; ++i) {
+        if (_cells.count(i)) { continue; }
+
+        auto view = _dataSource->cellForItem(this, i);
+        auto it = std::find_if(_dequeuedCells.begin(), _dequeuedCells.end(), [&](auto& cell) { return cell.view.get() == view; });
+        if (it == _dequeuedCells.end()) {
+            if (view) {
+                SCRAPS_LOG_ERROR("collection view cells must be obtained via dequeueCell");
+            }
+            continue;
+        }
+
+        auto cell = std::move(*it);
+        _dequeuedCells.erase(it);
+        auto frame = itemFrame(i);
+        cell.view->setBounds(frame.x, frame.y, frame.width, frame.height);
+        contentView()->addSubview(cell.view.get());
+        _cells.emplace(i, std::move(cell));
+    }
+
+    // anything dequeued but not returned by the data source can be reused later
+    for (auto& cell : _dequeuedCells) {
+        _reusableCells[cell.reuseIdentifier].emplace_back(std::move(cell.view));
+    }
+    _dequeuedCells.clear();
+
+    for (auto& kv : _cells) {
+        auto frame = itemFrame(kv.first);
+        kv.second.view->setBounds(frame.x, frame.y, frame.width, frame.height);
+    }
+}
+
+void CollectionView::_recycle(Cell cell) {
+    contentView()->removeSubview(cell.view.get());
+    _reusableCells[cell.reuseIdentifier].emplace_back(std::move(cell.view));
+}
+
+} // namespace okui::views
@@ -15,12 +15,15 @@
 */
 #include <okui/views/ImageView.h>
 
+#include <okui/Window.h>
+
 namespace okui::views {
 
 void ImageView::setTexture(std::string texture) {
     if (texture == _resource) { return; }
 
     _texture = nullptr;
+    _staleTexture = nullptr;
     _fromURL = texture.find("://") != std::string::npos;
     _resource = std::move(texture);
 
@@ -51,8 +54,22 @@ void ImageView::setTextureDistanceField(stdts::optional<double> edge) {
     invalidateRenderCache();
 }
 
+void ImageView::setDownscalesTexture(bool downscalesTexture) {
+    if (_downscalesTexture == downscalesTexture) { return; }
+    _downscalesTexture = downscalesTexture;
+
+    if (isVisibleInOpenWindow()) {
+        load();
+    }
+}
+
 void ImageView::render() {
+    if (_texture.isLoaded()) {
+        _staleTexture = nullptr;
+    }
+
     TextureHandle* texture = (_texture && _texture.isLoaded())                       ? &_texture :
+                             (_staleTexture && _staleTexture.isLoaded())             ? &_staleTexture :
                              (_placeholderTexture && _placeholderTexture.isLoaded()) ? &_placeholderTexture :
                              nullptr;
 
@@ -76,6 +93,12 @@ void ImageView::render() {
     }
 }
 
+void ImageView::layout() {
+    if (isVisibleInOpenWindow()) {
+        load();
+    }
+}
+
 void ImageView::windowChanged() {
     unload();
 
@@ -88,19 +111,46 @@ void ImageView::willAppear() {
     load();
 }
 
+void ImageView::disappeared() {
+    // let go of textures that haven't loaded yet so that they aren't decoded for nothing
+    if (_texture && !_texture.isLoaded()) {
+        _texture = nullptr;
+    }
+    if (_placeholderTexture && !_placeholderTexture.isLoaded()) {
+        _placeholderTexture = nullptr;
+    }
+}
+
 void ImageView::load() {
+    auto targetSize = Window::TextureTargetSizeBucket(_textureTargetSize());
+    if (_texture && targetSize != _targetSize) {
+        // the size changed enough to need a different texture, so it's reloaded. the current one is kept on screen
+        // until then
+        if (_texture.isLoaded()) {
+            _staleTexture = std::move(_texture);
+        }
+        _texture = nullptr;
+    }
+    _targetSize = targetSize;
+
     if (!_placeholderResource.empty() && !_placeholderTexture) {
-        _placeholderTexture = loadTextureResource(_placeholderResource);
+        _placeholderTexture = loadTextureResource(_placeholderResource, targetSize);
     }
 
     if (!_resource.empty() && !_texture) {
-        _texture = _fromURL ? loadTextureFromURL(_resource) : loadTextureResource(_resource);
+        _texture = _fromURL ? loadTextureFromURL(_resource, targetSize) : loadTextureResource(_resource, targetSize);
     }
 }
 
 void ImageView::unload() {
     _texture = nullptr;
+    _staleTexture = nullptr;
     _placeholderTexture = nullptr;
 }
 
+Point<int> ImageView::_textureTargetSize() const {
+    if (!_downscalesTexture || _distanceFieldEdge) { return {}; }
+    return pixelSize();
+}
+
 } // namespace okui::views
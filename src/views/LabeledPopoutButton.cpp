@@ -16,7 +16,6 @@
 #include <okui/views/LabeledPopoutButton.h>
 
 #include <okui/Application.h>
-#include <okui/shapes/Rectangle.h>
 
 using namespace std::literals;
 
@@ -47,17 +46,17 @@ void LabeledPopoutButton::setLabelStyle(TextView::Style focused, TextView::Style
     _focusedLabelStyle = std::move(focused);
     _unfocusedLabelStyle = std::move(unfocused);
     _label.setStyle(isFocus() ? _focusedLabelStyle : _unfocusedLabelStyle);
-    layout();
+    setNeedsLayout();
 }
 
 void LabeledPopoutButton::focusGained() {
     _label.setStyle(_focusedLabelStyle);
-    addUpdateHook("popout animation tracking", [this]{ layout(); });
+    addUpdateHook("popout animation tracking", [this]{ setNeedsLayout(); });
 }
 
 void LabeledPopoutButton::focusLost() {
     _label.setStyle(_unfocusedLabelStyle);
-    addUpdateHook("popout animation tracking", [this]{ layout(); });
+    addUpdateHook("popout animation tracking", [this]{ setNeedsLayout(); });
 }
 
 void LabeledPopoutButton::layout() {
@@ -98,10 +97,11 @@ void LabeledPopoutButton::Body::setIcon(std::string sdf) {
 }
 
 void LabeledPopoutButton::Body::render() {
-    auto colorShader = this->colorShader();
-    colorShader->setColor(_backgroundColor);
-    shapes::Rectangle(0, 0, bounds().width, bounds().height).round(3).draw(colorShader);
-    colorShader->flush();
+    auto shapeShader = this->shapeShader();
+    shaders::ShapeShader::Shape shape{{0, 0, bounds().width, bounds().height}, _backgroundColor};
+    shape.radii = 3;
+    shapeShader->draw(shape);
+    shapeShader->flush();
 }
 
 void LabeledPopoutButton::Body::layout() {
@@ -27,7 +27,7 @@ void MarkupView::load(stdts::string_view markup) {
     if (_element && _element->view()) {
         addSubview(_element->view());
         setPreferredFocus(_element->view());
-        layout();
+        setNeedsLayout();
     }
 }
 
@@ -317,13 +317,13 @@ void TextField::_updateCursorLayout() {
 }
 
 void TextField::SelectionHighlight::render() {
-    auto colorShader = this->colorShader();
-
-    colorShader->setColor(color);
+    auto shapeShader = this->shapeShader();
 
-    okui::shapes::Rectangle(0, 0, bounds().width, bounds().height).round(3).draw(colorShader);
+    shaders::ShapeShader::Shape shape{{0, 0, bounds().width, bounds().height}, color};
+    shape.radii = 3;
+    shapeShader->draw(shape);
 
-    colorShader->flush();
+    shapeShader->flush();
 }
 
 void TextField::Cursor::render() {
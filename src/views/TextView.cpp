@@ -307,14 +307,16 @@ void TextView::_updateLines() {
 }
 
 void TextView::_renderBitmapText(shaders::DistanceFieldShader* shader) {
-    // TODO: this could be much more optimized (e.g. via display list or vbo)
-
     auto& texture = _font->texture();
     if (!texture->isLoaded()) { return; }
 
     auto fontScale = _fontScale();
     auto lineSpacing = _font->lineSpacing() * fontScale;
     auto y = _calcYOffset();
+    auto textureWidth = static_cast<double>(texture->width());
+    auto textureHeight = static_cast<double>(texture->height());
+
+    _glyphQuads.clear();
 
     for (auto& line : _lines) {
         double x = _calcXOffset(line);
@@ -326,21 +328,28 @@ void TextView::_renderBitmapText(shaders::DistanceFieldShader* shader) {
             auto glyph = _font->glyph(line[i]);
             if (glyph) {
                 Rectangle<double> glyphBounds(x + glyph->xOffset * fontScale, y + glyph->yOffset * fontScale, glyph->width * fontScale, glyph->height * fontScale);
-                auto textureScale = glyphBounds.width / glyph->textureWidth;
-                shader->setTexture(
-                    *texture,
-                    glyphBounds.x - glyph->textureX * textureScale,
-                    glyphBounds.y - glyph->textureY * textureScale,
-                    texture->width() * textureScale,
-                    texture->height() * textureScale
-                );
-                shapes::Rectangle(glyphBounds.x, glyphBounds.y, glyphBounds.width, glyphBounds.height).draw(shader);
+                if (glyphBounds.width > 0.0 && glyph->textureWidth > 0.0) {
+                    auto textureScale = glyphBounds.width / glyph->textureWidth;
+                    Shader::Quad quad;
+                    quad.x = glyphBounds.x;
+                    quad.y = glyphBounds.y;
+                    quad.width = glyphBounds.width;
+                    quad.height = glyphBounds.height;
+                    quad.s = glyph->textureX / textureWidth;
+                    quad.t = glyph->textureY / textureHeight;
+                    quad.textureWidth = glyph->textureWidth / textureWidth;
+                    quad.textureHeight = glyphBounds.height / textureScale / textureHeight;
+                    _glyphQuads.emplace_back(quad);
+                }
                 x += glyph->xAdvance * fontScale;
             }
         }
 
         y += lineSpacing;
     }
+
+    shader->setTexture(*texture);
+    shader->drawQuads(_glyphQuads);
 }
 
 double TextView::_calcXOffset(const std::basic_string<BitmapFont::GlyphId>& line) const {
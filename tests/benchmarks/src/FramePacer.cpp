@@ -0,0 +1,85 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <benchmark/benchmark.h>
+
+#include <okui/FramePacer.h>
+
+#include <random>
+
+using namespace std::literals;
+
+namespace {
+
+struct FakeClock {
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<FakeClock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept { return t; }
+
+    static time_point t;
+};
+
+FakeClock::time_point FakeClock::t{};
+
+/**
+* Simulates frames whose work takes a random amount of time around the given mean on a 60hz display.
+*/
+void SimulateFrames(benchmark::State& state, bool adaptive) {
+    auto meanWork = std::chrono::microseconds(state.range(0));
+    std::mt19937 generator{0};
+    std::normal_distribution<double> distribution(static_cast<double>(meanWork.count()), meanWork.count() * 0.25);
+
+    okui::FramePacer<FakeClock> pacer;
+    pacer.setAdaptive(adaptive);
+
+    int64_t frames = 0, halfRateFrames = 0;
+    double jitter = 0.0;
+    auto lastPresentation = FakeClock::now();
+
+    while (state.KeepRunning()) {
+        FakeClock::t = std::max(FakeClock::t, pacer.nextFrameTime());
+        pacer.beginFrame();
+        FakeClock::t += std::chrono::microseconds(static_cast<int64_t>(std::max(distribution(generator), 0.0)));
+        pacer.endFrame();
+
+        auto presentation = std::max(pacer.predictedPresentationTime(), FakeClock::now());
+        jitter += std::abs(std::chrono::duration<double, std::milli>(presentation - lastPresentation - pacer.frameInterval()).count());
+        lastPresentation = presentation;
+
+        ++frames;
+        halfRateFrames += pacer.isHalfRate() ? 1 : 0;
+    }
+
+    state.counters["half_rate_frames"] = static_cast<double>(halfRateFrames) / std::max<int64_t>(frames, 1);
+    state.counters["jitter_ms"] = jitter / std::max<int64_t>(frames, 1);
+}
+
+} // anonymous namespace
+
+static void FramePacerFixedRate(benchmark::State& state) {
+    SimulateFrames(state, false);
+}
+
+BENCHMARK(FramePacerFixedRate)->Arg(5000)->Arg(15000)->Arg(20000);
+
+static void FramePacerAdaptiveRate(benchmark::State& state) {
+    SimulateFrames(state, true);
+}
+
+BENCHMARK(FramePacerAdaptiveRate)->Arg(5000)->Arg(15000)->Arg(20000);
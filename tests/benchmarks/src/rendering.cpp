@@ -0,0 +1,241 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <benchmark/benchmark.h>
+
+#include <okui/applications/Headless.h>
+
+#if ONAIR_OKUI_HAS_HEADLESS_APPLICATION
+
+#include <okui/FileResourceManager.h>
+#include <okui/View.h>
+#include <okui/Window.h>
+#include <okui/views/ImageView.h>
+#include <okui/views/ScrollView.h>
+#include <okui/views/TextView.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+struct BenchmarkApplication : okui::applications::Headless {
+    BenchmarkApplication() {
+        setResourceManager(&resourceManager);
+    }
+
+    virtual std::string name() const override { return "okui benchmarks"; }
+    virtual std::string organization() const override { return "BitTorrent Inc."; }
+
+    okui::FileResourceManager resourceManager{OKUI_BENCHMARK_RESOURCES_PATH};
+};
+
+struct Scene {
+    template <typename T>
+    T* add(okui::View* superview) {
+        views.emplace_back(std::make_unique<T>());
+        auto view = static_cast<T*>(views.back().get());
+        superview->addSubview(view);
+        return view;
+    }
+
+    std::vector<std::unique_ptr<okui::View>> views;
+    std::function<void(size_t frame)> step;
+};
+
+okui::Color GridColor(size_t i) {
+    return okui::RGB((i * 37) % 256, (i * 91) % 256, (i * 53) % 256);
+}
+
+/**
+* Renders a 1280x720 offscreen window every iteration. Besides the wall and cpu times, which include waiting for the
+* gpu to finish, this reports the cpu time spent updating, laying out, and recording each frame along with its draw
+* calls and vertices.
+*/
+void RenderScene(benchmark::State& state, std::function<void(okui::View* root, Scene* scene)> build) {
+    BenchmarkApplication application;
+    if (!application.isValid()) {
+        state.SkipWithError("unable to create an offscreen opengl context");
+        return;
+    }
+
+    okui::Window window(&application);
+    window.setSize(1280, 720);
+    window.open();
+    window.profiler()->setEnabled();
+
+    Scene scene;
+    build(window.contentView(), &scene);
+
+    // let textures and fonts load before measuring
+    for (int i = 0; i < 2 || (window.hasPendingTextures() && i < 5000); ++i) {
+        application.renderFrame(&window);
+        if (window.hasPendingTextures()) {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+
+    size_t frames = 0;
+    double drawCalls = 0.0, vertices = 0.0, frameTime = 0.0;
+    while (state.KeepRunning()) {
+        if (scene.step) {
+            scene.step(frames);
+        }
+        application.advance(window.framePacer().frameInterval());
+        application.renderFrame(&window);
+
+        drawCalls += window.drawStatistics().drawCalls;
+        vertices += window.drawStatistics().vertices;
+        if (auto stats = window.lastFrameStats()) {
+            auto cpuTime = stats->phase(okui::FrameProfiler::Phase::kUpdate) + stats->phase(okui::FrameProfiler::Phase::kLayout) + stats->phase(okui::FrameProfiler::Phase::kRender);
+            frameTime += std::chrono::duration<double, std::milli>(cpuTime).count();
+        }
+        ++frames;
+    }
+
+    frames = std::max<size_t>(frames, 1);
+    state.counters["cpu_frame_ms"] = frameTime / frames;
+    state.counters["draw_calls"] = drawCalls / frames;
+    state.counters["vertices"] = vertices / frames;
+}
+
+/**
+* Lays out count views in a grid that fills the area.
+*/
+template <typename Add>
+void Grid(okui::View* root, size_t count, Add&& add) {
+    auto width = root->bounds().width, height = root->bounds().height;
+    auto columns = static_cast<size_t>(std::ceil(std::sqrt(count * width / height)));
+    auto rows = (count + columns - 1) / columns;
+    auto cellWidth = width / columns, cellHeight = height / rows;
+    for (size_t i = 0; i < count; ++i) {
+        auto view = add(i);
+        view->setBounds((i % columns) * cellWidth, (i / columns) * cellHeight, cellWidth - 1, cellHeight - 1);
+    }
+}
+
+} // anonymous namespace
+
+static void RenderViewGrid(benchmark::State& state) {
+    RenderScene(state, [&](okui::View* root, Scene* scene) {
+        Grid(root, state.range(0), [&](size_t i) {
+            auto view = scene->add<okui::View>(root);
+            view->setBackgroundColor(GridColor(i));
+            return view;
+        });
+    });
+}
+
+BENCHMARK(RenderViewGrid)->Arg(100)->Arg(1000)->Arg(5000)->Unit(benchmark::kMillisecond);
+
+static void RenderTextScreen(benchmark::State& state) {
+    RenderScene(state, [&](okui::View* root, Scene* scene) {
+        Grid(root, state.range(0), [&](size_t i) {
+            auto view = scene->add<okui::views::TextView>(root);
+            view->setFont("Montserrat-regular.png", "Montserrat-regular.fnt");
+            view->setTextSize(14);
+            view->setTextColor(okui::Color::kWhite);
+            view->setText("The quick brown fox jumps over the lazy dog. Sphinx of black quartz, judge my vow. " + std::to_string(i));
+            return view;
+        });
+    });
+}
+
+BENCHMARK(RenderTextScreen)->Arg(20)->Arg(200)->Unit(benchmark::kMillisecond);
+
+static void RenderImageGrid(benchmark::State& state) {
+    RenderScene(state, [&](okui::View* root, Scene* scene) {
+        Grid(root, state.range(0), [&](size_t i) {
+            auto view = scene->add<okui::views::ImageView>(root);
+            view->setTexture("PlayIcon.png");
+            return view;
+        });
+    });
+}
+
+BENCHMARK(RenderImageGrid)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+static void RenderScrollView(benchmark::State& state) {
+    RenderScene(state, [&](okui::View* root, Scene* scene) {
+        auto scrollView = scene->add<okui::views::ScrollView>(root);
+        scrollView->setBounds(0, 0, root->bounds().width, root->bounds().height);
+
+        constexpr auto kRowHeight = 40.0;
+        auto rows = static_cast<size_t>(state.range(0));
+        scrollView->setContentSize(root->bounds().width, rows * kRowHeight);
+        for (size_t i = 0; i < rows; ++i) {
+            auto row = scene->add<okui::View>(scrollView->contentView());
+            row->setBackgroundColor(GridColor(i));
+            row->setBounds(0, i * kRowHeight, root->bounds().width, kRowHeight - 1);
+        }
+
+        auto maxOffset = rows * kRowHeight - root->bounds().height;
+        scene->step = [=](size_t frame) {
+            scrollView->setContentOffset(0, -std::fmod(frame * 7.0, maxOffset));
+        };
+    });
+}
+
+BENCHMARK(RenderScrollView)->Arg(100)->Arg(2000)->Unit(benchmark::kMillisecond);
+
+static void RenderToTexture(benchmark::State& state) {
+    RenderScene(state, [&](okui::View* root, Scene* scene) {
+        Grid(root, state.range(0), [&](size_t i) {
+            auto view = scene->add<okui::View>(root);
+            view->setBackgroundColor(GridColor(i));
+            view->setTintColor(okui::RGBF(1.0, 0.8, 0.8));
+            view->setOpacity(0.75);
+
+            auto child = scene->add<okui::View>(view);
+            child->setBackgroundColor(GridColor(i + 1));
+            child->setBounds(2, 2, 10, 10);
+            return view;
+        });
+
+        // keep the render caches from being reused between frames
+        scene->step = [root](size_t frame) {
+            for (auto& view : root->subviews()) {
+                view->invalidateRenderCache();
+            }
+        };
+    });
+}
+
+BENCHMARK(RenderToTexture)->Arg(10)->Arg(100)->Unit(benchmark::kMillisecond);
+
+static void RenderDeepNesting(benchmark::State& state) {
+    RenderScene(state, [&](okui::View* root, Scene* scene) {
+        auto superview = root;
+        auto bounds = root->bounds();
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            auto view = scene->add<okui::View>(superview);
+            view->setBackgroundColor(GridColor(i));
+            // shrink slowly so that every level stays visible
+            bounds = {0.25, 0.25, std::max(bounds.width - 0.5, 1.0), std::max(bounds.height - 0.5, 1.0)};
+            view->setBounds(bounds.x, bounds.y, bounds.width, bounds.height);
+            superview = view;
+        }
+    });
+}
+
+BENCHMARK(RenderDeepNesting)->Arg(10)->Arg(100)->Arg(500)->Unit(benchmark::kMillisecond);
+
+#endif // ONAIR_OKUI_HAS_HEADLESS_APPLICATION
@@ -0,0 +1,100 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <benchmark/benchmark.h>
+
+#include <okui/applications/Headless.h>
+
+#if ONAIR_OKUI_HAS_HEADLESS_APPLICATION
+
+#include <okui/shaders/TextureShader.h>
+#include <okui/shapes/Rectangle.h>
+
+#include <vector>
+
+namespace {
+
+struct BenchmarkApplication : okui::applications::Headless {
+    virtual std::string name() const override { return "okui benchmarks"; }
+    virtual std::string organization() const override { return "BitTorrent Inc."; }
+};
+
+/**
+* Generates vertices without ever drawing them.
+*/
+struct VertexGenerationShader : okui::shaders::TextureShader {
+    void discardVertices() { _vertices.clear(); }
+};
+
+std::vector<okui::Shader::Quad> GlyphQuads(size_t count) {
+    std::vector<okui::Shader::Quad> quads(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto& quad = quads[i];
+        quad.x = static_cast<GLfloat>((i % 100) * 12);
+        quad.y = static_cast<GLfloat>((i / 100) * 20);
+        quad.width = 10.0f;
+        quad.height = 18.0f;
+        quad.s = static_cast<GLfloat>(i % 16) / 16.0f;
+        quad.t = static_cast<GLfloat>(i / 16 % 16) / 16.0f;
+        quad.textureWidth = quad.textureHeight = 1.0f / 16.0f;
+    }
+    return quads;
+}
+
+/**
+* Measures how quickly a texture shader generates vertices for glyph-sized quads, either one rectangle at a time
+* via drawTriangle or all at once via drawQuads.
+*/
+void GenerateQuadVertices(benchmark::State& state, bool bulk) {
+    BenchmarkApplication application;
+    if (!application.isValid()) {
+        state.SkipWithError("unable to create an offscreen opengl context");
+        return;
+    }
+
+    VertexGenerationShader shader;
+    shader.setTransformation(okui::AffineTransformation{-1, 1, 0, 0, 2.0 / 1280, -2.0 / 720});
+
+    auto quads = GlyphQuads(state.range(0));
+
+    while (state.KeepRunning()) {
+        if (bulk) {
+            shader.drawQuads(quads);
+        } else {
+            for (auto& quad : quads) {
+                okui::shapes::Rectangle(quad.x, quad.y, quad.width, quad.height).draw(&shader);
+            }
+        }
+        shader.discardVertices();
+    }
+
+    state.SetItemsProcessed(state.iterations() * quads.size() * 6);
+}
+
+} // anonymous namespace
+
+static void GenerateQuadVerticesViaTriangles(benchmark::State& state) {
+    GenerateQuadVertices(state, false);
+}
+
+BENCHMARK(GenerateQuadVerticesViaTriangles)->Arg(100)->Arg(10000);
+
+static void GenerateQuadVerticesInBulk(benchmark::State& state) {
+    GenerateQuadVertices(state, true);
+}
+
+BENCHMARK(GenerateQuadVerticesInBulk)->Arg(100)->Arg(10000);
+
+#endif // ONAIR_OKUI_HAS_HEADLESS_APPLICATION
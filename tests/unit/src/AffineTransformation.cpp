@@ -63,3 +63,25 @@ TEST(AffineTransformation, combination) {
     EXPECT_FLOAT_EQ(x, -5.0);
     EXPECT_FLOAT_EQ(y, 11.0);
 }
+
+TEST(AffineTransformation, equality) {
+    EXPECT_EQ(AffineTransformation(1.0, 2.0, 3.0, 4.0, 5.0, 6.0), AffineTransformation(1.0, 2.0, 3.0, 4.0, 5.0, 6.0));
+    EXPECT_NE(AffineTransformation(1.0, 2.0), AffineTransformation(1.0, 3.0));
+    EXPECT_NE(AffineTransformation::Scale(2.0, 2.0), AffineTransformation::Scale(2.0, 1.0));
+}
+
+TEST(AffineTransformation, transform4) {
+    AffineTransformation transformation(-1.0, 3.0, 3.0, 1.0, 2.0, 4.0, M_PI / 3);
+
+    float x[4] = {1.0f, -2.0f, 0.5f, 100.0f};
+    float y[4] = {0.0f, 7.0f, -3.0f, 50.0f};
+    float xOut[4], yOut[4];
+    transformation.transform4(x, y, xOut, yOut);
+
+    for (int i = 0; i < 4; ++i) {
+        double expectedX, expectedY;
+        transformation.transform<double>(x[i], y[i], &expectedX, &expectedY);
+        EXPECT_NEAR(xOut[i], expectedX, 1e-3);
+        EXPECT_NEAR(yOut[i], expectedY, 1e-3);
+    }
+}
@@ -0,0 +1,87 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "RenderOnce.h"
+#include "TestFramebuffer.h"
+
+#include <okui/BatchRenderer.h>
+#include <okui/shaders/ColorShader.h>
+#include <okui/shapes/Rectangle.h>
+
+#include <gtest/gtest.h>
+
+using namespace okui;
+
+TEST(BatchRenderer, disabled) {
+    BatchRenderer batch;
+    EXPECT_FALSE(batch.isEnabled());
+
+    batch.begin(320, 200);
+    EXPECT_EQ(BatchRenderer::Current(), &batch);
+
+    std::vector<shaders::ColorVertex> vertices(3);
+    EXPECT_FALSE(batch.add(vertices));
+    batch.didDraw(3);
+    batch.didDraw(6);
+
+    batch.end();
+    EXPECT_EQ(BatchRenderer::Current(), nullptr);
+
+    EXPECT_EQ(batch.statistics().drawCalls, 2);
+    EXPECT_EQ(batch.statistics().batches, 0);
+    EXPECT_EQ(batch.statistics().batchedDraws, 0);
+    EXPECT_EQ(batch.statistics().vertices, 9);
+}
+
+#if ONAIR_OKUI_HAS_NATIVE_APPLICATION && !OPENGL_ES // TODO: fix for OpenGL ES
+
+TEST(BatchRenderer, clipping) {
+    RenderOnce([&] (View* view) {
+        TestFramebuffer framebuffer(320, 200);
+
+        BatchRenderer batch;
+        batch.setEnabled();
+        batch.begin(320, 200);
+
+        auto shader = view->colorShader();
+        shader->setColor(Color::kWhite);
+        shader->setTransformation(framebuffer.transformation());
+
+        // the scissor is given in OpenGL's coordinates, so it covers the top 100 rows
+        batch.setScissor(Rectangle<int>{0, 100, 320, 100});
+        auto a = Rectangle<double>(2, 13, 11, 123);
+        shapes::Rectangle(a).draw(shader);
+        shader->flush();
+
+        batch.setScissor(stdts::nullopt);
+        auto b = Rectangle<double>(50, 150, 20, 20);
+        shapes::Rectangle(b).draw(shader);
+        shader->flush();
+
+        batch.end();
+
+        EXPECT_EQ(batch.statistics().batches, 1);
+        EXPECT_EQ(batch.statistics().batchedDraws, 2);
+        EXPECT_EQ(batch.statistics().drawCalls, 1);
+
+        framebuffer.finish();
+
+        framebuffer.iteratePixels([&](int x, int y, Color pixel) {
+            EXPECT_EQ(pixel, (a.contains(x, y) && y < 100) || b.contains(x, y) ? Color::kWhite : Color::kBlack);
+        });
+    });
+}
+
+#endif // ONAIR_OKUI_HAS_NATIVE_APPLICATION
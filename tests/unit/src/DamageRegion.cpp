@@ -0,0 +1,72 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/DamageRegion.h>
+
+#include <gtest/gtest.h>
+
+using namespace okui;
+
+TEST(DamageRegion, add) {
+    DamageRegion region;
+    EXPECT_TRUE(region.empty());
+
+    region.add({0, 0, 0, 10});
+    EXPECT_TRUE(region.empty());
+
+    region.add({0, 0, 10, 10});
+    region.add({2, 2, 4, 4});
+    ASSERT_EQ(region.rectangles().size(), 1);
+    EXPECT_EQ(region.rectangles()[0], Rectangle<double>(0, 0, 10, 10));
+
+    region.add({50, 50, 10, 10});
+    EXPECT_EQ(region.rectangles().size(), 2);
+    EXPECT_EQ(region.area(), 200);
+    EXPECT_EQ(region.bounds(), Rectangle<double>(0, 0, 60, 60));
+
+    region.clear();
+    EXPECT_TRUE(region.empty());
+}
+
+TEST(DamageRegion, merging) {
+    DamageRegion region;
+    region.add({0, 0, 10, 10});
+    region.add({20, 0, 10, 10});
+    region.add({5, 5, 20, 2});
+    ASSERT_EQ(region.rectangles().size(), 1);
+    EXPECT_EQ(region.rectangles()[0], Rectangle<double>(0, 0, 30, 10));
+}
+
+TEST(DamageRegion, reduction) {
+    DamageRegion region{2};
+    region.add({0, 0, 10, 10});
+    region.add({12, 0, 10, 10});
+    region.add({100, 100, 10, 10});
+    ASSERT_EQ(region.rectangles().size(), 2);
+    EXPECT_EQ(region.bounds(), Rectangle<double>(0, 0, 110, 110));
+
+    // the two nearby rectangles waste the least area when merged
+    auto& rectangles = region.rectangles();
+    EXPECT_TRUE(std::find(rectangles.begin(), rectangles.end(), Rectangle<double>(0, 0, 22, 10)) != rectangles.end());
+
+    region.setMaxRectangles(1);
+    ASSERT_EQ(region.rectangles().size(), 1);
+    EXPECT_EQ(region.rectangles()[0], Rectangle<double>(0, 0, 110, 110));
+}
+
+TEST(DamageRegion, pixelBounds) {
+    EXPECT_EQ(DamageRegion::PixelBounds({0.5, 0.5, 1.0, 1.0}, 1.0, 1.0), Rectangle<int>(0, 0, 2, 2));
+    EXPECT_EQ(DamageRegion::PixelBounds({1.0, 2.0, 3.0, 4.0}, 2.0, 0.5), Rectangle<int>(2, 1, 6, 2));
+}
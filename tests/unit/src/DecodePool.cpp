@@ -0,0 +1,130 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/DecodePool.h>
+
+#include <gtest/gtest.h>
+
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace okui;
+
+TEST(DecodePool, priorities) {
+    DecodePool pool{1};
+    EXPECT_EQ(pool.threadCount(), 1);
+
+    // keep the thread busy until everything else is queued
+    std::promise<void> blocker;
+    auto blocked = blocker.get_future().share();
+    pool.async(DecodePool::Priority::kBackground, [=] { blocked.wait(); });
+    while (pool.statistics().running == 0) {
+        std::this_thread::yield();
+    }
+
+    std::mutex mutex;
+    std::vector<int> order;
+    auto record = [&](int n) {
+        return [&, n] {
+            std::lock_guard<std::mutex> lock{mutex};
+            order.push_back(n);
+        };
+    };
+
+    pool.async(DecodePool::Priority::kBackground, record(5));
+    pool.async(DecodePool::Priority::kPrefetch, record(3));
+    pool.async(DecodePool::Priority::kVisible, record(1));
+    auto raised = pool.async(DecodePool::Priority::kBackground, record(2));
+    auto canceled = pool.async(DecodePool::Priority::kVisible, record(0));
+    pool.async(DecodePool::Priority::kPrefetch, record(4));
+
+    pool.setPriority(raised, DecodePool::Priority::kVisible);
+    EXPECT_EQ(raised->priority(), DecodePool::Priority::kVisible);
+    EXPECT_TRUE(pool.cancel(canceled));
+    EXPECT_FALSE(pool.cancel(canceled));
+
+    EXPECT_EQ(pool.statistics().queued, 5);
+    EXPECT_EQ(pool.statistics().canceled, 1);
+
+    blocker.set_value();
+    auto last = pool.async(DecodePool::Priority::kBackground, [] {});
+    while (pool.statistics().completed < 7) {
+        std::this_thread::yield();
+    }
+    EXPECT_FALSE(pool.cancel(last));
+
+    EXPECT_EQ(order, (std::vector<int>{1, 2, 3, 4, 5}));
+
+    auto statistics = pool.statistics();
+    EXPECT_EQ(statistics.queued, 0);
+    EXPECT_EQ(statistics.running, 0);
+    EXPECT_GE(statistics.maximumLatency, statistics.averageLatency);
+    EXPECT_GT(statistics.maximumLatency.count(), 0);
+}
+
+TEST(DecodePool, concurrency) {
+    DecodePool pool{4};
+
+    // every thread should be able to run a task at once
+    std::mutex mutex;
+    std::condition_variable condition;
+    int running = 0;
+    for (int i = 0; i < 4; ++i) {
+        pool.async(DecodePool::Priority::kVisible, [&] {
+            std::unique_lock<std::mutex> lock{mutex};
+            ++running;
+            condition.notify_all();
+            condition.wait(lock, [&] { return running == 4; });
+        });
+    }
+
+    std::unique_lock<std::mutex> lock{mutex};
+    EXPECT_TRUE(condition.wait_for(lock, std::chrono::seconds(10), [&] { return running == 4; }));
+}
+
+TEST(DecodePool, cancelAndJoin) {
+    DecodePool pool{1};
+
+    std::promise<void> blocker;
+    auto blocked = blocker.get_future().share();
+    pool.async(DecodePool::Priority::kVisible, [=] { blocked.wait(); });
+
+    bool didRun = false;
+    auto ticket = pool.async(DecodePool::Priority::kVisible, [&] { didRun = true; });
+
+    while (pool.statistics().running == 0) {
+        std::this_thread::yield();
+    }
+
+    // unblock the running task once cancelAndJoin has emptied the queue
+    std::thread unblocker([&] {
+        while (pool.statistics().queued > 0) {
+            std::this_thread::yield();
+        }
+        blocker.set_value();
+    });
+    pool.cancelAndJoin();
+    unblocker.join();
+
+    EXPECT_FALSE(didRun);
+    EXPECT_FALSE(pool.cancel(ticket));
+    EXPECT_EQ(pool.statistics().completed, 1);
+    EXPECT_EQ(pool.statistics().canceled, 1);
+
+    // tasks submitted afterwards are never run
+    EXPECT_FALSE(pool.cancel(pool.async(DecodePool::Priority::kVisible, [&] { didRun = true; })));
+}
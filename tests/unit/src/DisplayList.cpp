@@ -0,0 +1,92 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/DisplayList.h>
+
+#include <gtest/gtest.h>
+
+using namespace okui;
+
+TEST(DisplayList, replay) {
+    DisplayList list;
+    EXPECT_TRUE(list.empty());
+
+    std::vector<int> calls;
+    list.append([&] { calls.push_back(1); });
+    list.append([&] { calls.push_back(2); });
+    EXPECT_EQ(list.size(), 2);
+
+    list.replay();
+    list.replay();
+    EXPECT_EQ(calls, (std::vector<int>{1, 2, 1, 2}));
+
+    list.clear();
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(DisplayList, recording) {
+    EXPECT_EQ(DisplayList::Current(), nullptr);
+
+    DisplayList outer, inner;
+    {
+        DisplayList::Recording outerRecording{&outer};
+        EXPECT_EQ(DisplayList::Current(), &outer);
+        {
+            DisplayList::Recording innerRecording{&inner};
+            EXPECT_EQ(DisplayList::Current(), &inner);
+            {
+                DisplayList::Recording suspended{nullptr};
+                EXPECT_EQ(DisplayList::Current(), nullptr);
+            }
+            EXPECT_EQ(DisplayList::Current(), &inner);
+        }
+        EXPECT_EQ(DisplayList::Current(), &outer);
+    }
+
+    EXPECT_EQ(DisplayList::Current(), nullptr);
+}
+
+TEST(DisplayList, deferring) {
+    std::vector<int> calls;
+    DisplayList frame, retained;
+    retained.append([&] { calls.push_back(2); });
+
+    EXPECT_FALSE(DisplayList::IsDeferring());
+    DisplayList::Perform([&] { calls.push_back(0); });
+    EXPECT_EQ(calls, (std::vector<int>{0}));
+    calls.clear();
+
+    {
+        DisplayList::Recording recording{&frame, true};
+        EXPECT_TRUE(DisplayList::IsDeferring());
+
+        DisplayList::Perform([&] { calls.push_back(1); });
+        retained.replay();
+        {
+            DisplayList::Recording nested{&retained};
+            EXPECT_TRUE(DisplayList::IsDeferring());
+            DisplayList::Perform([&] { calls.push_back(3); });
+        }
+        DisplayList::Perform([&] { calls.push_back(4); });
+    }
+
+    EXPECT_FALSE(DisplayList::IsDeferring());
+    EXPECT_TRUE(calls.empty());
+    EXPECT_EQ(frame.size(), 3);
+    EXPECT_EQ(retained.size(), 2);
+
+    frame.replay();
+    EXPECT_EQ(calls, (std::vector<int>{1, 2, 4}));
+}
@@ -98,24 +98,104 @@ TEST(FileTexture, png16BitRGB) {
     TextureTest(imageData, sizeof(imageData), 32, 32, png16BitRGBPixels);
 }
 
+// basn6a08 from http://www.schaik.com/pngsuite/pngsuite_bas_png.html
+static const unsigned char png8BitRGBAData[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x20, 0x08, 0x06, 0x00, 0x00, 0x00, 0x73, 0x7A, 0x7A,
+    0xF4, 0x00, 0x00, 0x00, 0x04, 0x67, 0x41, 0x4D, 0x41, 0x00, 0x01, 0x86, 0xA0, 0x31, 0xE8, 0x96,
+    0x5F, 0x00, 0x00, 0x00, 0x6F, 0x49, 0x44, 0x41, 0x54, 0x78, 0x9C, 0xED, 0xD6, 0x31, 0x0A, 0x80,
+    0x30, 0x0C, 0x46, 0xE1, 0x27, 0x64, 0x68, 0x4F, 0xA1, 0xF7, 0x3F, 0x55, 0x04, 0x8F, 0x21, 0xC4,
+    0xDD, 0xC5, 0x45, 0x78, 0x1D, 0x52, 0xE8, 0x50, 0x28, 0xFC, 0x1F, 0x4D, 0x28, 0xD9, 0x8A, 0x01,
+    0x30, 0x5E, 0x7B, 0x7E, 0x9C, 0xFF, 0xBA, 0x33, 0x83, 0x1D, 0x75, 0x05, 0x47, 0x03, 0xCA, 0x06,
+    0xA8, 0xF9, 0x0D, 0x58, 0xA0, 0x07, 0x4E, 0x35, 0x1E, 0x22, 0x7D, 0x80, 0x5C, 0x82, 0x54, 0xE3,
+    0x1B, 0xB0, 0x42, 0x0F, 0x5C, 0xDC, 0x2E, 0x00, 0x79, 0x20, 0x88, 0x92, 0xFF, 0xE2, 0xA0, 0x01,
+    0x36, 0xA0, 0x7B, 0x40, 0x07, 0x94, 0x3C, 0x10, 0x04, 0xD9, 0x00, 0x19, 0x50, 0x36, 0x40, 0x7F,
+    0x01, 0x1B, 0xF0, 0x00, 0x52, 0x20, 0x1A, 0x9C, 0x16, 0x0F, 0xB8, 0x4C, 0x00, 0x00, 0x00, 0x00,
+    0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+
 TEST(FileTexture, png8BitRGBA) {
-    // basn6a08 from http://www.schaik.com/pngsuite/pngsuite_bas_png.html
+    TextureTest(png8BitRGBAData, sizeof(png8BitRGBAData), 32, 32, png8BitRGBAPixels);
+}
+
+TEST(FileTexture, pngTargetSize) {
+    std::shared_ptr<TextureInterface> texture;
+
+    RenderOnce([&](View* view) {
+        texture = view->loadTextureFromMemory(std::make_shared<std::string>((const char*)png8BitRGBAData, sizeof(png8BitRGBAData)), {6, 8});
+
+        // until the texture is decoded, the dimensions are those of the source image
+        EXPECT_EQ(texture->width(), 32);
+        EXPECT_EQ(texture->height(), 32);
+    }, [&](View* view) {
+        ASSERT_TRUE(texture->isLoaded());
+
+        // the target is rounded up to 8x8, which a quarter size decode covers
+        ASSERT_EQ(texture->width(), 8);
+        ASSERT_EQ(texture->height(), 8);
+
+        std::vector<Pixel> pixels;
+        pixels.resize(texture->width() * texture->height());
+
+        glBindTexture(GL_TEXTURE_2D, texture->id());
+        glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+        // each pixel should be the average of a 4x4 block of the source, with the colors weighted by alpha
+        for (int y = 0; y < 8; ++y) {
+            for (int x = 0; x < 8; ++x) {
+                int r = 0, g = 0, b = 0, a = 0;
+                for (int sy = y * 4; sy < y * 4 + 4; ++sy) {
+                    for (int sx = x * 4; sx < x * 4 + 4; ++sx) {
+                        auto& source = png8BitRGBAPixels[sx + 32 * sy];
+                        r += source.r * source.a;
+                        g += source.g * source.a;
+                        b += source.b * source.a;
+                        a += source.a;
+                    }
+                }
+                auto& pixel = pixels[x + 8 * y];
+                ASSERT_GT(a, 0);
+                EXPECT_NEAR(pixel.r, static_cast<double>(r) / a, 1.0);
+                EXPECT_NEAR(pixel.g, static_cast<double>(g) / a, 1.0);
+                EXPECT_NEAR(pixel.b, static_cast<double>(b) / a, 1.0);
+                EXPECT_NEAR(pixel.a, a / 16.0, 1.0);
+            }
+        }
+    });
+}
+
+TEST(FileTexture, pngTargetSizeAlpha) {
+    // a 4x4 image in which the top-left pixel of each 2x2 block is opaque red and the rest are transparent green
     static const unsigned char imageData[] = {
-        0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
-        0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x20, 0x08, 0x06, 0x00, 0x00, 0x00, 0x73, 0x7A, 0x7A,
-        0xF4, 0x00, 0x00, 0x00, 0x04, 0x67, 0x41, 0x4D, 0x41, 0x00, 0x01, 0x86, 0xA0, 0x31, 0xE8, 0x96,
-        0x5F, 0x00, 0x00, 0x00, 0x6F, 0x49, 0x44, 0x41, 0x54, 0x78, 0x9C, 0xED, 0xD6, 0x31, 0x0A, 0x80,
-        0x30, 0x0C, 0x46, 0xE1, 0x27, 0x64, 0x68, 0x4F, 0xA1, 0xF7, 0x3F, 0x55, 0x04, 0x8F, 0x21, 0xC4,
-        0xDD, 0xC5, 0x45, 0x78, 0x1D, 0x52, 0xE8, 0x50, 0x28, 0xFC, 0x1F, 0x4D, 0x28, 0xD9, 0x8A, 0x01,
-        0x30, 0x5E, 0x7B, 0x7E, 0x9C, 0xFF, 0xBA, 0x33, 0x83, 0x1D, 0x75, 0x05, 0x47, 0x03, 0xCA, 0x06,
-        0xA8, 0xF9, 0x0D, 0x58, 0xA0, 0x07, 0x4E, 0x35, 0x1E, 0x22, 0x7D, 0x80, 0x5C, 0x82, 0x54, 0xE3,
-        0x1B, 0xB0, 0x42, 0x0F, 0x5C, 0xDC, 0x2E, 0x00, 0x79, 0x20, 0x88, 0x92, 0xFF, 0xE2, 0xA0, 0x01,
-        0x36, 0xA0, 0x7B, 0x40, 0x07, 0x94, 0x3C, 0x10, 0x04, 0xD9, 0x00, 0x19, 0x50, 0x36, 0x40, 0x7F,
-        0x01, 0x1B, 0xF0, 0x00, 0x52, 0x20, 0x1A, 0x9C, 0x16, 0x0F, 0xB8, 0x4C, 0x00, 0x00, 0x00, 0x00,
-        0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+        0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x04,
+        0x00, 0x00, 0x00, 0x04, 0x08, 0x06, 0x00, 0x00, 0x00, 0xa9, 0xf1, 0x9e, 0x7e, 0x00, 0x00, 0x00, 0x17, 0x49, 0x44, 0x41,
+        0x54, 0x78, 0xda, 0x63, 0xf8, 0xcf, 0xc0, 0xf0, 0x9f, 0x01, 0x4c, 0x40, 0x68, 0x30, 0x0b, 0x1d, 0xe3, 0x57, 0x01, 0x00,
+        0xd5, 0x8a, 0x13, 0xed, 0x8c, 0xf6, 0x6d, 0x5b, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
     };
 
-    TextureTest(imageData, sizeof(imageData), 32, 32, png8BitRGBAPixels);
+    std::shared_ptr<TextureInterface> texture;
+
+    RenderOnce([&](View* view) {
+        texture = view->loadTextureFromMemory(std::make_shared<std::string>((const char*)imageData, sizeof(imageData)), {2, 2});
+    }, [&](View* view) {
+        ASSERT_TRUE(texture->isLoaded());
+        ASSERT_EQ(texture->width(), 2);
+        ASSERT_EQ(texture->height(), 2);
+
+        std::vector<Pixel> pixels;
+        pixels.resize(texture->width() * texture->height());
+
+        glBindTexture(GL_TEXTURE_2D, texture->id());
+        glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+        // the transparent green shouldn't bleed into the red
+        for (auto& pixel : pixels) {
+            EXPECT_EQ(pixel.r, 255);
+            EXPECT_EQ(pixel.g, 0);
+            EXPECT_EQ(pixel.b, 0);
+            EXPECT_EQ(pixel.a, 64);
+        }
+    });
 }
 
 TEST(FileTexture, jpgWater) {
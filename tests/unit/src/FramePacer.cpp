@@ -0,0 +1,114 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/FramePacer.h>
+
+#include <gtest/gtest.h>
+
+using namespace okui;
+using namespace std::literals;
+
+namespace {
+    template <typename Duration>
+    double Milliseconds(Duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+}
+
+TEST(FramePacer, frameInterval) {
+    FramePacer<> pacer;
+    EXPECT_NEAR(Milliseconds(pacer.frameInterval()), 1000.0 / 60.0, 0.01);
+
+    pacer.setTargetFrameRate(30.0);
+    EXPECT_NEAR(Milliseconds(pacer.frameInterval()), 1000.0 / 30.0, 0.01);
+
+    // target rates are rounded to divisors of the refresh rate
+    pacer.setTargetFrameRate(45.0);
+    EXPECT_NEAR(Milliseconds(pacer.frameInterval()), 1000.0 / 60.0, 0.01);
+
+    pacer.setRefreshRate(120.0);
+    pacer.setTargetFrameRate(60.0);
+    EXPECT_NEAR(Milliseconds(pacer.frameInterval()), 1000.0 / 60.0, 0.01);
+
+    pacer.setTargetFrameRate(0.0);
+    EXPECT_NEAR(Milliseconds(pacer.frameInterval()), 1000.0 / 120.0, 0.01);
+
+    pacer.setRefreshRate(50.0);
+    pacer.setTargetFrameRate(60.0);
+    EXPECT_NEAR(Milliseconds(pacer.frameInterval()), 20.0, 0.01);
+}
+
+TEST(FramePacer, deadlines) {
+    FramePacer<> pacer;
+    pacer.setRefreshRate(50.0);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(pacer.isFrameDue(start));
+
+    pacer.beginFrame(start);
+    EXPECT_EQ(pacer.nextFrameTime(), start + 20ms);
+    EXPECT_EQ(pacer.predictedPresentationTime(), start + 20ms);
+    pacer.endFrame(start + 5ms);
+    EXPECT_FALSE(pacer.isFrameDue(start + 10ms));
+    EXPECT_TRUE(pacer.isFrameDue(start + 20ms));
+
+    // slightly late frames stay in phase
+    pacer.beginFrame(start + 22ms);
+    EXPECT_EQ(pacer.nextFrameTime(), start + 40ms);
+    pacer.endFrame(start + 25ms);
+
+    // after falling behind by more than a frame, the pacer starts over
+    pacer.beginFrame(start + 100ms);
+    EXPECT_EQ(pacer.nextFrameTime(), start + 120ms);
+    pacer.endFrame(start + 105ms);
+}
+
+TEST(FramePacer, adaptive) {
+    FramePacer<> pacer;
+    pacer.setRefreshRate(50.0);
+
+    auto time = std::chrono::steady_clock::now();
+    auto frame = [&](std::chrono::steady_clock::duration work) {
+        time = std::max(time, pacer.nextFrameTime());
+        pacer.beginFrame(time);
+        time += work;
+        pacer.endFrame(time);
+    };
+
+    for (int i = 0; i < FramePacer<>::kLateFrameThreshold * 2; ++i) {
+        frame(25ms);
+    }
+    EXPECT_FALSE(pacer.isHalfRate());
+
+    pacer.setAdaptive();
+
+    for (int i = 0; i < FramePacer<>::kLateFrameThreshold; ++i) {
+        frame(25ms);
+    }
+    EXPECT_TRUE(pacer.isHalfRate());
+    EXPECT_EQ(pacer.frameInterval(), std::chrono::steady_clock::duration{40ms});
+
+    // frames that would only barely fit at the full rate don't cause a recovery
+    for (int i = 0; i < FramePacer<>::kRecoveryFrameThreshold * 2; ++i) {
+        frame(15ms);
+    }
+    EXPECT_TRUE(pacer.isHalfRate());
+
+    for (int i = 0; i < FramePacer<>::kRecoveryFrameThreshold * 2; ++i) {
+        frame(5ms);
+    }
+    EXPECT_FALSE(pacer.isHalfRate());
+    EXPECT_EQ(pacer.frameInterval(), std::chrono::steady_clock::duration{20ms});
+}
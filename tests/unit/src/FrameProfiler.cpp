@@ -0,0 +1,103 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/FrameProfiler.h>
+#include <okui/View.h>
+
+#include <gtest/gtest.h>
+
+using namespace okui;
+using namespace std::chrono_literals;
+
+TEST(FrameProfiler, disabled) {
+    FrameProfiler profiler;
+    EXPECT_FALSE(profiler.isEnabled());
+
+    profiler.beginFrame();
+    EXPECT_FALSE(profiler.isFrameInProgress());
+    EXPECT_EQ(FrameProfiler::Current(), nullptr);
+    profiler.endFrame();
+
+    EXPECT_EQ(profiler.lastFrame(), nullptr);
+}
+
+TEST(FrameProfiler, frames) {
+    FrameProfiler profiler;
+    profiler.setEnabled();
+
+    auto start = FrameProfiler::Clock::now();
+
+    // phases recorded between frames belong to the next one
+    profiler.recordPhase(FrameProfiler::Phase::kEvents, start, start + 1ms);
+
+    profiler.beginFrame(start + 2ms);
+    EXPECT_EQ(FrameProfiler::Current(), &profiler);
+    profiler.recordPhase(FrameProfiler::Phase::kUpdate, start + 2ms, start + 4ms);
+    profiler.recordPhase(FrameProfiler::Phase::kRender, start + 4ms, start + 7ms);
+
+    View view;
+    profiler.recordView(&view, start + 5ms, start + 6ms);
+    FrameProfiler::DidFlushShader();
+    FrameProfiler::DidFlushShader();
+    FrameProfiler::DidRenderCache();
+
+    profiler.endFrame(start + 8ms);
+    EXPECT_EQ(FrameProfiler::Current(), nullptr);
+
+    // nothing is counted outside of frames
+    FrameProfiler::DidFlushShader();
+
+    auto stats = profiler.lastFrame();
+    ASSERT_TRUE(stats);
+    EXPECT_EQ(stats->number, 0);
+    EXPECT_EQ(stats->frame.start, start);
+    EXPECT_EQ(stats->frame.duration, 8ms);
+    EXPECT_EQ(stats->phase(FrameProfiler::Phase::kEvents), 1ms);
+    EXPECT_EQ(stats->phase(FrameProfiler::Phase::kUpdate), 2ms);
+    EXPECT_EQ(stats->phase(FrameProfiler::Phase::kRender), 3ms);
+    EXPECT_EQ(stats->phase(FrameProfiler::Phase::kSwap), 0ms);
+    EXPECT_EQ(stats->shaderFlushes, 2);
+    EXPECT_EQ(stats->renderCacheRenders, 1);
+    ASSERT_EQ(stats->viewSpans.size(), 1);
+    EXPECT_EQ(stats->viewSpans[0].view, &view);
+    EXPECT_EQ(stats->viewSpans[0].duration, 1ms);
+
+    profiler.setHistoryLength(3);
+    for (int i = 0; i < 5; ++i) {
+        profiler.beginFrame();
+        profiler.endFrame();
+    }
+    EXPECT_EQ(profiler.history().size(), 3);
+    EXPECT_EQ(profiler.lastFrame()->number, 5);
+}
+
+TEST(FrameProfiler, chromeTrace) {
+    FrameProfiler profiler;
+    EXPECT_EQ(profiler.chromeTrace(), "{\"traceEvents\":[]}");
+
+    profiler.setEnabled();
+    auto start = FrameProfiler::Clock::now();
+    profiler.beginFrame(start);
+    profiler.recordPhase(FrameProfiler::Phase::kLayout, start + 1ms, start + 2ms);
+    View view;
+    profiler.recordView(&view, start + 2ms, start + 3ms);
+    profiler.endFrame(start + 4ms);
+
+    auto trace = profiler.chromeTrace();
+    EXPECT_NE(trace.find("\"name\":\"Frame 0\""), std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"Layout\",\"cat\":\"phase\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":1000,\"dur\":1000"), std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"okui::View\""), std::string::npos);
+    EXPECT_NE(trace.find("\"ph\":\"C\""), std::string::npos);
+}
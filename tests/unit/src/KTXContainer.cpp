@@ -0,0 +1,136 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/KTXContainer.h>
+#include <okui/opengl/TextureCompression.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace okui;
+
+namespace {
+
+void Append32(std::string* s, uint32_t value, bool bigEndian = false) {
+    for (int i = 0; i < 4; ++i) {
+        s->push_back(static_cast<char>(value >> (bigEndian ? 24 - i * 8 : i * 8)));
+    }
+}
+
+void Append64(std::string* s, uint64_t value) {
+    Append32(s, static_cast<uint32_t>(value));
+    Append32(s, static_cast<uint32_t>(value >> 32));
+}
+
+std::string KTX1(GLenum internalFormat, GLenum format, GLenum type, int width, int height, const std::vector<std::string>& levels, bool bigEndian = false) {
+    std::string ret("\xabKTX 11\xbb\r\n\x1a\n", 12);
+    for (uint32_t field : {0x04030201u, uint32_t(type), 1u, uint32_t(format), uint32_t(internalFormat), uint32_t(format ? format : GL_RGBA),
+                           uint32_t(width), uint32_t(height), 0u, 0u, 1u, uint32_t(levels.size()), 4u}) {
+        Append32(&ret, field, bigEndian);
+    }
+    ret += "meta";
+    for (auto& level : levels) {
+        Append32(&ret, level.size(), bigEndian);
+        ret += level;
+        ret.resize((ret.size() + 3) & ~3);
+    }
+    return ret;
+}
+
+std::string KTX2(uint32_t vkFormat, int width, int height, const std::vector<std::string>& levels) {
+    std::string ret("\xabKTX 20\xbb\r\n\x1a\n", 12);
+    for (uint32_t field : {vkFormat, 1u, uint32_t(width), uint32_t(height), 0u, 0u, 1u, uint32_t(levels.size()), 0u, 0u, 0u, 0u, 0u}) {
+        Append32(&ret, field);
+    }
+    Append64(&ret, 0);
+    Append64(&ret, 0);
+
+    std::string data;
+    for (auto& level : levels) {
+        Append64(&ret, 80 + 24 * levels.size() + data.size());
+        Append64(&ret, level.size());
+        Append64(&ret, level.size());
+        data += level;
+    }
+    return ret + data;
+}
+
+} // anonymous namespace
+
+TEST(KTXContainer, compressed) {
+    std::vector<std::string> levels;
+    for (int size = 16; size; size /= 2) {
+        levels.emplace_back(opengl::CompressedTextureSize(opengl::kCompressedRGB8ETC2, size, size / 2 ? size / 2 : 1), 'x');
+    }
+
+    for (auto bigEndian : {false, true}) {
+        auto data = KTX1(opengl::kCompressedRGB8ETC2, 0, 0, 16, 8, levels, bigEndian);
+        ASSERT_TRUE(KTXContainer::IsKTX(data.data(), data.size()));
+
+        KTXContainer container;
+        ASSERT_TRUE(container.parse(data.data(), data.size()));
+        EXPECT_TRUE(container.isCompressed());
+        EXPECT_EQ(container.internalFormat(), opengl::kCompressedRGB8ETC2);
+        EXPECT_EQ(container.width(), 16);
+        EXPECT_EQ(container.height(), 8);
+        ASSERT_EQ(container.levels().size(), 5);
+        EXPECT_EQ(container.levels()[2].width, 4);
+        EXPECT_EQ(container.levels()[2].height, 2);
+        EXPECT_EQ(container.levels()[2].size, 8);
+        EXPECT_EQ(container.levels()[4].width, 1);
+        EXPECT_EQ(container.levels()[4].height, 1);
+    }
+}
+
+TEST(KTXContainer, uncompressed) {
+    auto data = KTX2(37, 3, 2, {std::string(24, 'x'), std::string(4, 'y')});
+
+    KTXContainer container;
+    ASSERT_TRUE(container.parse(data.data(), data.size()));
+    EXPECT_FALSE(container.isCompressed());
+    EXPECT_EQ(container.format(), GL_RGBA);
+    EXPECT_EQ(container.type(), GL_UNSIGNED_BYTE);
+    ASSERT_EQ(container.levels().size(), 2);
+    EXPECT_EQ(container.levels()[1].width, 1);
+    EXPECT_EQ(container.levels()[1].height, 1);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(container.levels()[1].data), container.levels()[1].size), "yyyy");
+}
+
+TEST(KTXContainer, invalid) {
+    KTXContainer container;
+
+    std::string png = "\x89PNG\r\n\x1a\n";
+    EXPECT_FALSE(KTXContainer::IsKTX(png.data(), png.size()));
+    EXPECT_FALSE(container.parse(png.data(), png.size()));
+
+    auto truncated = KTX1(opengl::kCompressedRGB8ETC2, 0, 0, 8, 8, {std::string(32, 'x')});
+    truncated.resize(truncated.size() - 1);
+    EXPECT_FALSE(container.parse(truncated.data(), truncated.size()));
+
+    auto shortLevel = KTX2(37, 4, 4, {std::string(60, 'x')});
+    EXPECT_FALSE(container.parse(shortLevel.data(), shortLevel.size()));
+
+    // a 4x4 texture has at most 3 levels
+    auto fullChain = KTX2(37, 4, 4, std::vector<std::string>(3, std::string(64, 'x')));
+    EXPECT_TRUE(container.parse(fullChain.data(), fullChain.size()));
+    for (auto levelCount : {4, 40}) {
+        std::vector<std::string> levels(levelCount, std::string(64, 'x'));
+        auto tooManyLevels = KTX2(37, 4, 4, levels);
+        EXPECT_FALSE(container.parse(tooManyLevels.data(), tooManyLevels.size()));
+        tooManyLevels = KTX1(GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, 4, 4, levels);
+        EXPECT_FALSE(container.parse(tooManyLevels.data(), tooManyLevels.size()));
+    }
+}
@@ -150,6 +150,13 @@ TEST(Rectangle, intersection) {
     }
 }
 
+TEST(Rectangle, unionBounds) {
+    EXPECT_EQ(Rectangle<int>(1, 2, 3, 4).unionBounds(Rectangle<int>(2, 1, 3, 4)), Rectangle<int>(1, 1, 4, 5));
+    EXPECT_EQ(Rectangle<int>(1, 2, 3, 4).unionBounds(Rectangle<int>(10, 10, 1, 1)), Rectangle<int>(1, 2, 10, 9));
+    EXPECT_EQ(Rectangle<int>(1, 2, 3, 4).unionBounds(Rectangle<int>()), Rectangle<int>(1, 2, 3, 4));
+    EXPECT_EQ(Rectangle<int>().unionBounds(Rectangle<int>(1, 2, 3, 4)), Rectangle<int>(1, 2, 3, 4));
+}
+
 TEST(Rectangle, interpolation) {
     EXPECT_EQ(Rectangle<int>(10, 10, 100, 200).interpolate(Rectangle<int>(-110, -310, 50, 300), 0.0, interpolation::Linear<int>), Rectangle<int>(10, 10, 100, 200));
     EXPECT_EQ(Rectangle<int>(10, 10, 100, 200).interpolate(Rectangle<int>(-110, -310, 50, 300), 1.0, interpolation::Linear<int>), Rectangle<int>(-110, -310, 50, 300));
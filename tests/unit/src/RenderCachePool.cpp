@@ -0,0 +1,106 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "RenderOnce.h"
+
+#include <okui/RenderCachePool.h>
+
+#include <gtest/gtest.h>
+
+using namespace okui;
+
+TEST(RenderCachePool, BucketSize) {
+    EXPECT_EQ(RenderCachePool::BucketSize(0), 0);
+    EXPECT_EQ(RenderCachePool::BucketSize(1), 32);
+    EXPECT_EQ(RenderCachePool::BucketSize(32), 32);
+    EXPECT_EQ(RenderCachePool::BucketSize(33), 64);
+    EXPECT_EQ(RenderCachePool::BucketSize(300), 384);
+    EXPECT_EQ(RenderCachePool::BucketSize(1000), 1024);
+    EXPECT_EQ(RenderCachePool::BucketSize(1025), 1536);
+
+    for (int size = 1; size < 4096; ++size) {
+        auto bucket = RenderCachePool::BucketSize(size);
+        EXPECT_GE(bucket, size);
+        EXPECT_LE(bucket, std::max(size * 2, 32));
+    }
+}
+
+#if ONAIR_OKUI_HAS_NATIVE_APPLICATION
+
+TEST(RenderCachePool, reuse) {
+    RenderOnce([&] (View* view) {
+        RenderCachePool pool;
+
+        auto a = pool.acquire(300, 200);
+        ASSERT_TRUE(a && a->isValid());
+        EXPECT_EQ(a->width(), 384);
+        EXPECT_EQ(a->height(), 256);
+        EXPECT_EQ(pool.bytes(), 384 * 256 * 4);
+
+        auto surface = a.get();
+        pool.release(std::move(a));
+        EXPECT_EQ(pool.idleBytes(), 384 * 256 * 4);
+
+        // a nearby size lands in the same bucket
+        auto b = pool.acquire(310, 210);
+        EXPECT_EQ(b.get(), surface);
+        EXPECT_EQ(pool.idleBytes(), 0);
+    });
+}
+
+TEST(RenderCachePool, budget) {
+    RenderOnce([&] (View* view) {
+        RenderCachePool pool;
+        pool.setBudget(3 * 64 * 64 * 4);
+
+        auto a = pool.acquire(64, 64);
+        auto b = pool.acquire(64, 64);
+        pool.release(std::move(b));
+        pool.endFrame();
+
+        auto c = pool.acquire(64, 64);
+        auto d = pool.acquire(64, 64);
+        pool.endFrame();
+        EXPECT_LE(pool.bytes(), pool.budget());
+
+        // a wasn't used recently, so it's evicted to make room
+        pool.use(c.get());
+        pool.use(d.get());
+        auto e = pool.acquire(64, 64);
+        EXPECT_FALSE(a->isValid());
+        EXPECT_TRUE(c->isValid());
+        EXPECT_TRUE(d->isValid());
+        EXPECT_TRUE(e->isValid());
+        EXPECT_LE(pool.bytes(), pool.budget());
+    });
+}
+
+TEST(RenderCachePool, maxUnusedFrames) {
+    RenderOnce([&] (View* view) {
+        RenderCachePool pool;
+        pool.setMaxUnusedFrames(2);
+
+        auto a = pool.acquire(64, 64);
+        for (int i = 0; i < 3; ++i) {
+            pool.endFrame();
+            EXPECT_TRUE(a->isValid());
+        }
+        pool.endFrame();
+        EXPECT_FALSE(a->isValid());
+        EXPECT_EQ(pool.bytes(), 0);
+    });
+}
+
+#endif // ONAIR_OKUI_HAS_NATIVE_APPLICATION
@@ -0,0 +1,70 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/RenderThread.h>
+#include <okui/opengl/ContextOwnership.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+using namespace okui;
+
+TEST(RenderThread, submit) {
+    RenderThread thread;
+    EXPECT_FALSE(thread.isCurrent());
+
+    std::atomic<int> frames{0};
+    std::atomic<bool> wasCurrent{true};
+    for (int i = 0; i < 10; ++i) {
+        thread.submit([&] {
+            wasCurrent = wasCurrent && thread.isCurrent();
+            ++frames;
+        });
+    }
+    thread.wait();
+
+    EXPECT_EQ(frames, 10);
+    EXPECT_TRUE(wasCurrent);
+}
+
+TEST(RenderThread, contextOwnership) {
+    EXPECT_TRUE(opengl::ContextOwnership::IsOwnedByCurrentThread());
+
+    int releases = 0;
+    {
+        RenderThread thread;
+        EXPECT_FALSE(opengl::ContextOwnership::IsOwnedByCurrentThread());
+
+        // releases on threads without the context are deferred until a thread claims it
+        opengl::ReleaseResources([&] { ++releases; });
+        EXPECT_EQ(releases, 0);
+
+        thread.submit([&] {
+            opengl::ContextOwnership ownership;
+            EXPECT_TRUE(opengl::ContextOwnership::IsOwnedByCurrentThread());
+        });
+        thread.wait();
+        EXPECT_EQ(releases, 1);
+
+        {
+            opengl::ContextOwnership ownership;
+            opengl::ReleaseResources([&] { ++releases; });
+            EXPECT_EQ(releases, 2);
+        }
+    }
+
+    EXPECT_TRUE(opengl::ContextOwnership::IsOwnedByCurrentThread());
+}
@@ -0,0 +1,76 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/SkylinePacker.h>
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace okui;
+
+TEST(SkylinePacker, pack) {
+    SkylinePacker packer(100, 100);
+
+    auto a = packer.pack(60, 40);
+    ASSERT_TRUE(a);
+    EXPECT_EQ(*a, Rectangle<int>(0, 0, 60, 40));
+
+    auto b = packer.pack(40, 20);
+    ASSERT_TRUE(b);
+    EXPECT_EQ(*b, Rectangle<int>(60, 0, 40, 20));
+
+    // this one fits lowest underneath b
+    auto c = packer.pack(40, 20);
+    ASSERT_TRUE(c);
+    EXPECT_EQ(*c, Rectangle<int>(60, 20, 40, 20));
+
+    auto d = packer.pack(100, 60);
+    ASSERT_TRUE(d);
+    EXPECT_EQ(*d, Rectangle<int>(0, 40, 100, 60));
+
+    EXPECT_FALSE(packer.pack(1, 1));
+    EXPECT_EQ(packer.usedArea(), 100 * 100);
+
+    packer.clear();
+    EXPECT_EQ(packer.usedArea(), 0);
+    EXPECT_FALSE(packer.pack(101, 1));
+    EXPECT_FALSE(packer.pack(0, 1));
+    EXPECT_TRUE(packer.pack(100, 100));
+}
+
+TEST(SkylinePacker, noOverlap) {
+    SkylinePacker packer(256, 256);
+
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<int> distribution(1, 32);
+
+    std::vector<Rectangle<int>> packed;
+    for (int i = 0; i < 500; ++i) {
+        if (auto placement = packer.pack(distribution(generator), distribution(generator))) {
+            EXPECT_GE(placement->minX(), 0);
+            EXPECT_GE(placement->minY(), 0);
+            EXPECT_LE(placement->maxX(), 256);
+            EXPECT_LE(placement->maxY(), 256);
+            for (auto& other : packed) {
+                EXPECT_FALSE(placement->intersects(other));
+            }
+            packed.push_back(*placement);
+        }
+    }
+
+    // the heuristic should do a reasonable job of filling the area
+    EXPECT_GT(packer.usedArea(), 256 * 256 * 0.7);
+}
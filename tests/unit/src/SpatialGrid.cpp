@@ -0,0 +1,126 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/SpatialGrid.h>
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace okui;
+
+namespace {
+    std::vector<int> Sorted(std::vector<int> items) {
+        std::sort(items.begin(), items.end());
+        return items;
+    }
+}
+
+TEST(SpatialGrid, query) {
+    SpatialGrid<int> grid(10.0);
+
+    grid.insert(1, Rectangle<double>(0, 0, 5, 5));
+    grid.insert(2, Rectangle<double>(5, 5, 20, 20));
+    grid.insert(3, Rectangle<double>(-15, -15, 10, 10));
+    grid.insert(4, stdts::nullopt);
+    EXPECT_EQ(grid.size(), 4);
+
+    std::vector<int> results;
+    grid.query(Rectangle<double>(0, 0, 10, 10), &results);
+    EXPECT_EQ(Sorted(results), (std::vector<int>{1, 2, 4}));
+
+    results.clear();
+    grid.query(-10, -10, &results);
+    EXPECT_EQ(Sorted(results), (std::vector<int>{3, 4}));
+
+    results.clear();
+    grid.query(5, 5, &results);
+    EXPECT_EQ(Sorted(results), (std::vector<int>{2, 4}));
+
+    // moving an item
+    grid.insert(2, Rectangle<double>(100, 100, 5, 5));
+    results.clear();
+    grid.query(Rectangle<double>(0, 0, 10, 10), &results);
+    EXPECT_EQ(Sorted(results), (std::vector<int>{1, 4}));
+
+    grid.remove(4);
+    grid.remove(1);
+    results.clear();
+    grid.query(Rectangle<double>(0, 0, 10, 10), &results);
+    EXPECT_TRUE(results.empty());
+    EXPECT_EQ(grid.size(), 2);
+    EXPECT_FALSE(grid.contains(1));
+    EXPECT_TRUE(grid.contains(2));
+}
+
+TEST(SpatialGrid, largeItems) {
+    SpatialGrid<int> grid(10.0);
+
+    // this spans too many cells to be indexed, but should still be found
+    grid.insert(1, Rectangle<double>(0, 0, 1000, 1000));
+
+    std::vector<int> results;
+    grid.query(500, 500, &results);
+    EXPECT_EQ(results, (std::vector<int>{1}));
+
+    results.clear();
+    grid.query(2000, 2000, &results);
+    EXPECT_TRUE(results.empty());
+
+    grid.insert(1, Rectangle<double>(0, 0, 10, 10));
+    results.clear();
+    grid.query(Rectangle<double>(-1000, -1000, 3000, 3000), &results);
+    EXPECT_EQ(results, (std::vector<int>{1}));
+}
+
+TEST(SpatialGrid, matchesLinearSearch) {
+    SpatialGrid<int> grid(50.0);
+    std::vector<Rectangle<double>> bounds;
+
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<double> position(-500, 1500);
+    std::uniform_real_distribution<double> size(1, 200);
+
+    for (int i = 0; i < 2000; ++i) {
+        bounds.emplace_back(position(generator), position(generator), size(generator), size(generator));
+        grid.insert(i, bounds.back());
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        Rectangle<double> area(position(generator), position(generator), size(generator), size(generator));
+
+        std::vector<int> expected;
+        for (int j = 0; j < static_cast<int>(bounds.size()); ++j) {
+            if (bounds[j].intersects(area)) {
+                expected.push_back(j);
+            }
+        }
+
+        std::vector<int> results;
+        grid.query(area, &results);
+        EXPECT_EQ(Sorted(results), expected);
+
+        expected.clear();
+        for (int j = 0; j < static_cast<int>(bounds.size()); ++j) {
+            if (bounds[j].contains(area.x, area.y)) {
+                expected.push_back(j);
+            }
+        }
+
+        results.clear();
+        grid.query(area.x, area.y, &results);
+        EXPECT_EQ(Sorted(results), expected);
+    }
+}
@@ -0,0 +1,74 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "RenderOnce.h"
+
+#include <okui/TextureAtlas.h>
+
+#include <gtest/gtest.h>
+
+#if ONAIR_OKUI_HAS_NATIVE_APPLICATION
+
+using namespace okui;
+
+TEST(TextureAtlas, accepts) {
+    TextureAtlas atlas(64);
+    atlas.setMaxEntrySize(32);
+
+    EXPECT_TRUE(atlas.accepts(32, 32));
+    EXPECT_FALSE(atlas.accepts(33, 1));
+    EXPECT_FALSE(atlas.accepts(0, 1));
+
+    atlas.setMaxEntrySize(64);
+    EXPECT_FALSE(atlas.accepts(64, 64)); // no room for the padding
+}
+
+TEST(TextureAtlas, allocation) {
+    RenderOnce([&] (View* view) {
+        TextureAtlas atlas(64);
+        atlas.setMaxPages(1);
+
+        // with padding, two of these fill the page
+        std::vector<uint8_t> pixels(40 * 20 * 4, 0xff);
+
+        auto a = atlas.add(40, 20, pixels.data());
+        auto b = atlas.add(40, 20, pixels.data());
+        ASSERT_TRUE(a);
+        ASSERT_TRUE(b);
+        EXPECT_EQ(a->texture(), b->texture());
+        EXPECT_NE(a->texture(), 0);
+        EXPECT_FALSE(a->coordinates().intersects(b->coordinates()));
+        EXPECT_DOUBLE_EQ(a->coordinates().width, 40.0 / 64.0);
+        EXPECT_DOUBLE_EQ(a->coordinates().height, 20.0 / 64.0);
+        EXPECT_EQ(atlas.pageCount(), 1);
+
+        EXPECT_FALSE(atlas.add(40, 20, pixels.data()));
+
+        // releasing an image allows the page to be repacked
+        b = nullptr;
+        auto generation = atlas.generation();
+        auto c = atlas.add(40, 20, pixels.data());
+        ASSERT_TRUE(c);
+        EXPECT_GT(atlas.generation(), generation);
+        EXPECT_FALSE(a->coordinates().intersects(c->coordinates()));
+
+        // empty pages are freed
+        a = c = nullptr;
+        atlas.collectGarbage();
+        EXPECT_EQ(atlas.pageCount(), 0);
+    });
+}
+
+#endif // ONAIR_OKUI_HAS_NATIVE_APPLICATION
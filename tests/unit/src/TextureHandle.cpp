@@ -15,10 +15,12 @@
 */
 #include <okui/FileTexture.h>
 #include <okui/TextureHandle.h>
+#include <okui/WeakTexture.h>
 
 #include <gtest/gtest.h>
 
 using namespace okui;
+using namespace std::string_literals;
 
 TEST(TextureHandle, callback) {
     TextureHandle handle;
@@ -64,3 +66,116 @@ TEST(TextureHandle, expiredHandle) {
     EXPECT_FALSE(one);
     EXPECT_TRUE(two);
 }
+
+namespace {
+
+// a loaded 2x2 texture, which uses 16 bytes
+TextureHandle LoadedTexture() {
+    auto texture = std::make_shared<WeakTexture>();
+    texture->set(1, 2, 2);
+    return TextureHandle{texture};
+}
+
+} // anonymous namespace
+
+TEST(TextureHandle, cacheWithoutBudget) {
+    scraps::Cache<TextureHandle> cache;
+
+    cache.add(LoadedTexture(), "a"s, scraps::Cache<TextureHandle>::kKeepForever);
+    cache.add(LoadedTexture(), "b"s);
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.bytes(), 32);
+
+    // unreferenced entries are removed as soon as another is added, unless they're kept forever
+    auto c = cache.add(LoadedTexture(), "c"s);
+    EXPECT_TRUE(cache.find("a"s));
+    EXPECT_FALSE(cache.find("b"s));
+    EXPECT_TRUE(cache.find("c"s));
+}
+
+TEST(TextureHandle, cacheBudget) {
+    scraps::Cache<TextureHandle> cache;
+    cache.setBudget(48);
+
+    cache.add(LoadedTexture(), "a"s);
+    cache.add(LoadedTexture(), "b"s);
+    cache.add(LoadedTexture(), "c"s);
+    cache.add(LoadedTexture(), "d"s);
+    EXPECT_EQ(cache.size(), 4);
+    EXPECT_EQ(cache.bytes(), 64);
+
+    // the least recently used entry is evicted first
+    cache.enforceBudget();
+    EXPECT_EQ(cache.bytes(), 48);
+    EXPECT_FALSE(cache.find("a"s));
+
+    EXPECT_TRUE(cache.get("b"s));
+    cache.add(LoadedTexture(), "e"s);
+    cache.enforceBudget();
+    EXPECT_TRUE(cache.find("b"s));
+    EXPECT_FALSE(cache.find("c"s));
+
+    // referenced entries are never evicted, and entries kept forever only are once nothing else can be
+    auto referenced = cache.add(LoadedTexture(), "f"s);
+    cache.add(LoadedTexture(), "g"s, scraps::Cache<TextureHandle>::kKeepForever);
+    cache.setBudget(32);
+    EXPECT_TRUE(cache.find("f"s));
+    EXPECT_TRUE(cache.find("g"s));
+    EXPECT_EQ(cache.bytes(), 32);
+
+    cache.setBudget(16);
+    EXPECT_TRUE(cache.find("f"s));
+    EXPECT_FALSE(cache.find("g"s));
+    EXPECT_EQ(cache.size(), 1);
+
+    // textures that haven't been loaded don't use any memory yet, so there's no reason to evict them
+    auto unloaded = std::make_shared<WeakTexture>();
+    cache.add(TextureHandle{unloaded}, "h"s);
+    cache.enforceBudget();
+    EXPECT_TRUE(cache.find("h"s));
+
+    // once loaded, they only count against the budget after they're updated
+    unloaded->set(1, 2, 2);
+    EXPECT_EQ(cache.bytes(), 16);
+    cache.updateBytes("h"s);
+    EXPECT_EQ(cache.bytes(), 32);
+    unloaded.reset();
+    cache.enforceBudget();
+    EXPECT_FALSE(cache.find("h"s));
+    EXPECT_EQ(cache.bytes(), 16);
+}
+
+TEST(TextureHandle, cacheStatistics) {
+    scraps::Cache<TextureHandle> cache;
+    cache.setBudget(16);
+
+    EXPECT_FALSE(cache.get("a"s));
+    cache.add(LoadedTexture(), "a"s);
+    EXPECT_TRUE(cache.get("a"s));
+    EXPECT_TRUE(cache.find("a"s));
+    cache.add(LoadedTexture(), "b"s);
+    cache.enforceBudget();
+
+    auto statistics = cache.statistics();
+    EXPECT_EQ(statistics.hits, 1);
+    EXPECT_EQ(statistics.misses, 1);
+    EXPECT_EQ(statistics.evictions, 1);
+
+    cache.resetStatistics();
+    EXPECT_EQ(cache.statistics().hits, 0);
+}
+
+TEST(TextureHandle, cachePurge) {
+    scraps::Cache<TextureHandle> cache;
+    cache.setBudget(1024);
+
+    auto referenced = cache.add(LoadedTexture(), "a"s);
+    cache.add(LoadedTexture(), "b"s);
+    cache.add(LoadedTexture(), "c"s, scraps::Cache<TextureHandle>::kKeepForever);
+
+    cache.purge();
+    EXPECT_TRUE(cache.find("a"s));
+    EXPECT_FALSE(cache.find("b"s));
+    EXPECT_FALSE(cache.find("c"s));
+    EXPECT_EQ(cache.statistics().evictions, 2);
+}
@@ -13,6 +13,7 @@
 * See the License for the specific language governing permissions and
 * limitations under the License.
 */
+#include "RenderOnce.h"
 #include "TestApplication.h"
 
 #include <okui/View.h>
@@ -561,3 +562,161 @@ TEST(View, focusOnRemoval) {
     EXPECT_EQ(window.focus(), nullptr);
 }
 #endif
+
+TEST(View, isOpaque) {
+    View view;
+    EXPECT_FALSE(view.isOpaque());
+
+    view.setBackgroundColor(Color::kBlack);
+    EXPECT_TRUE(view.isOpaque());
+
+    view.setOpacity(0.5);
+    EXPECT_FALSE(view.isOpaque());
+
+    view.setOpacity(1.0);
+    view.setBackgroundColor(Color::kTransparentBlack);
+    EXPECT_FALSE(view.isOpaque());
+
+    view.setIsOpaque();
+    EXPECT_TRUE(view.isOpaque());
+}
+
+#if ONAIR_OKUI_HAS_NATIVE_APPLICATION
+TEST(View, occlusion) {
+    struct CountingView : okui::View {
+        virtual void render() override { ++renders; }
+        int renders = 0;
+    };
+
+    CountingView covered, partiallyCovered, overlay;
+    covered.setBounds(10, 10, 50, 50);
+    partiallyCovered.setBounds(50, 50, 100, 100);
+    overlay.setBounds(0, 0, 100, 100);
+    overlay.setBackgroundColor(Color::kBlack);
+
+    RenderOnce([&](View* view) {
+        view->addSubview(&covered);
+        view->addSubview(&partiallyCovered);
+        view->addSubview(&overlay);
+        overlay.bringToFront();
+    }, [](View* view) {});
+
+    EXPECT_EQ(covered.renders, 0);
+    EXPECT_GE(partiallyCovered.renders, 1);
+    EXPECT_GE(overlay.renders, 1);
+}
+#endif
+
+TEST(View, spatialIndexHitTest) {
+    View view, back, front, overlapping, nonClipping, nonClippingChild;
+    view.setBounds(0, 0, 1000, 1000);
+    back.setBounds(0, 0, 100, 100);
+    front.setBounds(50, 50, 100, 100);
+    view.addSubview(&back);
+    view.addSubview(&front);
+
+    view.setUsesSpatialIndex(true, 64);
+    EXPECT_TRUE(view.usesSpatialIndex());
+
+    EXPECT_EQ(view.hitTestView(10, 10), &back);
+    EXPECT_EQ(view.hitTestView(75, 75), &front);
+    EXPECT_EQ(view.hitTestView(500, 500), &view);
+
+    back.bringToFront();
+    EXPECT_EQ(view.hitTestView(75, 75), &back);
+    back.sendToBack();
+    EXPECT_EQ(view.hitTestView(75, 75), &front);
+
+    front.setBounds(600, 600, 100, 100);
+    EXPECT_EQ(view.hitTestView(75, 75), &back);
+    EXPECT_EQ(view.hitTestView(650, 650), &front);
+
+    front.setScale(0.5);
+    EXPECT_EQ(view.hitTestView(690, 690), &front);
+    front.setScale(1.0);
+
+    overlapping.setBounds(640, 640, 20, 20);
+    view.addSubview(&overlapping);
+    EXPECT_EQ(view.hitTestView(650, 650), &overlapping);
+
+    view.removeSubview(&overlapping);
+    EXPECT_EQ(view.hitTestView(650, 650), &front);
+
+    front.hide();
+    EXPECT_EQ(view.hitTestView(650, 650), &view);
+    front.show();
+
+    nonClipping.setBounds(900, 900, 10, 10);
+    nonClipping.setClipsToBounds(false);
+    nonClippingChild.setBounds(-850, -850, 10, 10);
+    nonClipping.addSubview(&nonClippingChild);
+    view.addSubview(&nonClipping);
+    EXPECT_EQ(view.hitTestView(55, 55), &nonClippingChild);
+
+    view.setUsesSpatialIndex(false);
+    EXPECT_FALSE(view.usesSpatialIndex());
+    EXPECT_EQ(view.hitTestView(55, 55), &nonClippingChild);
+    EXPECT_EQ(view.hitTestView(10, 10), &back);
+}
+
+TEST(View, deferredLayout) {
+    struct LayoutView : okui::View {
+        virtual void layout() override {
+            ++layouts;
+            for (auto& subview : subviews()) {
+                subview->setBounds(0, 0, bounds().width / 2, bounds().height / 2);
+            }
+        }
+        int layouts = 0;
+    };
+
+    LayoutView root, child, grandchild;
+    root.addSubview(&child);
+    child.addSubview(&grandchild);
+    root.layoutIfNeeded();
+    root.layouts = child.layouts = grandchild.layouts = 0;
+
+    root.setBounds(0, 0, 100, 100);
+    root.setBounds(0, 0, 200, 200);
+    root.setBounds(0, 0, 400, 400);
+    EXPECT_EQ(root.layouts, 0);
+    EXPECT_TRUE(root.needsLayout());
+
+    root.layoutIfNeeded();
+    EXPECT_FALSE(root.needsLayout());
+    EXPECT_EQ(root.layouts, 1);
+    EXPECT_EQ(child.layouts, 1);
+    EXPECT_EQ(grandchild.layouts, 1);
+    EXPECT_EQ(grandchild.bounds(), Rectangle<double>(0, 0, 100, 100));
+
+    root.layoutIfNeeded();
+    EXPECT_EQ(root.layouts, 1);
+
+    grandchild.setNeedsLayout();
+    root.layoutIfNeeded();
+    EXPECT_EQ(root.layouts, 1);
+    EXPECT_EQ(child.layouts, 1);
+    EXPECT_EQ(grandchild.layouts, 2);
+}
+
+#if ONAIR_OKUI_HAS_NATIVE_APPLICATION
+TEST(View, layoutPassPerFrame) {
+    struct LayoutView : okui::View {
+        virtual void layout() override { ++layouts; }
+        int layouts = 0;
+    };
+
+    LayoutView view;
+
+    RenderOnce([&](View* root) {
+        root->addSubview(&view);
+        for (int i = 1; i <= 10; ++i) {
+            view.setBounds(0, 0, i * 10, i * 10);
+        }
+    }, [&](View* root) {
+        EXPECT_EQ(view.layouts, 1);
+        EXPECT_FALSE(view.needsLayout());
+        EXPECT_GE(root->window()->layoutCount(), 1);
+    });
+}
+#endif
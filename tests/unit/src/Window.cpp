@@ -16,9 +16,14 @@
 #include "TestApplication.h"
 
 #include <okui/Window.h>
+#include <okui/applications/Headless.h>
+#include <okui/opengl/TextureUploadBuffer.h>
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <thread>
+
 using namespace okui;
 
 #if ONAIR_OKUI_HAS_NATIVE_APPLICATION
@@ -127,4 +132,282 @@ TEST(Window, draggedViewRemoval) {
     // the window shouldn't invoke anything on b. as far as it knows, b doesn't exist anymore
     EXPECT_FALSE(b.receivedDrag);
 }
+
+TEST(Window, damagedRegion) {
+    TestApplication application;
+    okui::Window window(&application);
+    window.setSize(100, 100);
+    window.open();
+
+    View a, b;
+    window.contentView()->addSubview(&a);
+    a.addSubview(&b);
+    a.setBounds(10, 10, 50, 50);
+    b.setBounds(5, 5, 10, 10);
+
+    auto damaged = [&](const Rectangle<double>& r) {
+        for (auto& rectangle : window.damagedRegion().rectangles()) {
+            if (r.minX() >= rectangle.minX() && r.maxX() <= rectangle.maxX() && r.minY() >= rectangle.minY() && r.maxY() <= rectangle.maxY()) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    EXPECT_TRUE(damaged({10, 10, 50, 50}));
+
+    window.invalidate();
+    window.setRedrawMode(Window::RedrawMode::kDamaged);
+    EXPECT_EQ(window.redrawMode(), Window::RedrawMode::kDamaged);
+
+    b.setBounds(20, 20, 10, 10);
+    EXPECT_TRUE(damaged({15, 15, 10, 10}));
+    EXPECT_TRUE(damaged({30, 30, 10, 10}));
+
+    b.invalidateRenderCache();
+    EXPECT_TRUE(damaged({30, 30, 10, 10}));
+}
+
+TEST(Window, needsDisplay) {
+    TestApplication application;
+
+    struct RenderWindow : okui::Window {
+        using Window::Window;
+        virtual void render() override { application()->quit(); }
+    } window(&application);
+
+    window.setSize(100, 100);
+    window.setRendersOnDemand();
+    window.open();
+    EXPECT_TRUE(window.needsDisplay());
+
+    application.run();
+    EXPECT_FALSE(window.needsDisplay());
+
+    View view;
+    window.contentView()->addSubview(&view);
+    view.setBounds(10, 10, 10, 10);
+    EXPECT_TRUE(window.needsDisplay());
+}
+#endif
+
+#if ONAIR_OKUI_HAS_HEADLESS_APPLICATION
+namespace {
+    struct HeadlessApplication : applications::Headless {
+        virtual std::string name() const override { return "Window Test"; }
+        virtual std::string organization() const override { return "BitTorrent Inc."; }
+    };
+
+    struct CustomShader : shaders::ColorShader {};
+
+    // a 2x2 rgba image
+    const unsigned char png2x2[] = {
+        0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x02,
+        0x00, 0x00, 0x00, 0x02, 0x08, 0x06, 0x00, 0x00, 0x00, 0x72, 0xb6, 0x0d, 0x24, 0x00, 0x00, 0x00, 0x12, 0x49, 0x44, 0x41,
+        0x54, 0x78, 0xda, 0x63, 0xf8, 0xcf, 0xc0, 0xf0, 0x1f, 0x0c, 0x81, 0x34, 0x18, 0x00, 0x00, 0x49, 0xc8, 0x09, 0xf7, 0x03,
+        0xd9, 0x64, 0xf1, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+    };
+}
+
+TEST(Window, shaderWarmUp) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    okui::Window window(&application);
+    window.setSize(40, 30);
+    window.warmUpStandardShaders();
+    window.warmUpShader<CustomShader>("custom shader");
+    EXPECT_EQ(window.pendingShaderWarmUps(), 5);
+
+    // with no budget, nothing should be warmed up, and the window shouldn't keep redrawing for it
+    window.setShaderWarmUpBudget(std::chrono::microseconds::zero());
+    window.setRendersOnDemand();
+    window.open();
+    EXPECT_TRUE(window.needsDisplay());
+
+    application.renderFrame(&window);
+    EXPECT_EQ(window.pendingShaderWarmUps(), 5);
+    EXPECT_FALSE(window.shaderCache()->get(std::string("color shader")));
+    EXPECT_FALSE(window.needsDisplay());
+
+    // otherwise shaders are created with the time that each frame has to spare
+    window.setShaderWarmUpBudget(std::chrono::seconds(10));
+    EXPECT_TRUE(window.needsDisplay());
+    for (int i = 0; i < 100 && window.pendingShaderWarmUps(); ++i) {
+        application.renderFrame(&window);
+    }
+    EXPECT_EQ(window.pendingShaderWarmUps(), 0);
+    EXPECT_FALSE(window.needsDisplay());
+
+    auto custom = window.shaderCache()->get(std::string("custom shader"));
+    ASSERT_TRUE(custom);
+    EXPECT_TRUE(dynamic_cast<CustomShader*>(custom->get()));
+    EXPECT_TRUE(window.shaderCache()->get(std::string("shape shader")));
+}
+
+TEST(Window, damagedRegionRender) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    struct RenderWindow : okui::Window {
+        using Window::Window;
+        virtual void render() override {
+            BatchRenderer::Flush();
+            DisplayList::Perform([] {
+                glClearColor(1.0, 0.0, 0.0, 1.0);
+                glClear(GL_COLOR_BUFFER_BIT);
+            });
+        }
+    } window(&application);
+
+    window.setSize(40, 30);
+    window.setRedrawMode(Window::RedrawMode::kDamaged);
+    window.setBackBufferAge(1);
+
+    View view;
+    view.setBackgroundColor(Color::kGreen);
+    view.setBounds(0, 0, 10, 10);
+    window.contentView()->addSubview(&view);
+    window.open();
+
+    application.renderFrame(&window);
+    auto fullRedraw = application.readPixels(&window);
+
+    // moving the view damages both its old and new bounds, and the window's own rendering should be redrawn in each
+    view.setBounds(20, 10, 10, 10);
+    application.renderFrame(&window);
+    view.setBounds(0, 0, 10, 10);
+    application.renderFrame(&window);
+
+    auto pixels = application.readPixels(&window);
+    auto pixel = [&](int x, int y) {
+        auto p = &pixels[(y * 40 + x) * 4];
+        return std::vector<int>{p[0], p[1], p[2], p[3]};
+    };
+    EXPECT_EQ(pixel(5, 5), (std::vector<int>{0, 255, 0, 255}));
+    EXPECT_EQ(pixel(25, 15), (std::vector<int>{255, 0, 0, 255}));
+    EXPECT_EQ(pixels, fullRedraw);
+}
+
+TEST(Window, layoutDoesNotNeedDisplay) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    struct LayoutView : okui::View {
+        virtual void layout() override {
+            for (auto& subview : subviews()) {
+                subview->setBounds(0, 0, bounds().width / 2, bounds().height / 2);
+            }
+        }
+    };
+
+    okui::Window window(&application);
+    window.setSize(40, 30);
+    window.setRendersOnDemand();
+    window.open();
+
+    LayoutView view, child, grandchild;
+    view.addSubview(&child);
+    child.addSubview(&grandchild);
+    window.contentView()->addSubview(&view);
+    view.setBounds(0, 0, 40, 30);
+
+    // laying out the view resizes its subviews, which shouldn't leave anything flagged for another frame
+    application.renderFrame(&window);
+    EXPECT_FALSE(window.needsDisplay());
+    EXPECT_EQ(grandchild.bounds(), Rectangle<double>(0, 0, 10, 7.5));
+}
+
+TEST(Window, textureUploadBudget) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    okui::Window window(&application);
+    window.setSize(40, 30);
+    window.setRendersOnDemand();
+    window.open();
+
+    // each texture is over budget on its own, so only one should be uploaded per frame
+    window.setTextureUploadBudget(1, std::chrono::seconds(10));
+
+    std::vector<TextureHandle> textures;
+    for (int i = 0; i < 3; ++i) {
+        textures.emplace_back(window.loadTextureFromMemory(std::make_shared<std::string>(reinterpret_cast<const char*>(png2x2), sizeof(png2x2))));
+    }
+
+    size_t loaded = 0;
+    for (int i = 0; i < 5000 && loaded < textures.size(); ++i) {
+        if (!window.needsDisplay()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        application.renderFrame(&window);
+        auto previouslyLoaded = loaded;
+        loaded = std::count_if(textures.begin(), textures.end(), [](auto& texture) { return texture.isLoaded(); });
+        EXPECT_LE(loaded, previouslyLoaded + 1);
+    }
+
+    EXPECT_EQ(loaded, textures.size());
+    EXPECT_EQ(window.pendingTextureUploads(), 0);
+    EXPECT_FALSE(window.hasPendingTextures());
+    EXPECT_EQ(textures[0]->width(), 2);
+}
+
+TEST(Window, failedTextureDecode) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    okui::Window window(&application);
+    window.setSize(40, 30);
+    window.open();
+
+    auto entries = window.textureCache()->size();
+    auto texture = window.loadTextureFromMemory(std::make_shared<std::string>("not an image"));
+    EXPECT_EQ(window.textureCache()->size(), entries + 1);
+
+    for (int i = 0; i < 5000 && window.hasPendingTextures(); ++i) {
+        application.renderFrame(&window);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // the texture will never use any memory, so it shouldn't be left in the cache
+    EXPECT_FALSE(window.hasPendingTextures());
+    EXPECT_FALSE(texture.isLoaded());
+    EXPECT_EQ(window.textureCache()->size(), entries);
+}
+
+TEST(Window, textureUploadStaging) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    if (!okui::opengl::TextureUploadBuffer::IsSupported()) { return; }
+
+    okui::Window window(&application);
+    window.setSize(40, 30);
+    window.setRendersOnDemand();
+    window.setPacksTextures(false);
+    window.open();
+    EXPECT_TRUE(window.stagesTextureUploads());
+
+    auto texture = window.loadTextureFromMemory(std::make_shared<std::string>(reinterpret_cast<const char*>(png2x2), sizeof(png2x2)));
+
+    // the texture should be staged in one frame and finish loading in the next
+    bool wasStaged = false;
+    for (int i = 0; i < 5000 && !texture.isLoaded(); ++i) {
+        if (!window.needsDisplay()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        application.renderFrame(&window);
+        if (!texture.isLoaded() && window.pendingTextureUploads()) {
+            wasStaged = true;
+            EXPECT_TRUE(window.needsDisplay());
+        }
+    }
+
+    EXPECT_TRUE(wasStaged);
+    EXPECT_TRUE(texture.isLoaded());
+    EXPECT_EQ(window.pendingTextureUploads(), 0);
+    EXPECT_EQ(texture->width(), 2);
+}
 #endif
@@ -0,0 +1,155 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/applications/Headless.h>
+
+#if ONAIR_OKUI_HAS_HEADLESS_APPLICATION
+
+#include <okui/View.h>
+#include <okui/Window.h>
+
+#include <gtest/gtest.h>
+
+using namespace okui;
+using namespace std::literals;
+
+namespace {
+
+struct HeadlessApplication : applications::Headless {
+    virtual std::string name() const override { return "Headless Test"; }
+    virtual std::string organization() const override { return "BitTorrent Inc."; }
+};
+
+} // anonymous namespace
+
+TEST(Headless, render) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    Window window(&application);
+    window.setSize(40, 30);
+
+    View view;
+    view.setBackgroundColor(Color::kRed);
+    view.setBounds(0, 0, 20, 30);
+    window.contentView()->setBackgroundColor(Color::kBlue);
+    window.contentView()->addSubview(&view);
+    window.open();
+
+    application.renderFrame(&window);
+
+    auto pixels = application.readPixels(&window);
+    ASSERT_EQ(pixels.size(), 40 * 30 * 4);
+
+    auto pixel = [&](int x, int y) {
+        auto p = &pixels[(y * 40 + x) * 4];
+        return std::vector<int>{p[0], p[1], p[2], p[3]};
+    };
+    EXPECT_EQ(pixel(5, 5), (std::vector<int>{255, 0, 0, 255}));
+    EXPECT_EQ(pixel(35, 25), (std::vector<int>{0, 0, 255, 255}));
+
+    window.setSize(20, 10);
+    application.renderFrame(&window);
+    EXPECT_EQ(application.readPixels(&window).size(), 20 * 10 * 4);
+}
+
+TEST(Headless, clock) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    auto start = application.now();
+    std::this_thread::sleep_for(5ms);
+    EXPECT_EQ(application.now(), start);
+    application.advance(1s);
+    EXPECT_EQ(application.now(), start + 1s);
+
+    Window window(&application);
+    window.setSize(10, 10);
+
+    std::vector<std::chrono::steady_clock::time_point> times;
+    View view;
+    view.addUpdateHook("test", [&](auto time) { times.emplace_back(time); });
+    window.contentView()->addSubview(&view);
+    window.open();
+
+    for (int i = 0; i < 3; ++i) {
+        application.renderFrame(&window);
+        application.advance(window.framePacer().frameInterval());
+    }
+
+    ASSERT_EQ(times.size(), 3);
+    EXPECT_EQ(times[1] - times[0], window.framePacer().frameInterval());
+    EXPECT_EQ(times[2] - times[1], window.framePacer().frameInterval());
+}
+
+TEST(Headless, input) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    struct InputView : View {
+        virtual void mouseDown(MouseButton button, double x, double y) override { ++mouseDowns; }
+        virtual void mouseUp(MouseButton button, double startX, double startY, double x, double y) override { ++mouseUps; }
+        virtual void keyDown(KeyCode key, KeyModifiers modifiers, bool repeat) override { keys.emplace_back(key); }
+        virtual bool canBecomeDirectFocus() override { return true; }
+
+        int mouseDowns = 0;
+        int mouseUps = 0;
+        std::vector<KeyCode> keys;
+    } view;
+
+    Window window(&application);
+    window.setSize(100, 100);
+    view.setBounds(10, 10, 20, 20);
+    window.contentView()->addSubview(&view);
+    window.open();
+    view.focus();
+
+    application.click(&window, MouseButton::kLeft, 15, 15);
+    application.click(&window, MouseButton::kLeft, 50, 50);
+    EXPECT_EQ(view.mouseDowns, 1);
+    EXPECT_EQ(view.mouseUps, 1);
+
+    application.keyDown(&window, KeyCode::kA);
+    EXPECT_EQ(view.keys, std::vector<KeyCode>{KeyCode::kA});
+}
+
+TEST(Headless, run) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    Window window(&application);
+    window.setSize(10, 10);
+    window.open();
+
+    struct CountingView : View {
+        virtual void render() override {
+            if (++renders == 5) {
+                application()->quit();
+            }
+        }
+        int renders = 0;
+    } view;
+    view.setBounds(0, 0, 10, 10);
+    window.contentView()->addSubview(&view);
+
+    auto start = application.now();
+    application.run();
+
+    EXPECT_EQ(view.renders, 5);
+    // frames are rendered as fast as possible, but the clock still advances by a frame interval per frame
+    EXPECT_EQ(application.now() - start, window.framePacer().frameInterval() * 4);
+}
+
+#endif // ONAIR_OKUI_HAS_HEADLESS_APPLICATION
@@ -39,7 +39,7 @@ TEST(ml_Context, load) {
 
     EXPECT_EQ(view->backgroundColor(), okui::Color::kGreen);
     EXPECT_EQ(view->subviews().size(), 1);
-    view->layout();
+    view->layoutIfNeeded();
     EXPECT_EQ(view->subviews().front()->bounds(), okui::Rectangle<double>(20, 20, 200, 40));
     EXPECT_EQ(view->subviews().front()->backgroundColor(), okui::Color::kBlue);
 }
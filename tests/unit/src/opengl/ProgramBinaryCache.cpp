@@ -0,0 +1,292 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/applications/Headless.h>
+
+#if ONAIR_OKUI_HAS_HEADLESS_APPLICATION
+
+#include <okui/View.h>
+#include <okui/Window.h>
+#include <okui/opengl/ProgramBinaryCache.h>
+#include <okui/opengl/ShaderProgram.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+
+using namespace okui;
+using namespace okui::opengl;
+
+namespace {
+
+struct HeadlessApplication : applications::Headless {
+    virtual std::string name() const override { return "ProgramBinaryCache Test"; }
+    virtual std::string organization() const override { return "BitTorrent Inc."; }
+};
+
+bool Link(ProgramBinaryCache* cache, const std::string& alpha = "1.0") {
+    cache->begin();
+    ShaderProgram program;
+    program.bindAttribute(0, "positionAttrib");
+    program.link(scraps::opengl::CommonVertexShaderHeader() + R"(
+        ATTRIBUTE_IN vec2 positionAttrib;
+        void main() {
+            gl_Position = vec4(positionAttrib, 0.0, 1.0);
+        }
+    )", scraps::opengl::CommonFragmentShaderHeader() + R"(
+        uniform vec4 color;
+        void main() {
+            COLOR_OUT = vec4(color.rgb, color.a * )" + alpha + R"();
+        }
+    )");
+    cache->end();
+    return program.error().empty() && glGetUniformLocation(program.id(), "color") >= 0;
+}
+
+} // anonymous namespace
+
+TEST(ProgramBinaryCache, persistence) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    if (!ProgramBinaryCache::IsSupported()) { return; }
+
+    auto path = application.userStoragePath() + "ProgramBinaryCacheTest.cache";
+    std::remove(path.c_str());
+
+    {
+        ProgramBinaryCache cache{path};
+        EXPECT_TRUE(Link(&cache));
+        EXPECT_EQ(cache.statistics().misses, 1);
+        EXPECT_EQ(cache.statistics().stores, 1);
+    }
+
+    {
+        ProgramBinaryCache cache{path};
+        EXPECT_TRUE(Link(&cache));
+        EXPECT_EQ(cache.statistics().hits, 1);
+        EXPECT_EQ(cache.statistics().stores, 0);
+    }
+
+    // binaries that the driver rejects should be replaced by ones compiled from source
+    {
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(-16, std::ios::end);
+        for (int i = 0; i < 16; ++i) {
+            f.put('x');
+        }
+    }
+
+    {
+        ProgramBinaryCache cache{path};
+        EXPECT_TRUE(Link(&cache));
+        EXPECT_EQ(cache.statistics().hits + cache.statistics().rejections, 1);
+    }
+
+    {
+        ProgramBinaryCache cache{path};
+        EXPECT_TRUE(Link(&cache));
+        EXPECT_EQ(cache.statistics().hits, 1);
+    }
+
+    // unrecognized files should be discarded
+    {
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        f << "garbage";
+    }
+
+    {
+        ProgramBinaryCache cache{path};
+        EXPECT_TRUE(Link(&cache));
+        EXPECT_EQ(cache.statistics().misses, 1);
+    }
+
+    {
+        ProgramBinaryCache cache{path};
+        EXPECT_TRUE(Link(&cache));
+        EXPECT_EQ(cache.statistics().hits, 1);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(ProgramBinaryCache, keys) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    if (!ProgramBinaryCache::IsSupported()) { return; }
+
+    auto path = application.userStoragePath() + "ProgramBinaryCacheKeysTest.cache";
+    std::remove(path.c_str());
+
+    {
+        ProgramBinaryCache cache{path};
+        EXPECT_TRUE(Link(&cache));
+        EXPECT_EQ(cache.statistics().stores, 1);
+    }
+
+    // only the exact key that was stored may load the binary
+    {
+        ProgramBinaryCache cache{path};
+        auto program = glCreateProgram();
+        EXPECT_FALSE(cache.load(program, ""));
+        EXPECT_FALSE(cache.load(program, "positionAttrib"));
+        glDeleteProgram(program);
+        EXPECT_EQ(cache.statistics().misses, 2);
+        EXPECT_EQ(cache.statistics().rejections, 0);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(ProgramBinaryCache, corruption) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    if (!ProgramBinaryCache::IsSupported()) { return; }
+
+    auto path = application.userStoragePath() + "ProgramBinaryCacheCorruptionTest.cache";
+
+    // the file starts with the magic, version, and driver, followed by the entry count and the first entry's key
+    // length. the key is followed by the binary's format and length
+    auto corrupt = [&](bool binaryLength) {
+        std::remove(path.c_str());
+        {
+            ProgramBinaryCache cache{path};
+            EXPECT_TRUE(Link(&cache));
+        }
+
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        uint32_t driverLength = 0, keyLength = 0;
+        f.seekg(8);
+        f.read(reinterpret_cast<char*>(&driverLength), sizeof(driverLength));
+        std::streamoff offset = 12 + driverLength + 4;
+        if (binaryLength) {
+            f.seekg(offset);
+            f.read(reinterpret_cast<char*>(&keyLength), sizeof(keyLength));
+            offset += 4 + keyLength + 4;
+        }
+        uint32_t length = 0xffffffff;
+        f.seekp(offset);
+        f.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    };
+
+    // lengths that don't fit in the file should make the cache start over rather than attempt huge allocations
+    for (auto binaryLength : {false, true}) {
+        corrupt(binaryLength);
+        {
+            ProgramBinaryCache cache{path};
+            EXPECT_TRUE(Link(&cache));
+            EXPECT_EQ(cache.statistics().misses, 1);
+            EXPECT_EQ(cache.size(), 1);
+        }
+        {
+            ProgramBinaryCache cache{path};
+            EXPECT_TRUE(Link(&cache));
+            EXPECT_EQ(cache.statistics().hits, 1);
+        }
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(ProgramBinaryCache, maximumEntries) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    if (!ProgramBinaryCache::IsSupported()) { return; }
+
+    auto path = application.userStoragePath() + "ProgramBinaryCacheMaximumEntriesTest.cache";
+    std::remove(path.c_str());
+
+    {
+        ProgramBinaryCache cache{path};
+        cache.setMaximumEntries(2);
+        EXPECT_TRUE(Link(&cache, "0.25"));
+        EXPECT_TRUE(Link(&cache, "0.5"));
+        EXPECT_TRUE(Link(&cache, "0.75"));
+        EXPECT_EQ(cache.statistics().stores, 3);
+        EXPECT_EQ(cache.size(), 2);
+    }
+
+    // the least recently used program should have been dropped
+    {
+        ProgramBinaryCache cache{path};
+        cache.setMaximumEntries(2);
+        EXPECT_TRUE(Link(&cache, "0.75"));
+        EXPECT_TRUE(Link(&cache, "0.25"));
+        EXPECT_EQ(cache.statistics().hits, 1);
+        EXPECT_EQ(cache.statistics().misses, 1);
+        EXPECT_EQ(cache.size(), 2);
+    }
+
+    // using a program keeps it around
+    {
+        ProgramBinaryCache cache{path};
+        cache.setMaximumEntries(2);
+        EXPECT_TRUE(Link(&cache, "0.75"));
+        EXPECT_TRUE(Link(&cache, "0.25"));
+        EXPECT_EQ(cache.statistics().hits, 2);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(ProgramBinaryCache, window) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    if (!ProgramBinaryCache::IsSupported()) { return; }
+
+    auto path = application.userStoragePath() + "program-binaries.cache";
+    std::remove(path.c_str());
+
+    auto render = [&] (bool cachesProgramBinaries, size_t* hits = nullptr) {
+        Window window(&application);
+        window.setSize(40, 30);
+        window.setCachesProgramBinaries(cachesProgramBinaries);
+
+        View view;
+        view.setBackgroundColor(Color::kRed);
+        view.setBounds(0, 0, 20, 30);
+        window.contentView()->setBackgroundColor(Color::kBlue);
+        window.contentView()->addSubview(&view);
+        window.open();
+
+        application.renderFrame(&window);
+
+        EXPECT_EQ(window.programBinaryCache() != nullptr, cachesProgramBinaries);
+        if (hits && window.programBinaryCache()) {
+            *hits = window.programBinaryCache()->statistics().hits;
+        }
+
+        return application.readPixels(&window);
+    };
+
+    size_t hits = 0;
+    auto uncached = render(false);
+    auto first = render(true, &hits);
+    EXPECT_EQ(hits, 0);
+    auto second = render(true, &hits);
+    EXPECT_GT(hits, 0);
+
+    EXPECT_EQ(first, uncached);
+    EXPECT_EQ(second, uncached);
+
+    std::remove(path.c_str());
+}
+
+#endif // ONAIR_OKUI_HAS_HEADLESS_APPLICATION
@@ -0,0 +1,157 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/applications/Headless.h>
+
+#if ONAIR_OKUI_HAS_HEADLESS_APPLICATION
+
+#include <okui/View.h>
+#include <okui/Window.h>
+#include <okui/opengl/StreamingVertexBuffer.h>
+
+#include <gtest/gtest.h>
+
+using namespace okui;
+using namespace okui::opengl;
+
+namespace {
+
+struct HeadlessApplication : applications::Headless {
+    virtual std::string name() const override { return "StreamingVertexBuffer Test"; }
+    virtual std::string organization() const override { return "BitTorrent Inc."; }
+};
+
+struct Vertex {
+    GLfloat x, y, z;
+};
+
+std::vector<StreamingVertexBuffer::Mode> SupportedModes() {
+    std::vector<StreamingVertexBuffer::Mode> modes;
+    for (auto mode : {StreamingVertexBuffer::Mode::kPersistent, StreamingVertexBuffer::Mode::kUnsynchronized, StreamingVertexBuffer::Mode::kOrphaning}) {
+        if (StreamingVertexBuffer::IsSupported(mode)) {
+            modes.emplace_back(mode);
+        }
+    }
+    return modes;
+}
+
+} // anonymous namespace
+
+TEST(StreamingVertexBuffer, write) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    for (auto mode : SupportedModes()) {
+        // room for 5 vertices per segment, with 4 bytes to spare
+        StreamingVertexBuffer buffer{64 * StreamingVertexBuffer::kSegmentCount, mode};
+        EXPECT_EQ(buffer.mode(), mode);
+        EXPECT_EQ(buffer.capacity(), 64 * StreamingVertexBuffer::kSegmentCount);
+
+        std::vector<Vertex> vertices;
+        for (int i = 0; i < 5; ++i) {
+            vertices.push_back({GLfloat(i), GLfloat(i) * 2, GLfloat(i) * 3});
+        }
+
+        EXPECT_EQ(buffer.write(vertices.data(), 2), 0);
+        EXPECT_EQ(buffer.write(vertices.data(), 3), 2);
+        EXPECT_EQ(buffer.write(vertices.data(), 5), 5);
+        EXPECT_FALSE(buffer.write(vertices.data(), 6));
+
+#if !OPENGL_ES
+        std::vector<Vertex> contents(10);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.buffer());
+        glGetBufferSubData(GL_ARRAY_BUFFER, 0, contents.size() * sizeof(Vertex), contents.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        EXPECT_EQ(contents[1].y, 2.0f);
+        EXPECT_EQ(contents[4].z, 6.0f);
+        EXPECT_EQ(contents[9].x, 4.0f);
+#endif
+
+        // fill the ring and make sure it wraps back around to the start
+        size_t wraps = 0;
+        for (int i = 0; i < 20; ++i) {
+            auto first = buffer.write(vertices.data(), 5);
+            ASSERT_TRUE(first);
+            EXPECT_LE((*first + 5) * sizeof(Vertex), buffer.capacity());
+            if (*first == 0) {
+                ++wraps;
+            }
+        }
+        EXPECT_EQ(buffer.statistics().wraps, wraps);
+        EXPECT_GT(wraps, 0);
+    }
+}
+
+TEST(StreamingVertexBuffer, current) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    EXPECT_EQ(StreamingVertexBuffer::Current(), nullptr);
+    {
+        StreamingVertexBuffer buffer;
+        buffer.begin();
+        EXPECT_EQ(StreamingVertexBuffer::Current(), &buffer);
+        buffer.end();
+        EXPECT_EQ(StreamingVertexBuffer::Current(), nullptr);
+        buffer.begin();
+    }
+    EXPECT_EQ(StreamingVertexBuffer::Current(), nullptr);
+}
+
+TEST(StreamingVertexBuffer, generation) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    uint64_t previous = 0;
+    for (int i = 0; i < 3; ++i) {
+        // the buffer names may be reused, but the generations must not be
+        StreamingVertexBuffer buffer{64 * StreamingVertexBuffer::kSegmentCount};
+        EXPECT_GT(buffer.generation(), previous);
+        previous = buffer.generation();
+    }
+}
+
+TEST(StreamingVertexBuffer, window) {
+    HeadlessApplication application;
+    ASSERT_TRUE(application.isValid());
+
+    Window window(&application);
+    window.setSize(40, 30);
+    window.setBatchesDraws(false);
+
+    View a, b;
+    a.setBackgroundColor(Color::kRed);
+    a.setBounds(0, 0, 20, 30);
+    b.setBackgroundColor(Color::kGreen);
+    b.setBounds(20, 10, 20, 20);
+    window.contentView()->setBackgroundColor(Color::kBlue);
+    window.contentView()->addSubview(&a);
+    window.contentView()->addSubview(&b);
+    window.open();
+
+    EXPECT_TRUE(window.streamsVertices());
+
+    // draw a few frames so that the ring is reused across them
+    for (int i = 0; i < 3; ++i) {
+        application.renderFrame(&window);
+    }
+    auto streamed = application.readPixels(&window);
+
+    window.setStreamsVertices(false);
+    application.renderFrame(&window);
+    EXPECT_EQ(application.readPixels(&window), streamed);
+}
+
+#endif // ONAIR_OKUI_HAS_HEADLESS_APPLICATION
@@ -0,0 +1,65 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <okui/opengl/TextureCompression.h>
+
+#include <gtest/gtest.h>
+
+using namespace okui::opengl;
+
+TEST(TextureCompression, size) {
+    EXPECT_EQ(CompressedTextureSize(kCompressedRGB8ETC2, 4, 4), 8);
+    EXPECT_EQ(CompressedTextureSize(kCompressedRGB8ETC2, 5, 1), 16);
+    EXPECT_EQ(CompressedTextureSize(kCompressedRGBA8ETC2EAC, 8, 8), 64);
+    EXPECT_EQ(CompressedTextureSize(kCompressedRGBAS3TCDXT1, 1, 1), 8);
+    EXPECT_EQ(CompressedTextureSize(GL_RGBA, 4, 4), 0);
+}
+
+TEST(TextureCompression, decompressETC) {
+    // individual mode with bases of 0x88 and 0x44, tables 0 and 1, and the top-left pixel using the largest negative
+    // modifier
+    const uint8_t block[8] = {0x84, 0x84, 0x84, 0x04, 0x00, 0x01, 0x00, 0x01};
+
+    uint8_t pixels[4 * 4 * 4];
+    ASSERT_TRUE(DecompressTexture(kCompressedRGB8ETC2, block, sizeof(block), 4, 4, pixels));
+
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            auto pixel = pixels + (y * 4 + x) * 4;
+            auto expected = x == 0 && y == 0 ? 0x88 - 8 : x < 2 ? 0x88 + 2 : 0x44 + 5;
+            EXPECT_EQ(pixel[0], expected);
+            EXPECT_EQ(pixel[1], expected);
+            EXPECT_EQ(pixel[2], expected);
+            EXPECT_EQ(pixel[3], 255);
+        }
+    }
+}
+
+TEST(TextureCompression, decompressS3TC) {
+    // white and black endpoints with the first row stepping through each of the four colors
+    const uint8_t block[8] = {0xff, 0xff, 0x00, 0x00, 0xe4, 0x00, 0x00, 0x00};
+
+    // edge blocks are clipped to the texture
+    uint8_t pixels[3 * 2 * 4];
+    ASSERT_TRUE(DecompressTexture(kCompressedRGBS3TCDXT1, block, sizeof(block), 3, 2, pixels));
+
+    const uint8_t expected[] = {255, 0, 170, 255, 255, 255};
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_EQ(pixels[i * 4], expected[i]);
+        EXPECT_EQ(pixels[i * 4 + 3], 255);
+    }
+
+    EXPECT_FALSE(DecompressTexture(kCompressedRGBS3TCDXT1, block, sizeof(block) - 1, 3, 2, pixels));
+}
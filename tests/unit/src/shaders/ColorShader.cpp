@@ -79,4 +79,34 @@ TEST(ColorShader, gradient) {
     });
 }
 
+TEST(ColorShader, quads) {
+    RenderOnce([&] (View* view) {
+        TestFramebuffer framebuffer(320, 200);
+
+        auto shader = view->colorShader();
+        shader->setColor(Color::kWhite);
+        shader->setTransformation(framebuffer.transformation());
+
+        std::vector<Shader::Quad> quads(2);
+        quads[0].x = 2;
+        quads[0].y = 13;
+        quads[0].width = 11;
+        quads[0].height = 123;
+        quads[1].x = 100;
+        quads[1].y = 50;
+        quads[1].width = 40;
+        quads[1].height = 20;
+        shader->drawQuads(quads);
+        shader->flush();
+
+        framebuffer.finish();
+
+        auto a = Rectangle<double>(2, 13, 11, 123);
+        auto b = Rectangle<double>(100, 50, 40, 20);
+        framebuffer.iteratePixels([&](int x, int y, Color pixel) {
+            EXPECT_EQ(pixel, a.contains(x, y) || b.contains(x, y) ? Color::kWhite : Color::kBlack);
+        });
+    });
+}
+
 #endif // ONAIR_OKUI_HAS_NATIVE_APPLICATION
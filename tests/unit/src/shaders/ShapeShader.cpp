@@ -0,0 +1,102 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "../RenderOnce.h"
+#include "../TestFramebuffer.h"
+
+#include <okui/BatchRenderer.h>
+#include <okui/shaders/ShapeShader.h>
+#include <okui/shapes/Rectangle.h>
+
+#include <gtest/gtest.h>
+
+#if ONAIR_OKUI_HAS_NATIVE_APPLICATION && !OPENGL_ES // TODO: fix for OpenGL ES
+
+using namespace okui;
+
+TEST(ShapeShader, roundedRectangle) {
+    RenderOnce([&] (View* view) {
+        TestFramebuffer framebuffer(320, 200);
+
+        auto shader = view->shapeShader();
+        shader->setTransformation(framebuffer.transformation());
+
+        shaders::ShapeShader::Shape shape{{10, 20, 200, 100}, Color::kRed};
+        shape.radii = {40, 0, 0, 0};
+        shape.borderWidth = 5;
+        shape.borderColor = Color::kBlue;
+        shader->draw(shape);
+        shader->flush();
+
+        framebuffer.finish();
+
+        EXPECT_EQ(framebuffer.getPixel(110, 70), Color::kRed);
+        EXPECT_EQ(framebuffer.getPixel(12, 70), Color::kBlue);
+        EXPECT_EQ(framebuffer.getPixel(110, 118), Color::kBlue);
+        EXPECT_EQ(framebuffer.getPixel(5, 70), Color::kBlack);
+        EXPECT_EQ(framebuffer.getPixel(110, 125), Color::kBlack);
+
+        // only the min-min corner is rounded
+        EXPECT_EQ(framebuffer.getPixel(12, 22), Color::kBlack);
+        EXPECT_EQ(framebuffer.getPixel(208, 22), Color::kBlue);
+        EXPECT_EQ(framebuffer.getPixel(208, 118), Color::kBlue);
+        EXPECT_EQ(framebuffer.getPixel(12, 118), Color::kBlue);
+    });
+}
+
+TEST(ShapeShader, batching) {
+    RenderOnce([&] (View* view) {
+        TestFramebuffer framebuffer(320, 200);
+
+        BatchRenderer batch;
+        batch.setEnabled();
+        batch.begin(320, 200);
+
+        auto shader = view->shapeShader();
+        shader->setTransformation(framebuffer.transformation());
+
+        // shapes flushed separately, even with different scissors, should be drawn together
+        for (int i = 0; i < 10; ++i) {
+            batch.setScissor(i % 2 ? stdts::nullopt : stdts::make_optional(Rectangle<int>{0, 100, 320, 100}));
+            shaders::ShapeShader::Shape shape{{i * 30.0, 0, 20, 200}, Color::kWhite};
+            shape.radii = 5;
+            shader->draw(shape);
+            shader->flush();
+        }
+
+        auto colorShader = view->colorShader();
+        colorShader->setColor(Color::kRed);
+        colorShader->setTransformation(framebuffer.transformation());
+        shapes::Rectangle(0, 90, 320, 20).draw(colorShader);
+        colorShader->flush();
+
+        batch.end();
+
+        EXPECT_EQ(batch.statistics().drawCalls, 2);
+
+        framebuffer.finish();
+
+        // the even shapes are clipped to the top 100 rows
+        EXPECT_EQ(framebuffer.getPixel(10, 50), Color::kWhite);
+        EXPECT_EQ(framebuffer.getPixel(10, 150), Color::kBlack);
+        EXPECT_EQ(framebuffer.getPixel(40, 150), Color::kWhite);
+        EXPECT_EQ(framebuffer.getPixel(25, 50), Color::kBlack);
+
+        // the color shader's draw has to come after the shapes
+        EXPECT_EQ(framebuffer.getPixel(10, 100), Color::kRed);
+    });
+}
+
+#endif // ONAIR_OKUI_HAS_NATIVE_APPLICATION
@@ -185,4 +185,46 @@ TEST(TextureShader, color) {
     });
 }
 
+TEST(TextureShader, quads) {
+    std::shared_ptr<TextureInterface> texture;
+
+    RenderOnce([&](View* view) {
+        texture = view->loadTextureFromMemory(std::make_shared<std::string>((const char*)kImageData, sizeof(kImageData)));
+        EXPECT_NE(texture, nullptr);
+    },
+    [&](View* view) {
+        EXPECT_TRUE(texture->isLoaded());
+
+        TestFramebuffer framebuffer(320, 200);
+
+        auto shader = view->textureShader();
+        shader->setTransformation(framebuffer.transformation());
+
+        // the quad should look exactly like the texture drawn the usual way
+        shader->drawScaledFit(*texture, 20, 20, 100, 100);
+
+        Shader::Quad quad;
+        quad.x = 160;
+        quad.y = 20;
+        quad.width = 100;
+        quad.height = 100;
+        shader->setTexture(*texture);
+        shader->drawQuads(&quad, 1);
+
+        shader->flush();
+
+        framebuffer.finish();
+
+        for (int y = 20; y < 120; y += 7) {
+            for (int x = 20; x < 120; x += 7) {
+                auto expected = framebuffer.getPixel(x, y);
+                auto pixel = framebuffer.getPixel(x + 140, y);
+                EXPECT_NEAR(pixel.redF(), expected.redF(), 0.02);
+                EXPECT_NEAR(pixel.greenF(), expected.greenF(), 0.02);
+                EXPECT_NEAR(pixel.blueF(), expected.blueF(), 0.02);
+            }
+        }
+    });
+}
+
 #endif // ONAIR_OKUI_HAS_NATIVE_APPLICATION
@@ -0,0 +1,203 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "../TestApplication.h"
+
+#include <okui/views/CollectionView.h>
+
+#include <gtest/gtest.h>
+
+using namespace okui;
+using namespace okui::views;
+
+namespace {
+
+struct TestCell : View {
+    virtual bool canBecomeDirectFocus() override { return true; }
+
+    std::string kind;
+    size_t      item = 0;
+};
+
+struct TestDataSource : CollectionView::DataSource {
+    explicit TestDataSource(size_t count) : count{count} {}
+
+    virtual size_t numberOfItems(CollectionView* collectionView) override { return count; }
+
+    virtual View* cellForItem(CollectionView* collectionView, size_t index) override {
+        auto kind = (index % 2) ? "odd" : "even";
+        auto cell = dynamic_cast<TestCell*>(collectionView->dequeueCell(kind));
+        EXPECT_EQ(cell->kind, kind);
+        cell->item = index;
+        return cell;
+    }
+
+    size_t count;
+};
+
+void RegisterCells(CollectionView* collectionView, int* created) {
+    for (auto kind : {"even", "odd"}) {
+        collectionView->registerCell(kind, [=] {
+            ++*created;
+            auto cell = std::make_unique<TestCell>();
+            cell->kind = kind;
+            return cell;
+        });
+    }
+}
+
+} // anonymous namespace
+
+TEST(CollectionView, vertical) {
+    int created = 0;
+    TestDataSource dataSource{10000};
+    CollectionView collectionView;
+    collectionView.setBounds(0, 0, 200, 500);
+    collectionView.setItemSize(100, 50);
+    RegisterCells(&collectionView, &created);
+    collectionView.setDataSource(&dataSource);
+
+    EXPECT_EQ(collectionView.cellCount(), 10);
+    EXPECT_EQ(created, 10);
+    EXPECT_EQ(collectionView.contentSize(), Point<double>(200, 500000));
+
+    auto cell = collectionView.cell(3);
+    ASSERT_NE(cell, nullptr);
+    EXPECT_EQ(dynamic_cast<TestCell*>(cell)->item, 3);
+    EXPECT_EQ(cell->bounds(), Rectangle<double>(0, 150, 200, 50));
+    EXPECT_EQ(collectionView.item(cell), 3);
+
+    collectionView.scrollToItem(100);
+    EXPECT_EQ(collectionView.contentOffset(), Point<double>(0, -4550));
+    EXPECT_EQ(collectionView.cellCount(), 10);
+    EXPECT_EQ(created, 10);
+    EXPECT_EQ(collectionView.cell(0), nullptr);
+    ASSERT_NE(collectionView.cell(100), nullptr);
+    EXPECT_EQ(dynamic_cast<TestCell*>(collectionView.cell(100))->item, 100);
+    EXPECT_EQ(collectionView.cell(100)->bounds(), Rectangle<double>(0, 5000, 200, 50));
+
+    dataSource.count = 5;
+    collectionView.reloadData();
+    EXPECT_EQ(collectionView.cellCount(), 5);
+    EXPECT_EQ(collectionView.contentSize(), Point<double>(200, 250));
+}
+
+TEST(CollectionView, horizontal) {
+    int created = 0;
+    TestDataSource dataSource{100};
+    CollectionView collectionView;
+    collectionView.setBounds(0, 0, 300, 100);
+    collectionView.setItemLayout(CollectionView::Layout::kHorizontal);
+    collectionView.setItemSize(100, 50);
+    collectionView.setOverscan(100);
+    RegisterCells(&collectionView, &created);
+    collectionView.setDataSource(&dataSource);
+
+    EXPECT_EQ(collectionView.cellCount(), 4);
+    ASSERT_NE(collectionView.cell(3), nullptr);
+    EXPECT_EQ(collectionView.cell(3)->bounds(), Rectangle<double>(300, 0, 100, 100));
+}
+
+TEST(CollectionView, grid) {
+    int created = 0;
+    TestDataSource dataSource{100};
+    CollectionView collectionView;
+    collectionView.setBounds(0, 0, 350, 200);
+    collectionView.setItemLayout(CollectionView::Layout::kGrid);
+    collectionView.setItemSize(100, 100);
+    collectionView.setSpacing(10);
+    RegisterCells(&collectionView, &created);
+    collectionView.setDataSource(&dataSource);
+
+    EXPECT_EQ(collectionView.cellCount(), 6);
+    EXPECT_EQ(collectionView.itemFrame(4), Rectangle<double>(110, 110, 100, 100));
+    EXPECT_EQ(collectionView.contentSize(), Point<double>(320, 3730));
+
+    collectionView.setBounds(0, 0, 470, 200);
+    collectionView.layoutIfNeeded();
+    EXPECT_EQ(collectionView.cellCount(), 8);
+    EXPECT_EQ(collectionView.itemFrame(4), Rectangle<double>(0, 110, 100, 100));
+}
+
+#if ONAIR_OKUI_HAS_NATIVE_APPLICATION
+
+TEST(CollectionView, moveFocus) {
+    TestApplication application;
+    okui::Window window(&application);
+    window.open();
+
+    int created = 0;
+    TestDataSource dataSource{1000};
+    CollectionView collectionView;
+    collectionView.setBounds(0, 0, 100, 100);
+    collectionView.setItemSize(100, 50);
+    RegisterCells(&collectionView, &created);
+    collectionView.setDataSource(&dataSource);
+    window.contentView()->addSubview(&collectionView);
+
+    collectionView.cell(0)->focus();
+    for (size_t i = 1; i <= 20; ++i) {
+        EXPECT_TRUE(window.moveFocus(Direction::kDown));
+        EXPECT_EQ(collectionView.item(window.focus()), i);
+    }
+    EXPECT_LE(collectionView.cellCount(), 3);
+
+    for (size_t i = 20; i > 0; --i) {
+        EXPECT_TRUE(window.moveFocus(Direction::kUp));
+        EXPECT_EQ(collectionView.item(window.focus()), i - 1);
+    }
+
+    window.contentView()->removeSubview(&collectionView);
+}
+
+TEST(CollectionView, focusedSubviewKeepsCell) {
+    TestApplication application;
+    okui::Window window(&application);
+    window.open();
+
+    int created = 0;
+    TestDataSource dataSource{1000};
+    CollectionView collectionView;
+    collectionView.setBounds(0, 0, 100, 100);
+    collectionView.setItemSize(100, 50);
+    RegisterCells(&collectionView, &created);
+    collectionView.setDataSource(&dataSource);
+    window.contentView()->addSubview(&collectionView);
+
+    auto cell = collectionView.cell(0);
+    ASSERT_NE(cell, nullptr);
+    TestCell child;
+    cell->addSubview(&child);
+    child.focus();
+
+    // the cell is scrolled out of view, but it contains focus, so it shouldn't be recycled
+    collectionView.scrollToItem(100);
+    EXPECT_EQ(collectionView.cell(0), cell);
+    EXPECT_TRUE(child.isFocus());
+    EXPECT_EQ(collectionView.item(window.focus()), 0);
+    for (size_t i = 99; i <= 101; ++i) {
+        ASSERT_NE(collectionView.cell(i), nullptr);
+        EXPECT_NE(collectionView.cell(i), cell);
+    }
+
+    child.unfocus();
+    collectionView.scrolled();
+    EXPECT_EQ(collectionView.cell(0), nullptr);
+
+    cell->removeSubview(&child);
+    window.contentView()->removeSubview(&collectionView);
+}
+
+#endif // ONAIR_OKUI_HAS_NATIVE_APPLICATION
@@ -0,0 +1,56 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "../TestApplication.h"
+
+#include <okui/views/ImageView.h>
+
+#include <gtest/gtest.h>
+
+using namespace okui;
+using namespace okui::views;
+
+#if ONAIR_OKUI_HAS_NATIVE_APPLICATION
+
+TEST(ImageView, resizeWithinBucket) {
+    TestApplication application;
+    okui::Window window(&application);
+    window.setSize(200, 200);
+    window.open();
+
+    ImageView view;
+    view.setBounds(0, 0, 17, 17);
+    window.contentView()->addSubview(&view);
+    view.setTexture("PlayIcon.png");
+    ASSERT_TRUE(view.texture());
+
+    auto cache = window.textureCache();
+    cache->resetStatistics();
+
+    // the new size rounds up to the same bucket, so the texture shouldn't be requested again
+    view.setBounds(0, 0, 20, 20);
+    view.layoutIfNeeded();
+    EXPECT_EQ(cache->statistics().hits, 0);
+    EXPECT_EQ(cache->statistics().misses, 0);
+
+    view.setBounds(0, 0, 40, 40);
+    view.layoutIfNeeded();
+    EXPECT_EQ(cache->statistics().misses, 1);
+    EXPECT_TRUE(view.texture());
+
+    window.contentView()->removeSubview(&view);
+}
+
+#endif // ONAIR_OKUI_HAS_NATIVE_APPLICATION
@@ -0,0 +1,473 @@
+/**
+* Copyright 2017 BitTorrent Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+///usr/bin/env go run $0 $@ ; exit
+package main
+
+import (
+    "bytes"
+    "encoding/binary"
+    "flag"
+    "image"
+    "image/color"
+    _ "image/jpeg"
+    _ "image/png"
+    "io/ioutil"
+    "log"
+    "os"
+    "path/filepath"
+    "strings"
+)
+
+const (
+    glRGB                    = 0x1907
+    glRGBA                   = 0x1908
+    glCompressedRGB8ETC2     = 0x9274
+    glCompressedRGBA8ETC2EAC = 0x9278
+)
+
+var etcModifiers = [8][2]int{{2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}}
+
+var eacModifiers = [16][8]int{
+    {-3, -6,  -9, -15, 2, 5, 8, 14},
+    {-3, -7, -10, -13, 2, 6, 9, 12},
+    {-2, -5,  -8, -13, 1, 4, 7, 12},
+    {-2, -4,  -6, -13, 1, 3, 5, 12},
+    {-3, -6,  -8, -12, 2, 5, 7, 11},
+    {-3, -7,  -9, -11, 2, 6, 8, 10},
+    {-4, -7,  -8, -11, 3, 6, 7, 10},
+    {-3, -5,  -8, -11, 2, 4, 7, 10},
+    {-2, -6,  -8, -10, 1, 5, 7,  9},
+    {-2, -5,  -8, -10, 1, 4, 7,  9},
+    {-2, -4,  -8, -10, 1, 3, 7,  9},
+    {-2, -5,  -7, -10, 1, 4, 6,  9},
+    {-3, -4,  -7, -10, 2, 3, 6,  9},
+    {-1, -2,  -3, -10, 0, 1, 2,  9},
+    {-4, -6,  -8,  -9, 3, 5, 7,  8},
+    {-3, -5,  -7,  -9, 2, 4, 6,  8},
+}
+
+// level is a non-premultiplied RGBA image.
+type level struct {
+    width, height int
+    pixels []uint8
+}
+
+func clamp(v int) int {
+    if v < 0 {
+        return 0
+    } else if v > 255 {
+        return 255
+    }
+    return v
+}
+
+func newLevel(img image.Image) *level {
+    bounds := img.Bounds()
+    l := &level{width: bounds.Dx(), height: bounds.Dy()}
+    l.pixels = make([]uint8, l.width * l.height * 4)
+    for y := 0; y < l.height; y++ {
+        for x := 0; x < l.width; x++ {
+            c := color.NRGBAModel.Convert(img.At(bounds.Min.X + x, bounds.Min.Y + y)).(color.NRGBA)
+            copy(l.pixels[(y * l.width + x) * 4:], []uint8{c.R, c.G, c.B, c.A})
+        }
+    }
+    return l
+}
+
+func (l *level) hasAlpha() bool {
+    for i := 3; i < len(l.pixels); i += 4 {
+        if l.pixels[i] != 255 {
+            return true
+        }
+    }
+    return false
+}
+
+// pixel returns the pixel at the given coordinates, clamping them to the edges of the image.
+func (l *level) pixel(x, y int) []uint8 {
+    if x >= l.width {
+        x = l.width - 1
+    }
+    if y >= l.height {
+        y = l.height - 1
+    }
+    i := (y * l.width + x) * 4
+    return l.pixels[i:i + 4]
+}
+
+// downsample halves the image using a box filter. Colors are weighted by alpha so that transparent pixels don't bleed
+// into their neighbors.
+func (l *level) downsample() *level {
+    next := &level{width: max(l.width / 2, 1), height: max(l.height / 2, 1)}
+    next.pixels = make([]uint8, next.width * next.height * 4)
+    for y := 0; y < next.height; y++ {
+        for x := 0; x < next.width; x++ {
+            var sums [4]int
+            for dy := 0; dy < 2; dy++ {
+                for dx := 0; dx < 2; dx++ {
+                    p := l.pixel(x * 2 + dx, y * 2 + dy)
+                    for c := 0; c < 3; c++ {
+                        sums[c] += int(p[c]) * int(p[3])
+                    }
+                    sums[3] += int(p[3])
+                }
+            }
+            out := next.pixels[(y * next.width + x) * 4:]
+            for c := 0; c < 3; c++ {
+                if sums[3] > 0 {
+                    out[c] = uint8((sums[c] + sums[3] / 2) / sums[3])
+                }
+            }
+            out[3] = uint8((sums[3] + 2) / 4)
+        }
+    }
+    return next
+}
+
+func min(a, b int) int {
+    if a < b {
+        return a
+    }
+    return b
+}
+
+func max(a, b int) int {
+    if a > b {
+        return a
+    }
+    return b
+}
+
+func extend4(v int) int { return (v << 4) | v }
+func extend5(v int) int { return (v << 3) | (v >> 2) }
+
+type etcSubblock struct {
+    base [3]int
+    table int
+    indices [8]int
+    error int
+}
+
+// encodeSubblock finds the best table and pixel indices for the given base color.
+func encodeSubblock(pixels [][]uint8, base [3]int) etcSubblock {
+    best := etcSubblock{base: base, error: -1}
+    for table := 0; table < 8; table++ {
+        candidate := etcSubblock{base: base, table: table}
+        for i, p := range pixels {
+            bestIndex, bestError := 0, -1
+            for index := 0; index < 4; index++ {
+                modifier := etcModifiers[table][index & 1]
+                if index & 2 != 0 {
+                    modifier = -modifier
+                }
+                e := 0
+                for c := 0; c < 3; c++ {
+                    d := clamp(base[c] + modifier) - int(p[c])
+                    e += d * d
+                }
+                if bestError < 0 || e < bestError {
+                    bestIndex, bestError = index, e
+                }
+            }
+            candidate.indices[i] = bestIndex
+            candidate.error += bestError
+        }
+        if best.error < 0 || candidate.error < best.error {
+            best = candidate
+        }
+    }
+    return best
+}
+
+func average(pixels [][]uint8) [3]int {
+    var sums [3]int
+    for _, p := range pixels {
+        for c := 0; c < 3; c++ {
+            sums[c] += int(p[c])
+        }
+    }
+    return [3]int{sums[0] / len(pixels), sums[1] / len(pixels), sums[2] / len(pixels)}
+}
+
+// quantize returns the quantized color nearest to the given one along with its neighbors along the gray axis, which
+// the modifier tables can't reach otherwise.
+func quantize(color [3]int, bits uint) [][3]int {
+    maximum := (1 << bits) - 1
+    var candidates [][3]int
+    for offset := -1; offset <= 1; offset++ {
+        var q [3]int
+        for c := 0; c < 3; c++ {
+            q[c] = (color[c] * maximum + 127) / 255 + offset
+            if q[c] < 0 {
+                q[c] = 0
+            } else if q[c] > maximum {
+                q[c] = maximum
+            }
+        }
+        candidates = append(candidates, q)
+    }
+    return candidates
+}
+
+func bestSubblock(pixels [][]uint8, bits uint) ([3]int, etcSubblock) {
+    var bestQuantized [3]int
+    best := etcSubblock{error: -1}
+    for _, q := range quantize(average(pixels), bits) {
+        var base [3]int
+        for c := 0; c < 3; c++ {
+            if bits == 4 {
+                base[c] = extend4(q[c])
+            } else {
+                base[c] = extend5(q[c])
+            }
+        }
+        candidate := encodeSubblock(pixels, base)
+        if best.error < 0 || candidate.error < best.error {
+            bestQuantized, best = q, candidate
+        }
+    }
+    return bestQuantized, best
+}
+
+// encodeETCBlock encodes 16 row-major pixels as an ETC1 block in either individual or differential mode. ETC1 blocks
+// are also valid ETC2 blocks.
+func encodeETCBlock(pixels [16][]uint8) []uint8 {
+    var best []uint8
+    bestError := -1
+
+    for _, flipped := range []bool{false, true} {
+        var halves [2][][]uint8
+        var positions [2][][2]int
+        for y := 0; y < 4; y++ {
+            for x := 0; x < 4; x++ {
+                half := 0
+                if (flipped && y >= 2) || (!flipped && x >= 2) {
+                    half = 1
+                }
+                halves[half] = append(halves[half], pixels[y * 4 + x])
+                positions[half] = append(positions[half], [2]int{x, y})
+            }
+        }
+
+        for _, differential := range []bool{false, true} {
+            var quantized [2][3]int
+            var subblocks [2]etcSubblock
+            if differential {
+                quantized[0], subblocks[0] = bestSubblock(halves[0], 5)
+                quantized[1], subblocks[1] = bestSubblock(halves[1], 5)
+                representable := true
+                for c := 0; c < 3; c++ {
+                    d := quantized[1][c] - quantized[0][c]
+                    if d < -4 || d > 3 {
+                        representable = false
+                    }
+                }
+                if !representable {
+                    continue
+                }
+            } else {
+                quantized[0], subblocks[0] = bestSubblock(halves[0], 4)
+                quantized[1], subblocks[1] = bestSubblock(halves[1], 4)
+            }
+
+            e := subblocks[0].error + subblocks[1].error
+            if bestError >= 0 && e >= bestError {
+                continue
+            }
+            bestError = e
+
+            block := make([]uint8, 8)
+            for c := 0; c < 3; c++ {
+                if differential {
+                    block[c] = uint8((quantized[0][c] << 3) | ((quantized[1][c] - quantized[0][c]) & 7))
+                } else {
+                    block[c] = uint8((quantized[0][c] << 4) | quantized[1][c])
+                }
+            }
+            block[3] = uint8((subblocks[0].table << 5) | (subblocks[1].table << 2))
+            if differential {
+                block[3] |= 2
+            }
+            if flipped {
+                block[3] |= 1
+            }
+
+            var indices uint32
+            for half := 0; half < 2; half++ {
+                for i, p := range positions[half] {
+                    bit := uint(p[0] * 4 + p[1])
+                    index := uint32(subblocks[half].indices[i])
+                    indices |= ((index >> 1) << (bit + 16)) | ((index & 1) << bit)
+                }
+            }
+            binary.BigEndian.PutUint32(block[4:], indices)
+            best = block
+        }
+    }
+
+    return best
+}
+
+// encodeEACBlock encodes the alpha channel of 16 row-major pixels as an EAC block.
+func encodeEACBlock(pixels [16][]uint8) []uint8 {
+    minimum, maximum := 255, 0
+    for _, p := range pixels {
+        minimum = min(minimum, int(p[3]))
+        maximum = max(maximum, int(p[3]))
+    }
+
+    base := (minimum + maximum + 1) / 2
+    var best uint64
+    bestError := -1
+
+    for table := 0; table < 16; table++ {
+        for multiplier := 0; multiplier < 16; multiplier++ {
+            bits := uint64(base) << 56 | uint64(multiplier) << 52 | uint64(table) << 48
+            e := 0
+            for y := 0; y < 4; y++ {
+                for x := 0; x < 4; x++ {
+                    alpha := int(pixels[y * 4 + x][3])
+                    bestIndex, bestPixelError := 0, -1
+                    for index := 0; index < 8; index++ {
+                        d := clamp(base + eacModifiers[table][index] * multiplier) - alpha
+                        if bestPixelError < 0 || d * d < bestPixelError {
+                            bestIndex, bestPixelError = index, d * d
+                        }
+                    }
+                    bits |= uint64(bestIndex) << uint(45 - 3 * (x * 4 + y))
+                    e += bestPixelError
+                }
+            }
+            if bestError < 0 || e < bestError {
+                best, bestError = bits, e
+            }
+        }
+    }
+
+    block := make([]uint8, 8)
+    binary.BigEndian.PutUint64(block, best)
+    return block
+}
+
+func encodeLevel(l *level, hasAlpha bool) []uint8 {
+    var out []uint8
+    for by := 0; by < l.height; by += 4 {
+        for bx := 0; bx < l.width; bx += 4 {
+            var pixels [16][]uint8
+            for y := 0; y < 4; y++ {
+                for x := 0; x < 4; x++ {
+                    pixels[y * 4 + x] = l.pixel(bx + x, by + y)
+                }
+            }
+            if hasAlpha {
+                out = append(out, encodeEACBlock(pixels)...)
+            }
+            out = append(out, encodeETCBlock(pixels)...)
+        }
+    }
+    return out
+}
+
+// writeKTX writes a KTX 1.1 file containing the given compressed levels.
+func writeKTX(path string, internalFormat, baseInternalFormat uint32, width, height int, levels [][]uint8) error {
+    var buffer bytes.Buffer
+    buffer.Write([]byte{0xab, 'K', 'T', 'X', ' ', '1', '1', 0xbb, '\r', '\n', 0x1a, '\n'})
+    header := []uint32{0x04030201, 0, 1, 0, internalFormat, baseInternalFormat, uint32(width), uint32(height), 0, 0, 1, uint32(len(levels)), 0}
+    binary.Write(&buffer, binary.LittleEndian, header)
+    for _, data := range levels {
+        // compressed block sizes are always multiples of four, so no padding is needed
+        binary.Write(&buffer, binary.LittleEndian, uint32(len(data)))
+        buffer.Write(data)
+    }
+    return ioutil.WriteFile(path, buffer.Bytes(), 0644)
+}
+
+func compress(input, output string, mipmaps bool) error {
+    file, err := os.Open(input)
+    if err != nil {
+        return err
+    }
+    defer file.Close()
+
+    img, _, err := image.Decode(file)
+    if err != nil {
+        return err
+    }
+
+    l := newLevel(img)
+    width, height := l.width, l.height
+    hasAlpha := l.hasAlpha()
+
+    var levels [][]uint8
+    for {
+        levels = append(levels, encodeLevel(l, hasAlpha))
+        if !mipmaps || (l.width == 1 && l.height == 1) {
+            break
+        }
+        l = l.downsample()
+    }
+
+    if hasAlpha {
+        return writeKTX(output, glCompressedRGBA8ETC2EAC, glRGBA, width, height, levels)
+    }
+    return writeKTX(output, glCompressedRGB8ETC2, glRGB, width, height, levels)
+}
+
+func isImage(path string) bool {
+    switch strings.ToLower(filepath.Ext(path)) {
+    case ".png", ".jpg", ".jpeg":
+        return true
+    }
+    return false
+}
+
+func main() {
+    mipmaps := flag.Bool("mipmaps", true, "generate a full mipmap chain")
+    outputDirectory := flag.String("o", "", "the directory to write to. defaults to writing next to the inputs")
+    flag.Parse()
+
+    if len(flag.Args()) < 1 {
+        log.Fatal("Please provide one or more images or directories to compress.")
+    }
+
+    var inputs []string
+    for _, arg := range flag.Args() {
+        filepath.Walk(arg, func(path string, info os.FileInfo, err error) error {
+            if err == nil && !info.IsDir() && isImage(path) {
+                inputs = append(inputs, path)
+            }
+            return nil
+        })
+    }
+
+    failed := false
+    for _, input := range inputs {
+        output := strings.TrimSuffix(input, filepath.Ext(input)) + ".ktx"
+        if *outputDirectory != "" {
+            output = filepath.Join(*outputDirectory, filepath.Base(output))
+        }
+        if err := compress(input, output, *mipmaps); err != nil {
+            log.Printf("Unable to compress %s: %s", input, err)
+            failed = true
+            continue
+        }
+        log.Printf("Compressed %s to %s", input, output)
+    }
+
+    if failed {
+        os.Exit(1)
+    }
+}